@@ -0,0 +1,107 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+//
+// Layout of the binary log file, shared by the logger and iw_logdecode.
+// The file starts with BinaryLogHeader followed by the table of source 
+// files and the records ring. Records are written one after another, 
+// never cross the end of the ring and are aligned to 8 bytes. A record 
+// which does not fit before the end is preceded by a padding record, or
+// by nothing if even a padding header does not fit. Once the ring has
+// wrapped the oldest data may start in the middle of a record, readers
+// skip to the first aligned offset from which valid records follow each
+// other up to the end of the ring.
+//
+
+#ifdef _MSC_VER
+typedef unsigned __int64 iw_binlog_uint64;
+#else
+#include <stdint.h>
+typedef uint64_t iw_binlog_uint64;
+#endif
+
+#define IW_BINLOG_MAGIC				0x474C4249	// "IBLG"
+#define IW_BINLOG_VERSION			1
+
+#define IW_BINLOG_RECORD_MAGIC		0xB10C
+#define IW_BINLOG_RECORD_ALIGN		8
+
+#define IW_BINLOG_MAX_FILES			1024
+#define IW_BINLOG_FILE_NAME_LENGTH	64
+
+// level of padding records
+#define IW_BINLOG_LEVEL_PAD			0xFF
+
+// record flags
+#define IW_BINLOG_FLAG_SCRIPT		0x01
+
+#define IW_BINLOG_ALIGN(x) \
+	(((x) + IW_BINLOG_RECORD_ALIGN - 1) & ~(IW_BINLOG_RECORD_ALIGN - 1))
+
+struct BinaryLogHeader
+{
+	unsigned int magic;
+
+	unsigned int version;
+
+	unsigned int files_offset;
+
+	unsigned int files_count;
+
+	unsigned int ring_offset;
+
+	unsigned int ring_size;
+
+	// bytes ever written to the ring, next record goes to write_pos % ring_size
+	iw_binlog_uint64 write_pos;
+};
+
+// source file of log statements, a log site is a file index and a line
+struct BinaryLogFile
+{
+	char name[IW_BINLOG_FILE_NAME_LENGTH];
+};
+
+struct BinaryLogRecord
+{
+	unsigned short magic;
+
+	// whole record including the header and the alignment
+	unsigned short size;
+
+	unsigned char level;
+
+	unsigned char flags;
+
+	unsigned short file_index;
+
+	unsigned int line;
+
+	// bytes of message text following the header, not zero terminated
+	unsigned int length;
+
+	// FILETIME, 100 ns intervals since January 1, 1601 UTC
+	iw_binlog_uint64 timestamp;
+
+	unsigned int thread_id;
+
+	unsigned int fiber_id;
+};
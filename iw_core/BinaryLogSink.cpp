@@ -0,0 +1,252 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "BinaryLogSink.h"
+
+// log statements without a known site
+#define IW_BINLOG_NO_FILE	0xFFFF
+
+namespace ivrworx
+{
+	BinaryLogSink::BinaryLogSink():
+	_file(INVALID_HANDLE_VALUE),
+	_mapping(NULL),
+	_view(NULL),
+	_header(NULL),
+	_files(NULL),
+	_ring(NULL)
+	{
+
+	}
+
+	BinaryLogSink::~BinaryLogSink()
+	{
+		Close();
+	}
+
+	BOOL
+	BinaryLogSink::Open(IN const char *file_name, IN size_t ring_size)
+	{
+		Close();
+
+		DWORD files_offset	= IW_BINLOG_ALIGN(sizeof(BinaryLogHeader));
+		DWORD ring_offset	= IW_BINLOG_ALIGN(files_offset + IW_BINLOG_MAX_FILES*sizeof(BinaryLogFile));
+		DWORD aligned_size	= IW_BINLOG_ALIGN((DWORD)ring_size);
+		DWORD file_size		= ring_offset + aligned_size;
+
+		_file = ::CreateFileA(
+			file_name,
+			GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ,
+			NULL,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			NULL);
+
+		if (_file == INVALID_HANDLE_VALUE)
+		{
+			goto error;
+		}
+
+		_mapping = ::CreateFileMappingA(
+			_file,
+			NULL,
+			PAGE_READWRITE,
+			0,
+			file_size,
+			NULL);
+
+		if (_mapping == NULL)
+		{
+			goto error;
+		}
+
+		_view = (char *)::MapViewOfFile(
+			_mapping,
+			FILE_MAP_WRITE,
+			0,
+			0,
+			file_size);
+
+		if (_view == NULL)
+		{
+			goto error;
+		}
+
+		_header = (BinaryLogHeader *)_view;
+		_files	= (BinaryLogFile *)(_view + files_offset);
+		_ring	= _view + ring_offset;
+
+		::ZeroMemory(_view, ring_offset);
+
+		_header->magic			= IW_BINLOG_MAGIC;
+		_header->version		= IW_BINLOG_VERSION;
+		_header->files_offset	= files_offset;
+		_header->files_count	= 0;
+		_header->ring_offset	= ring_offset;
+		_header->ring_size		= aligned_size;
+		_header->write_pos		= 0;
+
+		return TRUE;
+
+error:
+		Close();
+		return FALSE;
+
+	}
+
+	void
+	BinaryLogSink::Close()
+	{
+		if (_view != NULL)
+		{
+			::UnmapViewOfFile(_view);
+		}
+
+		if (_mapping != NULL)
+		{
+			::CloseHandle(_mapping);
+		}
+
+		if (_file != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(_file);
+		}
+
+		_file	 = INVALID_HANDLE_VALUE;
+		_mapping = NULL;
+		_view	 = NULL;
+		_header	 = NULL;
+		_files	 = NULL;
+		_ring	 = NULL;
+
+		_fileIndexes.clear();
+	}
+
+	unsigned short
+	BinaryLogSink::FileIndex(IN const char *log_file)
+	{
+		if (log_file == NULL)
+		{
+			return IW_BINLOG_NO_FILE;
+		}
+
+		FileIndexMap::iterator iter = _fileIndexes.find(log_file);
+		if (iter != _fileIndexes.end())
+		{
+			return iter->second;
+		}
+
+		// same file may come through several literals
+		const char *name = log_file;
+		for (const char *p = log_file; *p != '\0'; ++p)
+		{
+			if (*p == '\\' || *p == '/')
+			{
+				name = p + 1;
+			}
+		}
+
+		unsigned short index = IW_BINLOG_NO_FILE;
+		for (unsigned int i = 0; i < _header->files_count; ++i)
+		{
+			if (::strncmp(_files[i].name, name, IW_BINLOG_FILE_NAME_LENGTH - 1) == 0)
+			{
+				index = (unsigned short)i;
+				break;
+			}
+		}
+
+		if (index == IW_BINLOG_NO_FILE && 
+			_header->files_count < IW_BINLOG_MAX_FILES)
+		{
+			index = (unsigned short)_header->files_count;
+			::strncpy_s(_files[index].name, IW_BINLOG_FILE_NAME_LENGTH, name, _TRUNCATE);
+			_header->files_count++;
+		}
+
+		_fileIndexes[log_file] = index;
+
+		return index;
+	}
+
+	void
+	BinaryLogSink::Write(
+		IN int log_level,
+		IN BOOL script_log,
+		IN const char *log_file,
+		IN int log_line,
+		IN DWORD thread_id,
+		IN PVOID fiber_id,
+		IN const FILETIME &timestamp,
+		IN const char *text,
+		IN size_t length)
+	{
+		if (_header == NULL)
+		{
+			return;
+		}
+
+		DWORD ring_size = _header->ring_size;
+		DWORD size = IW_BINLOG_ALIGN((DWORD)(sizeof(BinaryLogRecord) + length));
+		if (size > ring_size || size > 0xFFFF)
+		{
+			return;
+		}
+
+		DWORD pos  = (DWORD)(_header->write_pos % ring_size);
+		DWORD tail = ring_size - pos;
+
+		if (size > tail)
+		{
+			if (tail >= sizeof(BinaryLogRecord))
+			{
+				BinaryLogRecord *pad = (BinaryLogRecord *)(_ring + pos);
+				pad->magic	= IW_BINLOG_RECORD_MAGIC;
+				pad->size	= (unsigned short)tail;
+				pad->level	= IW_BINLOG_LEVEL_PAD;
+				pad->length = 0;
+			}
+
+			_header->write_pos += tail;
+			pos = 0;
+		}
+
+		BinaryLogRecord record;
+		record.magic		= IW_BINLOG_RECORD_MAGIC;
+		record.size			= (unsigned short)size;
+		record.level		= (unsigned char)log_level;
+		record.flags		= script_log ? IW_BINLOG_FLAG_SCRIPT : 0;
+		record.file_index	= FileIndex(log_file);
+		record.line			= log_line;
+		record.length		= (unsigned int)length;
+		record.timestamp	= ((iw_binlog_uint64)timestamp.dwHighDateTime << 32) | timestamp.dwLowDateTime;
+		record.thread_id	= thread_id;
+		record.fiber_id		= (unsigned int)fiber_id;
+
+		::memcpy(_ring + pos, &record, sizeof(record));
+		::memcpy(_ring + pos + sizeof(record), text, length);
+
+		// readers of a live file see only complete records
+		::MemoryBarrier();
+		_header->write_pos += size;
+	}
+
+}
@@ -0,0 +1,90 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "BinaryLogFormat.h"
+
+namespace ivrworx
+{
+	/**
+
+	Log output which copies records into a memory mapped file ring 
+	instead of formatting them. A record is a fixed header with the 
+	level, time, thread, fiber and log site followed by the message 
+	text, so writing one costs two memcpy calls. Old records are 
+	overwritten once the ring is full. The file is decoded offline 
+	with iw_logdecode.
+
+	Not thread safe, it is used by the logger thread or under the 
+	logger mutex.
+
+	**/
+	class BinaryLogSink:
+		public boost::noncopyable
+	{
+	public:
+
+		BinaryLogSink();
+
+		virtual ~BinaryLogSink();
+
+		// creates the file anew, ring_size is in bytes
+		BOOL Open(IN const char *file_name, IN size_t ring_size);
+
+		void Close();
+
+		BOOL IsOpen() const { return _header != NULL; };
+
+		void Write(
+			IN int log_level,
+			IN BOOL script_log,
+			IN const char *log_file,
+			IN int log_line,
+			IN DWORD thread_id,
+			IN PVOID fiber_id,
+			IN const FILETIME &timestamp,
+			IN const char *text,
+			IN size_t length);
+
+	private:
+
+		unsigned short FileIndex(IN const char *log_file);
+
+		HANDLE _file;
+
+		HANDLE _mapping;
+
+		char *_view;
+
+		BinaryLogHeader *_header;
+
+		BinaryLogFile *_files;
+
+		char *_ring;
+
+		// __FILE__ literals already found in the files table
+		typedef 
+		map<const char*, unsigned short> FileIndexMap;
+
+		FileIndexMap _fileIndexes;
+
+	};
+
+}
@@ -0,0 +1,178 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include <set>
+#include "CallLogFilter.h"
+#include "Logger.h"
+
+namespace ivrworx
+{
+	typedef
+	set<HandleId> HandlesSet;
+
+	static mutex		g_debuggedCallsMutex;
+
+	static HandlesSet	g_debuggedCalls;
+
+	static volatile LONG g_callsCounter = 0;
+
+	static BOOL
+	MatchesAny(IN const ConfigValue *filter, IN const string &value)
+	{
+		if (filter == NULL || 
+			filter->type != CONF_TYPE_ARRAY || 
+			value.empty())
+		{
+			return FALSE;
+		}
+
+		for (ListOfAny::const_iterator iter = filter->array_value.begin();
+			iter != filter->array_value.end(); ++iter)
+		{
+			if (typeid(string) != iter->type())
+			{
+				continue;
+			}
+
+			const string &pattern = any_cast<string>(*iter);
+			if (!pattern.empty() && value.find(pattern) != string::npos)
+			{
+				return TRUE;
+			}
+		}
+
+		return FALSE;
+	}
+
+	BOOL
+	CallLogFilter::Matches(
+		IN ConfigurationPtr conf, 
+		IN const string &ani, 
+		IN const string &dnis)
+	{
+		ConfigSnapshotPtr snapshot = conf->GetSnapshot();
+		if (!snapshot)
+		{
+			return FALSE;
+		}
+
+		return MatchesAny(snapshot->Find("call_debug_ani"), ani) || 
+			MatchesAny(snapshot->Find("call_debug_dnis"), dnis);
+	}
+
+	BOOL
+	CallLogFilter::Decide(
+		IN ConfigurationPtr conf, 
+		IN const string &ani, 
+		IN const string &dnis)
+	{
+		if (Matches(conf, ani, dnis))
+		{
+			return TRUE;
+		}
+
+		ConfigSnapshotPtr snapshot = conf->GetSnapshot();
+		if (!snapshot)
+		{
+			return FALSE;
+		}
+
+		const ConfigValue *percent = snapshot->Find("call_debug_sample_percent");
+		if (percent == NULL || 
+			percent->type != CONF_TYPE_INT ||
+			percent->int_value <= 0)
+		{
+			return FALSE;
+		}
+
+		// every call takes the next slot out of a hundred, so the share 
+		// is exact over any hundred consecutive calls
+		LONG slot = ::InterlockedIncrement(&g_callsCounter) % 100;
+		
+		return slot < percent->int_value;
+	}
+
+	void
+	CallLogFilter::Register(IN HandleId iwh)
+	{
+		if (iwh == IW_UNDEFINED)
+		{
+			return;
+		}
+
+		mutex::scoped_lock lock(g_debuggedCallsMutex);
+
+		g_debuggedCalls.insert(iwh);
+		SetDebuggedCallsCount((LONG)g_debuggedCalls.size());
+	}
+
+	void
+	CallLogFilter::Unregister(IN HandleId iwh)
+	{
+		mutex::scoped_lock lock(g_debuggedCallsMutex);
+
+		if (g_debuggedCalls.erase(iwh) > 0)
+		{
+			SetDebuggedCallsCount((LONG)g_debuggedCalls.size());
+		}
+	}
+
+	BOOL
+	CallLogFilter::IsDebugged(IN HandleId iwh)
+	{
+		if (g_DebuggedCalls == 0)
+		{
+			return FALSE;
+		}
+
+		mutex::scoped_lock lock(g_debuggedCallsMutex);
+
+		return g_debuggedCalls.find(iwh) != g_debuggedCalls.end();
+	}
+
+	CallLogScope::CallLogScope(IN HandleId iwh):
+	_ctx(NULL),
+	_prevDebug(FALSE)
+	{
+		if (g_DebuggedCalls == 0)
+		{
+			return;
+		}
+
+		_ctx = GetCurrRunningContext();
+		if (_ctx == NULL)
+		{
+			return;
+		}
+
+		// processes serving many calls are not debugged outside of the scope
+		_prevDebug = _ctx->LogContext().Decided() ? _ctx->CallDebug() : FALSE;
+		_ctx->CallDebug(CallLogFilter::IsDebugged(iwh));
+	}
+
+	CallLogScope::~CallLogScope()
+	{
+		if (_ctx != NULL)
+		{
+			_ctx->CallDebug(_prevDebug);
+		}
+	}
+
+}
@@ -0,0 +1,87 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "LightweightProcess.h"
+
+namespace ivrworx
+{
+	/**
+
+	Decides which calls are logged at debug level while the rest of the
+	system logs at its configured levels. A call is debugged if its ani
+	or dnis contains one of the call_debug_ani or call_debug_dnis strings,
+	or if it falls into the call_debug_sample_percent share of calls.
+
+	The decision is taken once, when the call is offered or made, and
+	stored in the log context of the process handling it. A script takes
+	a single sampling slot, further calls it handles are debugged if the 
+	script is debugged or if they match the filters. Messages sent by
+	that process carry the decision, so processes serving many calls, like
+	the sip stack or the media processes, log at debug level while they
+	handle them. Stack callbacks which are not triggered by a message find
+	the decision by the call stack handle.
+
+	**/
+	class IW_CORE_API CallLogFilter
+	{
+	public:
+
+		// options are read on every call, so reloaded values apply at once
+		static BOOL Matches(
+			IN ConfigurationPtr conf, 
+			IN const string &ani, 
+			IN const string &dnis);
+
+		// matches the call or takes the next sampling slot
+		static BOOL Decide(
+			IN ConfigurationPtr conf, 
+			IN const string &ani, 
+			IN const string &dnis);
+
+		static void Register(IN HandleId iwh);
+
+		static void Unregister(IN HandleId iwh);
+
+		static BOOL IsDebugged(IN HandleId iwh);
+
+	};
+
+	// logs the scope at debug level if the call is debugged, and restores 
+	// the previous state of the current process on exit, processes serving 
+	// many calls are left not debugged
+	class IW_CORE_API CallLogScope:
+		public boost::noncopyable
+	{
+	public:
+
+		CallLogScope(IN HandleId iwh);
+
+		~CallLogScope();
+
+	private:
+
+		RunningContext *_ctx;
+
+		BOOL _prevDebug;
+
+	};
+
+}
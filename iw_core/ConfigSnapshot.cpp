@@ -0,0 +1,139 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "ConfigSnapshot.h"
+
+#define IW_CONF_INITIAL_SLOTS	64
+
+namespace ivrworx
+{
+	ConfigValue::ConfigValue():
+	type(CONF_TYPE_OTHER),
+	int_value(0),
+	bool_value(FALSE),
+	real_value(0)
+	{
+
+	}
+
+	ConfigSnapshot::ConfigSnapshot():
+	_mask(0)
+	{
+		Rehash(IW_CONF_INITIAL_SLOTS);
+	}
+
+	ConfigSnapshot::~ConfigSnapshot()
+	{
+
+	}
+
+	unsigned long
+	ConfigSnapshot::Hash(IN const char *key, IN size_t length)
+	{
+		// FNV-1a
+		unsigned long hash = 2166136261UL;
+		for (size_t i = 0; i < length; ++i)
+		{
+			hash ^= (unsigned char)key[i];
+			hash *= 16777619UL;
+		}
+
+		return hash;
+	}
+
+	int
+	ConfigSnapshot::Probe(IN const char *key, IN size_t length, IN unsigned long hash) const
+	{
+		size_t slot = hash & _mask;
+		while (_slots[slot] != -1)
+		{
+			const Entry &entry = _entries[_slots[slot]];
+			if (entry.hash == hash &&
+				entry.key.size() == length &&
+				::memcmp(entry.key.c_str(), key, length) == 0)
+			{
+				return (int)slot;
+			}
+
+			slot = (slot + 1) & _mask;
+		}
+
+		return (int)slot;
+	}
+
+	void
+	ConfigSnapshot::Rehash(IN size_t slots_count)
+	{
+		_slots.assign(slots_count, -1);
+		_mask = slots_count - 1;
+
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			size_t slot = _entries[i].hash & _mask;
+			while (_slots[slot] != -1)
+			{
+				slot = (slot + 1) & _mask;
+			}
+
+			_slots[slot] = (int)i;
+		}
+	}
+
+	void
+	ConfigSnapshot::Add(IN const string &key, IN const ConfigValue &value)
+	{
+		unsigned long hash = Hash(key.c_str(), key.size());
+
+		int slot = Probe(key.c_str(), key.size(), hash);
+		if (_slots[slot] != -1)
+		{
+			return;
+		}
+
+		Entry entry;
+		entry.hash  = hash;
+		entry.key   = key;
+		entry.value = value;
+
+		_entries.push_back(entry);
+		_slots[slot] = (int)_entries.size() - 1;
+
+		// keep the table at most half full
+		if (_entries.size()*2 > _slots.size())
+		{
+			Rehash(_slots.size()*2);
+		}
+	}
+
+	const ConfigValue *
+	ConfigSnapshot::Find(IN const char *key, IN size_t length) const
+	{
+		int slot = Probe(key, length, Hash(key, length));
+
+		return _slots[slot] == -1 ? NULL : &_entries[_slots[slot]].value;
+	}
+
+	const ConfigValue *
+	ConfigSnapshot::Find(IN const string &key) const
+	{
+		return Find(key.c_str(), key.size());
+	}
+
+}
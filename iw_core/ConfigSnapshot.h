@@ -0,0 +1,119 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "DllHelpers.h"
+
+using namespace std;
+using namespace boost;
+
+namespace ivrworx
+{
+	typedef
+	list<boost::any> ListOfAny;
+
+	enum ConfigValueType
+	{
+		CONF_TYPE_OBJECT,
+		CONF_TYPE_ARRAY,
+		CONF_TYPE_STRING,
+		CONF_TYPE_BOOL,
+		CONF_TYPE_INT,
+		CONF_TYPE_REAL,
+		// arrays holding objects or arrays
+		CONF_TYPE_OTHER
+	};
+
+	struct IW_CORE_API ConfigValue
+	{
+		ConfigValue();
+
+		ConfigValueType type;
+
+		int int_value;
+
+		BOOL bool_value;
+
+		double real_value;
+
+		// environment references are already expanded
+		string str_value;
+
+		ListOfAny array_value;
+	};
+
+	/**
+
+	Immutable flattened view of a configuration. Every value is stored
+	under its full "a/b/c" path together with the hash of the path, so a
+	lookup is one hash computation and one probe of an open addressed
+	table. Snapshots are filled once when the configuration is read and
+	are only shared through ConfigSnapshotPtr afterwards, so readers need
+	no locking.
+
+	**/
+	class IW_CORE_API ConfigSnapshot:
+		public boost::noncopyable
+	{
+	public:
+
+		ConfigSnapshot();
+
+		virtual ~ConfigSnapshot();
+
+		static unsigned long Hash(IN const char *key, IN size_t length);
+
+		// the first value added for a key wins, as with lookups in the source document
+		void Add(IN const string &key, IN const ConfigValue &value);
+
+		const ConfigValue *Find(IN const char *key, IN size_t length) const;
+
+		const ConfigValue *Find(IN const string &key) const;
+
+		size_t Size() const { return _entries.size(); };
+
+	private:
+
+		struct Entry
+		{
+			unsigned long hash;
+
+			string key;
+
+			ConfigValue value;
+		};
+
+		int Probe(IN const char *key, IN size_t length, IN unsigned long hash) const;
+
+		void Rehash(IN size_t slots_count);
+
+		vector<Entry> _entries;
+
+		// indexes into _entries, -1 marks an empty slot
+		vector<int> _slots;
+
+		size_t _mask;
+
+	};
+
+	typedef
+	shared_ptr<const ConfigSnapshot> ConfigSnapshotPtr;
+
+}
@@ -52,6 +52,24 @@ namespace ivrworx
 		
 	}
 
+	ConfigSnapshotPtr
+	Configuration::GetSnapshot()
+	{
+		return ConfigSnapshotPtr();
+	}
+
+	ApiErrorCode
+	Configuration::Reload()
+	{
+		return API_FEATURE_DISABLED;
+	}
+
+	void
+	Configuration::AddReloadHandler(IN ConfigurationReloadHandler handler)
+	{
+
+	}
+
 
 }
 
@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include "IwBase.h"
+#include "ConfigSnapshot.h"
+
 using namespace std;
 using namespace boost;
 
@@ -34,8 +37,11 @@ namespace ivrworx
 		configuration_exception(const string &);
 	};
 
+	class Configuration;
+
+	// called after the configuration was reloaded
 	typedef
-	list<boost::any> ListOfAny;
+	void (*ConfigurationReloadHandler)(IN Configuration &conf);
 
 	// Configuration class follows basic JSON semantics
 	// though it may be implemented as XML or Db or any
@@ -59,6 +65,15 @@ namespace ivrworx
 
 		virtual void GetArray(IN const string &key, OUT ListOfAny &out_list) = 0;
 
+		// flattened values, empty if the implementation does not provide one
+		virtual ConfigSnapshotPtr GetSnapshot();
+
+		// replaces the values with the ones currently in the source,
+		// API_FEATURE_DISABLED if the implementation cannot reload
+		virtual ApiErrorCode Reload();
+
+		virtual void AddReloadHandler(IN ConfigurationReloadHandler handler);
+
 	};
 
 	typedef 
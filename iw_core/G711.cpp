@@ -0,0 +1,256 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "G711.h"
+
+#define SIGN_BIT	(0x80)		/* Sign bit for a A-law byte. */
+#define QUANT_MASK	(0xf)		/* Quantization field mask. */
+#define SEG_SHIFT	(4)			/* Left shift for segment number. */
+#define SEG_MASK	(0x70)		/* Segment field mask. */
+#define BIAS		(0x84)		/* Bias for linear code. */
+#define CLIP		8159
+
+namespace ivrworx
+{
+	static const short seg_aend[8] = {0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF};
+
+	static const short seg_uend[8] = {0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+
+	static int 
+	search(int val, const short *table, int size)
+	{
+		for (int i = 0; i < size; i++) 
+		{
+			if (val <= *table++)
+				return (i);
+		}
+		return (size);
+	}
+
+	//
+	// reference (CCITT G.711) per sample implementation
+	//
+	unsigned char
+	LinearToAlawSample(IN int pcm_val)
+	{
+		int mask;
+		int seg;
+		unsigned char aval;
+
+		pcm_val = pcm_val >> 3;
+
+		if (pcm_val >= 0) 
+		{
+			mask = 0xD5;
+		} 
+		else 
+		{
+			mask = 0x55;
+			pcm_val = -pcm_val - 1;
+		}
+
+		seg = search(pcm_val, seg_aend, 8);
+		if (seg >= 8)
+		{
+			return (unsigned char) (0x7F ^ mask);
+		}
+
+		aval = (unsigned char) seg << SEG_SHIFT;
+		if (seg < 2)
+			aval |= (pcm_val >> 1) & QUANT_MASK;
+		else
+			aval |= (pcm_val >> seg) & QUANT_MASK;
+
+		return (aval ^ mask);
+	}
+
+	short
+	AlawToLinearSample(IN unsigned char a_val)
+	{
+		int t;
+		int seg;
+
+		a_val ^= 0x55;
+
+		t = (a_val & QUANT_MASK) << 4;
+		seg = ((unsigned)a_val & SEG_MASK) >> SEG_SHIFT;
+		switch (seg) 
+		{
+		case 0:
+			t += 8;
+			break;
+		case 1:
+			t += 0x108;
+			break;
+		default:
+			t += 0x108;
+			t <<= seg - 1;
+		}
+		return (short)((a_val & SIGN_BIT) ? t : -t);
+	}
+
+	unsigned char
+	LinearToUlawSample(IN int pcm_val)
+	{
+		int mask;
+		int seg;
+		unsigned char uval;
+
+		pcm_val = pcm_val >> 2;
+		if (pcm_val < 0) 
+		{
+			pcm_val = -pcm_val;
+			mask = 0x7F;
+		} 
+		else 
+		{
+			mask = 0xFF;
+		}
+
+		if ( pcm_val > CLIP ) pcm_val = CLIP;
+		pcm_val += (BIAS >> 2);
+
+		seg = search(pcm_val, seg_uend, 8);
+		if (seg >= 8)
+		{
+			return (unsigned char) (0x7F ^ mask);
+		}
+
+		uval = (unsigned char) (seg << 4) | ((pcm_val >> (seg + 1)) & 0xF);
+		return (uval ^ mask);
+	}
+
+	short
+	UlawToLinearSample(IN unsigned char u_val)
+	{
+		int t;
+
+		u_val = ~u_val;
+
+		t = ((u_val & QUANT_MASK) << 3) + BIAS;
+		t <<= ((unsigned)u_val & SEG_MASK) >> SEG_SHIFT;
+
+		return (short)((u_val & SIGN_BIT) ? (BIAS - t) : (t - BIAS));
+	}
+
+	//
+	// ulaw encoder works on 14 bit magnitude and alaw on 13 bit,
+	// so the encoding tables are indexed by the top bits of the sample
+	//
+	struct G711Tables
+	{
+		G711Tables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				ulaw_to_linear[i] = (short)UlawToLinearSample((unsigned char)i);
+				alaw_to_linear[i] = (short)AlawToLinearSample((unsigned char)i);
+			}
+
+			for (int i = 0; i < 16384; i++)
+			{
+				linear_to_ulaw[i] = LinearToUlawSample((short)(i << 2));
+			}
+
+			for (int i = 0; i < 8192; i++)
+			{
+				linear_to_alaw[i] = LinearToAlawSample((short)(i << 3));
+			}
+
+			for (int i = 0; i < 256; i++)
+			{
+				ulaw_to_alaw[i] = LinearToAlawSample(ulaw_to_linear[i]);
+				alaw_to_ulaw[i] = LinearToUlawSample(alaw_to_linear[i]);
+			}
+		}
+
+		short ulaw_to_linear[256];
+		short alaw_to_linear[256];
+
+		unsigned char linear_to_ulaw[16384];
+		unsigned char linear_to_alaw[8192];
+
+		unsigned char ulaw_to_alaw[256];
+		unsigned char alaw_to_ulaw[256];
+	};
+
+	static const G711Tables g_tables;
+
+	void 
+	UlawToLinear(IN const unsigned char *in, OUT short *out, IN unsigned samples)
+	{
+		const short *table = g_tables.ulaw_to_linear;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[in[i]];
+		}
+	}
+
+	void 
+	AlawToLinear(IN const unsigned char *in, OUT short *out, IN unsigned samples)
+	{
+		const short *table = g_tables.alaw_to_linear;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[in[i]];
+		}
+	}
+
+	void 
+	LinearToUlaw(IN const short *in, OUT unsigned char *out, IN unsigned samples)
+	{
+		const unsigned char *table = g_tables.linear_to_ulaw;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[((unsigned short)in[i]) >> 2];
+		}
+	}
+
+	void 
+	LinearToAlaw(IN const short *in, OUT unsigned char *out, IN unsigned samples)
+	{
+		const unsigned char *table = g_tables.linear_to_alaw;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[((unsigned short)in[i]) >> 3];
+		}
+	}
+
+	void 
+	UlawToAlaw(IN const unsigned char *in, OUT unsigned char *out, IN unsigned samples)
+	{
+		const unsigned char *table = g_tables.ulaw_to_alaw;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[in[i]];
+		}
+	}
+
+	void 
+	AlawToUlaw(IN const unsigned char *in, OUT unsigned char *out, IN unsigned samples)
+	{
+		const unsigned char *table = g_tables.alaw_to_ulaw;
+		for (unsigned i = 0; i < samples; i++)
+		{
+			out[i] = table[in[i]];
+		}
+	}
+
+}
@@ -0,0 +1,61 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "DllHelpers.h"
+
+namespace ivrworx
+{
+	//
+	// G.711 conversions shared by the media modules. Per sample functions
+	// are the CCITT reference implementation, frame functions use lookup 
+	// tables built once upon load so per sample cost is a single lookup.
+	//
+	IW_CORE_API unsigned char 
+	LinearToUlawSample(IN int pcm);
+
+	IW_CORE_API short 
+	UlawToLinearSample(IN unsigned char ulaw);
+
+	IW_CORE_API unsigned char 
+	LinearToAlawSample(IN int pcm);
+
+	IW_CORE_API short 
+	AlawToLinearSample(IN unsigned char alaw);
+
+	IW_CORE_API void 
+	UlawToLinear(IN const unsigned char *in, OUT short *out, IN unsigned samples);
+
+	IW_CORE_API void 
+	AlawToLinear(IN const unsigned char *in, OUT short *out, IN unsigned samples);
+
+	IW_CORE_API void 
+	LinearToUlaw(IN const short *in, OUT unsigned char *out, IN unsigned samples);
+
+	IW_CORE_API void 
+	LinearToAlaw(IN const short *in, OUT unsigned char *out, IN unsigned samples);
+
+	IW_CORE_API void 
+	UlawToAlaw(IN const unsigned char *in, OUT unsigned char *out, IN unsigned samples);
+
+	IW_CORE_API void 
+	AlawToUlaw(IN const unsigned char *in, OUT unsigned char *out, IN unsigned samples);
+
+}
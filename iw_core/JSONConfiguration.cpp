@@ -19,6 +19,7 @@
 
 #include "StdAfx.h"
 #include "JSONConfiguration.h"
+#include "Logger.h"
 
 
 using namespace json_spirit;
@@ -27,234 +28,351 @@ namespace ivrworx
 {
 	
 
-	static bool 
-	same_name(const Pair& pair, const string& name )
+	string
+	get_env_variable_as_str(const char *var_name)
 	{
-		return pair.name_ == name;
-	}
+        
+		char* var_value = NULL;
+		size_t requiredSize;
 
-	static const Value& 
-	find_value( const Object& obj, const string& name )
-	{
-		Object::const_iterator i = find_if( obj.begin(), obj.end(), bind( same_name, _1, ref( name ) ) );
+		::getenv_s( &requiredSize, NULL, 0, var_name);
+		if (requiredSize == 0)
+		{
+			return "";
+		}
+
+		var_value = (char*)::malloc(requiredSize * sizeof(char));
+
+		// Get the value of the LIB environment variable.
+		::getenv_s( &requiredSize, var_value, requiredSize, var_name);
+
+		string res(var_value);
+
+		::free(var_value);
+
+		return res;
 
-		if( i == obj.end() ) return Value::null;
 
-		return i->value_;
 	}
 
-	static const Value&
-	query_value_with_path(const Object& parent_object, const string& name )
+	static void
+	flatten_value(const Value &val, const string &key, ConfigSnapshot &snapshot);
+
+	static void
+	flatten_object(const Object &obj, const string &prefix, ConfigSnapshot &snapshot)
 	{
-		size_t found = name.find_first_of("/");
-		if (found == string::npos)
+		for (Object::const_iterator iter = obj.begin(); iter != obj.end(); ++iter)
 		{
-			return find_value(parent_object,name);
+			flatten_value(iter->value_, prefix + iter->name_, snapshot);
 		}
+	}
 
-		string next_parent_key =  
-			name.substr (0,found);
+	static void
+	flatten_value(const Value &val, const string &key, ConfigSnapshot &snapshot)
+	{
+		ConfigValue value;
 
-		string remainder = 
-			name.substr(found + 1, name.length());
+		switch (val.type())
+		{
+		case obj_type:
+			{
+				value.type = CONF_TYPE_OBJECT;
+				snapshot.Add(key, value);
 
-		const Value& val = 
-			find_value(parent_object,next_parent_key);
+				flatten_object(val.get_obj(), key + "/", snapshot);
+				return;
+			}
+		case str_type:
+			{
+				value.type = CONF_TYPE_STRING;
+				value.str_value = val.get_str();
+				if (value.str_value.length() > 0 && 
+					*value.str_value.begin() == '$')
+				{
+					value.str_value = get_env_variable_as_str(value.str_value.c_str() + 1);
+				}
+				break;
+			}
+		case bool_type:
+			{
+				value.type = CONF_TYPE_BOOL;
+				value.bool_value = val.get_bool();
+				break;
+			}
+		case int_type:
+			{
+				value.type = CONF_TYPE_INT;
+				value.int_value = val.get_int();
+				break;
+			}
+		case real_type:
+			{
+				value.type = CONF_TYPE_REAL;
+				value.real_value = val.get_real();
+				break;
+			}
+		case array_type:
+			{
+				value.type = CONF_TYPE_ARRAY;
 
-		if (val.type() != obj_type)
-		{
-			throw configuration_exception("path not found, next_parent_key is not an object");
-		}
+				const Array &val_array = val.get_array();
+				for (Array::const_iterator iter = val_array.begin();
+					iter != val_array.end();
+					iter++)
+				{
+					switch (iter->type())
+					{
+					case str_type:	value.array_value.push_back(iter->get_str()); break;
+					case bool_type: value.array_value.push_back(iter->get_bool()); break;
+					case int_type:	value.array_value.push_back(iter->get_int()); break;
+					case real_type: value.array_value.push_back(iter->get_real()); break;
+					default:		value.type = CONF_TYPE_OTHER;
+					}
+				}
 
-		return query_value_with_path(val.get_obj(), remainder);
+				if (value.type == CONF_TYPE_OTHER)
+				{
+					value.array_value.clear();
+				}
+				break;
+			}
+		case null_type:
+		default:
+			{
+				// null values are reported as missing options
+				return;
+			}
+		}
 
+		snapshot.Add(key, value);
 	}
 
-	static const Array& 
-	find_array( const Object& obj, const string& name )
+	static BOOL
+	get_file_write_time(const string &filename, unsigned __int64 &write_time)
 	{
-		const Value & val = query_value_with_path(obj, name );
-		if ( val.type() != array_type)
+		WIN32_FILE_ATTRIBUTE_DATA attrs;
+		if (::GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attrs) == FALSE)
 		{
-			throw configuration_exception (name + " does not exist or not array type");
-		};
+			return FALSE;
+		}
+
+		write_time =
+			((unsigned __int64)attrs.ftLastWriteTime.dwHighDateTime << 32) |
+			attrs.ftLastWriteTime.dwLowDateTime;
 
-		return val.get_array(); 
+		return TRUE;
 	}
 
-	static int 
-	find_int( const Object& obj, const string& name )
+	JSONConfiguration::JSONConfiguration(void):
+	_writeTime(0),
+	_checkInterval(0),
+	_watcherThread(NULL),
+	_stopEvent(NULL)
 	{
-		const Value & val = query_value_with_path(obj, name );
-		if ( val.type() != int_type)
-		{
-			throw configuration_exception (name + " does not exist or not int type");
-		};
-		return val.get_int();
+		Publish(ConfigSnapshotPtr(new ConfigSnapshot()));
 	}
 
-	static bool
-	find_bool( const Object& obj, const string& name)
+	JSONConfiguration::~JSONConfiguration(void)
 	{
-		const Value & val = query_value_with_path(obj, name );
-		if ( val.type() != bool_type)
+		if (_watcherThread != NULL)
+		{
+			::SetEvent(_stopEvent);
+			::WaitForSingleObject(_watcherThread, INFINITE);
+			::CloseHandle(_watcherThread);
+		}
+
+		if (_stopEvent != NULL)
 		{
-			throw configuration_exception (name + " does not exist or not bool type");
-		};
-		return val.get_bool();
+			::CloseHandle(_stopEvent);
+		}
 	}
 
-	string
-	get_env_variable_as_str(const char *var_name)
+	const ConfigValue &
+	JSONConfiguration::FindValue(IN ConfigSnapshotPtr snapshot, IN const string &name, IN ConfigValueType type, IN const char *type_name)
 	{
-        
-		char* var_value = NULL;
-		size_t requiredSize;
-
-		::getenv_s( &requiredSize, NULL, 0, var_name);
-		var_value = (char*)::malloc(requiredSize * sizeof(char));
-
-		// Get the value of the LIB environment variable.
-		::getenv_s( &requiredSize, var_value, requiredSize, var_name);
+		const ConfigValue *value = snapshot->Find(name);
+		if (value == NULL || value->type != type)
+		{
+			throw configuration_exception (name + " does not exist or not " + type_name + " type");
+		}
 
-		string res(var_value);
+		return *value;
+	}
 
-		::free(var_value);
+	int
+	JSONConfiguration::GetInt(IN const string &name)
+	{
+		ConfigSnapshotPtr snapshot = GetSnapshot();
+		return FindValue(snapshot, name, CONF_TYPE_INT, "int").int_value;
+	}
 
-		return res;
+	string
+	JSONConfiguration::GetString(IN const string &name)
+	{
+		ConfigSnapshotPtr snapshot = GetSnapshot();
+		return FindValue(snapshot, name, CONF_TYPE_STRING, "string").str_value;
+	}
 
+	BOOL
+	JSONConfiguration::GetBool(IN const string &name)
+	{
+		ConfigSnapshotPtr snapshot = GetSnapshot();
+		return FindValue(snapshot, name, CONF_TYPE_BOOL, "bool").bool_value;
+	}
 
+	BOOL 
+	JSONConfiguration::HasOption(const string &name)
+	{
+		ConfigSnapshotPtr snapshot = GetSnapshot();
+		return snapshot->Find(name) != NULL;
 	}
 
-	static string 
-	find_str( const Object& obj, const string& name )
+	void 
+	JSONConfiguration::GetArray(IN const string &name, OUT list<any> &out_list)
 	{
-		
-		
-		const Value & val = query_value_with_path(obj, name );
-		if ( val.type() != str_type)
-		{
-			throw configuration_exception (name + " does not exist or not string type");
-		};
+		ConfigSnapshotPtr snapshot = GetSnapshot();
 
-		string value_str = val.get_str();
-		if (value_str.length() > 0 && 
-			 *value_str.begin() == '$')
+		const ConfigValue *value = snapshot->Find(name);
+		if (value != NULL && value->type == CONF_TYPE_OTHER)
 		{
-			return get_env_variable_as_str(value_str.c_str() + 1);
+			throw new configuration_exception("not supported JSON type. (TBD)");
 		}
 
-		return value_str;
+		out_list = FindValue(snapshot, name, CONF_TYPE_ARRAY, "array").array_value;
 	}
 
-	JSONConfiguration::JSONConfiguration(void)
+	ConfigSnapshotPtr
+	JSONConfiguration::GetSnapshot()
 	{
-		
+		mutex::scoped_lock lock(_currentMutex);
+
+		return _current;
 	}
 
-	JSONConfiguration::~JSONConfiguration(void)
+	ApiErrorCode
+	JSONConfiguration::Compile(OUT ConfigSnapshotPtr &snapshot, OUT unsigned __int64 &write_time)
 	{
-	}
+		// taken before reading, so a write racing
+		// with the read is picked by the next check
+		write_time = 0;
+		get_file_write_time(_fileName, write_time);
 
+		Value root_value;
 
-	int
-	JSONConfiguration::GetInt(IN const string &name)
-	{
-		return find_int(_rootValue.get_obj(),name);
-	}
+		ifstream  is(_fileName.c_str());
+		if (read(is, root_value) == false)
+		{
+			return API_FAILURE;
+		}
+		is.close();
 
-	string
-	JSONConfiguration::GetString(IN const string &name)
-	{
+		if (root_value.type() != obj_type)
+		{
+			return API_FAILURE;
+		}
 
-		return find_str(_rootValue.get_obj(),name);
-				
+		ConfigSnapshot *compiled = new ConfigSnapshot();
+		flatten_object(root_value.get_obj(), "", *compiled);
+		snapshot = ConfigSnapshotPtr(compiled);
+
+		return API_SUCCESS;
 	}
 
-	BOOL
-	JSONConfiguration::GetBool(IN const string &name)
+	void
+	JSONConfiguration::Publish(IN ConfigSnapshotPtr snapshot)
 	{
+		ConfigSnapshotPtr replaced;
+		{
+			mutex::scoped_lock lock(_currentMutex);
 
-		return find_bool(_rootValue.get_obj(),name);
+			replaced = _current;
+			_current = snapshot;
+		}
 
+		// freed here unless some reader still holds it
+		replaced.reset();
 	}
 
-	BOOL 
-	JSONConfiguration::HasOption(const string &name)
+	ApiErrorCode
+	JSONConfiguration::Reload()
 	{
-		try
+		mutex::scoped_lock lock(_reloadMutex);
+
+		ConfigSnapshotPtr snapshot;
+		unsigned __int64 write_time = 0;
+		if (IW_FAILURE(Compile(snapshot, write_time)))
 		{
-			const Value& val = 
-				query_value_with_path(_rootValue.get_obj(),name);
-			return (val.type() != null_type);
+			// keep the write time, the file is retried after the next change only
+			_writeTime = write_time;
+
+			LogWarn("Error reloading json configuration file '" << _fileName << "', keeping the current one.");
+			return API_FAILURE;
 		}
-		catch (configuration_exception e)
+
+		_writeTime = write_time;
+
+		Publish(snapshot);
+
+		LogInfo("Reloaded configuration '" << _fileName << "', options:" << snapshot->Size());
+
+		for (ReloadHandlersList::iterator iter = _reloadHandlers.begin(); 
+			iter != _reloadHandlers.end(); ++iter)
 		{
-			return FALSE;
+			(*iter)(*this);
 		}
-		
+
+		return API_SUCCESS;
 	}
 
-	void 
-	JSONConfiguration::GetArray(IN const string &name, OUT list<any> &out_list)
+	void
+	JSONConfiguration::AddReloadHandler(IN ConfigurationReloadHandler handler)
 	{
-		const Array &val_array = 
-			find_array(_rootValue.get_obj(),name);
+		mutex::scoped_lock lock(_reloadMutex);
+
+		_reloadHandlers.push_back(handler);
+	}
 
-		out_list.clear();
+	DWORD WINAPI 
+	JSONConfiguration::WatcherThread(LPVOID lpParam)
+	{
+		JSONConfiguration *conf = (JSONConfiguration *)lpParam;
 
-		for (Array::const_iterator iter = val_array.begin();
-			 iter != val_array.end();
-		     iter++)
+		while (::WaitForSingleObject(conf->_stopEvent, conf->_checkInterval) == WAIT_TIMEOUT)
 		{
-			Value_type vt = iter->type();
-			switch (vt)
+			unsigned __int64 write_time = 0;
+			if (get_file_write_time(conf->_fileName, write_time) == FALSE)
 			{
-			case str_type: 
-				{
-					out_list.push_back(iter->get_str());
-					break;
-				}
-			case bool_type: 
-				{
-					out_list.push_back(iter->get_bool());
-					break;
-				}
-			case int_type: 
-				{
-					out_list.push_back(iter->get_int());
-					break;
-				}
-			case real_type: 
-				{
-					out_list.push_back(iter->get_real());
-					break;
-				}
-			case obj_type:
-			case null_type:
-			case array_type:
-			default:
-				{
-					throw new configuration_exception("not supported JSON type. (TBD)");
+				continue;
+			}
 
-				}
-			} // switch
-		}
-	}
+			BOOL changed = FALSE;
+			{
+				mutex::scoped_lock lock(conf->_reloadMutex);
+				changed = (write_time != conf->_writeTime);
+			}
 
+			if (changed)
+			{
+				conf->Reload();
+			}
+		}
 
+		return 0;
+	}
 
 	ApiErrorCode
 	JSONConfiguration::InitFromFile(IN const string &filename)
 	{
-		
-		ifstream  is(filename.c_str());
-		if (read(is, _rootValue) == false)
+		_fileName = filename;
+
+		ConfigSnapshotPtr snapshot;
+		if (IW_FAILURE(Compile(snapshot, _writeTime)))
 		{
 			cerr << "Error reading json configuration file '" << filename << "'. Check that file exists, accessible and JSON valid." << endl;
 			return API_FAILURE;
 		}
-		is.close();
+
+		Publish(snapshot);
 
 		if (HasOption("dump_configuration") && GetBool("dump_configuration") == TRUE)
 		{
@@ -277,6 +395,30 @@ namespace ivrworx
 			}
 		}
 
+		_checkInterval = HasOption("config_check_interval") && GetInt("config_check_interval") > 0 ? 
+			GetInt("config_check_interval") : 0;
+
+		if (_checkInterval != 0)
+		{
+			_stopEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+
+			DWORD tid = 0;
+			_watcherThread = (_stopEvent == NULL) ? NULL : ::CreateThread(
+				NULL,
+				0,
+				&JSONConfiguration::WatcherThread,
+				this,
+				NULL,
+				&tid
+				);
+
+			if (_watcherThread == NULL)
+			{
+				string err = FormatLastSysError("CreateThread");
+				cerr << "Cannot watch configuration file '" << filename << "' - " << err << endl;
+			}
+		}
+
 		return API_SUCCESS;
 	}
 
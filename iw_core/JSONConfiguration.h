@@ -28,6 +28,17 @@ using namespace json_spirit;
 namespace ivrworx
 {
 
+	/**
+
+	Configuration read from a JSON file and compiled into a flattened
+	snapshot, so every accessor is a single hash probe. When the
+	configuration sets config_check_interval, the file is watched and a
+	changed file is compiled into a new snapshot that replaces the current
+	one atomically. Readers hold a reference to the snapshot taken under a
+	short lock, so a replaced snapshot is released by its last reader. A 
+	failed reload keeps serving the previous snapshot.
+
+	**/
 	class JSONConfiguration :
 		public Configuration
 	{
@@ -49,13 +60,46 @@ namespace ivrworx
 
 		virtual void GetArray(IN const string &name, OUT list<any> &out_list);
 
+		virtual ConfigSnapshotPtr GetSnapshot();
+
+		virtual ApiErrorCode Reload();
+
+		virtual void AddReloadHandler(IN ConfigurationReloadHandler handler);
+
 	protected:
 
-		const Value& QueryValue(IN const string &name, const Object &parent_object);
+		const ConfigValue &FindValue(IN ConfigSnapshotPtr snapshot, IN const string &name, IN ConfigValueType type, IN const char *type_name);
+
+		ApiErrorCode Compile(OUT ConfigSnapshotPtr &snapshot, OUT unsigned __int64 &write_time);
+
+		void Publish(IN ConfigSnapshotPtr snapshot);
+
+		static DWORD WINAPI WatcherThread(LPVOID lpParam);
 
 	private:
 
-		Value _rootValue;
+		string _fileName;
+
+		ConfigSnapshotPtr _current;
+
+		// guards _current only, held for the copy of the pointer
+		mutex _currentMutex;
+
+		typedef
+		list<ConfigurationReloadHandler> ReloadHandlersList;
+
+		ReloadHandlersList _reloadHandlers;
+
+		// serializes reloads and handlers registration
+		mutex _reloadMutex;
+
+		unsigned __int64 _writeTime;
+
+		DWORD _checkInterval;
+
+		HANDLE _watcherThread;
+
+		HANDLE _stopEvent;
 	};
 
 }
@@ -54,6 +54,13 @@ namespace ivrworx
 
 	}
 
+	CallLogContext::CallLogContext():
+	iwh(IW_UNDEFINED),
+	debug(FALSE)
+	{
+
+	}
+
 	RunningContext::RunningContext(
 		IN LpHandlePair pair,
 		IN const string &owner_name,
@@ -579,6 +586,30 @@ select_end:
 		FUNCTRACKER;
 	}
 
+	const CallLogContext &
+	RunningContext::LogContext() const
+	{
+		return _logContext;
+	}
+
+	void
+	RunningContext::LogContext(IN const CallLogContext &log_context)
+	{
+		_logContext = log_context;
+	}
+
+	BOOL
+	RunningContext::CallDebug() const
+	{
+		return _logContext.debug;
+	}
+
+	void
+	RunningContext::CallDebug(IN BOOL debug)
+	{
+		_logContext.debug = debug;
+	}
+
 
 	BOOL 
 	RunningContext::InboundPending()
@@ -637,6 +668,13 @@ select_end:
 		return  (iter == GetTlsProcMap()->end()) ? NULL : iter->second;
 	}
 
+	IW_CORE_API BOOL
+	IsCallDebugOn()
+	{
+		RunningContext *ctx = GetCurrRunningContext();
+		return ctx != NULL && ctx->CallDebug();
+	}
+
 	IW_CORE_API string 
 	GetCurrLpName()
 	{
@@ -73,6 +73,24 @@ private:
 	AnyMap _map;
 };
 
+// call a process works on, tells whether its debug messages are written
+struct IW_CORE_API CallLogContext
+{
+	CallLogContext();
+
+	// stack handle of the call, undefined in processes serving many calls
+	HandleId iwh;
+
+	string ani;
+
+	string dnis;
+
+	BOOL debug;
+
+	// processes which took the decision keep it, others follow their messages
+	BOOL Decided() const { return iwh != IW_UNDEFINED || !dnis.empty(); };
+};
+
 class IW_CORE_API RunningContext
 {
 public:
@@ -180,6 +198,17 @@ public:
 	virtual AppData *GetAppData();
 	virtual void SetAppData(AppData *data);
 
+	//
+	// Call Logging
+	//
+	const CallLogContext &LogContext() const;
+
+	void LogContext(IN const CallLogContext &log_context);
+
+	BOOL CallDebug() const;
+
+	void CallDebug(IN BOOL debug);
+
 	BucketPtr _bucket;
 
 protected:
@@ -202,6 +231,8 @@ protected:
 
 	 AppData *_appData;
 
+	 CallLogContext _logContext;
+
 private:
 
 	void Init(int UID, const string &owner_name);
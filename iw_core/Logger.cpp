@@ -20,6 +20,7 @@
 #include "StdAfx.h"
 #include "Logger.h"
 #include "syslog.h"
+#include "BinaryLogSink.h"
 
 using namespace boost;
 using namespace std;
@@ -36,6 +37,18 @@ namespace ivrworx
 
 	#define IW_MAX_MESSAGES_IN_QUEUE	1000
 
+	#define IW_DEFAULT_BINARY_LOG_SIZE_KB	16384
+
+	#define IW_DEFAULT_SYSLOG_BATCH_BYTES	8192
+	#define IW_DEFAULT_SYSLOG_BATCH_MS		200
+
+	// longest wait for the tcp syslog server to take the last batch
+	#define IW_SYSLOG_EXIT_TIMEOUT			2000
+
+	#define IW_LOGGER_IDLE_TIMEOUT			5000
+
+	#define IW_LOG_MASK_TEXT (IW_LOG_MASK_CONSOLE | IW_LOG_MASK_DEBUGVIEW | IW_LOG_MASK_SYSLOG | IW_LOG_MASK_FILE)
+
 
 	string 
 	FormatLastSysError(const char *lpszFunction) 
@@ -86,6 +99,22 @@ namespace ivrworx
 	HANDLE		g_loggerThread	= NULL;
 
 	IW_CORE_API extern LogLevel g_MaxLogLevel 	= LOG_LEVEL_INFO;
+
+	IW_CORE_API volatile LONG g_ModuleLogLevels[LOG_MODULE_COUNT] = 
+	{
+		LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO,
+		LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO
+	};
+
+	IW_CORE_API volatile LONG g_DebuggedCalls = 0;
+
+	// -1 means the module follows g_MaxLogLevel
+	LONG	 g_moduleLogOverrides[LOG_MODULE_COUNT] = {-1, -1, -1, -1, -1, -1, -1};
+
+	const char *g_logModuleNames[LOG_MODULE_COUNT] = 
+	{
+		"core", "ivr", "sip", "media", "mrcp", "rtsp", "sql"
+	};
 	DWORD	 g_logMask		= IW_LOG_MASK_CONSOLE;
 	BOOL	 g_LogSyncMode  = FALSE;
 
@@ -94,6 +123,11 @@ namespace ivrworx
 	BOOL g_override = TRUE;
 	FILE *g_file	= NULL;
 
+	BinaryLogSink g_binaryLog;
+
+	// how long syslog lines may wait for their batch
+	DWORD	g_syslogBatchMs = 0;
+
 	char	g_hostname[IW_MAX_FILE_NAME];
 
 // 	__declspec( thread ) debug_dostream *tls_logger = NULL;
@@ -194,8 +228,14 @@ namespace ivrworx
 
 		DWORD timestamp;
 
+		FILETIME filetime;
+
 		BOOL script_log;
 
+		const char *log_file;
+
+		int log_line;
+
 	};
 
 	DWORD WINAPI LoggerThread(LPVOID lpParam);
@@ -212,6 +252,37 @@ namespace ivrworx
 		StoreCoreData(SCRIPT_LOG_SLOT, (LPVOID)FALSE);
 	}
 	
+	static LogLevel
+	ParseLogLevel(const string &level_str);
+
+	static void
+	ApplyModuleLogLevels(IN Configuration &conf)
+	{
+		for (int module = 0; module < LOG_MODULE_COUNT; ++module)
+		{
+			string key = string("module_debug_levels/") + g_logModuleNames[module];
+			if (conf.HasOption(key))
+			{
+				SetModuleLogLevel((LogModule)module, ParseLogLevel(conf.GetString(key)));
+			}
+			else
+			{
+				ResetModuleLogLevel((LogModule)module);
+			}
+		}
+	}
+
+	static void
+	ReloadLogSettings(IN Configuration &conf)
+	{
+		if (conf.HasOption("debug_level"))
+		{
+			SetLogLevelFromString(conf.GetString("debug_level"));
+		}
+
+		ApplyModuleLogLevels(conf);
+	}
+
 	BOOL 
 	InitLog(ConfigurationPtr conf)
 	{
@@ -222,11 +293,39 @@ namespace ivrworx
 			g_hostname[0] = '\0';
 
 		SetLogLevelFromString(conf->GetString("debug_level"));
+		ApplyModuleLogLevels(*conf);
 		SetLogMaskFromString(conf->GetString("debug_outputs"));
 
 		g_LogSyncMode = conf->GetBool("sync_log");
 
-		openlog(conf->GetString("syslogd_host").c_str(),conf->GetInt("syslogd_port"),"ivrworx",0,LOG_USER );
+		// log level follows configuration reloads
+		conf->AddReloadHandler(&ReloadLogSettings);
+
+		// lines are batched by the logger thread, in sync mode
+		// there is none to send late batches
+		int syslog_batch_bytes = conf->HasOption("syslogd_batch_bytes") ? 
+			conf->GetInt("syslogd_batch_bytes") : IW_DEFAULT_SYSLOG_BATCH_BYTES;
+
+		g_syslogBatchMs = conf->HasOption("syslogd_batch_ms") ? 
+			conf->GetInt("syslogd_batch_ms") : IW_DEFAULT_SYSLOG_BATCH_MS;
+
+		if (g_LogSyncMode)
+		{
+			syslog_batch_bytes = 0;
+			g_syslogBatchMs = 0;
+		}
+
+		setlogbatch(syslog_batch_bytes, g_syslogBatchMs);
+
+		string syslog_protocol = conf->HasOption("syslogd_protocol") ? 
+			conf->GetString("syslogd_protocol") : "udp";
+
+		openlog(
+			conf->GetString("syslogd_host").c_str(),
+			conf->GetInt("syslogd_port"),
+			"ivrworx",
+			syslog_protocol == "tcp" ? LOG_TCP : 0,
+			LOG_USER );
 
 		// file preparation 
 		g_filename[0] = '\0';
@@ -238,6 +337,23 @@ namespace ivrworx
 			g_file = ::fopen(g_filename, (g_override ? "w" : "a"));
 		}
 
+		if (g_logMask & IW_LOG_MASK_BINARY)
+		{
+			string binary_filename = conf->HasOption("binary_log_file_name") ? 
+				conf->GetString("binary_log_file_name") : "iwlog.bin";
+
+			int binary_size_kb = conf->HasOption("binary_log_size_kb") ? 
+				conf->GetInt("binary_log_size_kb") : IW_DEFAULT_BINARY_LOG_SIZE_KB;
+
+			if (!g_binaryLog.Open(binary_filename.c_str(), binary_size_kb*1024))
+			{
+				string err = FormatLastSysError("BinaryLogSink::Open");
+				std::cerr << "Cannot open binary log " << binary_filename << " - " << err;
+
+				g_logMask &= ~IW_LOG_MASK_BINARY;
+			}
+		}
+
 		g_override = conf->GetBool("log_override");
 
 
@@ -353,6 +469,10 @@ error:
 			g_IocpLogger = NULL;
 		}
 
+		g_binaryLog.Close();
+
+		syslogdrain(IW_SYSLOG_EXIT_TIMEOUT);
+
 // 		if (g_file)
 // 		{
 // 			g_file = NULL;
@@ -361,8 +481,8 @@ error:
 
 	}
 
-	void
-	SetLogLevelFromString(const string &level_str)
+	static LogLevel
+	ParseLogLevel(const string &level_str)
 	{
 		LogLevel debugLevel = LOG_LEVEL_INFO;
 		if (level_str == "DBG")
@@ -390,9 +510,13 @@ error:
 			debugLevel = LOG_LEVEL_OFF;
 		};
 
-		SetLogLevel(debugLevel);
-
+		return debugLevel;
+	}
 
+	void
+	SetLogLevelFromString(const string &level_str)
+	{
+		SetLogLevel(ParseLogLevel(level_str));
 	}
 
 	void
@@ -424,6 +548,12 @@ error:
 			mask |= IW_LOG_MASK_FILE;
 		}
 
+		found = mask_str.find("binary");
+		if (found != string::npos)
+		{
+			mask |= IW_LOG_MASK_BINARY;
+		}
+
 		SetLogMask(mask);
 
 
@@ -472,6 +602,34 @@ error:
 
 	}
 
+	// called under g_loggerMutex
+	static void
+	UpdateModuleLogLevels()
+	{
+		LogLevel max_level = g_MaxLogLevel;
+		for (int module = 0; module < LOG_MODULE_COUNT; ++module)
+		{
+			LONG level = g_moduleLogOverrides[module] < 0 ? 
+				g_MaxLogLevel : g_moduleLogOverrides[module];
+
+			::InterlockedExchange(&g_ModuleLogLevels[module], level);
+
+			if (level > max_level)
+			{
+				max_level = (LogLevel)level;
+			}
+		}
+
+		if (g_DebuggedCalls > 0 && max_level < LOG_LEVEL_DEBUG)
+		{
+			max_level = LOG_LEVEL_DEBUG;
+		}
+
+		// syslog must pass messages of the most verbose module
+		// and of debugged calls
+		setlogmask(GetSyslogPri(max_level));
+	}
+
 	void
 	SetLogLevel(IN LogLevel log_level)
 	{
@@ -479,9 +637,43 @@ error:
 
 		g_MaxLogLevel = log_level;
 
-		setlogmask(GetSyslogPri(log_level));
+		UpdateModuleLogLevels();
+	}
 
-		
+	void
+	SetModuleLogLevel(IN LogModule module, IN LogLevel log_level)
+	{
+		mutex::scoped_lock scoped_lock(g_loggerMutex);
+
+		g_moduleLogOverrides[module] = log_level;
+
+		UpdateModuleLogLevels();
+	}
+
+	void
+	ResetModuleLogLevel(IN LogModule module)
+	{
+		mutex::scoped_lock scoped_lock(g_loggerMutex);
+
+		g_moduleLogOverrides[module] = -1;
+
+		UpdateModuleLogLevels();
+	}
+
+	void
+	GetSyslogCounters(OUT long &sent, OUT long &dropped, OUT long &batches)
+	{
+		syslogstats(&sent, &dropped, &batches);
+	}
+
+	void
+	SetDebuggedCallsCount(IN LONG count)
+	{
+		mutex::scoped_lock scoped_lock(g_loggerMutex);
+
+		::InterlockedExchange(&g_DebuggedCalls, count);
+
+		UpdateModuleLogLevels();
 	}
 
 	void 
@@ -493,6 +685,14 @@ error:
 	}
 
 	
+	basic_debugbuf::basic_debugbuf():
+	log_level(LOG_LEVEL_OFF),
+	log_file(NULL),
+	log_line(0)
+	{
+
+	}
+
 	basic_debugbuf::~basic_debugbuf()
 	{
 		sync();
@@ -513,6 +713,10 @@ error:
 		lb->timestamp  = ::GetTickCount();
 		lb->log_str	   = str();
 		lb->script_log = GetScriptLog();
+		lb->log_file   = log_file;
+		lb->log_line   = log_line;
+
+		::GetSystemTimeAsFileTime(&lb->filetime);
 
 		// Clear the string buffer
 		str(std::basic_string<char>());
@@ -620,6 +824,34 @@ error:
 	void 
 	LogBucketAndDelete(LogBucket *lb)
 	{
+		if (g_logMask & IW_LOG_MASK_BINARY)
+		{
+			// the stream always ends the message with a new line
+			size_t length = lb->log_str.length();
+			if (length > 0 && lb->log_str[length - 1] == '\n')
+			{
+				length--;
+			}
+
+			g_binaryLog.Write(
+				lb->log_level,
+				lb->script_log,
+				lb->log_file,
+				lb->log_line,
+				lb->thread_id,
+				lb->fiber_id,
+				lb->filetime,
+				lb->log_str.c_str(),
+				min(length, (size_t)IW_SINGLE_LOG_BUCKET_LENGTH));
+		}
+
+		// binary output alone needs no formatting
+		if ((g_logMask & IW_LOG_MASK_TEXT) == 0)
+		{
+			delete lb;
+			return;
+		}
+
 		char formatted_log_str[IW_SINGLE_LOG_BUCKET_LENGTH];
 		formatted_log_str[0] = '\0';
 
@@ -726,18 +958,24 @@ error:
 
 		while (true)
 		{
+			// wake up to send syslog batches which are not full,
+			// mask may change on configuration reload
+			DWORD timeout = (g_logMask & IW_LOG_MASK_SYSLOG) && g_syslogBatchMs > 0 ? 
+				g_syslogBatchMs : IW_LOGGER_IDLE_TIMEOUT;
+
 			BOOL res  = ::GetQueuedCompletionStatus(
 				g_IocpLogger,
 				&number_of_bytes,
 				&completion_key,
 				&olap,
-				5000
+				timeout
 				);
 
 			if (res == FALSE)
 			{
 				if (::GetLastError() == WAIT_TIMEOUT)
 				{
+					syslogpoll();
 					continue;
 				}
 
@@ -757,6 +995,8 @@ error:
 
 			::ReleaseSemaphore(g_queueSemaphore,1,NULL);
 
+			syslogpoll();
+
 			
 		}
 
@@ -765,30 +1005,19 @@ error:
 	}
 
 	
-	LoggerTracker::LoggerTracker(IN char *log_function)
+	void
+	LoggerTracker::Enter(IN const char *log_function)
 	{
-		if (::InterlockedExchangeAdd((LONG*)&g_MaxLogLevel,0) < LOG_LEVEL_TRACE)
-		{
-			_funcname[0] = '\0';
-			return;
-		}
-
-		strncpy_s(_funcname, 
-			log_function, 
-			MAX_LENGTH);
+		_funcname = log_function;
 
-		COND_LOG(LOG_LEVEL_TRACE,_funcname << " Enters -->")
+		// the level of the calling module was checked by the constructor
+		IX_SCOPED_LOG(LOG_LEVEL_TRACE,_funcname << " Enters -->");
 	}
 
-	LoggerTracker::~LoggerTracker()
+	void
+	LoggerTracker::Exit()
 	{
-		if (_funcname[0] == '\0')
-		{
-			return;
-		}
-
-		COND_LOG(LOG_LEVEL_TRACE,_funcname << " <-- Exits");
-
+		IX_SCOPED_LOG(LOG_LEVEL_TRACE,_funcname << " <-- Exits");
 	}
 
 	ostream& 
@@ -41,6 +41,7 @@ namespace ivrworx
 	#define IW_LOG_MASK_DEBUGVIEW	0x0010
 	#define IW_LOG_MASK_SYSLOG		0x0100
 	#define IW_LOG_MASK_FILE		0x1000
+	#define IW_LOG_MASK_BINARY		0x10000
 
 	void
 	SetLogMask(IN int mask);
@@ -57,12 +58,69 @@ namespace ivrworx
 
 	extern IW_CORE_API LogLevel g_MaxLogLevel;
 
+	// every module logs at its own level, which is debug_level
+	// unless module_debug_levels in configuration overrides it
+	enum LogModule
+	{
+		LOG_MODULE_CORE,
+		LOG_MODULE_IVR,
+		LOG_MODULE_SIP,
+		LOG_MODULE_MEDIA,
+		LOG_MODULE_MRCP,
+		LOG_MODULE_RTSP,
+		LOG_MODULE_SQL,
+		LOG_MODULE_COUNT
+	};
+
+	// each dll defines it in its stdafx.h before including this file
+	#ifndef IW_LOG_MODULE
+	#define IW_LOG_MODULE	LOG_MODULE_CORE
+	#endif
+
+	// messages above this level are removed at compile time
+	#ifndef IW_COMPILED_LOG_LEVEL
+	#define IW_COMPILED_LOG_LEVEL	LOG_LEVEL_TRACE
+	#endif
+
+	// written only when levels change, read without interlocking
+	extern IW_CORE_API volatile LONG g_ModuleLogLevels[LOG_MODULE_COUNT];
+
+	// calls whose debug messages are written regardless of module levels
+	extern IW_CORE_API volatile LONG g_DebuggedCalls;
+
+	// whether the current lightweight process works on such a call
+	IW_CORE_API BOOL
+	IsCallDebugOn();
+
+	// the per call check costs nothing while no call is debugged
+	#define IW_MODULE_LOG_ENABLED(module,level) \
+		((level) <= IW_COMPILED_LOG_LEVEL && \
+		(g_ModuleLogLevels[module] >= (level) || \
+		((level) == LOG_LEVEL_DEBUG && g_DebuggedCalls > 0 && IsCallDebugOn())))
+
+	#define IW_LOG_ENABLED(level) IW_MODULE_LOG_ENABLED(IW_LOG_MODULE,level)
+
 	void
 	SetLogLevelFromString(const string &level_str);
 
+	IW_CORE_API void
+	SetModuleLogLevel(IN LogModule module, IN LogLevel log_level);
+
+	// reverts the module to the global level
+	IW_CORE_API void
+	ResetModuleLogLevel(IN LogModule module);
+
+	// sinks have to pass debug messages while count is not zero
+	IW_CORE_API void
+	SetDebuggedCallsCount(IN LONG count);
+
 	void
 	SetLogMaskFromString(const string &mask_str);
 
+	// syslog lines sent and dropped, and batches sent since start
+	IW_CORE_API void
+	GetSyslogCounters(OUT long &sent, OUT long &dropped, OUT long &batches);
+
 	void
 	SetLogLevel(IN LogLevel log_level);
 
@@ -79,11 +137,17 @@ namespace ivrworx
 		public char_string_buf
 	{
 	public:
+		basic_debugbuf();
 		~basic_debugbuf();
 	protected:
 		int sync();
 	public:
 		LogLevel log_level;
+
+		// __FILE__ and __LINE__ of the log statement
+		const char *log_file;
+
+		int log_line;
 	};
 
 	typedef
@@ -101,18 +165,43 @@ namespace ivrworx
 			((basic_debugbuf*)rdbuf())->log_level = log_level;
 		}
 
+		inline void set_log_site(const char *log_file, int log_line)
+		{
+			((basic_debugbuf*)rdbuf())->log_file = log_file;
+			((basic_debugbuf*)rdbuf())->log_line = log_line;
+		}
+
 	};
 
 	extern __declspec( thread ) debug_dostream *tls_logger;
 
+	// costs one level check unless the module traces
 	class IW_CORE_API LoggerTracker
 	{
 	public:
-		LoggerTracker(char *log_function);
-		~LoggerTracker();
+		LoggerTracker(IN int module, IN const char *log_function):
+		_funcname(NULL)
+		{
+			if (IW_MODULE_LOG_ENABLED(module,LOG_LEVEL_TRACE))
+			{
+				Enter(log_function);
+			}
+		}
+
+		~LoggerTracker()
+		{
+			if (_funcname != NULL)
+			{
+				Exit();
+			}
+		}
+
 	private:
-		static const int MAX_LENGTH = 100; 
-		char _funcname[MAX_LENGTH];
+		void Enter(IN const char *log_function);
+		void Exit();
+
+		// __FUNCTION__ literal, NULL while not tracing
+		const char *_funcname;
 	};
 
 	#define __STR2WSTR(str)    L##str
@@ -128,6 +217,7 @@ namespace ivrworx
 	#define IX_SCOPED_LOG(level,x) {			\
 		debug_dostream *tls_logger = GetTlsLogger();\
 		(*tls_logger).set_log_level(level);		\
+		(*tls_logger).set_log_site(__FILE__,__LINE__);\
 		(*tls_logger) << x << std::endl;		\
 	}	
 
@@ -137,7 +227,8 @@ namespace ivrworx
 		#define LogProfile(x)
 	#endif
 
-	#define COND_LOG(level,x) if (::InterlockedExchangeAdd(( LONG *)&g_MaxLogLevel,0) >= level) IX_SCOPED_LOG(level,x)
+	// arguments are evaluated only after the level check passes
+	#define COND_LOG(level,x) if (IW_LOG_ENABLED(level)) IX_SCOPED_LOG(level,x)
 
 #ifndef NOLOGS
 	// hack to display script logging 
@@ -153,7 +244,7 @@ namespace ivrworx
 
 #ifdef TRACE_FUNC_CALLS
 	#define LogTrace(x)		COND_LOG(LOG_LEVEL_TRACE,x)
-	#define FUNCTRACKER LoggerTracker _ltTag(__FUNCTION__) 
+	#define FUNCTRACKER LoggerTracker _ltTag(IW_LOG_MODULE,__FUNCTION__) 
 #else 
 	#define LogTrace(x)		
 	#define FUNCTRACKER 
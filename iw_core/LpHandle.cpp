@@ -19,6 +19,7 @@
 
 #include "StdAfx.h"
 #include "LpHandle.h"
+#include "LightweightProcess.h"
 #include "Logger.h"
 #include "Profiler.h"
 #include "LocalProcessRegistrar.h"
@@ -217,6 +218,11 @@ namespace ivrworx
 			message->source.handle_id = GetCurrLpId();
 		};
 
+		if (g_DebuggedCalls > 0 && !message->call_debug)
+		{
+			message->call_debug = IsCallDebugOn();
+		}
+
 		try 
 		{
 			_channel.writer() << message;
@@ -232,9 +238,7 @@ namespace ivrworx
 			return API_FAILURE;
 		}
 
-		LpHandlePtr rsp_handle;
-		rsp_handle = GetHandle(message->source.handle_id);
-		LogDebug("snd " << message->message_id_str << " to (" << this << "), via (" << rsp_handle <<").");
+		LogDebug("snd " << message->message_id_str << " to (" << this << "), via (" << GetHandle(message->source.handle_id) <<").");
 		return API_SUCCESS;
 	}
 
@@ -297,8 +301,18 @@ namespace ivrworx
 			return NULL_MSG;
 		}
 
-		LpHandlePtr rsp_handle = GetHandle(ptr->source.handle_id);
-		LogDebug("rcv " << ptr->message_id_str << " to (" << this << "), via (" << rsp_handle <<").");
+		// processes serving many calls follow the call of the message
+		// until they read the next one or clear it once it is handled
+		if (g_DebuggedCalls > 0)
+		{
+			RunningContext *ctx = GetCurrRunningContext();
+			if (ctx != NULL && !ctx->LogContext().Decided())
+			{
+				ctx->CallDebug(ptr->call_debug);
+			}
+		}
+
+		LogDebug("rcv " << ptr->message_id_str << " to (" << this << "), via (" << GetHandle(ptr->source.handle_id) <<").");
 		return ptr;
 
 	}
@@ -55,7 +55,8 @@ namespace ivrworx
 	IwMessage::IwMessage (IN int message_id, IN const string &message_id_str):
 	transaction_id(-1),
 	is_response(FALSE),
-	preferrable_ipc_interface(IW_UNDEFINED)
+	preferrable_ipc_interface(IW_UNDEFINED),
+	call_debug(FALSE)
 	{
 		::QueryPerformanceCounter(&enter_queue_timestamp);
 		this->message_id = message_id;
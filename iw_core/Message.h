@@ -93,6 +93,9 @@ namespace ivrworx
 
 			TimeStamp enter_queue_timestamp;
 
+			// sent on behalf of a call logged at debug level
+			BOOL call_debug;
+
 			virtual ~IwMessage();
 
 		virtual void copy_data_on_response(IN IwMessage *request)
@@ -100,6 +103,7 @@ namespace ivrworx
 			transaction_id = request->transaction_id;
 			dest = request->source;
 			preferrable_ipc_interface = request->preferrable_ipc_interface;
+			call_debug = request->call_debug;
 		};
 
 	};
@@ -50,6 +50,28 @@ static int datagramm_size;
 static char g_syslog_hostname[ MAX_COMPUTERNAME_LENGTH + 1 ];
 static int  g_syslog_port;
 
+/* queued messages, udp messages are prefixed by their length and
+   tcp ones by the octet count framing
+ */
+#define SYSLOG_BATCH_SIZE (64*1024)
+
+/* longest wait for the tcp logger upon close */
+#define SYSLOG_CLOSE_TIMEOUT 2000
+
+static int syslog_option;
+static char batch[ SYSLOG_BATCH_SIZE ];
+static int batch_size;
+static int batch_sent;
+static int batch_count;
+static DWORD batch_time;
+static int batch_max_bytes;
+static DWORD batch_max_delay;
+static BOOL tcp_connected;
+static DWORD tcp_retry_time;
+static volatile LONG stat_sent;
+static volatile LONG stat_dropped;
+static volatile LONG stat_batches;
+
 /******************************************************************************
  * set_syslog_conf_dir
  *
@@ -92,6 +114,292 @@ use_default:
     sa_logger.sin_port = htons( SYSLOG_PORT );
 }
 
+/******************************************************************************
+ * tcp_connect
+ *
+ * Start non blocking connection to the logger.
+ * Returns: 0 - connected or connecting, -1 - error.
+ */
+static int tcp_connect( void )
+{
+    u_long nonblocking = 1;
+
+    tcp_connected = FALSE;
+    tcp_retry_time = GetTickCount();
+
+    sock = socket( AF_INET, SOCK_STREAM, 0 );
+    if( INVALID_SOCKET == sock )
+        return -1;
+
+    if( ioctlsocket( sock, FIONBIO, &nonblocking ) )
+        goto error;
+
+    if( connect( sock, (SOCKADDR*) &sa_logger, sizeof(SOCKADDR_IN) ) == 0 )
+        tcp_connected = TRUE;
+    else if( WSAGetLastError() != WSAEWOULDBLOCK )
+        goto error;
+
+    return 0;
+
+error:
+    closesocket( sock );
+    sock = INVALID_SOCKET;
+    return -1;
+}
+
+/******************************************************************************
+ * tcp_close
+ *
+ * Drop the connection, next send reconnects.
+ */
+static void tcp_close( void )
+{
+    if( sock != INVALID_SOCKET )
+        closesocket( sock );
+    sock = INVALID_SOCKET;
+    tcp_connected = FALSE;
+    tcp_retry_time = GetTickCount();
+}
+
+/******************************************************************************
+ * tcp_ready
+ *
+ * Check without blocking whether the connection is established,
+ * reconnect at most once a second if it was lost.
+ */
+static BOOL tcp_ready( void )
+{
+    fd_set wr, ex;
+    struct timeval tv = { 0, 0 };
+
+    if( tcp_connected )
+        return TRUE;
+
+    if( INVALID_SOCKET == sock )
+    {
+        if( GetTickCount() - tcp_retry_time < 1000 || tcp_connect() )
+            return FALSE;
+        if( tcp_connected )
+            return TRUE;
+    }
+
+    FD_ZERO( &wr );
+    FD_SET( sock, &wr );
+    FD_ZERO( &ex );
+    FD_SET( sock, &ex );
+    if( select( 0, NULL, &wr, &ex, &tv ) <= 0 )
+        return FALSE;
+
+    if( FD_ISSET( sock, &ex ) )
+    {
+        tcp_close();
+        return FALSE;
+    }
+
+    tcp_connected = TRUE;
+    return TRUE;
+}
+
+/******************************************************************************
+ * reset_batch
+ */
+static void reset_batch( void )
+{
+    batch_size = 0;
+    batch_sent = 0;
+    batch_count = 0;
+}
+
+/******************************************************************************
+ * syslogflush
+ *
+ * Send queued messages without blocking. Udp messages which cannot be
+ * sent are dropped, tcp ones wait for the connection unless the stream
+ * was broken in the middle of the batch.
+ */
+void syslogflush( void )
+{
+    char *p;
+    unsigned short len;
+    int n;
+
+    if( !initialized || batch_size == 0 )
+        return;
+
+    if( syslog_option & LOG_TCP )
+    {
+        if( !tcp_ready() )
+            return;
+
+        n = send( sock, batch + batch_sent, batch_size - batch_sent, 0 );
+        if( SOCKET_ERROR == n )
+        {
+            if( WSAGetLastError() == WSAEWOULDBLOCK )
+                return;
+
+            /* receiver cannot resync in the middle of a frame */
+            tcp_close();
+            InterlockedExchangeAdd( &stat_dropped, batch_count );
+            reset_batch();
+            return;
+        }
+
+        batch_sent += n;
+        if( batch_sent < batch_size )
+            return;
+
+        InterlockedExchangeAdd( &stat_sent, batch_count );
+    }
+    else
+    {
+        for( p = batch; p < batch + batch_size; p += len )
+        {
+            memcpy( &len, p, sizeof(len) );
+            p += sizeof(len);
+
+            if( sendto( sock, p, len, 0, (SOCKADDR*) &sa_logger, sizeof(SOCKADDR_IN) ) == SOCKET_ERROR )
+                InterlockedIncrement( &stat_dropped );
+            else
+                InterlockedIncrement( &stat_sent );
+        }
+    }
+
+    InterlockedIncrement( &stat_batches );
+    reset_batch();
+}
+
+/******************************************************************************
+ * syslogdrain
+ *
+ * Send queued messages waiting for the tcp connection to take them up to
+ * timeout_ms, count the messages which are still queued as dropped.
+ */
+void syslogdrain( int timeout_ms )
+{
+    DWORD start = GetTickCount();
+    DWORD elapsed;
+    fd_set wr, ex;
+    struct timeval tv;
+
+    if( !initialized )
+        return;
+
+    syslogflush();
+
+    while( batch_size > 0 && (syslog_option & LOG_TCP) )
+    {
+        elapsed = GetTickCount() - start;
+        if( elapsed >= (DWORD) timeout_ms )
+            break;
+
+        /* no point to wait a second before reconnecting */
+        if( INVALID_SOCKET == sock && tcp_connect() )
+            break;
+
+        FD_ZERO( &wr );
+        FD_SET( sock, &wr );
+        FD_ZERO( &ex );
+        FD_SET( sock, &ex );
+        tv.tv_sec = (timeout_ms - elapsed) / 1000;
+        tv.tv_usec = ((timeout_ms - elapsed) % 1000) * 1000;
+        if( select( 0, NULL, &wr, &ex, &tv ) <= 0 )
+            break;
+
+        syslogflush();
+
+        /* logger refused the connection */
+        if( INVALID_SOCKET == sock )
+            break;
+    }
+
+    if( batch_size > 0 )
+    {
+        InterlockedExchangeAdd( &stat_dropped, batch_count );
+        reset_batch();
+    }
+}
+
+/******************************************************************************
+ * syslogpoll
+ *
+ * Send queued messages if the oldest of them waited long enough.
+ */
+void syslogpoll( void )
+{
+    if( batch_size > 0 && GetTickCount() - batch_time >= batch_max_delay )
+        syslogflush();
+}
+
+/******************************************************************************
+ * setlogbatch
+ */
+void setlogbatch( int max_bytes, int max_delay_ms )
+{
+    batch_max_bytes = max_bytes > 0 ? max_bytes : 0;
+    batch_max_delay = max_delay_ms > 0 ? max_delay_ms : 0;
+}
+
+/******************************************************************************
+ * syslogstats
+ */
+void syslogstats( long *sent, long *dropped, long *batches )
+{
+    *sent = stat_sent;
+    *dropped = stat_dropped;
+    *batches = stat_batches;
+}
+
+/******************************************************************************
+ * enqueue
+ *
+ * Add a formatted message to the batch, drop it if the batch is full
+ * and cannot be sent.
+ */
+static void enqueue( const char *msg, int len )
+{
+    char frame[ 16 ];
+    int frame_len;
+    unsigned short short_len = (unsigned short) len;
+
+    if( syslog_option & LOG_TCP )
+        frame_len = sprintf( frame, "%d ", len );
+    else
+    {
+        memcpy( frame, &short_len, sizeof(short_len) );
+        frame_len = sizeof(short_len);
+    }
+
+    if( batch_size + frame_len + len > sizeof(batch) )
+    {
+        syslogflush();
+
+        /* keep only what the connection has not taken yet */
+        if( batch_sent > 0 )
+        {
+            memmove( batch, batch + batch_sent, batch_size - batch_sent );
+            batch_size -= batch_sent;
+            batch_sent = 0;
+        }
+
+        if( batch_size + frame_len + len > sizeof(batch) )
+        {
+            InterlockedIncrement( &stat_dropped );
+            return;
+        }
+    }
+
+    if( batch_size == 0 )
+        batch_time = GetTickCount();
+
+    memcpy( batch + batch_size, frame, frame_len );
+    memcpy( batch + batch_size + frame_len, msg, len );
+    batch_size += frame_len + len;
+    batch_count++;
+
+    if( batch_size >= batch_max_bytes )
+        syslogflush();
+}
+
 /******************************************************************************
  * closelog
  *
@@ -101,6 +409,7 @@ void closelog(void)
 {
     if( !initialized )
         return;
+    syslogdrain( SYSLOG_CLOSE_TIMEOUT );
     closesocket( sock );
     WSACleanup();
     initialized = FALSE;
@@ -118,12 +427,14 @@ void openlog( const char *syslog_host, int port, char* ident, int option, int fa
     SOCKADDR_IN sa_local;
     DWORD n;
     int size;
+    u_long nonblocking = 1;
 
     if( initialized )
         return;
 
 	strcpy(g_syslog_hostname,syslog_host);
 	g_syslog_port = port;
+	syslog_option = option;
 
     syslog_facility = facility? facility : LOG_USER;
 
@@ -147,27 +458,43 @@ void openlog( const char *syslog_host, int port, char* ident, int option, int fa
 
     init_logger_addr(syslog_host,port);
 
-    for( n = 0;; n++ )
+    reset_batch();
+
+    if( option & LOG_TCP )
     {
-        sock = socket( AF_INET, SOCK_DGRAM, 0 );
-        if( INVALID_SOCKET == sock )
+        /* logger being down is not an error, connecting is retried on send */
+        tcp_connect();
+
+        datagramm_size = sizeof(datagramm);
+    }
+    else
+    {
+        for( n = 0;; n++ )
+        {
+            sock = socket( AF_INET, SOCK_DGRAM, 0 );
+            if( INVALID_SOCKET == sock )
+                goto done;
+
+            memset( &sa_local, 0, sizeof(SOCKADDR_IN) );
+            sa_local.sin_family = AF_INET;
+            if( bind( sock, (SOCKADDR*) &sa_local, sizeof(SOCKADDR_IN) ) == 0 )
+                break;
+            closesocket( sock );
+            sock = INVALID_SOCKET;
+            if( n == 100 )
+                goto done;
+            Sleep(0);
+        }
+
+        /* sends must never stall the logger thread */
+        if( ioctlsocket( sock, FIONBIO, &nonblocking ) )
             goto done;
 
-        memset( &sa_local, 0, sizeof(SOCKADDR_IN) );
-        sa_local.sin_family = AF_INET;
-        if( bind( sock, (SOCKADDR*) &sa_local, sizeof(SOCKADDR_IN) ) == 0 )
-            break;
-        closesocket( sock );
-        sock = INVALID_SOCKET;
-        if( n == 100 )
+        /* get size of datagramm */
+        size = sizeof(datagramm_size);
+        if( getsockopt( sock, SOL_SOCKET, SO_MAX_MSG_SIZE, (char*) &datagramm_size, &size ) )
             goto done;
-        Sleep(0);
     }
-
-    /* get size of datagramm */
-    size = sizeof(datagramm_size);
-    if( getsockopt( sock, SOL_SOCKET, SO_MAX_MSG_SIZE, (char*) &datagramm_size, &size ) )
-        goto done;
     if( datagramm_size - strlen(local_hostname) - (ident? strlen(ident) : 0) < 64 )
         goto done;
     if( datagramm_size > sizeof(datagramm) )
@@ -233,7 +560,7 @@ void vsyslog( int pri, char* fmt, va_list ap )
     if( !(LOG_MASK( LOG_PRI( pri )) & log_mask) )
         return;
 
-    openlog(g_syslog_hostname,g_syslog_port, NULL, 0, pri & LOG_FACMASK );
+    openlog(g_syslog_hostname,g_syslog_port, NULL, syslog_option, pri & LOG_FACMASK );
     if( !initialized )
         return;
 
@@ -253,7 +580,7 @@ void vsyslog( int pri, char* fmt, va_list ap )
     if( p )
         *p = 0;
 
-    sendto( sock, datagramm, strlen(datagramm), 0, (SOCKADDR*) &sa_logger, sizeof(SOCKADDR_IN) );
+    enqueue( datagramm, strlen(datagramm) );
 	
 }
 #pragma warning (pop)
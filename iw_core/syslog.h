@@ -159,6 +159,7 @@ CODE facilitynames[] =
 #define	LOG_NDELAY	0x08	/* don't delay open */
 #define	LOG_NOWAIT	0x10	/* don't wait for console forks: DEPRECATED */
 #define	LOG_PERROR	0x20	/* log to stderr as well */
+#define	LOG_TCP		0x40	/* send over tcp with octet counting framing (RFC 6587) */
 
 #define SYSLOG_PORT     514
 
@@ -188,6 +189,33 @@ extern void vsyslog (int __pri, char *__fmt, va_list __ap);
 */
 extern const char* set_syslog_conf_dir( const char* dir );
 
+/* windows-specific;
+   messages are queued and sent once max_bytes are pending or the oldest
+   of them waited max_delay_ms, both 0 send every message at once
+*/
+extern void setlogbatch (int max_bytes, int max_delay_ms);
+
+/* windows-specific;
+   sends the queued messages if the batch delay has expired
+*/
+extern void syslogpoll (void);
+
+/* windows-specific;
+   sends the queued messages
+*/
+extern void syslogflush (void);
+
+/* windows-specific;
+   sends the queued messages waiting up to timeout_ms for the tcp
+   connection, the messages still queued then are counted as dropped
+*/
+extern void syslogdrain (int timeout_ms);
+
+/* windows-specific;
+   messages sent and dropped since openlog, and batches sent
+*/
+extern void syslogstats (long *sent, long *dropped, long *batches);
+
 
 #ifdef __cplusplus
 }
@@ -97,6 +97,42 @@ BOOL GetTableStringParam(lua_State *L, BOOL tableIndex, string &value, char *nam
 
 };
 
+BOOL GetTableStringListParam(lua_State *L, int tableIndex, list<string> &values, char *name)
+{
+	CLuaRestoreStack l(L);
+
+	if (name == NULL || !lua_istable(L,tableIndex))
+	{
+		return FALSE;
+	}
+
+	lua_pushstring(L, name);
+	lua_gettable(L, tableIndex - 1);
+
+	if (!lua_istable(L,-1))
+	{
+		return FALSE;
+	}
+
+	// array part only, keeps the order
+	size_t len = lua_objlen(L,-1);
+	for (size_t i = 1; i <= len; i++)
+	{
+		lua_rawgeti(L, -1, (int)i);
+		if (lua_isstring(L,-1) == FALSE)
+		{
+			values.clear();
+			return FALSE;
+		}
+
+		values.push_back(lua_tostring(L,-1));
+		lua_pop(L,1);
+	}
+
+	return TRUE;
+
+};
+
 BOOL FillTable(lua_State *L, int tableIndex, OUT MapOfAny &valuesmap)
 {
 	if (L == NULL || !lua_istable(L,tableIndex))
@@ -138,6 +138,8 @@ BOOL GetTableBoolParam(lua_State *L, int tableIndex, bool *value, char *name, bo
 
 BOOL GetTableStringParam(lua_State *L, BOOL tableIndex, string &value, char *name, const string &defaultValue = "");
 
+BOOL GetTableStringListParam(lua_State *L, int tableIndex, list<string> &values, char *name);
+
 BOOL FillTable(lua_State *L, int tableIndex, OUT MapOfAny &valuesmap);
 
 }
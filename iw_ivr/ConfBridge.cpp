@@ -37,10 +37,24 @@ namespace ivrworx
 	}
 
 	ConfBridge::ConfBridge(ConfigurationPtr conf):
-	_conf(conf)
+	_conf(conf),
+	_snapshot(conf->GetSnapshot())
 	{
 	}
 
+	const ConfigValue *
+	ConfBridge::FindValue(const char *name, size_t name_length, ConfigValueType type)
+	{
+		const ConfigValue *value = _snapshot->Find(name, name_length);
+		if (value == NULL || value->type != type)
+		{
+			LogWarn("ConfBridge - " << name << " does not exist or has other type");
+			return NULL;
+		}
+
+		return value;
+	}
+
 	ConfBridge::~ConfBridge(void)
 	{
 	}
@@ -58,6 +72,15 @@ namespace ivrworx
 		size_t string_length = 0;
 		const char *log_string = lua_tolstring(L, -1, &string_length);
 
+		if (_snapshot)
+		{
+			const ConfigValue *conf_value = 
+				FindValue(log_string, string_length, CONF_TYPE_STRING);
+
+			lua_pushstring(L, conf_value ? conf_value->str_value.c_str() : "");
+			return 1;
+		}
+
 		string value;
 		try
 		{
@@ -86,6 +109,15 @@ namespace ivrworx
 		size_t string_length = 0;
 		const char *log_string = lua_tolstring(L, -1, &string_length);
 
+		if (_snapshot)
+		{
+			const ConfigValue *conf_value = 
+				FindValue(log_string, string_length, CONF_TYPE_BOOL);
+
+			lua_pushboolean(L, conf_value ? conf_value->bool_value : FALSE);
+			return 1;
+		}
+
 		BOOL value = FALSE;
 		try
 		{
@@ -115,7 +147,16 @@ namespace ivrworx
 		const char *log_string = lua_tolstring(L, -1, &string_length);
 
 
-		string value;
+		if (_snapshot)
+		{
+			const ConfigValue *conf_value = 
+				FindValue(log_string, string_length, CONF_TYPE_INT);
+
+			lua_pushnumber(L, conf_value ? conf_value->int_value : 0);
+			return 1;
+		}
+
+		int value = 0;
 		try
 		{
 			value = _conf->GetInt(log_string);
@@ -125,7 +166,7 @@ namespace ivrworx
 			LogWarn("ConfBridge::getint e:" << e->what());
 		}
 
-		lua_pushstring(L, value.c_str());
+		lua_pushnumber(L, value);
 		return 1;
 
 	}
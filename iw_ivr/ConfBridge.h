@@ -42,6 +42,13 @@ namespace ivrworx
 		static Luna<ConfBridge>::RegType methods[];
 
 		ConfigurationPtr _conf;
+
+		// scalar lookups are served from it when available
+		ConfigSnapshotPtr _snapshot;
+
+	private:
+
+		const ConfigValue *FindValue(const char *name, size_t name_length, ConfigValueType type);
 	};
 
 
@@ -18,6 +18,7 @@
 */
 #include "StdAfx.h"
 #include "LoggerBridge.h"
+#include "BridgeMacros.h"
 
 namespace ivrworx
 {
@@ -28,6 +29,8 @@ namespace ivrworx
 		method(LoggerBridge, logwarn),
 		method(LoggerBridge, logcrit),
 		method(LoggerBridge, logdebug),
+		method(LoggerBridge, benchmark),
+		method(LoggerBridge, syslogstats),
 		{0,0}
 	};
 
@@ -68,9 +71,88 @@ namespace ivrworx
 
 	};
 
+	static volatile int g_benchEvaluations = 0;
+
+	// stands for a log argument that is costly to compute
+	static const string &
+	BenchArgument(IN const string &value)
+	{
+		g_benchEvaluations++;
+		return value;
+	}
+
+	static void
+	BenchTrackedCall(IN volatile int &calls)
+	{
+		LoggerTracker tracker(IW_LOG_MODULE, __FUNCTION__);
+		calls++;
+	}
+
+	static double
+	ElapsedNs(IN const LARGE_INTEGER &start, IN int rounds)
+	{
+		LARGE_INTEGER end, frequency;
+		::QueryPerformanceCounter(&end);
+		::QueryPerformanceFrequency(&frequency);
+
+		return ((double)(end.QuadPart - start.QuadPart)*1000000000.0)/
+			((double)frequency.QuadPart*rounds);
+	}
+
+	int
+	LoggerBridge::benchmark(lua_State *L)
+	{
+		int rounds = 0;
+		GetTableNumberParam<int>(L,-1,&rounds,"rounds",1000000);
+		if (rounds <= 0)
+		{
+			return 0;
+		}
+
+		string argument("benchmark argument");
+		g_benchEvaluations = 0;
+
+		LARGE_INTEGER start;
+		::QueryPerformanceCounter(&start);
+		for (int i = 0; i < rounds; ++i)
+		{
+			LogDebug("benchmark " << i << " " << BenchArgument(argument));
+		}
+		double debug_ns = ElapsedNs(start, rounds);
+
+		volatile int calls = 0;
+		::QueryPerformanceCounter(&start);
+		for (int i = 0; i < rounds; ++i)
+		{
+			BenchTrackedCall(calls);
+		}
+		double tracker_ns = ElapsedNs(start, rounds);
+
+		lua_pushnumber(L, debug_ns);
+		lua_pushnumber(L, tracker_ns);
+		lua_pushnumber(L, g_benchEvaluations);
+		return 3;
+	}
+
+	int
+	LoggerBridge::syslogstats(lua_State *L)
+	{
+		long sent = 0, dropped = 0, batches = 0;
+		GetSyslogCounters(sent, dropped, batches);
+
+		lua_pushnumber(L, sent);
+		lua_pushnumber(L, dropped);
+		lua_pushnumber(L, batches);
+		return 3;
+	}
+
 	void
 	LoggerBridge::LuaLog(LogLevel log_level, lua_State *state)
 	{
+		if (!IW_LOG_ENABLED(log_level))
+		{
+			return;
+		}
 
 		if (lua_isstring(state, -1) != 1 )
 		{
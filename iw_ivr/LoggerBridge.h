@@ -35,6 +35,13 @@ namespace ivrworx
 		int logcrit(lua_State *L);
 		int logdebug(lua_State *L);
 
+		// ns per LogDebug and per traced call at the current levels,
+		// and how many times LogDebug arguments were evaluated
+		int benchmark(lua_State *L);
+
+		// syslog lines sent and dropped, and batches sent
+		int syslogstats(lua_State *L);
+
 		void LuaLog(LogLevel level, lua_State *state);
 
 		static const char className[];
@@ -0,0 +1,205 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "LuaArena.h"
+
+#define IW_ARENA_PAGE_SIZE		(64*1024)
+
+#define IW_ARENA_MAX_SMALL		(IW_ARENA_GRANULARITY*IW_ARENA_SIZE_CLASSES)
+
+namespace ivrworx
+{
+	LuaArena::LuaArena(IN size_t limit):
+	_cursor(NULL),
+	_left(0),
+	_limit(limit),
+	_inUse(0),
+	_peak(0),
+	_reserved(0)
+	{
+		::memset(_freeLists, 0, sizeof(_freeLists));
+	}
+
+	LuaArena::~LuaArena()
+	{
+		for (vector<char *>::iterator iter = _pages.begin();
+			iter != _pages.end(); ++iter)
+		{
+			::free(*iter);
+		}
+	}
+
+	int
+	LuaArena::SizeClass(IN size_t size)
+	{
+		return (int)((size + IW_ARENA_GRANULARITY - 1)/IW_ARENA_GRANULARITY) - 1;
+	}
+
+	void *
+	LuaArena::Allocate(IN size_t size, IN BOOL enforce_limit)
+	{
+		if (size > IW_ARENA_MAX_SMALL)
+		{
+			if (enforce_limit && _limit != 0 && _inUse + size > _limit)
+			{
+				return NULL;
+			}
+
+			void *ptr = ::malloc(size);
+			if (ptr != NULL)
+			{
+				_inUse += size;
+				_reserved += size;
+			}
+			return ptr;
+		}
+
+		int size_class = SizeClass(size);
+		size_t block_size = (size_class + 1)*IW_ARENA_GRANULARITY;
+
+		if (enforce_limit && _limit != 0 && _inUse + block_size > _limit)
+		{
+			return NULL;
+		}
+
+		void *ptr = NULL;
+		if (_freeLists[size_class] != NULL)
+		{
+			FreeBlock *block = _freeLists[size_class];
+			_freeLists[size_class] = block->next;
+			ptr = block;
+		}
+		else
+		{
+			// the tail of the previous page is left unused
+			if (_left < block_size)
+			{
+				char *page = (char *)::malloc(IW_ARENA_PAGE_SIZE);
+				if (page == NULL)
+				{
+					return NULL;
+				}
+
+				_pages.push_back(page);
+				_reserved += IW_ARENA_PAGE_SIZE;
+
+				_cursor = page;
+				_left = IW_ARENA_PAGE_SIZE;
+			}
+
+			ptr = _cursor;
+			_cursor += block_size;
+			_left -= block_size;
+		}
+
+		_inUse += block_size;
+
+		return ptr;
+	}
+
+	void
+	LuaArena::Free(IN void *ptr, IN size_t size)
+	{
+		if (size > IW_ARENA_MAX_SMALL)
+		{
+			::free(ptr);
+			_inUse -= size;
+			_reserved -= size;
+			return;
+		}
+
+		int size_class = SizeClass(size);
+
+		FreeBlock *block = (FreeBlock *)ptr;
+		block->next = _freeLists[size_class];
+		_freeLists[size_class] = block;
+
+		_inUse -= (size_class + 1)*IW_ARENA_GRANULARITY;
+	}
+
+	void *
+	LuaArena::Reallocate(IN void *ptr, IN size_t osize, IN size_t nsize)
+	{
+		if (osize > IW_ARENA_MAX_SMALL && nsize > IW_ARENA_MAX_SMALL)
+		{
+			if (_limit != 0 && nsize > osize && _inUse + nsize - osize > _limit)
+			{
+				return NULL;
+			}
+
+			void *new_ptr = ::realloc(ptr, nsize);
+			if (new_ptr != NULL)
+			{
+				_inUse += nsize - osize;
+				_reserved += nsize - osize;
+			}
+			return new_ptr;
+		}
+
+		if (osize <= IW_ARENA_MAX_SMALL && nsize <= IW_ARENA_MAX_SMALL &&
+			SizeClass(osize) == SizeClass(nsize))
+		{
+			return ptr;
+		}
+
+		// lua expects shrinking to succeed, so it is never refused by the limit
+		void *new_ptr = Allocate(nsize, nsize > osize);
+		if (new_ptr == NULL)
+		{
+			return NULL;
+		}
+
+		::memcpy(new_ptr, ptr, osize < nsize ? osize : nsize);
+		Free(ptr, osize);
+
+		return new_ptr;
+	}
+
+	void *
+	LuaArena::Alloc(IN void *ud, IN void *ptr, IN size_t osize, IN size_t nsize)
+	{
+		LuaArena *arena = (LuaArena *)ud;
+
+		void *res = NULL;
+		if (nsize == 0)
+		{
+			if (ptr != NULL)
+			{
+				arena->Free(ptr, osize);
+			}
+		}
+		else if (ptr == NULL)
+		{
+			res = arena->Allocate(nsize, TRUE);
+		}
+		else
+		{
+			res = arena->Reallocate(ptr, osize, nsize);
+		}
+
+		if (arena->_inUse > arena->_peak)
+		{
+			arena->_peak = arena->_inUse;
+		}
+
+		return res;
+	}
+
+}
@@ -0,0 +1,95 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+// small blocks are rounded up to multiples of 16 bytes up to 512 bytes
+#define IW_ARENA_GRANULARITY	16
+#define IW_ARENA_SIZE_CLASSES	32
+
+namespace ivrworx
+{
+	/**
+
+	Lua allocator serving a single call VM. Small blocks are carved from
+	arena pages and recycled through per size class free lists, larger
+	ones go to the heap. Pages are released all at once when the VM is
+	closed, so short lived call VMs neither contend on the shared heap
+	nor fragment it. Not thread safe, the VM is used by its call only.
+
+	**/
+	class LuaArena:
+		public boost::noncopyable
+	{
+	public:
+
+		// limit of 0 means unlimited
+		LuaArena(
+			IN size_t limit);
+
+		virtual ~LuaArena();
+
+		// lua_Alloc, ud is the arena
+		static void *Alloc(
+			IN void *ud,
+			IN void *ptr,
+			IN size_t osize,
+			IN size_t nsize);
+
+		size_t InUse() const { return _inUse; };
+
+		size_t Peak() const { return _peak; };
+
+		size_t Reserved() const { return _reserved; };
+
+	private:
+
+		struct FreeBlock
+		{
+			FreeBlock *next;
+		};
+
+		static int SizeClass(IN size_t size);
+
+		void *Allocate(IN size_t size, IN BOOL enforce_limit);
+
+		void Free(IN void *ptr, IN size_t size);
+
+		void *Reallocate(IN void *ptr, IN size_t osize, IN size_t nsize);
+
+		FreeBlock *_freeLists[IW_ARENA_SIZE_CLASSES];
+
+		vector<char *> _pages;
+
+		char *_cursor;
+
+		size_t _left;
+
+		size_t _limit;
+
+		size_t _inUse;
+
+		size_t _peak;
+
+		// pages and large blocks taken from the heap
+		size_t _reserved;
+
+	};
+
+}
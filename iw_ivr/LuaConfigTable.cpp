@@ -0,0 +1,180 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "LuaConfigTable.h"
+
+namespace ivrworx
+{
+	int
+	LuaConfigTable::Lookup(IN lua_State *L)
+	{
+		// cache table and key
+		if (lua_type(L, 2) != LUA_TSTRING)
+		{
+			return 0;
+		}
+
+		SnapshotHolder *holder =
+			(SnapshotHolder *)lua_touserdata(L, lua_upvalueindex(1));
+
+		size_t key_length = 0;
+		const char *key = lua_tolstring(L, 2, &key_length);
+
+		const ConfigValue *value = holder->snapshot->Find(key, key_length);
+		if (value == NULL)
+		{
+			return 0;
+		}
+
+		switch (value->type)
+		{
+		case CONF_TYPE_STRING:
+			{
+				lua_pushlstring(L, value->str_value.c_str(), value->str_value.size());
+				break;
+			}
+		case CONF_TYPE_INT:
+			{
+				lua_pushnumber(L, value->int_value);
+				break;
+			}
+		case CONF_TYPE_REAL:
+			{
+				lua_pushnumber(L, value->real_value);
+				break;
+			}
+		case CONF_TYPE_BOOL:
+			{
+				lua_pushboolean(L, value->bool_value);
+				break;
+			}
+		case CONF_TYPE_ARRAY:
+			{
+				lua_createtable(L, (int)value->array_value.size(), 0);
+
+				int index = 1;
+				for (ListOfAny::const_iterator iter = value->array_value.begin();
+					iter != value->array_value.end(); ++iter)
+				{
+					const any &element = *iter;
+					if (typeid(string) == element.type())
+					{
+						lua_pushstring(L, any_cast<string>(element).c_str());
+					}
+					else if (typeid(int) == element.type())
+					{
+						lua_pushnumber(L, any_cast<int>(element));
+					}
+					else if (typeid(double) == element.type())
+					{
+						lua_pushnumber(L, any_cast<double>(element));
+					}
+					else if (typeid(bool) == element.type())
+					{
+						lua_pushboolean(L, any_cast<bool>(element));
+					}
+					else
+					{
+						continue;
+					}
+
+					lua_rawseti(L, -2, index++);
+				}
+				break;
+			}
+		default:
+			{
+				return 0;
+			}
+		}
+
+		// next reads of the key do not reach the snapshot
+		lua_pushvalue(L, 2);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, 1);
+
+		return 1;
+	}
+
+	int
+	LuaConfigTable::ReadOnly(IN lua_State *L)
+	{
+		return luaL_error(L, "ivrworx.config is read only");
+	}
+
+	int
+	LuaConfigTable::CollectHolder(IN lua_State *L)
+	{
+		SnapshotHolder *holder = (SnapshotHolder *)lua_touserdata(L, 1);
+		holder->~SnapshotHolder();
+
+		return 0;
+	}
+
+	void
+	LuaConfigTable::Install(
+		IN lua_State *L,
+		IN int table_ref,
+		IN ConfigSnapshotPtr snapshot)
+	{
+		FUNCTRACKER;
+
+		if (!snapshot)
+		{
+			return;
+		}
+
+		lua_rawgeti(L, LUA_REGISTRYINDEX, table_ref);
+
+		// scripts see an empty proxy, its metatable cannot be
+		// reached or replaced and writes to it are refused
+		lua_newtable(L);
+		lua_newtable(L);
+
+		// values already read by this VM
+		lua_newtable(L);
+		lua_newtable(L);
+
+		// keeps the snapshot alive as long as the VM uses it
+		void *holder_mem = lua_newuserdata(L, sizeof(SnapshotHolder));
+		SnapshotHolder *holder = new (holder_mem) SnapshotHolder();
+		holder->snapshot = snapshot;
+
+		lua_newtable(L);
+		lua_pushcfunction(L, &LuaConfigTable::CollectHolder);
+		lua_setfield(L, -2, "__gc");
+		lua_setmetatable(L, -2);
+
+		lua_pushcclosure(L, &LuaConfigTable::Lookup, 1);
+		lua_setfield(L, -2, "__index");
+		lua_setmetatable(L, -2);
+
+		lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, &LuaConfigTable::ReadOnly);
+		lua_setfield(L, -2, "__newindex");
+		lua_pushboolean(L, 0);
+		lua_setfield(L, -2, "__metatable");
+		lua_setmetatable(L, -2);
+
+		lua_setfield(L, -2, "config");
+		lua_pop(L, 1);
+	}
+
+}
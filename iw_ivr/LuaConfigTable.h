@@ -0,0 +1,63 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	/**
+
+	Read only view of the configuration snapshot for scripts, published
+	as ivrworx.config and keyed by the full option path. The snapshot
+	itself is shared by all VMs, every VM only caches the values its
+	script has already read, so a repeated lookup is a plain table hit
+	and a first one is a single probe of the snapshot. Objects and
+	missing options read as nil, arrays as tables indexed from 1.
+
+	@code
+	port = ivrworx.config["ivr/sip_port"]
+	@endcode
+
+	**/
+	class LuaConfigTable
+	{
+	public:
+
+		// does nothing if snapshot is empty
+		static void Install(
+			IN lua_State *L,
+			IN int table_ref,
+			IN ConfigSnapshotPtr snapshot);
+
+	private:
+
+		struct SnapshotHolder
+		{
+			ConfigSnapshotPtr snapshot;
+		};
+
+		static int Lookup(IN lua_State *L);
+
+		static int ReadOnly(IN lua_State *L);
+
+		static int CollectHolder(IN lua_State *L);
+
+	};
+
+}
@@ -17,6 +17,19 @@
 
 using namespace ivrworx;
 
+// instructions between count hooks while the budget is enforced
+#define IW_BUDGET_HOOK_COUNT  1000
+
+// registry key of the debugger owning the VM
+static char g_debuggerKey;
+
+static __int64 QueryTicks (void)
+{
+   LARGE_INTEGER ticks;
+   ::QueryPerformanceCounter (&ticks);
+   return ticks.QuadPart;
+}
+
 // typedef void (*lua_Hook) (lua_State *L, lua_Debug *ar);
 static void LuaHookCall (lua_State *lua)
 {
@@ -55,6 +68,14 @@ static void LuaHookLine (lua_State *lua)
 
 static void LuaHookCount (lua_State *lua)
 {
+   CLuaDebugger *dbg = CLuaDebugger::FromState (lua);
+
+   if (dbg != NULL)
+   {
+      dbg->OnCount (lua);
+      return;
+   }
+
    LuaHookLine (lua);
 }
 
@@ -79,7 +100,10 @@ static void LuaHook (lua_State *lua, lua_Debug *ar)
    }
 }
 
-CLuaDebugger::CLuaDebugger (CLuaVirtualMachine& vm) : m_iCountMask (10), m_vm (vm)
+CLuaDebugger::CLuaDebugger (CLuaVirtualMachine& vm) : m_iCountMask (10), m_vm (vm), 
+   m_fBudget (false), m_iSliceInstructions (0), m_iSliceTicks (0), m_iCpuLimitTicks (0), 
+   m_iInstructionLimit (0), m_iFrequency (1), m_iLastTick (0), m_iBlockingStart (0), 
+   m_iBlockingDepth (0), m_iSliceStart (0), m_iSliceCount (0), m_iCpuTicks (0), m_iInstructions (0), m_iPreemptions (0)
 {
    // Clear all current hooks
    if (vm.Ok ())
@@ -95,6 +119,120 @@ CLuaDebugger::~CLuaDebugger (void)
    if (m_vm.Ok ())
    {
       lua_sethook ((lua_State *) m_vm, LuaHook, 0, m_iCountMask);
+
+      if (m_fBudget)
+      {
+         lua_pushlightuserdata ((lua_State *) m_vm, &g_debuggerKey);
+         lua_pushnil ((lua_State *) m_vm);
+         lua_rawset ((lua_State *) m_vm, LUA_REGISTRYINDEX);
+      }
+   }
+}
+
+void CLuaDebugger::SetBudget (int iSliceInstructions, int iSliceMs, int iCpuLimitMs, __int64 iInstructionLimit)
+{
+   if (!m_vm.Ok ())
+   {
+      return;
+   }
+
+   LARGE_INTEGER frequency;
+   ::QueryPerformanceFrequency (&frequency);
+
+   m_iFrequency = frequency.QuadPart;
+   m_iSliceInstructions = iSliceInstructions;
+   m_iSliceTicks = (__int64) iSliceMs * m_iFrequency / 1000;
+   m_iCpuLimitTicks = (__int64) iCpuLimitMs * m_iFrequency / 1000;
+   m_iInstructionLimit = iInstructionLimit;
+   m_iLastTick = QueryTicks ();
+   m_iSliceStart = m_iLastTick;
+   m_fBudget = true;
+
+   lua_State *lua = (lua_State *) m_vm;
+
+   lua_pushlightuserdata (lua, &g_debuggerKey);
+   lua_pushlightuserdata (lua, this);
+   lua_rawset (lua, LUA_REGISTRYINDEX);
+
+   m_iCountMask = IW_BUDGET_HOOK_COUNT;
+   lua_sethook (lua, LuaHook, LUA_MASKCOUNT, m_iCountMask);
+}
+
+CLuaDebugger *CLuaDebugger::FromState (lua_State *lua)
+{
+   // coroutines of the script share its registry
+   lua_pushlightuserdata (lua, &g_debuggerKey);
+   lua_rawget (lua, LUA_REGISTRYINDEX);
+   CLuaDebugger *dbg = (CLuaDebugger *) lua_touserdata (lua, -1);
+   lua_pop (lua, 1);
+
+   return dbg;
+}
+
+void CLuaDebugger::OnBlockingEnter (void)
+{
+   if (m_iBlockingDepth++ > 0)
+   {
+      return;
+   }
+
+   __int64 now = QueryTicks ();
+
+   m_iCpuTicks += now - m_iLastTick;
+   m_iBlockingStart = now;
+   m_iLastTick = now;
+}
+
+void CLuaDebugger::OnBlockingLeave (void)
+{
+   if (m_iBlockingDepth == 0 || --m_iBlockingDepth > 0)
+   {
+      return;
+   }
+
+   __int64 now = QueryTicks ();
+
+   // the slice measures the time the script runs only
+   m_iSliceStart += now - m_iBlockingStart;
+   m_iLastTick = now;
+}
+
+void CLuaDebugger::OnCount (lua_State *lua)
+{
+   if (m_iBlockingDepth > 0)
+   {
+      // lua error raised in the bridge call skipped its leave, 
+      // or the bridge calls back into the script
+      m_iBlockingDepth = 1;
+      OnBlockingLeave ();
+   }
+
+   __int64 now = QueryTicks ();
+
+   m_iInstructions += m_iCountMask;
+   m_iCpuTicks += now - m_iLastTick;
+
+   m_iSliceCount += m_iCountMask;
+   m_iLastTick = now;
+
+   if ((m_iCpuLimitTicks != 0 && m_iCpuTicks > m_iCpuLimitTicks) ||
+       (m_iInstructionLimit != 0 && m_iInstructions > m_iInstructionLimit))
+   {
+      luaL_error (lua, "script aborted, over its budget cpu:%d ms instructions:%d", 
+         (int) CpuMs (), (int) m_iInstructions);
+      return;
+   }
+
+   if ((m_iSliceInstructions != 0 && m_iSliceCount >= m_iSliceInstructions) ||
+       (m_iSliceTicks != 0 && now - m_iSliceStart >= m_iSliceTicks))
+   {
+      // let the other scripts of this kernel thread run
+      m_iPreemptions++;
+      csp::CPPCSP_Yield ();
+
+      m_iLastTick = QueryTicks ();
+      m_iSliceStart = m_iLastTick;
+      m_iSliceCount = 0;
    }
 }
 
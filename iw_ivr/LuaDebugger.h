@@ -38,9 +38,72 @@ public:
 
    void ErrorRun (int iErrorCode);
 
+   // Preempts the script every iSliceInstructions instructions or iSliceMs 
+   // of continuous run, so it does not starve the other scripts of its 
+   // kernel thread. Aborts it once it runs over iCpuLimitMs or 
+   // iInstructionLimit. 0 means no limit.
+   void SetBudget (int iSliceInstructions, int iSliceMs, int iCpuLimitMs, __int64 iInstructionLimit);
+
+   // Called from the count hook
+   void OnCount (lua_State *lua);
+
+   // Called around the bridge calls which may block the script
+   void OnBlockingEnter (void);
+   void OnBlockingLeave (void);
+
+   // NULL if no budget is enforced on the VM of the state
+   static CLuaDebugger *FromState (lua_State *lua);
+
+   // CPU time is the time the script ran between count hooks 
+   // less the time it spent in blocking bridge calls
+   __int64 CpuMs (void) { return m_iCpuTicks * 1000 / m_iFrequency; }
+   __int64 Instructions (void) { return m_iInstructions; }
+   int Preemptions (void) { return m_iPreemptions; }
+
 protected:
    int m_iCountMask;
    CLuaVirtualMachine& m_vm;
+
+   // budget state
+   bool m_fBudget;
+   __int64 m_iSliceInstructions;
+   __int64 m_iSliceTicks;
+   __int64 m_iCpuLimitTicks;
+   __int64 m_iInstructionLimit;
+   __int64 m_iFrequency;
+   __int64 m_iLastTick;
+   __int64 m_iBlockingStart;
+   int m_iBlockingDepth;
+   __int64 m_iSliceStart;
+   __int64 m_iSliceCount;
+   __int64 m_iCpuTicks;
+   __int64 m_iInstructions;
+   int m_iPreemptions;
+};
+
+// Marks a bridge call which may block the script, so the time it waits
+// there counts neither as its CPU time nor against its slice
+class CLuaBlockingCall
+{
+public:
+   CLuaBlockingCall (lua_State *lua) : m_pDebugger (CLuaDebugger::FromState (lua))
+   {
+      if (m_pDebugger != NULL)
+      {
+         m_pDebugger->OnBlockingEnter ();
+      }
+   }
+
+   ~CLuaBlockingCall (void)
+   {
+      if (m_pDebugger != NULL)
+      {
+         m_pDebugger->OnBlockingLeave ();
+      }
+   }
+
+private:
+   CLuaDebugger *m_pDebugger;
 };
 
 
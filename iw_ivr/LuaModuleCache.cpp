@@ -0,0 +1,283 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "LuaModuleCache.h"
+#include "LuaUtils.h"
+
+// report hit rate every 100 lookups
+#define IW_MODULE_CACHE_STATS_INTERVAL		100
+
+#define IW_DEFAULT_MODULE_CHECK_INTERVAL	1000
+
+namespace ivrworx
+{
+	LuaModuleCache::LuaModuleCache(IN DWORD check_interval):
+	_checkInterval(check_interval),
+	_hits(0),
+	_compiles(0),
+	_reloads(0)
+	{
+		FUNCTRACKER;
+	}
+
+	LuaModuleCache::~LuaModuleCache()
+	{
+		FUNCTRACKER;
+	}
+
+	BOOL
+	LuaModuleCache::GetFileStamp(
+		IN const string &file_name,
+		OUT unsigned __int64 &write_time,
+		OUT unsigned __int64 &size)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attrs;
+		if (::GetFileAttributesExA(file_name.c_str(), GetFileExInfoStandard, &attrs) == FALSE ||
+			(attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			return FALSE;
+		}
+
+		write_time =
+			((unsigned __int64)attrs.ftLastWriteTime.dwHighDateTime << 32) |
+			attrs.ftLastWriteTime.dwLowDateTime;
+
+		size =
+			((unsigned __int64)attrs.nFileSizeHigh << 32) |
+			attrs.nFileSizeLow;
+
+		return TRUE;
+	}
+
+	ApiErrorCode
+	LuaModuleCache::GetChunk(IN const string &file_name, OUT LuaChunkPtr &chunk)
+	{
+		DWORD now = ::GetTickCount();
+
+		{
+			mutex::scoped_lock lock(_mutex);
+
+			LuaModulesMap::iterator iter = _modules.find(file_name);
+			if (iter != _modules.end() &&
+				now - iter->second.checked < _checkInterval)
+			{
+				_hits++;
+				chunk = iter->second.chunk;
+				return API_SUCCESS;
+			}
+		}
+
+		unsigned __int64 write_time = 0;
+		unsigned __int64 size = 0;
+		if (GetFileStamp(file_name, write_time, size) == FALSE)
+		{
+			return API_FAILURE;
+		}
+
+		mutex::scoped_lock lock(_mutex);
+
+		LuaModulesMap::iterator iter = _modules.find(file_name);
+		if (iter != _modules.end() &&
+			iter->second.write_time == write_time &&
+			iter->second.size == size)
+		{
+			_hits++;
+			iter->second.checked = now;
+			chunk = iter->second.chunk;
+			return API_SUCCESS;
+		}
+
+		// compiled under lock, so concurrent calls
+		// do not compile the same new version twice
+		char *buffer = NULL;
+		size_t buffer_size = 0;
+		ApiErrorCode res = LuaUtils::Precompile(file_name, &buffer, &buffer_size);
+		if (IW_FAILURE(res))
+		{
+			LogWarn("LuaModuleCache::GetChunk - cannot compile " << file_name << ", res:" << res);
+			return res;
+		}
+
+		LuaModuleEntry entry;
+		entry.chunk = LuaChunkPtr(new string(buffer, buffer_size));
+		entry.write_time = write_time;
+		entry.size = size;
+		entry.checked = now;
+
+		::free(buffer);
+
+		if (iter != _modules.end())
+		{
+			_reloads++;
+			LogInfo("LuaModuleCache::GetChunk - reloaded " << file_name);
+		}
+
+		_compiles++;
+		_modules[file_name] = entry;
+
+		chunk = entry.chunk;
+
+		if ((_hits + _compiles) % IW_MODULE_CACHE_STATS_INTERVAL == 0)
+		{
+			LogStats();
+		}
+
+		return API_SUCCESS;
+	}
+
+	int
+	LuaModuleCache::CachedLoader(IN lua_State *L)
+	{
+		LuaModuleCache *cache =
+			(LuaModuleCache *)lua_touserdata(L, lua_upvalueindex(1));
+
+		string name = luaL_checkstring(L, 1);
+		for (string::iterator iter = name.begin(); iter != name.end(); ++iter)
+		{
+			if (*iter == '.')
+			{
+				*iter = LUA_DIRSEP[0];
+			}
+		}
+
+		lua_getglobal(L, "package");
+		lua_getfield(L, -1, "path");
+		string path = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+		lua_pop(L, 2);
+
+		// same search as the standard file loader,
+		// but the chunk comes from the cache
+		size_t start = 0;
+		while (start <= path.size())
+		{
+			size_t end = path.find(LUA_PATHSEP[0], start);
+			if (end == string::npos)
+			{
+				end = path.size();
+			}
+
+			string file_name = path.substr(start, end - start);
+			start = end + 1;
+
+			if (file_name.empty())
+			{
+				continue;
+			}
+
+			size_t mark = 0;
+			while ((mark = file_name.find(LUA_PATH_MARK[0], mark)) != string::npos)
+			{
+				file_name.replace(mark, 1, name);
+				mark += name.size();
+			}
+
+			LuaChunkPtr chunk;
+			if (IW_FAILURE(cache->GetChunk(file_name, chunk)))
+			{
+				continue;
+			}
+
+			string chunk_name = "@" + file_name;
+			if (luaL_loadbuffer(L, chunk->c_str(), chunk->size(), chunk_name.c_str()) != 0)
+			{
+				return luaL_error(L, "error loading module " LUA_QS " from cache " LUA_QS ":\n\t%s",
+					lua_tostring(L, 1), file_name.c_str(), lua_tostring(L, -1));
+			}
+
+			return 1;
+		}
+
+		lua_pushfstring(L, "\n\tno cached module " LUA_QS, lua_tostring(L, 1));
+		return 1;
+	}
+
+	void
+	LuaModuleCache::Install(IN lua_State *L)
+	{
+		FUNCTRACKER;
+
+		lua_getglobal(L, "package");
+		if (!lua_istable(L, -1))
+		{
+			lua_pop(L, 1);
+			return;
+		}
+
+		lua_getfield(L, -1, "loaders");
+		if (!lua_istable(L, -1))
+		{
+			lua_pop(L, 2);
+			return;
+		}
+
+		// right after the preload loader, ahead of the file loaders
+		int count = (int)lua_objlen(L, -1);
+		for (int i = count; i >= 2; --i)
+		{
+			lua_rawgeti(L, -1, i);
+			lua_rawseti(L, -2, i + 1);
+		}
+
+		lua_pushlightuserdata(L, this);
+		lua_pushcclosure(L, &LuaModuleCache::CachedLoader, 1);
+		lua_rawseti(L, -2, 2);
+
+		lua_pop(L, 2);
+	}
+
+	void
+	LuaModuleCache::LogStats()
+	{
+		unsigned long lookups = _hits + _compiles;
+
+		LogInfo("Lua module cache - modules:" << _modules.size()
+			<< ", hits:"		<< _hits
+			<< ", compiles:"	<< _compiles
+			<< ", hit rate:"	<< (lookups ? (_hits*100)/lookups : 0) << "%"
+			<< ", reloads:"		<< _reloads);
+	}
+
+	static mutex g_moduleCacheMutex;
+
+	static LuaModuleCachePtr g_moduleCache;
+
+	LuaModuleCachePtr
+	GetLuaModuleCache(IN ConfigurationPtr conf)
+	{
+		if (conf->HasOption("ivr/module_cache") && !conf->GetBool("ivr/module_cache"))
+		{
+			return LuaModuleCachePtr();
+		}
+
+		mutex::scoped_lock lock(g_moduleCacheMutex);
+
+		if (!g_moduleCache)
+		{
+			int check_interval = conf->HasOption("ivr/module_check_interval") ?
+				conf->GetInt("ivr/module_check_interval") : IW_DEFAULT_MODULE_CHECK_INTERVAL;
+
+			g_moduleCache = LuaModuleCachePtr(new LuaModuleCache(
+				check_interval > 0 ? check_interval : 0));
+		}
+
+		return g_moduleCache;
+	}
+
+}
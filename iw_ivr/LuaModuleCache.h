@@ -0,0 +1,102 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	// immutable precompiled chunk, shared by all VMs loading it
+	typedef
+	shared_ptr<const string> LuaChunkPtr;
+
+	/**
+
+	Process wide cache of precompiled Lua chunks. The script file and every
+	module loaded with require are compiled once and served to the VMs of
+	the following calls from memory. A file is recompiled when its last
+	write time or size changes, checked at most once per ivr/module_check_interval
+	milliseconds, so a new version takes effect on the next call without
+	restart. Calls in progress keep running the version they have loaded.
+
+	**/
+	class LuaModuleCache:
+		public boost::noncopyable
+	{
+	public:
+
+		LuaModuleCache(
+			IN DWORD check_interval);
+
+		virtual ~LuaModuleCache();
+
+		ApiErrorCode GetChunk(
+			IN const string &file_name,
+			OUT LuaChunkPtr &chunk);
+
+		// hooks package.loaders of the VM, so require is served from the cache
+		void Install(
+			IN lua_State *L);
+
+		void LogStats();
+
+	private:
+
+		struct LuaModuleEntry
+		{
+			LuaChunkPtr chunk;
+
+			unsigned __int64 write_time;
+
+			unsigned __int64 size;
+
+			DWORD checked;
+		};
+
+		typedef
+		map<string, LuaModuleEntry> LuaModulesMap;
+
+		static BOOL GetFileStamp(
+			IN const string &file_name,
+			OUT unsigned __int64 &write_time,
+			OUT unsigned __int64 &size);
+
+		static int CachedLoader(
+			IN lua_State *L);
+
+		mutex _mutex;
+
+		DWORD _checkInterval;
+
+		LuaModulesMap _modules;
+
+		unsigned long _hits;
+
+		unsigned long _compiles;
+
+		unsigned long _reloads;
+
+	};
+
+	typedef
+	shared_ptr<LuaModuleCache> LuaModuleCachePtr;
+
+	// NULL if ivr/module_cache is disabled
+	LuaModuleCachePtr GetLuaModuleCache(IN ConfigurationPtr conf);
+
+}
@@ -29,6 +29,9 @@
 #include "LuaTable.h"
 #include "MrcpBridge.h"
 #include "RtspBridge.h"
+#include "SqlBridge.h"
+#include "SdpBridge.h"
+#include "LuaConfigTable.h"
 
 namespace ivrworx
 {
@@ -122,16 +125,24 @@ namespace ivrworx
 		Luna<ConfBridge>::RegisterType(L,LUA_RT_ALLOW_GC);
 		Luna<ConfBridge>::RegisterObject(L,new ConfBridge(ctx->_conf),ivrworxTable.TableRef(),"CONF");
 
+		//
+		// ivrworx.config
+		//
+		LuaConfigTable::Install(L,ivrworxTable.TableRef(),ctx->_conf->GetSnapshot());
+
 		
 
 
 		
 		Luna<rtpproxy>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateRtpProxy);
+		Luna<rtpconference>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateRtpConference);
 		Luna<sipcall>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateSip);
 		Luna<streamer>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateStreamer);
 		Luna<mrcpsession>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateMrcp);
 		Luna<rtspsession>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateRtspSession);
 		Luna<selector>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateSelector);
+		Luna<sqlsession>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateSqlSession);
+		Luna<sdpdesc>::RegisterType(L,LUA_RT_ALLOW_ALL,&LuaCreateSdp);
 
 
 	
@@ -162,6 +173,40 @@ namespace ivrworx
 	}
 
 	
+	int
+	LuaCreateSqlSession(lua_State *L)
+	{
+		HandleId service_handle_id = IW_UNDEFINED;
+		if (IW_FAILURE(GetConfiguredServiceHandle(service_handle_id, "ivr/sql_service", CTX_FIELD(_conf))))
+		{
+			return 0;
+		}
+
+		SqliteSessionPtr sql_ptr(new SqliteSession(service_handle_id));
+
+		Luna<sqlsession>::PushObject(L, new sqlsession(sql_ptr));
+
+		return 1;
+	}
+
+	int
+	LuaCreateSdp(lua_State *L)
+	{
+		string sdp;
+		GetTableStringParam(L,-1,sdp,"sdp");
+
+		sdpdesc *desc = new sdpdesc();
+		if (desc->Parse(sdp.c_str(), sdp.size()) == FALSE)
+		{
+			delete desc;
+			return 0;
+		}
+
+		Luna<sdpdesc>::PushObject(L, desc);
+
+		return 1;
+	}
+
 	int
 	LuaCreateSip(lua_State *L)
 	{
@@ -196,6 +241,23 @@ namespace ivrworx
 		return 1;
 	}
 
+	int
+	LuaCreateRtpConference(lua_State *L)
+	{
+		HandleId service_handle_id = IW_UNDEFINED;
+		if (IW_FAILURE(GetConfiguredServiceHandle(service_handle_id, "ivr/rtpproxy_service",  CTX_FIELD(_conf))))
+		{
+			return 0;
+		}
+
+		RtpConferenceSessionPtr conference_ptr =
+			RtpConferenceSessionPtr(new RtpConferenceSession(service_handle_id));
+
+		Luna<rtpconference>::PushObject(L, new rtpconference(conference_ptr));
+
+		return 1;
+	}
+
 	int
 	LuaCreateRtspSession(lua_State *L)
 	{
@@ -249,6 +311,8 @@ namespace ivrworx
 
 		LogDebug("IwScript::LuaWait - Wait for " << time_to_sleep);
 
+		CLuaBlockingCall blocking(state);
+
 	#pragma warning (suppress:4244)
 		csp::SleepFor(MilliSeconds(time_to_sleep));
 		lua_pushnumber (state, API_SUCCESS);
@@ -263,6 +327,8 @@ namespace ivrworx
 
 		DECLARE_NAMED_HANDLE_PAIR(runner_pair);
 		int err = 0;
+
+		CLuaBlockingCall blocking(state);
 		csp::Run(new ProcBlockingOperationRunner(runner_pair,state,err));
 
 		err ? lua_pushnumber (state, API_FAILURE): lua_pushnumber (state, API_SUCCESS);
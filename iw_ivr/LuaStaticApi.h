@@ -50,10 +50,16 @@ namespace ivrworx
 
 	int LuaCreateRtpProxy(lua_State *L);
 
+	int LuaCreateRtpConference(lua_State *L);
+
 	int LuaCreateStreamer( lua_State *L);
 
 	int LuaCreateRtspSession(lua_State *L);
 
 	int LuaCreateSelector(lua_State *L);
+
+	int LuaCreateSqlSession(lua_State *L);
+
+	int LuaCreateSdp(lua_State *L);
 }
 
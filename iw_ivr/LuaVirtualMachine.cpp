@@ -71,7 +71,7 @@ static int printMessage (lua_State *lua)
 // None.
 //
 //============================================================================
-CLuaVirtualMachine::CLuaVirtualMachine (void) : m_pState (NULL), m_pDbg (NULL)
+CLuaVirtualMachine::CLuaVirtualMachine (void) : m_pState (NULL), m_pDbg (NULL), m_pArena (NULL)
 {
    m_fIsOk = false;
 }
@@ -92,10 +92,7 @@ CLuaVirtualMachine::CLuaVirtualMachine (void) : m_pState (NULL), m_pDbg (NULL)
 //============================================================================
 CLuaVirtualMachine::~CLuaVirtualMachine (void)
 {
-   if (m_pState != NULL)
-   {
-      lua_close (m_pState);
-   }
+   DestroyVM ();
 }
 
 //============================================================================
@@ -119,23 +116,25 @@ void CLuaVirtualMachine::Panic (lua_State *lua)
 //============================================================================
 // bool CLuaVirtualMachine::InitialiseVM
 //---------------------------------------------------------------------------
-// Initialises the VM, open lua, makes sure things are OK
+// Initialises the VM, open lua, makes sure things are OK. The VM allocates
+// from its own arena, released at once when the VM is destroyed
 //
-// Parameter   Dir      Description
-// ---------   ---      -----------
-// None.
+// Parameter    Dir      Description
+// ---------    ---      -----------
+// szArenaLimit IN       Max bytes the VM may allocate, 0 for unlimited
 //
 // Return
 // ------
 // Success.
 //
 //============================================================================
-bool CLuaVirtualMachine::InitialiseVM (void)
+bool CLuaVirtualMachine::InitialiseVM (size_t szArenaLimit /* = 0 */)
 {
    // Open Lua!
    if (Ok ()) DestroyVM ();
 
-   m_pState = lua_open ();
+   m_pArena = new LuaArena (szArenaLimit);
+   m_pState = lua_newstate (LuaArena::Alloc, m_pArena);
 
    if (m_pState) 
    {
@@ -187,6 +186,13 @@ bool CLuaVirtualMachine::DestroyVM (void)
       m_pState = NULL;
       m_fIsOk = false;
    }
+
+   // all pages at once, after lua_close has run the finalizers
+   if (m_pArena)
+   {
+      delete m_pArena;
+      m_pArena = NULL;
+   }
    return true;
 }
 
@@ -16,6 +16,7 @@
 
 //#include "lualib/luainc.h"
 #include "luadebugger.h"
+#include "LuaArena.h"
 
 
 using namespace ivrworx;
@@ -28,7 +29,8 @@ public:
    CLuaVirtualMachine (void);
    virtual ~CLuaVirtualMachine (void);
 
-   bool InitialiseVM (void);
+   // szArenaLimit of 0 means the arena is unlimited
+   bool InitialiseVM (size_t szArenaLimit = 0);
    bool DestroyVM (void);
 
    // Load and run script elements
@@ -50,10 +52,15 @@ public:
    // For debugging
    void AttachDebugger (CLuaDebugger *dbg) { m_pDbg = dbg; }
 
+   // Memory taken by the VM
+   size_t MemoryInUse (void) { return m_pArena ? m_pArena->InUse () : 0; }
+   size_t PeakMemory (void) { return m_pArena ? m_pArena->Peak () : 0; }
+
 protected:
    lua_State *m_pState;
    bool m_fIsOk;
    CLuaDebugger *m_pDbg;
+   LuaArena *m_pArena;
 };
 
 
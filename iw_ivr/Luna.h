@@ -1,5 +1,6 @@
 #pragma once
 #include "LuaObject.h"
+#include "LuaDebugger.h"
 
 #define method(class, name) {#name, &class::name}
 
@@ -159,6 +160,8 @@ private:
 		lua_remove(L, 1);  // remove self so member function args start at index 1
 		// get member function from upvalue
 		RegType *l = static_cast<RegType*>(lua_touserdata(L, lua_upvalueindex(1)));
+		// bridge methods may wait for their service
+		CLuaBlockingCall blocking(L);
 		return (obj->*(l->mfunc))(L);  // call member function
 	}
 
@@ -1,6 +1,8 @@
 #include "StdAfx.h"
 #include "MrcpBridge.h"
 #include "BridgeMacros.h"
+#include "LuaStaticApi.h"
+#include "TtsCache.h"
 
 namespace ivrworx
 {
@@ -9,6 +11,7 @@ namespace ivrworx
 		method(mrcpsession, allocate),
 		method(mrcpsession, stopspeak),
 		method(mrcpsession, speak),
+		method(mrcpsession, cachedprompt),
 		method(mrcpsession, teardown),
 		method(mrcpsession, localoffer),
 		method(mrcpsession, remoteoffer),
@@ -195,20 +198,10 @@ namespace ivrworx
 
 	}
 
-	int 
-	mrcpsession::speak(lua_State *L)
+	BOOL
+	mrcpsession::GetSpeakBody(lua_State *L, OUT MrcpParams &p, OUT string &body)
 	{
-		FUNCTRACKER;
-
-		if (!_mrcpSession)
-		{
-			lua_pushnumber (L, API_WRONG_STATE);
-			return 1;
-		}
-
-		bool sync = false;
 		string sentence;
-		GetTableBoolParam(L,-1,&sync,"sync",false);
 		GetTableStringParam(L,-1,sentence,"sentence");
 
 		string rawbody;
@@ -216,15 +209,11 @@ namespace ivrworx
 
 		if (sentence.empty() && rawbody.empty())
 		{
-			lua_pushnumber (L, API_WRONG_PARAMETER);
-			return 1;
+			return FALSE;
 		}
 
-		MrcpParams p;
 		FillTable(L,-1,p);
 
-
-		
 		stringstream mrcp_body;
 		if (!sentence.empty())
 		{
@@ -240,10 +229,89 @@ namespace ivrworx
 		{
 			mrcp_body << rawbody;
 		}
-		
 
+		body = mrcp_body.str();
+		return TRUE;
+	}
+
+	//
+	// Returns file name of the synthesized prompt if it is cached,
+	// otherwise returns nil and captures the prompt in background 
+	// so the next call may play it with the streamer.
+	//
+	int 
+	mrcpsession::cachedprompt(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		TtsCachePtr cache = GetTtsCache(CTX_FIELD(_conf));
+		if (!cache)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		MrcpParams p;
+		string mrcp_body;
+		if (!GetSpeakBody(L,p,mrcp_body))
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		string voice;
+		GetTableStringParam(L,-1,voice,"voice_param");
+
+		string language;
+		GetTableStringParam(L,-1,language,"speech_language");
+
+		string prosody;
+		GetTableStringParam(L,-1,prosody,"prosody_param");
+
+		string codec = CTX_FIELD(_conf)->HasOption("ivr/tts_cache_codec") ? 
+			CTX_FIELD(_conf)->GetString("ivr/tts_cache_codec") : "PCMU";
+
+		string key = TtsCache::MakeKey(mrcp_body, voice + "|" + language + "|" + prosody, codec);
+
+		string file_name;
+		if (cache->Lookup(key,file_name))
+		{
+			lua_pushstring(L, file_name.c_str());
+			return 1;
+		}
+
+		if (cache->BeginCapture(key))
+		{
+			cache->StartCapture(CTX_FIELD(_conf), key, p, mrcp_body);
+		}
+
+		lua_pushnil(L);
+		return 1;
+	}
+
+	int 
+	mrcpsession::speak(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_mrcpSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		bool sync = false;
+		GetTableBoolParam(L,-1,&sync,"sync",false);
+
+		MrcpParams p;
+		string mrcp_body;
+		if (!GetSpeakBody(L,p,mrcp_body))
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
 
-		ApiErrorCode res =_mrcpSession->Speak(p,mrcp_body.str(),sync);
+		ApiErrorCode res =_mrcpSession->Speak(p,mrcp_body,sync);
 
 		lua_pushnumber (L, res);
 		return 1;
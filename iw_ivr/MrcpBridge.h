@@ -37,6 +37,7 @@ namespace ivrworx
 		int allocate(lua_State *L);
 		int stopspeak(lua_State *L);
 		int speak(lua_State *L);
+		int cachedprompt(lua_State *L);
 		int teardown(lua_State *L);
 		int localoffer(lua_State *L);
 		int remoteoffer(lua_State *L);
@@ -50,6 +51,8 @@ namespace ivrworx
 		static Luna<mrcpsession>::RegType methods[];
 
 	private:
+		BOOL GetSpeakBody(lua_State *L, OUT MrcpParams &p, OUT string &body);
+
 		MrcpSessionPtr _mrcpSession;
 	};
 
@@ -23,6 +23,7 @@
 #include "LocalProcessRegistrar.h"
 #include "ProcHandleWaiter.h"
 #include "LuaUtils.h"
+#include "TtsCache.h"
 
 
 
@@ -255,6 +256,8 @@ ProcIvr::real_run()
 
 	END_FORKING_REGION;
 
+	ReleaseTtsCache();
+
 	if (event != NULL_MSG && 
 		event->message_id == MSG_PROC_SHUTDOWN_REQ)
 	{
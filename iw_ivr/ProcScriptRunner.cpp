@@ -26,6 +26,7 @@
 #include "RTPProxyBridge.h"
 #include "LuaRestoreStack.h"
 #include "StreamerBridge.h"
+#include "LuaModuleCache.h"
 
 
 
@@ -81,7 +82,17 @@ namespace ivrworx
 		FUNCTRACKER;
 
 		bool res = false;
-		if (_precompiledBuffer!=NULL)
+
+		// the cached chunk follows script file changes, 
+		// so it wins over the buffer precompiled at startup
+		LuaModuleCachePtr module_cache = GetLuaModuleCache(_conf);
+		LuaChunkPtr chunk;
+		if (module_cache && 
+			IW_SUCCESS(module_cache->GetChunk(_scriptName, chunk)))
+		{
+			res = script.CompileBuffer((unsigned char*)chunk->c_str(), chunk->size());
+		}
+		else if (_precompiledBuffer!=NULL)
 		{
 			res = script.CompileBuffer((unsigned char*)_precompiledBuffer,_bufferSize);
 		} 
@@ -110,8 +121,11 @@ namespace ivrworx
 			_ctx._forking = &forking;
 			_ctx._conf    = _conf;
 
+			int arena_limit_kb = _conf->HasOption("ivr/lua_arena_limit_kb") ? 
+				_conf->GetInt("ivr/lua_arena_limit_kb") : 0;
+
 			CLuaVirtualMachine vm;
-			vm.InitialiseVM();
+			vm.InitialiseVM(arena_limit_kb > 0 ? arena_limit_kb*1024 : 0);
 
 			if (vm.Ok() == false)
 			{
@@ -120,11 +134,23 @@ namespace ivrworx
 			}
 
 			CLuaDebugger debugger(vm);
+			debugger.SetBudget(
+				_conf->HasOption("ivr/script_slice_instructions") ? _conf->GetInt("ivr/script_slice_instructions") : 100000,
+				_conf->HasOption("ivr/script_slice_ms") ? _conf->GetInt("ivr/script_slice_ms") : 10,
+				_conf->HasOption("ivr/script_cpu_limit_ms") ? _conf->GetInt("ivr/script_cpu_limit_ms") : 0,
+				_conf->HasOption("ivr/script_instruction_limit") ? _conf->GetInt("ivr/script_instruction_limit") : 0);
+
 			LuaTable ivrworx_table(vm);
 			ivrworx_table.Create("ivrworx");
 
 			InitStaticTypes(vm,ivrworx_table,&_ctx);
 
+			LuaModuleCachePtr module_cache = GetLuaModuleCache(_conf);
+			if (module_cache)
+			{
+				module_cache->Install(vm);
+			}
+
 
 			_forking = &forking;
 
@@ -174,6 +200,11 @@ namespace ivrworx
 
 			}
 
+			LogInfo("script:" << _scriptName << ", iwh:" << iwh << " peak memory:" << vm.PeakMemory() << " bytes" 
+				<< ", cpu:" << debugger.CpuMs() << " ms"
+				<< ", instructions:" << debugger.Instructions() 
+				<< ", preemptions:" << debugger.Preemptions());
+
 			
 			END_FORKING_REGION
 			_forking = NULL;
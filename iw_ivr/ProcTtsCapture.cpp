@@ -0,0 +1,239 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "ProcTtsCapture.h"
+
+// recorder file is closed asynchronously after streamer teardown
+#define IW_TTS_CAPTURE_COMMIT_RETRIES	50
+
+#define IW_TTS_CAPTURE_COMMIT_WAIT		100
+
+#define IW_DEFAULT_TTS_CACHE_CODEC		"PCMU"
+
+namespace ivrworx
+{
+	ProcTtsCapture::ProcTtsCapture(
+		IN LpHandlePair pair,
+		IN ConfigurationPtr conf,
+		IN TtsCache &cache,
+		IN const string &key,
+		IN const MrcpParams &params,
+		IN const string &body)
+		:LightweightProcess(pair,"TtsCapture"),
+		_conf(conf),
+		_cache(cache),
+		_key(key),
+		_params(params),
+		_body(body)
+	{
+		FUNCTRACKER;
+	}
+
+	ProcTtsCapture::~ProcTtsCapture()
+	{
+		FUNCTRACKER;
+	}
+
+	void
+	ProcTtsCapture::real_run()
+	{
+		FUNCTRACKER;
+
+		string captured_path;
+		ApiErrorCode res = API_FAILURE;
+
+		{
+			START_FORKING_REGION;
+			res = Capture(forking, captured_path);
+			END_FORKING_REGION;
+		}
+
+		if (IW_FAILURE(res))
+		{
+			LogWarn("ProcTtsCapture::real_run - cannot capture key:" << _key << ", res:" << res);
+			_cache.AbortCapture(_key);
+			if (!captured_path.empty())
+			{
+				::DeleteFileA(captured_path.c_str());
+			}
+			return;
+		}
+
+		for (int i = 0; i < IW_TTS_CAPTURE_COMMIT_RETRIES; ++i)
+		{
+			if (IW_SUCCESS(_cache.CommitCapture(_key, captured_path)))
+			{
+				return;
+			}
+
+			// file is still held by the recorder
+			csp::SleepFor(MilliSeconds(IW_TTS_CAPTURE_COMMIT_WAIT));
+		}
+
+		LogWarn("ProcTtsCapture::real_run - cannot commit key:" << _key);
+		_cache.AbortCapture(_key);
+		::DeleteFileA(captured_path.c_str());
+	}
+
+	ApiErrorCode
+	ProcTtsCapture::Capture(
+		IN ScopedForking &forking,
+		OUT string &captured_path)
+	{
+		FUNCTRACKER;
+
+		HandleId stream_service = IW_UNDEFINED;
+		HandleId mrcp_service = IW_UNDEFINED;
+
+		if (IW_FAILURE(GetConfiguredServiceHandle(stream_service, "ivr/stream_service", _conf)) ||
+			IW_FAILURE(GetConfiguredServiceHandle(mrcp_service, "ivr/mrcp_service", _conf)))
+		{
+			return API_FEATURE_DISABLED;
+		}
+
+		string codec = _conf->HasOption("ivr/tts_cache_codec") ? 
+			_conf->GetString("ivr/tts_cache_codec") : IW_DEFAULT_TTS_CACHE_CODEC;
+
+		MediaFormat media_format = MediaFormat::GetMediaFormat(codec);
+		if (media_format.get_media_type() != MediaFormat::MediaType_SPEECH)
+		{
+			LogWarn("ProcTtsCapture::Capture - unsupported codec:" << codec);
+			return API_WRONG_PARAMETER;
+		}
+
+		//
+		// recording streamer, remote end is not known yet
+		//
+		StreamingSession streamer(forking, stream_service);
+		ApiErrorCode res = streamer.Allocate(AbstractOffer(), RCV_DEVICE_FILE_REC_ID, SND_DEVICE_TYPE_FILE);
+		if (IW_FAILURE(res))
+		{
+			return res;
+		}
+
+		SdpParser parser(streamer.LocalOffer().body);
+		SdpParser::Medium medium = parser.first_audio_medium();
+		if (!medium.connection.is_valid())
+		{
+			streamer.TearDown();
+			return API_FAILURE;
+		}
+
+		// offer the synthesizer the capture codec only
+		DWORD time = ::GetTickCount();
+		stringstream sdps;
+		sdps << "v=0\r\n"
+			<< "o=ivrworx " << time << " " << time << " IN IP4 " << medium.connection.iptoa() << "\r\n"
+			<< "s=ttscapture\r\n"
+			<< "c=IN IP4 " << medium.connection.iptoa() << "\r\n"
+			<< "t=0 0\r\n"
+			<< "m=audio " << medium.connection.port_ho() << " RTP/AVP " << media_format.sdp_mapping() << "\r\n"
+			<< media_format.get_sdp_a() << "\r\n";
+
+		MrcpSession mrcp(forking, mrcp_service);
+		res = mrcp.Allocate(SYNTHESIZER, AbstractOffer(sdps.str(), "application/sdp"), Seconds(15));
+		if (IW_FAILURE(res))
+		{
+			streamer.TearDown();
+			return res;
+		}
+
+		// recording starts once streamer knows where synthesizer sends from
+		res = streamer.ModifyConnection(mrcp.RemoteOffer(SYNTHESIZER));
+		if (IW_SUCCESS(res))
+		{
+			char buf[100];
+			::itoa(streamer.SessionHandle(),buf,10);
+			captured_path = _conf->GetString("m2ims/record_dir") + "\\" + buf + ".wav";
+
+			res = mrcp.Speak(_params, _body, TRUE);
+		}
+
+		mrcp.TearDown();
+		streamer.TearDown();
+
+		return res;
+	}
+
+	ProcTtsCaptureRunner::ProcTtsCaptureRunner(
+		IN LpHandlePair pair,
+		IN TtsCache &cache)
+		:LightweightProcess(pair,"TtsCaptureRunner"),
+		_cache(cache)
+	{
+		FUNCTRACKER;
+	}
+
+	ProcTtsCaptureRunner::~ProcTtsCaptureRunner()
+	{
+		FUNCTRACKER;
+	}
+
+	void
+	ProcTtsCaptureRunner::real_run()
+	{
+		FUNCTRACKER;
+
+		START_FORKING_REGION;
+
+		BOOL shutdown_flag = FALSE;
+		while (shutdown_flag == FALSE)
+		{
+			ApiErrorCode res = API_SUCCESS;
+			IwMessagePtr msg = _inbound->Wait(Seconds(60), res);
+
+			if (res == API_TIMEOUT)
+			{
+				continue;
+			}
+
+			if (IW_FAILURE(res))
+			{
+				LogWarn("ProcTtsCaptureRunner::real_run - cannot read inbound, res:" << res);
+				break;
+			}
+
+			switch (msg->message_id)
+			{
+			case MSG_TTS_CAPTURE_REQ:
+				{
+					shared_ptr<MsgTtsCaptureReq> req = 
+						shared_polymorphic_cast<MsgTtsCaptureReq>(msg);
+
+					DECLARE_NAMED_HANDLE_PAIR(capture_pair);
+					FORK_IN_THIS_THREAD(
+						new ProcTtsCapture(capture_pair, req->conf, _cache, req->key, req->params, req->body));
+					break;
+				}
+			case MSG_PROC_SHUTDOWN_REQ:
+				{
+					shutdown_flag = TRUE;
+					break;
+				}
+			default:
+				{
+					LogWarn("ProcTtsCaptureRunner::real_run - unknown message:" << msg->message_id_str);
+				}
+			}
+		}
+
+		END_FORKING_REGION;
+	}
+
+}
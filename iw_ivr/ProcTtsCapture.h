@@ -0,0 +1,117 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "TtsCache.h"
+
+namespace ivrworx
+{
+	enum TtsCaptureEvents
+	{
+		MSG_TTS_CAPTURE_REQ = MSG_USER_DEFINED
+	};
+
+	class MsgTtsCaptureReq:
+		public IwMessage
+	{
+	public:
+		MsgTtsCaptureReq():
+		  IwMessage(MSG_TTS_CAPTURE_REQ, NAME(MSG_TTS_CAPTURE_REQ)){};
+
+		ConfigurationPtr conf;
+
+		string key;
+
+		MrcpParams params;
+
+		string body;
+	};
+
+	/**
+
+	Fills the TTS cache with a single prompt. Synthesizes the prompt once
+	more on a dedicated MRCP session whose audio is sent to a recording
+	streamer session, and moves the recorded file into the cache when the
+	synthesis completes. Runs on the capture thread of the cache, so the 
+	call does not wait for it.
+
+	**/
+	class ProcTtsCapture
+		: public LightweightProcess
+	{
+	public:
+
+		ProcTtsCapture(
+			IN LpHandlePair pair,
+			IN ConfigurationPtr conf,
+			IN TtsCache &cache,
+			IN const string &key,
+			IN const MrcpParams &params,
+			IN const string &body);
+
+		virtual ~ProcTtsCapture();
+
+		virtual void real_run();
+
+	private:
+
+		ApiErrorCode Capture(
+			IN ScopedForking &forking,
+			OUT string &captured_path);
+
+		ConfigurationPtr _conf;
+
+		TtsCache &_cache;
+
+		string _key;
+
+		MrcpParams _params;
+
+		string _body;
+
+	};
+
+	/**
+
+	Runs in the capture thread of the TTS cache and forks a capture 
+	process for every capture request it receives. Waits for the captures
+	in progress upon shutdown.
+
+	**/
+	class ProcTtsCaptureRunner
+		: public LightweightProcess
+	{
+	public:
+
+		ProcTtsCaptureRunner(
+			IN LpHandlePair pair,
+			IN TtsCache &cache);
+
+		virtual ~ProcTtsCaptureRunner();
+
+		virtual void real_run();
+
+	private:
+
+		TtsCache &_cache;
+
+	};
+
+}
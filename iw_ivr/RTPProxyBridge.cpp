@@ -34,6 +34,8 @@ namespace ivrworx
 		method(rtpproxy, waitfordtmf),
 		method(rtpproxy, cleandtmfbuffer),
 		method(rtpproxy, dtmfbuffer),
+		method(rtpproxy, stats),
+		method(rtpproxy, benchmark),
 		{0,0}
 	};
 
@@ -85,6 +87,79 @@ namespace ivrworx
 	}
 
 
+	int
+	rtpproxy::stats(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_rtpProxySession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		RtpQualityStats stats;
+		ApiErrorCode res = _rtpProxySession->Stats(stats);
+
+		lua_pushnumber(L, res);
+		if (IW_FAILURE(res))
+		{
+			return 1;
+		}
+
+		lua_newtable(L);
+
+		lua_pushstring(L, "packets_received");	lua_pushnumber(L, stats.packets_received);	lua_settable(L,-3);
+		lua_pushstring(L, "packets_expected");	lua_pushnumber(L, stats.packets_expected);	lua_settable(L,-3);
+		lua_pushstring(L, "packets_lost");		lua_pushnumber(L, stats.packets_lost);		lua_settable(L,-3);
+		lua_pushstring(L, "loss_percent");		lua_pushnumber(L, stats.loss_percent());	lua_settable(L,-3);
+		lua_pushstring(L, "packets_sent");		lua_pushnumber(L, stats.packets_sent);		lua_settable(L,-3);
+		lua_pushstring(L, "jitter_ms");			lua_pushnumber(L, stats.jitter_ms);			lua_settable(L,-3);
+		lua_pushstring(L, "rtt_ms");			lua_pushnumber(L, stats.rtt_ms);			lua_settable(L,-3);
+		lua_pushstring(L, "kbps_in");			lua_pushnumber(L, stats.kbps_in);			lua_settable(L,-3);
+		lua_pushstring(L, "kbps_out");			lua_pushnumber(L, stats.kbps_out);			lua_settable(L,-3);
+		lua_pushstring(L, "duration_ms");		lua_pushnumber(L, stats.duration_ms);		lua_settable(L,-3);
+
+		return 2;
+
+	}
+
+	int
+	rtpproxy::benchmark(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_rtpProxySession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		int frames = 0;
+		GetTableNumberParam<int>(L,-1,&frames,"frames",50000);
+
+		int participants = 0;
+		GetTableNumberParam<int>(L,-1,&participants,"participants",8);
+
+		RtpProxyBenchmark result;
+		ApiErrorCode res = _rtpProxySession->Benchmark(frames, participants, result);
+
+		lua_pushnumber(L, res);
+		if (IW_FAILURE(res))
+		{
+			return 1;
+		}
+
+		lua_newtable(L);
+
+		lua_pushstring(L, "transcode_ns");		lua_pushnumber(L, result.transcode_ns);		lua_settable(L,-3);
+		lua_pushstring(L, "dtmf_ns");			lua_pushnumber(L, result.dtmf_ns);			lua_settable(L,-3);
+		lua_pushstring(L, "mix_ns");			lua_pushnumber(L, result.mix_ns);			lua_settable(L,-3);
+
+		return 2;
+
+	}
+
 	int
 	rtpproxy::waitfordtmf(lua_State *L)
 	{
@@ -251,5 +326,166 @@ namespace ivrworx
 
 
 
+	const char rtpconference::className[] = "rtpconference";
+	Luna<rtpconference>::RegType rtpconference::methods[] = {
+		method(rtpconference, allocate),
+		method(rtpconference, attach),
+		method(rtpconference, handle),
+		method(rtpconference, join),
+		method(rtpconference, leave),
+		method(rtpconference, teardown),
+		{0,0}
+	};
+
+	rtpconference::rtpconference(lua_State *L)
+	{
+	}
+
+	rtpconference::rtpconference(RtpConferenceSessionPtr conferenceSession):
+	_conferenceSession(conferenceSession)
+	{
+	}
+
+	rtpconference::~rtpconference(void)
+	{
+
+	}
+
+	int 
+	rtpconference::allocate(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		};
+
+		ApiErrorCode res  = _conferenceSession->Allocate();
+		lua_pushnumber (L, res);
+
+		return 1;
+	}
+
+	int 
+	rtpconference::attach(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		};
+
+		int handle = IW_UNDEFINED;
+		BOOL paramres = GetTableNumberParam<int>(L,-1,&handle,"handle",IW_UNDEFINED);
+		if (paramres == FALSE || handle == IW_UNDEFINED)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		ApiErrorCode res  = _conferenceSession->Attach(handle);
+		lua_pushnumber (L, res);
+
+		return 1;
+	}
+
+	int 
+	rtpconference::handle(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, IW_UNDEFINED);
+			return 1;
+		};
+
+		lua_pushnumber (L, _conferenceSession->ConferenceHandle());
+
+		return 1;
+	}
+
+	rtpproxy*
+	rtpconference::participant(lua_State *L)
+	{
+		rtpproxy *other = NULL;
+		BOOL paramres = GetLunaUserData<rtpproxy>(L,-1,&other,"rtpproxy");
+		if (paramres == FALSE || other == NULL || !other->_rtpProxySession)
+		{
+			return NULL;
+		}
+
+		return other;
+	}
+
+	int 
+	rtpconference::join(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		};
+
+		rtpproxy *other = participant(L);
+		if (other == NULL)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		ApiErrorCode res  = _conferenceSession->Join(*(other->_rtpProxySession));
+		lua_pushnumber (L, res);
+
+		return 1;
+	}
+
+	int 
+	rtpconference::leave(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		};
+
+		rtpproxy *other = participant(L);
+		if (other == NULL)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		ApiErrorCode res  = _conferenceSession->Leave(*(other->_rtpProxySession));
+		lua_pushnumber (L, res);
+
+		return 1;
+	}
+
+	int 
+	rtpconference::teardown(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_conferenceSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		};
+
+		ApiErrorCode res  = _conferenceSession->TearDown();
+		lua_pushnumber (L, res);
+
+		return 1;
+	}
+
 }
 
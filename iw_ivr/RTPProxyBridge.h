@@ -43,6 +43,8 @@ namespace ivrworx
 		int waitfordtmf(lua_State *L);
 		int cleandtmfbuffer(lua_State *L);
 		int dtmfbuffer(lua_State *L);
+		int stats(lua_State *L);
+		int benchmark(lua_State *L);
 
 		ActiveObjectPtr get_active_object();
 		
@@ -54,7 +56,35 @@ namespace ivrworx
 
 		RtpProxySessionPtr _rtpProxySession;
 
-	
+		friend class rtpconference;
+
+	};
+
+	class rtpconference: 
+		public luaobject
+	{
+	public:
+		rtpconference(lua_State *L);
+		rtpconference(RtpConferenceSessionPtr conferenceSession);
+
+		virtual ~rtpconference();
+
+		// Lua interface
+		int allocate(lua_State *L);
+		int attach(lua_State *L);
+		int handle(lua_State *L);
+		int join(lua_State *L);
+		int leave(lua_State *L);
+		int teardown(lua_State *L);
+
+		static const char className[];
+		static Luna<rtpconference>::RegType methods[];
+
+		private:
+
+		rtpproxy* participant(lua_State *L);
+
+		RtpConferenceSessionPtr _conferenceSession;
 
 	};
 
@@ -0,0 +1,780 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "SdpBridge.h"
+#include "BridgeMacros.h"
+
+// canonical order of lines as defined by RFC 4566
+#define IW_SDP_SESSION_ORDER	"vosiuepcbtrzka"
+#define IW_SDP_MEDIA_ORDER		"micbka"
+
+namespace ivrworx
+{
+	const char sdpdesc::className[] = "sdpdesc";
+	Luna<sdpdesc>::RegType sdpdesc::methods[] = {
+		method(sdpdesc, field),
+		method(sdpdesc, setfield),
+		method(sdpdesc, attributes),
+		method(sdpdesc, attribute),
+		method(sdpdesc, addattribute),
+		method(sdpdesc, removeattribute),
+		method(sdpdesc, medianum),
+		method(sdpdesc, media),
+		method(sdpdesc, setport),
+		method(sdpdesc, setcodecs),
+		method(sdpdesc, codec),
+		method(sdpdesc, removemedia),
+		method(sdpdesc, copy),
+		method(sdpdesc, tostring),
+		{0,0}
+	};
+
+	struct StaticPayload
+	{
+		int ptype;
+
+		const char *ename;
+
+		int crate;
+	};
+
+	static const StaticPayload g_staticPayloads[] = {
+		{0,  "PCMU",  8000},
+		{3,  "GSM",   8000},
+		{4,  "G723",  8000},
+		{5,  "DVI4",  8000},
+		{6,  "DVI4",  16000},
+		{7,  "LPC",   8000},
+		{8,  "PCMA",  8000},
+		{9,  "G722",  8000},
+		{10, "L16",   44100},
+		{11, "L16",   44100},
+		{12, "QCELP", 8000},
+		{13, "CN",    8000},
+		{14, "MPA",   8000},
+		{15, "G728",  8000},
+		{16, "DVI4",  11025},
+		{17, "DVI4",  22050},
+		{18, "G729",  8000},
+		{-1, NULL,    0}
+	};
+
+	struct SdpMediaLine
+	{
+		string medium;
+
+		string port;
+
+		string protocol;
+
+		vector<string> formats;
+	};
+
+	static void
+	SplitMediaLine(IN const string &value, OUT SdpMediaLine &media)
+	{
+		size_t start = 0;
+		int field = 0;
+
+		while (start < value.size())
+		{
+			size_t end = value.find(' ', start);
+			if (end == string::npos)
+			{
+				end = value.size();
+			}
+
+			if (end > start)
+			{
+				string token = value.substr(start, end - start);
+				switch (field++)
+				{
+				case 0:	 media.medium = token; break;
+				case 1:	 media.port = token; break;
+				case 2:	 media.protocol = token; break;
+				default: media.formats.push_back(token);
+				}
+			}
+
+			start = end + 1;
+		}
+	}
+
+	static string
+	JoinMediaLine(IN const SdpMediaLine &media)
+	{
+		string value = media.medium + " " + media.port + " " + media.protocol;
+		for (vector<string>::const_iterator iter = media.formats.begin();
+			iter != media.formats.end(); ++iter)
+		{
+			value += " ";
+			value += *iter;
+		}
+
+		return value;
+	}
+
+	static string
+	AttributeName(IN const string &value)
+	{
+		size_t colon = value.find(':');
+		return colon == string::npos ? value : value.substr(0, colon);
+	}
+
+	// payload type the rtpmap or fmtp attribute refers to
+	static string
+	AttributeFormat(IN const string &value)
+	{
+		size_t colon = value.find(':');
+		if (colon == string::npos)
+		{
+			return "";
+		}
+
+		size_t end = value.find(' ', colon);
+		return value.substr(colon + 1, end == string::npos ? string::npos : end - colon - 1);
+	}
+
+	static BOOL
+	ContainsFormat(IN const list<string> &formats, IN const string &format)
+	{
+		for (list<string>::const_iterator iter = formats.begin(); iter != formats.end(); ++iter)
+		{
+			if (*iter == format)
+			{
+				return TRUE;
+			}
+		}
+
+		return FALSE;
+	}
+
+	sdpdesc::sdpdesc()
+	{
+
+	}
+
+	sdpdesc::sdpdesc(lua_State *L)
+	{
+
+	}
+
+	sdpdesc::sdpdesc(const sdpdesc &other):
+	_text(other._text),
+	_session(other._session),
+	_media(other._media)
+	{
+
+	}
+
+	sdpdesc::~sdpdesc(void)
+	{
+
+	}
+
+	string
+	sdpdesc::Value(IN const SdpLine &line)
+	{
+		return _text.substr(line.offset, line.length);
+	}
+
+	void
+	sdpdesc::SetValue(IN SdpLine &line, IN const string &value)
+	{
+		line.offset = _text.size();
+		line.length = value.size();
+
+		_text += value;
+	}
+
+	BOOL
+	sdpdesc::HasPrefix(IN const SdpLine &line, IN const char *prefix)
+	{
+		size_t length = ::strlen(prefix);
+		return line.length >= length && _text.compare(line.offset, length, prefix) == 0;
+	}
+
+	void
+	sdpdesc::InsertLine(IN SdpLines &lines, IN char type, IN const string &value, IN const char *order)
+	{
+		const char *type_pos = ::strchr(order, type);
+
+		SdpLines::iterator iter = lines.begin();
+		if (type_pos != NULL)
+		{
+			for (; iter != lines.end(); ++iter)
+			{
+				const char *pos = ::strchr(order, iter->type);
+				if (pos != NULL && pos > type_pos)
+				{
+					break;
+				}
+			}
+		}
+		else
+		{
+			iter = lines.end();
+		}
+
+		SdpLine line;
+		line.type = type;
+		SetValue(line, value);
+
+		lines.insert(iter, line);
+	}
+
+	BOOL
+	sdpdesc::FindRtpmap(IN const SdpLines &lines, IN const string &ptype, OUT string &ename, OUT int &crate)
+	{
+		for (SdpLines::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+		{
+			if (iter->type != 'a' || 
+				HasPrefix(*iter, "rtpmap:") == FALSE)
+			{
+				continue;
+			}
+
+			string value = Value(*iter);
+			if (AttributeFormat(value) != ptype)
+			{
+				continue;
+			}
+
+			// rtpmap:<payload type> <encoding name>/<clock rate>[/<parameters>]
+			size_t space = value.find(' ');
+			if (space == string::npos)
+			{
+				return FALSE;
+			}
+
+			size_t slash = value.find('/', space);
+			ename = value.substr(space + 1, slash == string::npos ? string::npos : slash - space - 1);
+			crate = (slash == string::npos) ? 0 : ::atoi(value.c_str() + slash + 1);
+
+			return TRUE;
+		}
+
+		return FALSE;
+	}
+
+	BOOL
+	sdpdesc::Parse(IN const char *text, IN size_t length)
+	{
+		_text.assign(text, length);
+		_session.clear();
+		_media.clear();
+
+		SdpLines *current = &_session;
+
+		const char *begin = _text.c_str();
+		const char *pos = begin;
+		const char *end = begin + length;
+
+		while (pos < end)
+		{
+			const char *eol = (const char *)::memchr(pos, '\n', end - pos);
+			if (eol == NULL)
+			{
+				eol = end;
+			}
+
+			const char *line_start = pos;
+			const char *line_end = eol;
+			pos = eol + 1;
+
+			while (line_start < line_end && (*line_start == ' ' || *line_start == '\t'))
+			{
+				++line_start;
+			}
+
+			if (line_end > line_start && line_end[-1] == '\r')
+			{
+				--line_end;
+			}
+
+			if (line_end - line_start < 2 || line_start[1] != '=')
+			{
+				continue;
+			}
+
+			if (*line_start == 'm')
+			{
+				_media.push_back(SdpLines());
+				current = &_media.back();
+			}
+
+			SdpLine line;
+			line.type = *line_start;
+			line.offset = (line_start + 2) - begin;
+			line.length = line_end - (line_start + 2);
+
+			current->push_back(line);
+		}
+
+		return (_session.empty() == false && _session.front().type == 'v');
+	}
+
+	string
+	sdpdesc::Serialize()
+	{
+		size_t size = 0;
+		for (SdpLines::iterator iter = _session.begin(); iter != _session.end(); ++iter)
+		{
+			size += iter->length + 4;
+		}
+
+		for (vector<SdpLines>::iterator media_iter = _media.begin(); media_iter != _media.end(); ++media_iter)
+		{
+			for (SdpLines::iterator iter = media_iter->begin(); iter != media_iter->end(); ++iter)
+			{
+				size += iter->length + 4;
+			}
+		}
+
+		string res;
+		res.reserve(size);
+
+		for (SdpLines::iterator iter = _session.begin(); iter != _session.end(); ++iter)
+		{
+			res += iter->type;
+			res += '=';
+			res.append(_text, iter->offset, iter->length);
+			res += "\r\n";
+		}
+
+		for (vector<SdpLines>::iterator media_iter = _media.begin(); media_iter != _media.end(); ++media_iter)
+		{
+			for (SdpLines::iterator iter = media_iter->begin(); iter != media_iter->end(); ++iter)
+			{
+				res += iter->type;
+				res += '=';
+				res.append(_text, iter->offset, iter->length);
+				res += "\r\n";
+			}
+		}
+
+		return res;
+	}
+
+	SdpLines *
+	sdpdesc::GetLines(IN int media_index)
+	{
+		if (media_index == 0)
+		{
+			return &_session;
+		}
+
+		if (media_index < 0 || media_index > (int)_media.size())
+		{
+			return NULL;
+		}
+
+		return &_media[media_index - 1];
+	}
+
+	int
+	sdpdesc::field(lua_State *L)
+	{
+		string name;
+		GetTableStringParam(L,-1,name,"name");
+
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || name.size() != 1)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); ++iter)
+		{
+			if (iter->type == name[0])
+			{
+				lua_pushlstring(L, _text.c_str() + iter->offset, iter->length);
+				return 1;
+			}
+		}
+
+		lua_pushnil(L);
+		return 1;
+	}
+
+	int
+	sdpdesc::setfield(lua_State *L)
+	{
+		string name;
+		GetTableStringParam(L,-1,name,"name");
+
+		string value;
+		GetTableStringParam(L,-1,value,"value");
+
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || name.size() != 1 ||
+			(name[0] == 'm' && media_index == 0))
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); ++iter)
+		{
+			if (iter->type == name[0])
+			{
+				SetValue(*iter, value);
+				lua_pushnumber (L, API_SUCCESS);
+				return 1;
+			}
+		}
+
+		InsertLine(*lines, name[0], value,
+			media_index == 0 ? IW_SDP_SESSION_ORDER : IW_SDP_MEDIA_ORDER);
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+	}
+
+	int
+	sdpdesc::attributes(lua_State *L)
+	{
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		lua_newtable(L);
+
+		int index = 1;
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); ++iter)
+		{
+			if (iter->type == 'a')
+			{
+				lua_pushlstring(L, _text.c_str() + iter->offset, iter->length);
+				lua_rawseti(L, -2, index++);
+			}
+		}
+
+		return 1;
+	}
+
+	int
+	sdpdesc::attribute(lua_State *L)
+	{
+		string name;
+		GetTableStringParam(L,-1,name,"name");
+
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); ++iter)
+		{
+			if (iter->type != 'a')
+			{
+				continue;
+			}
+
+			string value = Value(*iter);
+			if (AttributeName(value) != name)
+			{
+				continue;
+			}
+
+			// property attributes have no value
+			size_t colon = value.find(':');
+			if (colon == string::npos)
+			{
+				lua_pushliteral(L, "");
+			}
+			else
+			{
+				lua_pushlstring(L, value.c_str() + colon + 1, value.size() - colon - 1);
+			}
+
+			return 1;
+		}
+
+		lua_pushnil(L);
+		return 1;
+	}
+
+	int
+	sdpdesc::addattribute(lua_State *L)
+	{
+		string value;
+		if (GetTableStringParam(L,-1,value,"value") == FALSE)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		InsertLine(*lines, 'a', value,
+			media_index == 0 ? IW_SDP_SESSION_ORDER : IW_SDP_MEDIA_ORDER);
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+	}
+
+	int
+	sdpdesc::removeattribute(lua_State *L)
+	{
+		string name;
+		GetTableStringParam(L,-1,name,"name");
+
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL)
+		{
+			lua_pushnumber (L, 0);
+			return 1;
+		}
+
+		int removed = 0;
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); )
+		{
+			if (iter->type == 'a' && AttributeName(Value(*iter)) == name)
+			{
+				iter = lines->erase(iter);
+				removed++;
+			}
+			else
+			{
+				++iter;
+			}
+		}
+
+		lua_pushnumber (L, removed);
+		return 1;
+	}
+
+	int
+	sdpdesc::medianum(lua_State *L)
+	{
+		lua_pushnumber (L, _media.size());
+		return 1;
+	}
+
+	int
+	sdpdesc::media(lua_State *L)
+	{
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"index",0);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || media_index == 0)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		SdpMediaLine media_line;
+		SplitMediaLine(Value(lines->front()), media_line);
+
+		lua_pushstring(L, media_line.medium.c_str());
+		lua_pushstring(L, media_line.port.c_str());
+		lua_pushstring(L, media_line.protocol.c_str());
+
+		lua_newtable(L);
+
+		int index = 1;
+		for (vector<string>::iterator iter = media_line.formats.begin();
+			iter != media_line.formats.end(); ++iter)
+		{
+			lua_pushstring(L, iter->c_str());
+			lua_rawseti(L, -2, index++);
+		}
+
+		return 4;
+	}
+
+	int
+	sdpdesc::setport(lua_State *L)
+	{
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"index",0);
+
+		string port;
+		GetTableStringParam(L,-1,port,"port");
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || media_index == 0 || port.empty())
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		SdpMediaLine media_line;
+		SplitMediaLine(Value(lines->front()), media_line);
+
+		media_line.port = port;
+		SetValue(lines->front(), JoinMediaLine(media_line));
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+	}
+
+	int
+	sdpdesc::setcodecs(lua_State *L)
+	{
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"index",0);
+
+		list<string> codecs;
+		GetTableStringListParam(L,-1,codecs,"codecs");
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || media_index == 0 || codecs.empty())
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		SdpMediaLine media_line;
+		SplitMediaLine(Value(lines->front()), media_line);
+
+		media_line.formats.assign(codecs.begin(), codecs.end());
+		SetValue(lines->front(), JoinMediaLine(media_line));
+
+		// drop the attributes of the formats not offered anymore
+		for (SdpLines::iterator iter = lines->begin(); iter != lines->end(); )
+		{
+			if (iter->type == 'a' &&
+				(HasPrefix(*iter, "rtpmap:") || HasPrefix(*iter, "fmtp:")) &&
+				ContainsFormat(codecs, AttributeFormat(Value(*iter))) == FALSE)
+			{
+				iter = lines->erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+	}
+
+	int
+	sdpdesc::codec(lua_State *L)
+	{
+		string ptype;
+		GetTableStringParam(L,-1,ptype,"pt");
+
+		int media_index = 1;
+		GetTableNumberParam<int>(L,-1,&media_index,"media",1);
+
+		SdpLines *lines = GetLines(media_index);
+		if (lines == NULL || ptype.empty())
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		string ename;
+		int crate = 0;
+
+		// media attributes first, then session ones, then static payload types
+		if (FindRtpmap(*lines, ptype, ename, crate) == FALSE &&
+			FindRtpmap(_session, ptype, ename, crate) == FALSE)
+		{
+			int static_ptype = ::atoi(ptype.c_str());
+			for (const StaticPayload *payload = g_staticPayloads; payload->ename != NULL; ++payload)
+			{
+				if (payload->ptype == static_ptype)
+				{
+					ename = payload->ename;
+					crate = payload->crate;
+					break;
+				}
+			}
+		}
+
+		if (ename.empty())
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		lua_pushstring(L, ename.c_str());
+		lua_pushnumber(L, crate);
+		return 2;
+	}
+
+	int
+	sdpdesc::removemedia(lua_State *L)
+	{
+		int media_index = 0;
+		GetTableNumberParam<int>(L,-1,&media_index,"index",0);
+
+		if (media_index < 1 || media_index > (int)_media.size())
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		_media.erase(_media.begin() + (media_index - 1));
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+	}
+
+	int
+	sdpdesc::copy(lua_State *L)
+	{
+		Luna<sdpdesc>::PushObject(L, new sdpdesc(*this));
+		return 1;
+	}
+
+	int
+	sdpdesc::tostring(lua_State *L)
+	{
+		string res = Serialize();
+		lua_pushlstring(L, res.c_str(), res.size());
+		return 1;
+	}
+
+}
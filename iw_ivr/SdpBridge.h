@@ -0,0 +1,109 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+#include "Luna.h"
+#include "LuaObject.h"
+
+namespace ivrworx
+{
+	// value is a slice of the description text
+	struct SdpLine
+	{
+		char type;
+
+		size_t offset;
+
+		size_t length;
+	};
+
+	typedef
+	vector<SdpLine> SdpLines;
+
+	/**
+
+	Parsed session description. Lines are kept as slices of the original
+	text and split into fields only when a script asks for them, so parsing
+	a whole offer is a single pass over the text with no allocation per 
+	line. Modified values are appended to the text. Media are numbered 
+	from 1, media index 0 stands for the session level lines.
+
+	@code
+	offer = sdpdesc:new{sdp=caller:remoteoffer()}
+	medium, port, protocol, codecs = offer:media{index=1}
+	offer:setcodecs{index=1, codecs={8, 101}}
+	answer = offer:tostring()
+	@endcode
+
+	**/
+	class sdpdesc :
+		public luaobject
+	{
+	public:
+		sdpdesc();
+		sdpdesc(lua_State *L);
+		sdpdesc(const sdpdesc &other);
+		virtual ~sdpdesc(void);
+
+		BOOL Parse(IN const char *text, IN size_t length);
+
+		string Serialize();
+
+		int field(lua_State *L);
+		int setfield(lua_State *L);
+		int attributes(lua_State *L);
+		int attribute(lua_State *L);
+		int addattribute(lua_State *L);
+		int removeattribute(lua_State *L);
+		int medianum(lua_State *L);
+		int media(lua_State *L);
+		int setport(lua_State *L);
+		int setcodecs(lua_State *L);
+		int codec(lua_State *L);
+		int removemedia(lua_State *L);
+		int copy(lua_State *L);
+		int tostring(lua_State *L);
+
+		static const char className[];
+		static Luna<sdpdesc>::RegType methods[];
+
+	private:
+
+		SdpLines *GetLines(IN int media_index);
+
+		string Value(IN const SdpLine &line);
+
+		void SetValue(IN SdpLine &line, IN const string &value);
+
+		BOOL HasPrefix(IN const SdpLine &line, IN const char *prefix);
+
+		void InsertLine(IN SdpLines &lines, IN char type, IN const string &value, IN const char *order);
+
+		BOOL FindRtpmap(IN const SdpLines &lines, IN const string &ptype, OUT string &ename, OUT int &crate);
+
+		string _text;
+
+		SdpLines _session;
+
+		// first line of every media is its m= line
+		vector<SdpLines> _media;
+	};
+
+
+}
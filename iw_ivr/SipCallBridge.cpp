@@ -21,6 +21,7 @@
 #include "BridgeMacros.h"
 #include "SipCallBridge.h"
 #include "LuaStaticApi.h"
+#include "CallLogFilter.h"
 
 
 namespace ivrworx
@@ -53,22 +54,67 @@ Luna<sipcall>::RegType sipcall::methods[] = {
 	{0,0}
 };
 
-sipcall::sipcall(lua_State *L)
+sipcall::sipcall(lua_State *L):
+_debugHandle(IW_UNDEFINED)
 {
 
 }
 
 sipcall::sipcall(SipMediaCallPtr call):
-_call(call)
+_call(call),
+_debugHandle(IW_UNDEFINED)
 {
 
 }
 
 sipcall::~sipcall(void)
 {
+	StopCallLog();
 	_call.reset();
 }
 
+BOOL
+sipcall::StartCallLog(IN HandleId iwh, IN const string &ani, IN const string &dnis)
+{
+	RunningContext *ctx = GetCurrRunningContext();
+
+	CallLogContext log_context = ctx->LogContext();
+	if (log_context.Decided())
+	{
+		// script already took its sampling slot, further calls it
+		// makes are debugged if it is or if they match the filters
+		log_context.debug = log_context.debug || 
+			CallLogFilter::Matches(CTX_FIELD(_conf), ani, dnis);
+	}
+	else
+	{
+		log_context.iwh   = iwh;
+		log_context.ani   = ani;
+		log_context.dnis  = dnis;
+		log_context.debug = CallLogFilter::Decide(CTX_FIELD(_conf), ani, dnis);
+	}
+
+	ctx->LogContext(log_context);
+
+	if (log_context.debug)
+	{
+		LogInfo("sipcall::StartCallLog - debugging call ani:" << ani << ", dnis:" << dnis);
+	}
+
+	return log_context.debug;
+}
+
+void
+sipcall::StopCallLog()
+{
+	if (_debugHandle != IW_UNDEFINED)
+	{
+		CallLogFilter::Unregister(_debugHandle);
+		_debugHandle = IW_UNDEFINED;
+	}
+}
+
+
 int
 sipcall::accept(lua_State *L)
 {
@@ -124,6 +170,13 @@ sipcall::accept(lua_State *L)
 				shared_polymorphic_cast<MsgCallOfferedReq> (msg);
 
 			_call.reset(new SipMediaCall(*CTX_FIELD(_forking),call_offered));
+
+			StopCallLog();
+			if (StartCallLog(_call->StackCallHandle(), _call->Ani(), _call->Dnis()))
+			{
+				_debugHandle = _call->StackCallHandle();
+				CallLogFilter::Register(_debugHandle);
+			}
 			break;
 		}
 	default:
@@ -168,6 +221,8 @@ sipcall::hangup(lua_State *L)
 	}
 
 	ApiErrorCode res = _call->HangupCall();
+	StopCallLog();
+
 	lua_pushnumber (L, res);
 
 	return 1;
@@ -494,9 +549,20 @@ sipcall::makecall(lua_State *L)
 
 	FillTable(L,-1,freemap);
 
+	// messages of the call setup already carry the decision
+	StopCallLog();
+	BOOL call_debug = StartCallLog(
+		GetCurrRunningContext()->LogContext().iwh, username, dest);
+
 	ApiErrorCode res = 
 		_call->MakeCall(dest,offer,cred,freemap,Seconds(timeout));
 
+	if (IW_SUCCESS(res) && call_debug)
+	{
+		_debugHandle = _call->StackCallHandle();
+		CallLogFilter::Register(_debugHandle);
+	}
+
 
 	lua_pushnumber (L, res);
 	return 1;
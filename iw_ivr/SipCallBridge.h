@@ -77,7 +77,16 @@ namespace ivrworx
 
 	private:
 
+		// decides whether the call is logged at debug level, 
+		// the script and the sip stack follow the decision
+		BOOL StartCallLog(IN HandleId iwh, IN const string &ani, IN const string &dnis);
+
+		void StopCallLog();
+
 		SipMediaCallPtr _call;
+
+		// registered with CallLogFilter while the call is debugged
+		HandleId _debugHandle;
 	};
 
 
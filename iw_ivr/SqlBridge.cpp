@@ -0,0 +1,537 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "SqlBridge.h"
+#include "BridgeMacros.h"
+
+#define IW_SQL_CURSOR_META "ivrworx.sqlcursor"
+
+namespace ivrworx
+{
+	const char sqlsession::className[] = "sqlsession";
+	Luna<sqlsession>::RegType sqlsession::methods[] = {
+		method(sqlsession, open),
+		method(sqlsession, exec),
+		method(sqlsession, submit),
+		method(sqlsession, flush),
+		method(sqlsession, query),
+		method(sqlsession, rows),
+		method(sqlsession, changes),
+		method(sqlsession, lastrowid),
+		method(sqlsession, close),
+		{0,0}
+	};
+
+	struct SqlCursor
+	{
+		SqliteSessionPtr session;
+
+		sqlite3_stmt *stmt;
+
+		int batch;
+
+		vector<string> columns;
+
+		SqlRowsList rows;
+
+		BOOL done;
+
+		BOOL started;
+
+		// set while the worker streams the result set to the cursor
+		BOOL streaming;
+	};
+
+	static void
+	CloseCursor(SqlCursor *cursor)
+	{
+		if (cursor->streaming == TRUE)
+		{
+			cursor->session->sqlite3_stream_end();
+			cursor->streaming = FALSE;
+		}
+
+		if (cursor->stmt != NULL)
+		{
+			int rc = SQLITE_OK;
+			cursor->session->sqlite3_finalize(cursor->stmt, rc);
+			cursor->stmt = NULL;
+		}
+
+		cursor->rows.clear();
+		cursor->done = TRUE;
+	}
+
+	static void
+	PushRow(lua_State *L, const vector<string> &columns, const SqlRow &row)
+	{
+		lua_newtable(L);
+
+		for (size_t i = 0; i < row.size() && i < columns.size(); ++i)
+		{
+			const SqlValue &value = row[i];
+
+			lua_pushstring(L, columns[i].c_str());
+			switch (value.type)
+			{
+			case SQLITE_INTEGER:
+				{
+					lua_pushnumber(L, (lua_Number)value.int_value);
+					break;
+				}
+			case SQLITE_FLOAT:
+				{
+					lua_pushnumber(L, value.float_value);
+					break;
+				}
+			case SQLITE_TEXT:
+			case SQLITE_BLOB:
+				{
+					lua_pushlstring(L, value.text_value.c_str(), value.text_value.length());
+					break;
+				}
+			default:
+				{
+					lua_pushnil(L);
+				}
+			}
+			lua_settable(L, -3);
+		}
+	}
+
+	static ApiErrorCode
+	PrepareCursor(SqlCursor &cursor, const string &sql)
+	{
+		int rc = SQLITE_OK;
+		ApiErrorCode res = cursor.session->sqlite3_prepare(
+			sql.c_str(), 
+			(int)sql.length(), 
+			&cursor.stmt, 
+			NULL, 
+			rc);
+
+		if (IW_FAILURE(res) || rc != SQLITE_OK || cursor.stmt == NULL)
+		{
+			LogWarn("Cannot prepare sql:" << sql << ", rc:" << rc);
+			return API_WRONG_PARAMETER;
+		}
+
+		return API_SUCCESS;
+	}
+
+	static int
+	SqlCursorGc(lua_State *L)
+	{
+		SqlCursorPtr **cursor = (SqlCursorPtr **)luaL_checkudata(L, 1, IW_SQL_CURSOR_META);
+		if (*cursor != NULL)
+		{
+			CloseCursor((*cursor)->get());
+			delete *cursor;
+			*cursor = NULL;
+		}
+
+		return 0;
+	}
+
+	static int
+	SqlCursorNext(lua_State *L)
+	{
+		SqlCursorPtr cursor = 
+			**(SqlCursorPtr **)lua_touserdata(L, lua_upvalueindex(1));
+
+		if (cursor->started == FALSE)
+		{
+			// only one stream per session, loops nested 
+			// in it fetch a batch per round trip instead
+			cursor->started = TRUE;
+			cursor->streaming = IW_SUCCESS(cursor->session->sqlite3_stream_begin(
+				cursor->stmt, 
+				cursor->batch)) ? TRUE : FALSE;
+		}
+
+		if (cursor->rows.empty() && cursor->done == FALSE)
+		{
+			int rc = SQLITE_OK;
+			ApiErrorCode res = API_SUCCESS;
+			if (cursor->streaming == TRUE)
+			{
+				res = cursor->session->sqlite3_stream_next(
+					cursor->columns,
+					cursor->rows,
+					cursor->done,
+					rc);
+
+				// stream is ended by the session once done or failed
+				cursor->streaming = (IW_FAILURE(res) || cursor->done) ? FALSE : TRUE;
+			}
+			else
+			{
+				res = cursor->session->sqlite3_fetch(
+					cursor->stmt,
+					cursor->batch,
+					cursor->columns,
+					cursor->rows,
+					cursor->done,
+					rc);
+			}
+
+			if (IW_FAILURE(res) || (rc != SQLITE_ROW && rc != SQLITE_DONE))
+			{
+				LogWarn("Error fetching rows res:" << res << ", rc:" << rc);
+				cursor->done = TRUE;
+			}
+		}
+
+		if (cursor->rows.empty())
+		{
+			CloseCursor(cursor.get());
+			lua_pushnil(L);
+			return 1;
+		}
+
+		PushRow(L, cursor->columns, cursor->rows.front());
+		cursor->rows.pop_front();
+
+		return 1;
+	}
+
+	sqlsession::sqlsession(SqliteSessionPtr sqlSession):
+	_sqlSession(sqlSession)
+	{
+
+	}
+
+	sqlsession::sqlsession(lua_State *L)
+	{
+
+	}
+
+	sqlsession::~sqlsession(void)
+	{
+	}
+
+	void
+	sqlsession::CloseCursors()
+	{
+		for (SqlCursorsList::iterator iter = _cursors.begin(); 
+			iter != _cursors.end(); ++iter)
+		{
+			CloseCursor((*iter).get());
+		}
+
+		_cursors.clear();
+	}
+
+	int 
+	sqlsession::open(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		string url;
+		if (GetTableStringParam(L,-1,url,"url") == FALSE)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		int rc = SQLITE_OK;
+		ApiErrorCode res = _sqlSession->sqlite3_open(url.c_str(), rc);
+
+		lua_pushnumber (L, res);
+		lua_pushnumber (L, rc);
+		return 2;
+
+	}
+
+	int 
+	sqlsession::exec(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		string sql;
+		if (GetTableStringParam(L,-1,sql,"sql") == FALSE)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		bool batched = false;
+		GetTableBoolParam(L,-1,&batched,"batched",false);
+
+		int rc = SQLITE_OK;
+		ApiErrorCode res = batched ?
+			_sqlSession->sqlite3_exec_batched(sql.c_str(), rc) :
+			_sqlSession->sqlite3_exec(sql.c_str(), NULL, NULL, NULL, rc);
+
+		lua_pushnumber (L, res);
+		lua_pushnumber (L, rc);
+		return 2;
+
+	}
+
+	int 
+	sqlsession::submit(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		string sql;
+		if (GetTableStringParam(L,-1,sql,"sql") == FALSE)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		ApiErrorCode res = _sqlSession->sqlite3_submit_batched(sql.c_str());
+
+		lua_pushnumber (L, res);
+		return 1;
+
+	}
+
+	int 
+	sqlsession::flush(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		int failed = 0;
+		ApiErrorCode res = _sqlSession->sqlite3_wait_batched(failed);
+
+		lua_pushnumber (L, res);
+		lua_pushnumber (L, failed);
+		return 2;
+
+	}
+
+	int 
+	sqlsession::query(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		string sql;
+		if (GetTableStringParam(L,-1,sql,"sql") == FALSE)
+		{
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 1;
+		}
+
+		int max_rows = 0;
+		GetTableNumberParam<int>(L,-1,&max_rows,"maxrows",0);
+
+		SqlCursor cursor;
+		cursor.session = _sqlSession;
+		cursor.stmt = NULL;
+		cursor.batch = max_rows;
+		cursor.done = FALSE;
+		cursor.started = TRUE;
+		cursor.streaming = FALSE;
+
+		ApiErrorCode res = PrepareCursor(cursor, sql);
+		if (IW_FAILURE(res))
+		{
+			lua_pushnumber (L, res);
+			return 1;
+		}
+
+		// single round trip for up to maxrows rows
+		int rc = SQLITE_OK;
+		res = _sqlSession->sqlite3_fetch(
+			cursor.stmt, 
+			max_rows, 
+			cursor.columns,
+			cursor.rows, 
+			cursor.done, 
+			rc);
+		CloseCursor(&cursor);
+
+		if (IW_FAILURE(res))
+		{
+			lua_pushnumber (L, res);
+			return 1;
+		}
+
+		lua_pushnumber (L, res);
+		lua_newtable(L);
+
+		int index = 1;
+		for (SqlRowsList::iterator iter = cursor.rows.begin(); 
+			iter != cursor.rows.end(); ++iter)
+		{
+			PushRow(L, cursor.columns, *iter);
+			lua_rawseti(L, -2, index++);
+		}
+
+		return 2;
+
+	}
+
+	int 
+	sqlsession::rows(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnil (L);
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 2;
+		}
+
+		string sql;
+		if (GetTableStringParam(L,-1,sql,"sql") == FALSE)
+		{
+			lua_pushnil (L);
+			lua_pushnumber (L, API_WRONG_PARAMETER);
+			return 2;
+		}
+
+		int batch = 0;
+		GetTableNumberParam<int>(L,-1,&batch,"batch",0);
+
+		SqlCursorPtr cursor(new SqlCursor());
+		cursor->session = _sqlSession;
+		cursor->stmt = NULL;
+		cursor->batch = batch;
+		cursor->done = FALSE;
+		cursor->started = FALSE;
+		cursor->streaming = FALSE;
+
+		ApiErrorCode res = PrepareCursor(*cursor, sql);
+		if (IW_FAILURE(res))
+		{
+			lua_pushnil (L);
+			lua_pushnumber (L, res);
+			return 2;
+		}
+
+		// forget the cursors of the loops that already ended
+		for (SqlCursorsList::iterator iter = _cursors.begin(); 
+			iter != _cursors.end();)
+		{
+			if ((*iter)->stmt == NULL)
+			{
+				iter = _cursors.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		_cursors.push_back(cursor);
+
+		// cursor is shared by the iterator closure and the session, it is
+		// finalized when the loop ends, the session is closed or collected
+		SqlCursorPtr **ud = (SqlCursorPtr **)lua_newuserdata(L, sizeof(SqlCursorPtr *));
+		*ud = new SqlCursorPtr(cursor);
+
+		if (luaL_newmetatable(L, IW_SQL_CURSOR_META))
+		{
+			lua_pushstring(L, "__gc");
+			lua_pushcfunction(L, SqlCursorGc);
+			lua_settable(L, -3);
+		}
+		lua_setmetatable(L, -2);
+
+		lua_pushcclosure(L, SqlCursorNext, 1);
+		return 1;
+
+	}
+
+	int 
+	sqlsession::changes(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, 0);
+			return 1;
+		}
+
+		lua_pushnumber (L, _sqlSession->sqlite3_changes());
+		return 1;
+
+	}
+
+	int 
+	sqlsession::lastrowid(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, 0);
+			return 1;
+		}
+
+		lua_pushnumber (L, (lua_Number)_sqlSession->sqlite3_last_insert_rowid());
+		return 1;
+
+	}
+
+	int 
+	sqlsession::close(lua_State *L)
+	{
+		FUNCTRACKER;
+
+		if (!_sqlSession)
+		{
+			lua_pushnumber (L, API_WRONG_STATE);
+			return 1;
+		}
+
+		CloseCursors();
+		_sqlSession->sqlite3_close();
+
+		lua_pushnumber (L, API_SUCCESS);
+		return 1;
+
+	}
+
+}
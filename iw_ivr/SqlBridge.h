@@ -0,0 +1,68 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+#include "Luna.h"
+#include "LuaObject.h"
+#include "SqliteSession.h"
+
+namespace ivrworx
+{
+	struct SqlCursor;
+
+	typedef
+	shared_ptr<SqlCursor> SqlCursorPtr;
+
+	typedef
+	list<SqlCursorPtr> SqlCursorsList;
+
+	class sqlsession :
+		public luaobject
+	{
+	public:
+		sqlsession(SqliteSessionPtr sqlSession);
+		sqlsession(lua_State *L);
+		virtual ~sqlsession(void);
+
+		int open(lua_State *L);
+		int exec(lua_State *L);
+		int submit(lua_State *L);
+		int flush(lua_State *L);
+		int query(lua_State *L);
+		int rows(lua_State *L);
+		int changes(lua_State *L);
+		int lastrowid(lua_State *L);
+		int close(lua_State *L);
+
+		static const char className[];
+		static Luna<sqlsession>::RegType methods[];
+
+	private:
+
+		void CloseCursors();
+
+		SqliteSessionPtr _sqlSession;
+
+		// iterators returned by rows, a loop left by break 
+		// keeps its statement open until the session is closed
+		SqlCursorsList _cursors;
+	};
+
+
+}
@@ -140,6 +140,10 @@ namespace ivrworx
 
 		string file ;
 		BOOL paramres = GetTableStringParam(L,-1,file,"file");
+
+		// ordered playlist, played back to back
+		list<string> files;
+		GetTableStringListParam(L,-1,files,"files");
 		
 
 		bool sync = true;
@@ -149,8 +153,9 @@ namespace ivrworx
 		GetTableBoolParam(L,-1,&loop,"loop");
 		
 
-		ApiErrorCode res =
-			_streamingSessionPtr->PlayFile(file,sync,loop);
+		ApiErrorCode res = files.empty() ? 
+			_streamingSessionPtr->PlayFile(file,sync,loop) :
+			_streamingSessionPtr->PlayFiles(files,sync,loop);
 
 		lua_pushnumber (L, res);
 		return 1;
@@ -0,0 +1,472 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "TtsCache.h"
+#include "ProcTtsCapture.h"
+
+// report hit rate every 100 lookups
+#define IW_TTS_CACHE_STATS_INTERVAL		100
+
+#define IW_DEFAULT_TTS_CACHE_DIR		"tts_cache"
+
+#define IW_DEFAULT_TTS_CACHE_MAX_MB		256
+
+// captures are bound by mrcp and streamer timeouts
+#define IW_TTS_CAPTURE_STOP_TIMEOUT		30000
+
+namespace ivrworx
+{
+	TtsCache::TtsCache(
+		IN const string &sounds_dir, 
+		IN const string &cache_dir, 
+		IN size_t max_bytes):
+	_soundsDir(sounds_dir),
+	_cacheDir(cache_dir),
+	_maxBytes(max_bytes),
+	_totalBytes(0),
+	_hits(0),
+	_misses(0),
+	_captures(0),
+	_evictions(0),
+	_captureThread(NULL)
+	{
+		FUNCTRACKER;
+
+		::CreateDirectoryA((_soundsDir + "\\" + _cacheDir).c_str(), NULL);
+
+		LoadIndex();
+	}
+
+	TtsCache::~TtsCache()
+	{
+		FUNCTRACKER;
+
+		if (_captureThread != NULL)
+		{
+			// captures in progress are finished before the thread exits
+			_capturePair.inbound->Send(new MsgShutdownReq());
+			if (::WaitForSingleObject(_captureThread, IW_TTS_CAPTURE_STOP_TIMEOUT) != WAIT_OBJECT_0)
+			{
+				LogWarn("TtsCache::~TtsCache - capture thread did not stop");
+			}
+
+			::CloseHandle(_captureThread);
+			_captureThread = NULL;
+		}
+	}
+
+	DWORD WINAPI
+	TtsCache::CaptureThread(LPVOID param)
+	{
+		TtsCache *cache = (TtsCache *)param;
+
+		Start_CPPCSP();
+
+		csp::RunInThisThread(new ProcTtsCaptureRunner(cache->_capturePair, *cache));
+
+		End_CPPCSP();
+
+		return 0;
+	}
+
+	ApiErrorCode
+	TtsCache::StartCapture(
+		IN ConfigurationPtr conf,
+		IN const string &key, 
+		IN const MrcpParams &params, 
+		IN const string &body)
+	{
+		FUNCTRACKER;
+
+		{
+			mutex::scoped_lock lock(_mutex);
+
+			if (_captureThread == NULL)
+			{
+				DECLARE_NAMED_HANDLE_PAIR(capture_pair);
+				_capturePair = capture_pair;
+
+				DWORD dwThreadId = 0;
+				_captureThread = ::CreateThread( 
+					NULL,                   // default security attributes
+					0,                      // use default stack size  
+					CaptureThread,			// thread function name
+					this,			        // argument to thread function 
+					0,                      // use default creation flags 
+					&dwThreadId);			// returns the thread identifier 
+
+				if (_captureThread == NULL)
+				{
+					LogSysError("::CreateThread");
+					_capturing.erase(key);
+					return API_FAILURE;
+				}
+			}
+		}
+
+		MsgTtsCaptureReq *req = new MsgTtsCaptureReq();
+		req->conf	= conf;
+		req->key	= key;
+		req->params = params;
+		req->body	= body;
+
+		ApiErrorCode res = _capturePair.inbound->Send(req);
+		if (IW_FAILURE(res))
+		{
+			LogWarn("TtsCache::StartCapture - cannot queue key:" << key << ", res:" << res);
+			AbortCapture(key);
+		}
+
+		return res;
+	}
+
+	string
+	TtsCache::NormalizeSsml(IN const string &ssml)
+	{
+		string res;
+		res.reserve(ssml.size());
+
+		BOOL pending_space = FALSE;
+		for (string::const_iterator iter = ssml.begin(); iter != ssml.end(); ++iter)
+		{
+			char c = *iter;
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+			{
+				pending_space = TRUE;
+				continue;
+			}
+
+			// whitespace between tags and at the edges is formatting only
+			if (pending_space && !res.empty() && 
+				res[res.size() - 1] != '>' && c != '<')
+			{
+				res += ' ';
+			}
+
+			pending_space = FALSE;
+			res += c;
+		}
+
+		return res;
+	}
+
+	string
+	TtsCache::MakeKey(
+		IN const string &ssml, 
+		IN const string &voice, 
+		IN const string &codec)
+	{
+		// 64 bit FNV-1a over all the fields separated by zero
+		unsigned __int64 hash = 14695981039346656037ULL;
+
+		string normalized = NormalizeSsml(ssml);
+		const string *fields[] = {&normalized, &voice, &codec};
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const string &field = *fields[i];
+			for (size_t j = 0; j <= field.size(); ++j)
+			{
+				unsigned char c = j < field.size() ? (unsigned char)field[j] : 0;
+				hash ^= c;
+				hash *= 1099511628211ULL;
+			}
+		}
+
+		char buf[17];
+		::_snprintf_s(buf, sizeof(buf), _TRUNCATE, "%016I64x", hash);
+
+		return string(buf);
+	}
+
+	string
+	TtsCache::FileName(IN const string &key)
+	{
+		return _cacheDir + "\\" + key + ".wav";
+	}
+
+	string
+	TtsCache::FullPath(IN const string &key)
+	{
+		return _soundsDir + "\\" + FileName(key);
+	}
+
+	void
+	TtsCache::LoadIndex()
+	{
+		FUNCTRACKER;
+
+		// ordered by last write time
+		typedef multimap<unsigned __int64, TtsCacheEntry> TimedEntries;
+		TimedEntries entries;
+
+		WIN32_FIND_DATAA find_data;
+		string pattern = _soundsDir + "\\" + _cacheDir + "\\*.wav";
+
+		HANDLE find_handle = ::FindFirstFileA(pattern.c_str(), &find_data);
+		if (find_handle == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		do 
+		{
+			string name = find_data.cFileName;
+
+			TtsCacheEntry entry;
+			entry.key  = name.substr(0, name.size() - 4);
+			entry.size = find_data.nFileSizeLow;
+
+			unsigned __int64 time = 
+				((unsigned __int64)find_data.ftLastWriteTime.dwHighDateTime << 32) | 
+				find_data.ftLastWriteTime.dwLowDateTime;
+
+			entries.insert(TimedEntries::value_type(time, entry));
+
+		} while (::FindNextFileA(find_handle, &find_data));
+
+		::FindClose(find_handle);
+
+		// newest first, files left from previous runs keep their LRU order
+		for (TimedEntries::reverse_iterator iter = entries.rbegin(); iter != entries.rend(); ++iter)
+		{
+			_lru.push_back(iter->second);
+			_index[iter->second.key] = --_lru.end();
+			_totalBytes += iter->second.size;
+		}
+
+		LogInfo("TtsCache::LoadIndex - entries:" << _index.size() << ", bytes:" << _totalBytes);
+
+		EvictIfNeeded();
+	}
+
+	BOOL
+	TtsCache::Lookup(IN const string &key, OUT string &file_name)
+	{
+		mutex::scoped_lock lock(_mutex);
+
+		TtsCacheIndex::iterator iter = _index.find(key);
+		BOOL found = (iter != _index.end());
+
+		if (found)
+		{
+			_hits++;
+
+			// move to the head of LRU
+			_lru.splice(_lru.begin(), _lru, iter->second);
+			file_name = FileName(key);
+		}
+		else
+		{
+			_misses++;
+		}
+
+		if ((_hits + _misses) % IW_TTS_CACHE_STATS_INTERVAL == 0)
+		{
+			LogStats();
+		}
+
+		return found;
+	}
+
+	BOOL
+	TtsCache::BeginCapture(IN const string &key)
+	{
+		mutex::scoped_lock lock(_mutex);
+
+		if (_index.find(key) != _index.end() || 
+			_capturing.find(key) != _capturing.end())
+		{
+			return FALSE;
+		}
+
+		// a new capture would replace the file still waiting to be deleted
+		for (TtsCacheLru::iterator iter = _pendingDeletes.begin(); 
+			iter != _pendingDeletes.end(); ++iter)
+		{
+			if (iter->key == key)
+			{
+				return FALSE;
+			}
+		}
+
+		_capturing.insert(key);
+		return TRUE;
+	}
+
+	void
+	TtsCache::AbortCapture(IN const string &key)
+	{
+		mutex::scoped_lock lock(_mutex);
+
+		_capturing.erase(key);
+	}
+
+	ApiErrorCode
+	TtsCache::CommitCapture(IN const string &key, IN const string &captured_path)
+	{
+		FUNCTRACKER;
+
+		mutex::scoped_lock lock(_mutex);
+
+		// key stays reserved, caller may retry
+		string path = FullPath(key);
+		if (!::MoveFileExA(captured_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED))
+		{
+			LogDebug("TtsCache::CommitCapture - cannot move " << captured_path << ", err:" << ::GetLastError());
+			return API_FAILURE;
+		}
+
+		_capturing.erase(key);
+
+		WIN32_FILE_ATTRIBUTE_DATA attrs;
+		if (!::GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attrs))
+		{
+			LogSysError("::GetFileAttributesExA");
+			::DeleteFileA(path.c_str());
+			return API_FAILURE;
+		}
+
+		TtsCacheEntry entry;
+		entry.key  = key;
+		entry.size = attrs.nFileSizeLow;
+
+		_lru.push_front(entry);
+		_index[key] = _lru.begin();
+		_totalBytes += entry.size;
+		_captures++;
+
+		LogDebug("TtsCache::CommitCapture - key:" << key << ", bytes:" << entry.size);
+
+		EvictIfNeeded();
+
+		return API_SUCCESS;
+	}
+
+	BOOL
+	TtsCache::DeleteEntry(IN const TtsCacheEntry &entry)
+	{
+		if (!::DeleteFileA(FullPath(entry.key).c_str()))
+		{
+			DWORD err = ::GetLastError();
+			if (err != ERROR_FILE_NOT_FOUND)
+			{
+				LogWarn("TtsCache::DeleteEntry - cannot delete " << FullPath(entry.key) << ", err:" << err);
+				return FALSE;
+			}
+		}
+
+		_totalBytes -= entry.size;
+		return TRUE;
+	}
+
+	void
+	TtsCache::EvictIfNeeded()
+	{
+		// files which were still played on the previous pass
+		for (TtsCacheLru::iterator iter = _pendingDeletes.begin(); 
+			iter != _pendingDeletes.end();)
+		{
+			if (DeleteEntry(*iter))
+			{
+				iter = _pendingDeletes.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+
+		// never evict the entry just added
+		while (_totalBytes > _maxBytes && _lru.size() > 1)
+		{
+			TtsCacheEntry victim = _lru.back();
+
+			_index.erase(victim.key);
+			_lru.pop_back();
+			_evictions++;
+
+			// file may be still played, it is retried on the next pass
+			if (!DeleteEntry(victim))
+			{
+				_pendingDeletes.push_back(victim);
+			}
+		}
+	}
+
+	void
+	TtsCache::LogStats()
+	{
+		unsigned long lookups = _hits + _misses;
+
+		LogInfo("Tts cache - entries:" << _index.size() 
+			<< ", bytes:"		<< _totalBytes 
+			<< ", hits:"		<< _hits 
+			<< ", misses:"		<< _misses 
+			<< ", hit rate:"	<< (lookups ? (_hits*100)/lookups : 0) << "%" 
+			<< ", captures:"	<< _captures 
+			<< ", evictions:"	<< _evictions
+			<< ", pending deletes:" << _pendingDeletes.size());
+	}
+
+	static mutex g_ttsCacheMutex;
+
+	static TtsCachePtr g_ttsCache;
+
+	TtsCachePtr 
+	GetTtsCache(IN ConfigurationPtr conf)
+	{
+		if (!conf->HasOption("ivr/tts_cache") || !conf->GetBool("ivr/tts_cache"))
+		{
+			return TtsCachePtr();
+		}
+
+		mutex::scoped_lock lock(g_ttsCacheMutex);
+
+		if (!g_ttsCache)
+		{
+			string cache_dir = conf->HasOption("ivr/tts_cache_dir") ? 
+				conf->GetString("ivr/tts_cache_dir") : IW_DEFAULT_TTS_CACHE_DIR;
+
+			int max_mb = conf->HasOption("ivr/tts_cache_max_mb") ? 
+				conf->GetInt("ivr/tts_cache_max_mb") : IW_DEFAULT_TTS_CACHE_MAX_MB;
+
+			g_ttsCache = TtsCachePtr(new TtsCache(
+				conf->GetString("m2ims/sounds_dir"), 
+				cache_dir, 
+				(max_mb > 0 ? max_mb : IW_DEFAULT_TTS_CACHE_MAX_MB)*1024*1024));
+		}
+
+		return g_ttsCache;
+	}
+
+	void
+	ReleaseTtsCache()
+	{
+		TtsCachePtr cache;
+		{
+			mutex::scoped_lock lock(g_ttsCacheMutex);
+			cache.swap(g_ttsCache);
+		}
+
+		// waits for the captures in progress without holding the lock
+		cache.reset();
+	}
+
+}
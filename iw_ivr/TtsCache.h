@@ -0,0 +1,154 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	/**
+
+	Content-addressed cache of synthesized prompts. Every entry is a wav
+	file named after the hash of the normalized SSML, the voice and the codec
+	it was captured with, so the streamer can play it instead of asking 
+	the TTS server for the same synthesis again. Files live under the 
+	streamer sounds directory and are evicted in LRU order once the cache
+	grows over its size limit. Shared by all scripts of the process.
+
+	Captures run on a thread owned by the cache, so the call that asked
+	for a capture may end without waiting for it.
+
+	**/
+	class TtsCache:
+		public boost::noncopyable
+	{
+	public:
+
+		TtsCache(
+			IN const string &sounds_dir, 
+			IN const string &cache_dir, 
+			IN size_t max_bytes);
+
+		virtual ~TtsCache();
+
+		static string NormalizeSsml(
+			IN const string &ssml);
+
+		static string MakeKey(
+			IN const string &ssml, 
+			IN const string &voice, 
+			IN const string &codec);
+
+		// file name is relative to sounds dir and may be passed to streamer as is
+		BOOL Lookup(
+			IN const string &key, 
+			OUT string &file_name);
+
+		// FALSE if the key is cached or some call captures it already
+		BOOL BeginCapture(
+			IN const string &key);
+
+		ApiErrorCode CommitCapture(
+			IN const string &key, 
+			IN const string &captured_path);
+
+		void AbortCapture(
+			IN const string &key);
+
+		// runs the capture of a key reserved by BeginCapture on the capture thread
+		ApiErrorCode StartCapture(
+			IN ConfigurationPtr conf,
+			IN const string &key, 
+			IN const MrcpParams &params, 
+			IN const string &body);
+
+		void LogStats();
+
+	private:
+
+		struct TtsCacheEntry
+		{
+			string key;
+
+			size_t size;
+		};
+
+		typedef 
+		list<TtsCacheEntry> TtsCacheLru;
+
+		typedef 
+		map<string, TtsCacheLru::iterator> TtsCacheIndex;
+
+		void LoadIndex();
+
+		void EvictIfNeeded();
+
+		BOOL DeleteEntry(IN const TtsCacheEntry &entry);
+
+		string FullPath(IN const string &key);
+
+		string FileName(IN const string &key);
+
+		static DWORD WINAPI CaptureThread(LPVOID param);
+
+		mutex _mutex;
+
+		string _soundsDir;
+
+		string _cacheDir;
+
+		size_t _maxBytes;
+
+		size_t _totalBytes;
+
+		// most recently used first
+		TtsCacheLru _lru;
+
+		TtsCacheIndex _index;
+
+		// evicted entries whose files could not be deleted yet, 
+		// their bytes are counted until the delete succeeds
+		TtsCacheLru _pendingDeletes;
+
+		set<string> _capturing;
+
+		unsigned long _hits;
+
+		unsigned long _misses;
+
+		unsigned long _captures;
+
+		unsigned long _evictions;
+
+		HANDLE _captureThread;
+
+		LpHandlePair _capturePair;
+
+	};
+
+	typedef
+	shared_ptr<TtsCache> TtsCachePtr;
+
+	// NULL if ivr/tts_cache is disabled
+	TtsCachePtr GetTtsCache(IN ConfigurationPtr conf);
+
+	// stops the capture thread once the scripts are over, 
+	// rather than at the module unload under the loader lock
+	void ReleaseTtsCache();
+
+}
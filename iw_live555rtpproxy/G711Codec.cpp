@@ -0,0 +1,195 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "G711Codec.h"
+
+namespace ivrworx
+{
+	PcmCodec 
+	PcmCodecFromMediaFormat(IN const MediaFormat &media_format)
+	{
+		// no resampling
+		if (media_format.sampling_rate() != 8000)
+		{
+			return PCM_CODEC_UNKNOWN;
+		}
+
+		string name = media_format.sdp_name_tos();
+		boost::to_upper(name);
+
+		if (name == "PCMU") return PCM_CODEC_ULAW;
+		if (name == "PCMA") return PCM_CODEC_ALAW;
+		if (name == "L16")  return PCM_CODEC_L16;
+
+		return PCM_CODEC_UNKNOWN;
+	}
+
+	unsigned 
+	PcmBytesPerSample(IN PcmCodec codec)
+	{
+		switch (codec)
+		{
+		case PCM_CODEC_ULAW:
+		case PCM_CODEC_ALAW:
+			return 1;
+		case PCM_CODEC_L16:
+			return 2;
+		default:
+			return 0;
+		}
+	}
+
+	unsigned
+	DecodeToLinear(
+		IN PcmCodec codec, 
+		IN const unsigned char *in, 
+		IN unsigned in_len, 
+		OUT short *out, 
+		IN unsigned max_samples)
+	{
+		unsigned samples = 0;
+		switch (codec)
+		{
+		case PCM_CODEC_ULAW:
+			{
+				samples = min(in_len, max_samples);
+				UlawToLinear(in, out, samples);
+				break;
+			}
+		case PCM_CODEC_ALAW:
+			{
+				samples = min(in_len, max_samples);
+				AlawToLinear(in, out, samples);
+				break;
+			}
+		case PCM_CODEC_L16:
+			{
+				// network order on the wire
+				samples = min(in_len/2, max_samples);
+				for (unsigned i = 0; i < samples; i++)
+				{
+					out[i] = (short)((in[2*i] << 8) | in[2*i + 1]);
+				}
+				break;
+			}
+		default:
+			{
+			}
+		}
+
+		return samples;
+	}
+
+	unsigned
+	EncodeFromLinear(
+		IN PcmCodec codec, 
+		IN const short *in, 
+		IN unsigned samples, 
+		OUT unsigned char *out, 
+		IN unsigned max_len)
+	{
+		switch (codec)
+		{
+		case PCM_CODEC_ULAW:
+			{
+				samples = min(samples, max_len);
+				LinearToUlaw(in, out, samples);
+				return samples;
+			}
+		case PCM_CODEC_ALAW:
+			{
+				samples = min(samples, max_len);
+				LinearToAlaw(in, out, samples);
+				return samples;
+			}
+		case PCM_CODEC_L16:
+			{
+				samples = min(samples, max_len/2);
+				for (unsigned i = 0; i < samples; i++)
+				{
+					out[2*i]	 = (unsigned char)(((unsigned short)in[i]) >> 8);
+					out[2*i + 1] = (unsigned char)(in[i] & 0xFF);
+				}
+				return samples*2;
+			}
+		default:
+			{
+				return 0;
+			}
+		}
+	}
+
+	unsigned
+	TranscodeFrame(
+		IN PcmCodec from, 
+		IN const unsigned char *in, 
+		IN unsigned in_len, 
+		IN PcmCodec to, 
+		OUT unsigned char *out, 
+		IN unsigned max_len)
+	{
+		if (from == to)
+		{
+			unsigned len = min(in_len, max_len);
+			::memcpy(out, in, len);
+			return len;
+		}
+
+		// direct 8 bit mappings
+		if (from == PCM_CODEC_ULAW && to == PCM_CODEC_ALAW)
+		{
+			unsigned len = min(in_len, max_len);
+			UlawToAlaw(in, out, len);
+			return len;
+		}
+
+		if (from == PCM_CODEC_ALAW && to == PCM_CODEC_ULAW)
+		{
+			unsigned len = min(in_len, max_len);
+			AlawToUlaw(in, out, len);
+			return len;
+		}
+
+		// everything else goes via linear, frame by frame
+		short linear[PCM_FRAME_SAMPLES];
+		unsigned written = 0;
+		unsigned in_bps = PcmBytesPerSample(from);
+		if (in_bps == 0 || PcmBytesPerSample(to) == 0)
+		{
+			return 0;
+		}
+
+		while (in_len >= in_bps)
+		{
+			unsigned samples = DecodeToLinear(from, in, in_len, linear, PCM_FRAME_SAMPLES);
+			unsigned encoded = EncodeFromLinear(to, linear, samples, out + written, max_len - written);
+			if (encoded == 0)
+			{
+				break;
+			}
+
+			written += encoded;
+			in		+= samples*in_bps;
+			in_len	-= samples*in_bps;
+		}
+
+		return written;
+	}
+
+}
@@ -0,0 +1,81 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "G711.h"
+
+namespace ivrworx
+{
+	enum PcmCodec
+	{
+		PCM_CODEC_UNKNOWN,
+		PCM_CODEC_ULAW,
+		PCM_CODEC_ALAW,
+		PCM_CODEC_L16
+	};
+
+	//
+	// 20 ms of narrowband audio
+	//
+	#define PCM_FRAME_SAMPLES 160
+
+	PcmCodec 
+	PcmCodecFromMediaFormat(IN const MediaFormat &media_format);
+
+	unsigned 
+	PcmBytesPerSample(IN PcmCodec codec);
+
+	//
+	// Decodes rtp payload of given codec to host order linear samples.
+	// Returns number of decoded samples.
+	//
+	unsigned
+	DecodeToLinear(
+		IN PcmCodec codec, 
+		IN const unsigned char *in, 
+		IN unsigned in_len, 
+		OUT short *out, 
+		IN unsigned max_samples);
+
+	//
+	// Encodes host order linear samples to rtp payload of given codec.
+	// Returns number of bytes written.
+	//
+	unsigned
+	EncodeFromLinear(
+		IN PcmCodec codec, 
+		IN const short *in, 
+		IN unsigned samples, 
+		OUT unsigned char *out, 
+		IN unsigned max_len);
+
+	//
+	// Converts rtp payload between codecs. Returns number of bytes written
+	// to out.
+	//
+	unsigned
+	TranscodeFrame(
+		IN PcmCodec from, 
+		IN const unsigned char *in, 
+		IN unsigned in_len, 
+		IN PcmCodec to, 
+		OUT unsigned char *out, 
+		IN unsigned max_len);
+}
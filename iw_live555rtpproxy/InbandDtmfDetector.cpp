@@ -0,0 +1,198 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "InbandDtmfDetector.h"
+#include <xmmintrin.h>
+
+//
+// thresholds are taken from the well known (spandsp/asterisk) 
+// detector for block of 102 samples of non scaled 16 bit pcm
+//
+#define DTMF_THRESHOLD				8.0e7f
+#define DTMF_NORMAL_TWIST			6.3f	/* 8dB */
+#define DTMF_REVERSE_TWIST			2.5f	/* 4dB */
+#define DTMF_RELATIVE_PEAK_ROW		6.3f	/* 8dB */
+#define DTMF_RELATIVE_PEAK_COL		6.3f	/* 8dB */
+#define DTMF_TO_TOTAL_ENERGY		42.0f
+
+namespace ivrworx
+{
+	//
+	// 2*cos(2*pi*f/8000) for 697, 770, 852, 941, 1209, 1336, 1477, 1633 Hz
+	//
+	static const float g_dtmfCoefs[DTMF_NUM_TONES] = 
+	{
+		1.7077378f, 1.6452810f, 1.5686870f, 1.4782046f, 
+		1.1641040f, 0.9963702f, 0.7986184f, 0.5685327f
+	};
+
+	static const char g_dtmfPositions[] = "123A456B789C*0#D";
+
+	InbandDtmfDetector::InbandDtmfDetector()
+	{
+		Reset();
+	}
+
+	void 
+	InbandDtmfDetector::Reset()
+	{
+		for (int i = 0; i < DTMF_NUM_TONES; i++)
+		{
+			_s1[i] = 0.0f;
+			_s2[i] = 0.0f;
+		}
+
+		_energy = 0.0f;
+		_blockSamples = 0;
+		_lastHit = '\0';
+		_currentDigit = '\0';
+	}
+
+	unsigned 
+	InbandDtmfDetector::Process(
+		IN const short *samples, 
+		IN unsigned count, 
+		OUT char *out_digits, 
+		IN unsigned max_digits)
+	{
+		unsigned detected = 0;
+
+		// state lives in heap allocated source, so unaligned 
+		// loads are used, they happen only once per call
+		const __m128 coef_rows = _mm_loadu_ps(g_dtmfCoefs);
+		const __m128 coef_cols = _mm_loadu_ps(g_dtmfCoefs + 4);
+
+		__m128 s1_rows = _mm_loadu_ps(_s1);
+		__m128 s1_cols = _mm_loadu_ps(_s1 + 4);
+		__m128 s2_rows = _mm_loadu_ps(_s2);
+		__m128 s2_cols = _mm_loadu_ps(_s2 + 4);
+
+		float energy = _energy;
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			float famp = (float)samples[i];
+			energy += famp*famp;
+
+			// s0 = x + coef*s1 - s2 for all 8 tones at once
+			__m128 x = _mm_set1_ps(famp);
+
+			__m128 s0_rows = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(coef_rows, s1_rows)), s2_rows);
+			__m128 s0_cols = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(coef_cols, s1_cols)), s2_cols);
+
+			s2_rows = s1_rows;
+			s2_cols = s1_cols;
+			s1_rows = s0_rows;
+			s1_cols = s0_cols;
+
+			if (++_blockSamples < DTMF_BLOCK_SIZE)
+			{
+				continue;
+			}
+
+			_mm_storeu_ps(_s1, s1_rows);
+			_mm_storeu_ps(_s1 + 4, s1_cols);
+			_mm_storeu_ps(_s2, s2_rows);
+			_mm_storeu_ps(_s2 + 4, s2_cols);
+			_energy = energy;
+
+			char digit = AnalyzeBlock();
+			if (digit != '\0' && detected < max_digits)
+			{
+				out_digits[detected++] = digit;
+			}
+
+			s1_rows = s1_cols = s2_rows = s2_cols = _mm_setzero_ps();
+			energy = 0.0f;
+			_blockSamples = 0;
+		}
+
+		_mm_storeu_ps(_s1, s1_rows);
+		_mm_storeu_ps(_s1 + 4, s1_cols);
+		_mm_storeu_ps(_s2, s2_rows);
+		_mm_storeu_ps(_s2 + 4, s2_cols);
+		_energy = energy;
+
+		return detected;
+	}
+
+	char
+	InbandDtmfDetector::AnalyzeBlock()
+	{
+		float power[DTMF_NUM_TONES];
+		for (int i = 0; i < DTMF_NUM_TONES; i++)
+		{
+			power[i] = _s1[i]*_s1[i] + _s2[i]*_s2[i] - g_dtmfCoefs[i]*_s1[i]*_s2[i];
+		}
+
+		const float *row_power = power;
+		const float *col_power = power + 4;
+
+		int best_row = 0;
+		int best_col = 0;
+		for (int i = 1; i < 4; i++)
+		{
+			if (row_power[i] > row_power[best_row]) best_row = i;
+			if (col_power[i] > col_power[best_col]) best_col = i;
+		}
+
+		char hit = '\0';
+
+		// energy and twist checks
+		if (row_power[best_row] >= DTMF_THRESHOLD && 
+			col_power[best_col] >= DTMF_THRESHOLD &&
+			col_power[best_col] < row_power[best_row]*DTMF_REVERSE_TWIST &&
+			col_power[best_col]*DTMF_NORMAL_TWIST > row_power[best_row])
+		{
+			// relative peak check
+			int i = 0;
+			for (; i < 4; i++)
+			{
+				if ((i != best_col && col_power[i]*DTMF_RELATIVE_PEAK_COL > col_power[best_col]) ||
+					(i != best_row && row_power[i]*DTMF_RELATIVE_PEAK_ROW > row_power[best_row]))
+				{
+					break;
+				}
+			}
+
+			// tones must hold most of the block energy
+			if (i == 4 && 
+				(row_power[best_row] + col_power[best_col]) > DTMF_TO_TOTAL_ENERGY*_energy)
+			{
+				hit = g_dtmfPositions[best_row*4 + best_col];
+			}
+		}
+
+		//
+		// report digit upon second consecutive block, same digit 
+		// is reported again only after it was interrupted
+		//
+		char reported = '\0';
+		if (hit == _lastHit && hit != _currentDigit)
+		{
+			_currentDigit = hit;
+			reported = hit;
+		}
+
+		_lastHit = hit;
+
+		return reported;
+	}
+
+}
@@ -0,0 +1,76 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#define DTMF_NUM_TONES		8
+#define DTMF_BLOCK_SIZE		102
+
+namespace ivrworx
+{
+	/**
+
+	In-band DTMF detector. Runs bank of 8 Goertzel filters (4 row and 4 column 
+	frequencies) over blocks of 102 samples at 8kHz. Filters are updated together 
+	with SSE, two registers of four lanes each. Block result is validated with 
+	energy, twist and relative peak checks, and digit is reported once it is 
+	seen in two consecutive blocks.
+
+	Detector does not allocate memory and keeps its state between frames so it 
+	may be fed with frames of any length.
+
+	**/
+	class InbandDtmfDetector
+	{
+	public:
+
+		InbandDtmfDetector();
+
+		void Reset();
+
+		//
+		// Returns number of digits detected in the supplied samples,
+		// digits are written into out_digits (up to max_digits).
+		//
+		unsigned Process(
+			IN const short *samples, 
+			IN unsigned count, 
+			OUT char *out_digits, 
+			IN unsigned max_digits);
+
+	private:
+
+		char AnalyzeBlock();
+
+		// rows are lanes 0-3 and columns 4-7
+		float _s1[DTMF_NUM_TONES];
+
+		float _s2[DTMF_NUM_TONES];
+
+		float _energy;
+
+		unsigned _blockSamples;
+
+		char _lastHit;
+
+		char _currentDigit;
+
+	};
+
+}
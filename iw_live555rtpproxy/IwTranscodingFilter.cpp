@@ -0,0 +1,114 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "IwTranscodingFilter.h"
+
+namespace ivrworx
+{
+	IwTranscodingFilter* 
+	IwTranscodingFilter::createNew(UsageEnvironment& env, 
+		FramedSource* inputSource, 
+		PcmCodec from, 
+		PcmCodec to)
+	{
+		return new IwTranscodingFilter(env, inputSource, from, to);
+	}
+
+	BOOL 
+	IwTranscodingFilter::NeedsTranscoding(
+		IN const MediaFormat &from, 
+		IN const MediaFormat &to)
+	{
+		return from != to && 
+			PcmCodecFromMediaFormat(from) != PcmCodecFromMediaFormat(to);
+	}
+
+	BOOL 
+	IwTranscodingFilter::CanTranscode(
+		IN const MediaFormat &from, 
+		IN const MediaFormat &to)
+	{
+		if (from == to)
+		{
+			return TRUE;
+		}
+
+		return 
+			PcmCodecFromMediaFormat(from) != PCM_CODEC_UNKNOWN &&
+			PcmCodecFromMediaFormat(to)	  != PCM_CODEC_UNKNOWN;
+	}
+
+	IwTranscodingFilter::IwTranscodingFilter(UsageEnvironment& env, 
+		FramedSource* inputSource, 
+		PcmCodec from, 
+		PcmCodec to):
+	FramedFilter(env, inputSource),
+	_from(from),
+	_to(to)
+	{
+
+	}
+
+	IwTranscodingFilter::~IwTranscodingFilter()
+	{
+
+	}
+
+	void 
+	IwTranscodingFilter::doGetNextFrame()
+	{
+		// read no more than we are able to deliver after conversion
+		unsigned max_input = 
+			(fMaxSize * PcmBytesPerSample(_from)) / PcmBytesPerSample(_to);
+
+		if (max_input > sizeof(_buffer))
+		{
+			max_input = sizeof(_buffer);
+		}
+
+		fInputSource->getNextFrame(_buffer, max_input,
+			afterGettingFrame, this,
+			FramedSource::handleClosure, this);
+	}
+
+	void 
+	IwTranscodingFilter::afterGettingFrame(void* clientData, unsigned frameSize,
+		unsigned numTruncatedBytes,
+		struct timeval presentationTime,
+		unsigned durationInMicroseconds)
+	{
+		IwTranscodingFilter* filter = (IwTranscodingFilter*)clientData;
+		filter->afterGettingFrame1(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
+	}
+
+	void 
+	IwTranscodingFilter::afterGettingFrame1(unsigned frameSize,
+		unsigned numTruncatedBytes,
+		struct timeval presentationTime,
+		unsigned durationInMicroseconds)
+	{
+		fFrameSize = TranscodeFrame(_from, _buffer, frameSize, _to, fTo, fMaxSize);
+		fNumTruncatedBytes = numTruncatedBytes;
+		fPresentationTime = presentationTime;
+		fDurationInMicroseconds = durationInMicroseconds;
+
+		FramedSource::afterGetting(this);
+	}
+
+}
@@ -0,0 +1,90 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "G711Codec.h"
+
+#define TRANSCODING_FILTER_BUFFER_SIZE 2048
+
+namespace ivrworx
+{
+	/**
+
+	Framed filter placed between rtp source and rtp sink of the bridge
+	when both legs use different narrowband PCM codecs (PCMU, PCMA, L16).
+	Each received frame is converted as a whole.
+
+	**/
+	class IwTranscodingFilter : 
+		public FramedFilter 
+	{
+	public:
+
+		static IwTranscodingFilter* 
+		createNew(UsageEnvironment& env, 
+			FramedSource* inputSource, 
+			PcmCodec from, 
+			PcmCodec to);
+
+		static BOOL 
+		CanTranscode(
+			IN const MediaFormat &from, 
+			IN const MediaFormat &to);
+
+		static BOOL 
+		NeedsTranscoding(
+			IN const MediaFormat &from, 
+			IN const MediaFormat &to);
+
+	protected:
+
+		IwTranscodingFilter(UsageEnvironment& env, 
+			FramedSource* inputSource, 
+			PcmCodec from, 
+			PcmCodec to);
+
+		virtual ~IwTranscodingFilter();
+
+	private:
+		// redefined virtual function:
+		virtual void doGetNextFrame();
+
+	private:
+		static void afterGettingFrame(void* clientData, unsigned frameSize,
+			unsigned numTruncatedBytes,
+			struct timeval presentationTime,
+			unsigned durationInMicroseconds);
+
+		void afterGettingFrame1(unsigned frameSize,
+			unsigned numTruncatedBytes,
+			struct timeval presentationTime,
+			unsigned durationInMicroseconds);
+
+	private:
+
+		PcmCodec _from;
+
+		PcmCodec _to;
+
+		unsigned char _buffer[TRANSCODING_FILTER_BUFFER_SIZE];
+
+	};
+
+}
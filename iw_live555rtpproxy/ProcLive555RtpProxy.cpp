@@ -20,6 +20,7 @@
 #include "ProcLive555RtpProxy.h"
 #include "IwUsageEnvironment.h"
 #include "MockRtpSink.h"
+#include "RtpProxyBenchmark.h"
 
 #define RTP_PROXY_POLL_TIME 10
 
@@ -31,8 +32,11 @@ RtpConnection::RtpConnection()
 :connection_id(NULL),
 state(CONNECTION_STATE_ALLOCATED),
 source(NULL),
+transcoder(NULL),
 sink(NULL),
-rtcp_instance(NULL)
+rtcp_instance(NULL),
+allocated_at(0),
+conference()
 {
 
 }
@@ -78,6 +82,41 @@ void processIwMessagesTask(void* clientData)
 				proxy->UponDeallocateReq(msg);
 				break; 
 			}; 
+		case MSG_RTP_PROXY_STATS_REQ:
+			{ 
+				proxy->UponStatsReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_BENCHMARK_REQ:
+			{ 
+				proxy->UponBenchmarkReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_CONF_ALLOCATE_REQ:
+			{ 
+				proxy->UponConfAllocateReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_CONF_ATTACH_REQ:
+			{ 
+				proxy->UponConfAttachReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_CONF_JOIN_REQ:
+			{ 
+				proxy->UponConfJoinReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_CONF_LEAVE_REQ:
+			{ 
+				proxy->UponConfLeaveReq(msg);
+				break; 
+			}; 
+		case MSG_RTP_PROXY_CONF_DEALLOCATE_REQ:
+			{ 
+				proxy->UponConfDeallocateReq(msg);
+				break; 
+			}; 
 		case MSG_PROC_SHUTDOWN_REQ:
 			{ 
 				proxy->_stopChar = 'S';
@@ -172,6 +211,55 @@ IwSimpleRTPSource::processUnknownPayload( unsigned rtpHdr,
 	return False;
 }
 
+void
+IwSimpleRTPSource::EnableInbandDtmf(PcmCodec codec)
+{
+	_inbandCodec = codec;
+	_inbandDetector.Reset();
+}
+
+Boolean 
+IwSimpleRTPSource::processSpecialHeader(BufferedPacket* packet,
+										unsigned& resultSpecialHeaderSize)
+{
+	if (!SimpleRTPSource::processSpecialHeader(packet,resultSpecialHeaderSize))
+	{
+		return False;
+	}
+
+	if (_inbandCodec == PCM_CODEC_UNKNOWN || !handler)
+	{
+		return True;
+	}
+
+	const unsigned char *payload = packet->data() + resultSpecialHeaderSize;
+	unsigned payload_size = packet->dataSize() - resultSpecialHeaderSize;
+	unsigned bytes_per_sample = PcmBytesPerSample(_inbandCodec);
+
+	short linear[PCM_FRAME_SAMPLES];
+	char digits[8];
+
+	while (payload_size >= bytes_per_sample)
+	{
+		unsigned samples = DecodeToLinear(_inbandCodec, payload, payload_size, linear, PCM_FRAME_SAMPLES);
+
+		unsigned num_of_digits = _inbandDetector.Process(linear, samples, digits, sizeof(digits));
+		for (unsigned i = 0; i < num_of_digits; i++)
+		{
+			LogDebug("IwSimpleRTPSource::processSpecialHeader in-band dtmf:" << digits[i] << ", ssrc: 0x" << hex << SSRC());
+
+			MsgRtpProxyDtmfEvt *evt = new MsgRtpProxyDtmfEvt();
+			evt->signal = string(1,digits[i]);
+			handler->Send(evt);
+		}
+
+		payload		 += samples*bytes_per_sample;
+		payload_size -= samples*bytes_per_sample;
+	}
+
+	return True;
+}
+
 IwSimpleRTPSource::IwSimpleRTPSource(UsageEnvironment& env, 
  Groupsock* RTPgs,
  unsigned char rtpPayloadFormat,
@@ -186,7 +274,8 @@ IwSimpleRTPSource::IwSimpleRTPSource(UsageEnvironment& env,
 		mimeTypeString, 
 		offset,
 		doNormalMBitRule),
-		_packetLogged(FALSE)
+		_packetLogged(FALSE),
+		_inbandCodec(PCM_CODEC_UNKNOWN)
 {
 	_lastTimestamp = 0;
 }
@@ -197,10 +286,16 @@ LightweightProcess(pair,"ProcLive555RtpProxy"),
 _conf(conf),
 _env(NULL),
 _scheduler(NULL),
-_stopChar('\0')
+_stopChar('\0'),
+_inbandDtmf(FALSE),
+_conferenceCounter(0)
 {
 
 	ServiceId(_conf->GetString("live555rtpproxy/uri"));
+
+	_inbandDtmf = 
+		_conf->HasOption("live555rtpproxy/inband_dtmf") && 
+		_conf->GetBool("live555rtpproxy/inband_dtmf");
 	
 }
 
@@ -337,6 +432,8 @@ ProcLive555RtpProxy::real_run()
 		Unbridge(iter->second);
 	};
 
+	_conferencesMap.clear();
+
 	
 	if (_env) _env->reclaim();
 	if (_scheduler) delete _scheduler;
@@ -397,6 +494,7 @@ ProcLive555RtpProxy::UponAllocateReq(IwMessagePtr msg)
 	candidate->dtmf_format	= m.dtmf_format;
 
 	candidate->handler		= req->handler;
+	candidate->allocated_at = ::GetTickCount();
 
 	if (m.connection.is_ip_valid() && 
 		m.connection.is_port_valid())
@@ -476,7 +574,12 @@ ProcLive555RtpProxy::UponDeallocateReq(IwMessagePtr msg)
 	// safe side
 	Unbridge(conn);
 
+	// collect before live555 objects holding the counters are closed
+	MsgRtpProxyStatsAck *ack = new MsgRtpProxyStatsAck();
+	ack->rtp_proxy_handle = conn->connection_id;
+	CollectStats(conn, ack->stats);
 
+	LogDebug("ProcLive555RtpProxy::UponDeallocateReq rtph:" << conn->connection_id << " " << ack->stats);
 
 	if (conn->rtcp_instance) 
 	{
@@ -498,6 +601,126 @@ ProcLive555RtpProxy::UponDeallocateReq(IwMessagePtr msg)
 	}
 	
 	conn->state = CONNECTION_STATE_AVAILABLE;
+
+	if (req->report_stats)
+	{
+		SendResponse(req, ack);
+	}
+	else
+	{
+		delete ack;
+	}
+}
+
+void 
+ProcLive555RtpProxy::UponStatsReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyStatsReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyStatsReq>(msg);
+
+	RtpConnectionsMap::iterator iter = 
+		_connectionsMap.find(req->rtp_proxy_handle);
+	if (iter == _connectionsMap.end() || 
+		iter->second->state == CONNECTION_STATE_AVAILABLE)
+	{
+		LogWarn("ProcLive555RtpProxy::UponStatsReq rtph:" << req->rtp_proxy_handle << " not allocated");
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	MsgRtpProxyStatsAck *ack = new MsgRtpProxyStatsAck();
+	ack->rtp_proxy_handle = req->rtp_proxy_handle;
+	CollectStats(iter->second, ack->stats);
+
+	SendResponse(req, ack);
+}
+
+void 
+ProcLive555RtpProxy::UponBenchmarkReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyBenchmarkReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyBenchmarkReq>(msg);
+
+	if (req->frames <= 0 || req->participants <= 0)
+	{
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	// runs on the scheduler thread, media of all connections waits
+	LogInfo("ProcLive555RtpProxy::UponBenchmarkReq - running benchmark over " << req->frames << " frames");
+
+	MsgRtpProxyBenchmarkAck *ack = new MsgRtpProxyBenchmarkAck();
+	ack->result.transcode_ns = BenchmarkTranscoding(req->frames);
+	ack->result.dtmf_ns		 = BenchmarkInbandDtmf(req->frames);
+	ack->result.mix_ns		 = BenchmarkConferenceMix(req->frames, req->participants);
+
+	SendResponse(req, ack);
+}
+
+void
+ProcLive555RtpProxy::CollectStats(RtpConnectionPtr conn, RtpQualityStats &stats)
+{
+	FUNCTRACKER;
+
+	//
+	// Per packet accounting is done by live555 itself (RTPReceptionStatsDB 
+	// is updated on every incoming packet and RTPTransmissionStatsDB on every 
+	// incoming RR), so we only walk the per SSRC records upon request.
+	//
+	stats.duration_ms = ::GetTickCount() - conn->allocated_at;
+
+	if (conn->source)
+	{
+		unsigned frequency = conn->media_format.sampling_rate();
+
+		RTPReceptionStatsDB::Iterator iter(conn->source->receptionStatsDB());
+		RTPReceptionStats* rs = NULL;
+		while ((rs = iter.next(True)) != NULL)
+		{
+			stats.packets_received += rs->totNumPacketsReceived();
+			stats.packets_expected += rs->totNumPacketsExpected();
+			stats.octets_received  += (unsigned long)(rs->totNumKBytesReceived()*1024);
+
+			// jitter is kept in timestamp units
+			double jitter_ms = frequency == 0 ? 0 : (rs->jitter()*1000.0)/frequency;
+			stats.jitter_ms = max(stats.jitter_ms, jitter_ms);
+		}
+
+		stats.packets_lost = (long)stats.packets_expected - (long)stats.packets_received;
+	}
+
+	if (conn->sink && conn->sink->isRTPSink())
+	{
+		RTPSink *rtp_sink = (RTPSink*)conn->sink;
+
+		stats.packets_sent = rtp_sink->packetCount();
+		stats.octets_sent  = rtp_sink->octetCount();
+
+		RTPTransmissionStatsDB::Iterator iter(rtp_sink->transmissionStatsDB());
+		RTPTransmissionStats* ts = NULL;
+		while ((ts = iter.next()) != NULL)
+		{
+			// round trip is in units of 1/65536 seconds, 
+			// zero means that no RR with LSR was received yet
+			unsigned rtd = ts->roundTripDelay();
+			if (rtd != 0)
+			{
+				stats.rtt_ms = (rtd*1000.0)/65536;
+			}
+		}
+	}
+
+	if (stats.duration_ms > 0)
+	{
+		stats.kbps_in  = (stats.octets_received * 8.0)/stats.duration_ms;
+		stats.kbps_out = (stats.octets_sent * 8.0)/stats.duration_ms;
+	}
+
 }
 
 void 
@@ -574,6 +797,15 @@ ProcLive555RtpProxy::DoUnbridge(RtpConnectionPtr src, RtpConnectionPtr dst)
 		dst->source_conn = RtpConnectionPtr();
 	}
 
+	// sink has stopped reading from it, the source 
+	// itself is owned by connection so it is not closed
+	if (src && src->transcoder)
+	{
+		src->transcoder->detachInputSource();
+		Medium::close(src->transcoder);
+		src->transcoder = NULL;
+	}
+
 	return API_SUCCESS;
 
 }
@@ -589,6 +821,15 @@ ProcLive555RtpProxy::Unbridge(RtpConnectionPtr conn)
 	RtpConnectionPtr source_conn;
 	RtpConnectionPtr dest_conn;
 
+	// conference owns both directions of the connection
+	if (conn->conference)
+	{
+		conn->conference->Leave(conn->connection_id);
+		conn->conference.reset();
+		conn->state = CONNECTION_STATE_ALLOCATED;
+		return API_SUCCESS;
+	}
+
 	switch (conn->state)
 	{
 	case CONNECTION_STATE_AVAILABLE:
@@ -644,6 +885,75 @@ ProcLive555RtpProxy::Bridge(RtpConnectionPtr source_connection, RtpConnectionPtr
 }
 
 
+IwSimpleRTPSource*
+ProcLive555RtpProxy::CreateSource(RtpConnectionPtr conn)
+{
+	const MediaFormat &media_format = conn->media_format;
+
+	IwSimpleRTPSource *rtp_source = 
+		IwSimpleRTPSource::createNew(
+		*_env,								// env
+		conn->live_rtp_socket.get(),		// RTPgs
+		media_format.sdp_mapping(),			// rtpPayloadFormat
+		media_format.sampling_rate(),		// rtpTimestampFrequency
+		media_format.sdp_name_tos().c_str()	// mimeTypeString
+		);
+
+	if (rtp_source == NULL)
+	{
+		return NULL;
+	}
+
+	rtp_source->cn_format   = conn->cn_format;
+	rtp_source->dtmf_format = conn->dtmf_format;
+	rtp_source->handler		= conn->handler;
+
+	// remote side did not negotiate rfc2833, look for tones in media
+	if (_inbandDtmf && 
+		conn->dtmf_format.get_media_type() != MediaFormat::MediaType_DTMF)
+	{
+		PcmCodec codec = PcmCodecFromMediaFormat(media_format);
+		if (codec != PCM_CODEC_UNKNOWN)
+		{
+			LogDebug("ProcLive555RtpProxy::CreateSource - in-band dtmf detection on rtph:" << conn->connection_id);
+			rtp_source->EnableInbandDtmf(codec);
+		}
+	}
+
+	return rtp_source;
+
+}
+
+MediaSink*
+ProcLive555RtpProxy::CreateSink(RtpConnectionPtr conn, const MediaFormat &media_format)
+{
+	SimpleRTPSink *rtp_sink = 
+		SimpleRTPSink::createNew(
+		*_env,									 // env
+		conn->live_rtp_socket.get(),			 // RTPgs
+		media_format.sdp_mapping(),				 // rtpPayloadFormat
+		media_format.sampling_rate(),			 // rtpTimestampFrequency
+		media_format.sdp_name_tos().c_str(),	 // sdpMediaTypeString
+		media_format.sdp_name_tos().c_str()		 // rtpPayloadFormatName
+		);
+
+	if (rtp_sink == NULL)
+	{
+		return NULL;
+	}
+
+	// linear payload is twice the size of G.711 one
+	int size_factor = 
+		PcmCodecFromMediaFormat(media_format) == PCM_CODEC_L16 ? 2 : 1;
+
+	rtp_sink->setPacketSizes(
+		size_factor*_conf->GetInt("live555rtpproxy/preferred_rtp_size"),
+		size_factor*_conf->GetInt("live555rtpproxy/max_rtp_size"));
+
+	return rtp_sink;
+
+}
+
 ApiErrorCode
 ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination_connection)
 {
@@ -669,25 +979,20 @@ ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination
 
 	MediaFormat		media_format		  = source_connection->media_format;
 
+	// dummy sink just consumes whatever source produces
+	MediaFormat		sink_media_format	  = 
+		using_dummy_sink ? media_format : destination_connection->media_format;
+
+	IwTranscodingFilter *transcoder		  = NULL;
+	FramedSource	*feed				  = NULL;
+
 	{
 		//
 		// source
 		//
 		if (!rtp_source)
 		{
-			rtp_source = 
-				IwSimpleRTPSource::createNew(
-				*_env,											// env
-				source_connection->live_rtp_socket.get(),		// RTPgs
-				media_format.sdp_mapping(),			// rtpPayloadFormat
-				media_format.sampling_rate(),		// rtpTimestampFrequency
-				media_format.sdp_name_tos().c_str()	// mimeTypeString
-				);
-
-			rtp_source->cn_format   = source_connection->cn_format;
-			rtp_source->dtmf_format = source_connection->dtmf_format;
-			rtp_source->handler		= source_connection->handler;
-
+			rtp_source = CreateSource(source_connection);
 			if (rtp_source == NULL)
 			{
 				LogWarn("ProcLive555RtpProxy::UponBridgeReq - Cannot create source");
@@ -726,24 +1031,12 @@ ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination
 			//
 			if (!rtp_sink)
 			{
-				rtp_sink = 
-					SimpleRTPSink::createNew(
-					*_env,											 // env
-					destination_connection->live_rtp_socket.get(),  // RTPgs
-					media_format.sdp_mapping(),			 // rtpPayloadFormat
-					media_format.sampling_rate(),		 // rtpTimestampFrequency
-					media_format.sdp_name_tos().c_str(), // sdpMediaTypeString
-					media_format.sdp_name_tos().c_str()  // rtpPayloadFormatName
-					);
+				rtp_sink = CreateSink(destination_connection, sink_media_format);
 				if (rtp_sink == NULL)
 				{
 					LogWarn("ProcLive555RtpProxy::UponBridgeReq - Cannot create sink instance");
 					goto error;
 				}
-
-				((SimpleRTPSink*)rtp_sink)->setPacketSizes(
-					_conf->GetInt("live555rtpproxy/preferred_rtp_size"),
-					_conf->GetInt("live555rtpproxy/max_rtp_size"));
 			}// rtp_sink creation
 
 
@@ -766,8 +1059,23 @@ ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination
 			} // rtcp creation
 		}// non dummy sink
 
+		feed = rtp_source;
+		if (IwTranscodingFilter::NeedsTranscoding(media_format, sink_media_format))
+		{
+			transcoder = IwTranscodingFilter::createNew(
+				*_env,
+				rtp_source,
+				PcmCodecFromMediaFormat(media_format),
+				PcmCodecFromMediaFormat(sink_media_format));
+
+			feed = transcoder;
+
+			LogDebug("ProcLive555RtpProxy::DoBridge transcoding (" << media_format << ") -> (" << sink_media_format << ")");
+		}
+
 		source_connection->state			= (CONNECTION_STATE) (source_connection->state | CONNECTION_STATE_INPUT);
 		source_connection->source			= rtp_source;
+		source_connection->transcoder		= transcoder;
 		source_connection->destination_conn = destination_connection;
 		source_connection->rtcp_instance	= source_rtcp_instance;
 
@@ -776,7 +1084,7 @@ ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination
 		destination_connection->source_conn		= source_connection;
 		destination_connection->rtcp_instance	= sink_rtcp_instance;
 
-		if (rtp_sink->startPlaying(*rtp_source, NULL, NULL) == FALSE)
+		if (rtp_sink->startPlaying(*feed, NULL, NULL) == FALSE)
 		{
 			LogWarn("ProcLive555RtpProxy::UponBridgeReq error: startPlaying");
 			goto error;
@@ -796,6 +1104,12 @@ ProcLive555RtpProxy::DoBridge(RtpConnectionPtr src, RtpConnectionPtr destination
 
 error:
 
+	if (transcoder != NULL) 
+	{
+		transcoder->detachInputSource();
+		Medium::close(transcoder);
+	}
+
 	if (rtp_source != NULL) Medium::close(rtp_source);
 	if (source_rtcp_instance!= NULL) RTCPInstance::close(source_rtcp_instance);
 
@@ -804,6 +1118,7 @@ error:
 
 
 	source_connection->source			= NULL;
+	source_connection->transcoder		= NULL;
 	source_connection->destination_conn = RtpConnectionPtr();
 	source_connection->rtcp_instance	= NULL;
 
@@ -856,10 +1171,10 @@ ProcLive555RtpProxy::UponBridgeReq(IwMessagePtr msg)
 
 	RtpConnectionPtr destination_connection = iter->second;
 
-	// check codec settings
+	// check codec settings, only PCM family may be transcoded
 	if (source_connection->media_format.get_media_type()      == MediaFormat::MediaType_UNKNOWN	|| 
 		destination_connection->media_format.get_media_type() == MediaFormat::MediaType_UNKNOWN ||
-		destination_connection->media_format != source_connection->media_format)
+		!IwTranscodingFilter::CanTranscode(source_connection->media_format, destination_connection->media_format))
 	{
 		LogWarn("ProcLive555RtpProxy::UponBridgeReq - transcoding not supported src rtph:"
 			<< source_connection->connection_id << "(" << source_connection->media_format << ")" << 
@@ -882,6 +1197,221 @@ ProcLive555RtpProxy::UponBridgeReq(IwMessagePtr msg)
 	
 }
 
+void 
+ProcLive555RtpProxy::UponConfAllocateReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyConfAllocateReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyConfAllocateReq>(msg);
+
+	int conference_id = ++_conferenceCounter;
+	_conferencesMap[conference_id] = 
+		RtpConferencePtr(new RtpConference(*_env, conference_id));
+
+	LogDebug("ProcLive555RtpProxy::UponConfAllocateReq allocated confh:" << conference_id);
+
+	MsgRtpProxyConfAck *ack = new MsgRtpProxyConfAck();
+	ack->conference_handle = conference_id;
+
+	SendResponse(req, ack);
+
+}
+
+void 
+ProcLive555RtpProxy::UponConfAttachReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyConfAttachReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyConfAttachReq>(msg);
+
+	RtpConferencesMap::iterator conf_iter = 
+		_conferencesMap.find(req->conference_handle);
+	if (conf_iter == _conferencesMap.end())
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfAttachReq - confh:" << req->conference_handle << " not found");
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	int references = conf_iter->second->AddReference();
+
+	LogDebug("ProcLive555RtpProxy::UponConfAttachReq attached confh:" << req->conference_handle << ", references:" << references);
+
+	MsgRtpProxyConfAck *ack = new MsgRtpProxyConfAck();
+	ack->conference_handle = req->conference_handle;
+
+	SendResponse(req, ack);
+
+}
+
+void 
+ProcLive555RtpProxy::UponConfJoinReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyConfJoinReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyConfJoinReq>(msg);
+
+	RtpConferencesMap::iterator conf_iter = 
+		_conferencesMap.find(req->conference_handle);
+	if (conf_iter == _conferencesMap.end())
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfJoinReq - confh:" << req->conference_handle << " not found");
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	RtpConnectionsMap::iterator iter = 
+		_connectionsMap.find(req->rtp_proxy_handle);
+	if (iter == _connectionsMap.end() || 
+		iter->second->state == CONNECTION_STATE_AVAILABLE)
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfJoinReq - rtph:" << req->rtp_proxy_handle << " not allocated");
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	RtpConferencePtr conference = conf_iter->second;
+	RtpConnectionPtr conn = iter->second;
+
+	if (conn->conference == conference)
+	{
+		SendResponse(req, new MsgRtpProxyAck());
+		return;
+	}
+
+	// mixer works on linear samples, only PCM family may join
+	PcmCodec codec = PcmCodecFromMediaFormat(conn->media_format);
+	if (codec == PCM_CODEC_UNKNOWN)
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfJoinReq - rtph:" << conn->connection_id << " codec not supported (" << conn->media_format << ")");
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	// leave whatever bridge or conference connection was part of
+	Unbridge(conn);
+
+	if (!conn->source)
+	{
+		conn->source = CreateSource(conn);
+	}
+
+	if (!conn->sink)
+	{
+		conn->sink = CreateSink(conn, conn->media_format);
+	}
+
+	if (!conn->rtcp_instance && conn->sink && conn->source)
+	{
+		conn->rtcp_instance  = 
+			RTCPInstance::createNew(
+			*_env,									// env	
+			conn->live_rtcp_socket.get(),			// RTCPgs
+			500,									// totSessionBW
+			(const unsigned char *)"ivrworx",		// cname
+			(SimpleRTPSink*)conn->sink,				// sink
+			conn->source							// source
+			);
+	}
+
+	if (conn->source == NULL || conn->sink == NULL || conn->rtcp_instance == NULL)
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfJoinReq - Cannot create media for rtph:" << conn->connection_id);
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	if (IW_FAILURE(conference->Join(conn->connection_id, conn->source, conn->sink, codec)))
+	{
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	conn->conference		= conference;
+	conn->state				= CONNECTION_STATE_FULLDUPLEX;
+	conn->source_conn		= RtpConnectionPtr();
+	conn->destination_conn	= RtpConnectionPtr();
+
+	LogDebug("ProcLive555RtpProxy::UponConfJoinReq rtph:" << conn->connection_id << " ==> confh:" << conference->ConferenceId());
+
+	SendResponse(req, new MsgRtpProxyAck());
+
+}
+
+void 
+ProcLive555RtpProxy::UponConfLeaveReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyConfLeaveReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyConfLeaveReq>(msg);
+
+	RtpConnectionsMap::iterator iter = 
+		_connectionsMap.find(req->rtp_proxy_handle);
+	if (iter == _connectionsMap.end() || 
+		!iter->second->conference ||
+		iter->second->conference->ConferenceId() != req->conference_handle)
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfLeaveReq - rtph:" << req->rtp_proxy_handle << " is not in confh:" << req->conference_handle);
+		SendResponse(req, new MsgRtpProxyNack());
+		return;
+	}
+
+	Unbridge(iter->second);
+
+	SendResponse(req, new MsgRtpProxyAck());
+
+}
+
+void 
+ProcLive555RtpProxy::UponConfDeallocateReq(IwMessagePtr msg)
+{
+	FUNCTRACKER;
+
+	shared_ptr<MsgRtpProxyConfDeallocateReq> req = 
+		dynamic_pointer_cast<MsgRtpProxyConfDeallocateReq>(msg);
+
+	RtpConferencesMap::iterator conf_iter = 
+		_conferencesMap.find(req->conference_handle);
+	if (conf_iter == _conferencesMap.end())
+	{
+		LogWarn("ProcLive555RtpProxy::UponConfDeallocateReq - confh:" << req->conference_handle << " not found");
+		return;
+	}
+
+	RtpConferencePtr conference = conf_iter->second;
+
+	// other calls still use the conference
+	int references = conference->ReleaseReference();
+	if (references > 0)
+	{
+		LogDebug("ProcLive555RtpProxy::UponConfDeallocateReq released confh:" << req->conference_handle << ", references:" << references);
+		return;
+	}
+
+	list<int> participants;
+	conference->ParticipantIds(participants);
+
+	for (list<int>::iterator p_iter = participants.begin(); 
+		p_iter != participants.end(); 
+		++p_iter)
+	{
+		RtpConnectionsMap::iterator iter = _connectionsMap.find(*p_iter);
+		if (iter != _connectionsMap.end())
+		{
+			Unbridge(iter->second);
+		}
+	}
+
+	_conferencesMap.erase(conf_iter);
+
+	LogDebug("ProcLive555RtpProxy::UponConfDeallocateReq deallocated confh:" << req->conference_handle);
+
+}
+
 ProcLive555RtpProxy::~ProcLive555RtpProxy(void)
 {
 
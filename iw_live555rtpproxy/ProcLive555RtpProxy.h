@@ -25,6 +25,10 @@
 #endif						
 
 #include "RtpProxySession.h"
+#include "IwTranscodingFilter.h"
+#include "InbandDtmfDetector.h"
+#include "RtpConference.h"
+
 namespace ivrworx
 {
 	enum CONNECTION_STATE
@@ -63,6 +67,11 @@ namespace ivrworx
 			unsigned char rtpPtType,
 			BufferedPacket* packet);
 
+		Boolean processSpecialHeader(BufferedPacket* packet,
+			unsigned& resultSpecialHeaderSize);
+
+		void EnableInbandDtmf(PcmCodec codec);
+
 		MediaFormat dtmf_format;
 
 		MediaFormat cn_format;
@@ -73,6 +82,11 @@ namespace ivrworx
 
 		BOOL _packetLogged;
 
+		// PCM_CODEC_UNKNOWN if in-band detection is off
+		PcmCodec _inbandCodec;
+
+		InbandDtmfDetector _inbandDetector;
+
 	};
 
 	typedef shared_ptr<struct RtpConnection> 
@@ -109,11 +123,19 @@ namespace ivrworx
 		RtpConnectionPtr source_conn;
 		IwSimpleRTPSource* source;
 
+		// set if source feeds destination through codec conversion
+		IwTranscodingFilter* transcoder;
+
 		RtpConnectionPtr destination_conn;
 		MediaSink* sink;
 
 		LpHandlePtr handler;
 
+		DWORD allocated_at;
+
+		// set while connection takes part in conference
+		RtpConferencePtr conference;
+
 	};
 
 	
@@ -140,8 +162,31 @@ namespace ivrworx
 
 		virtual void UponBridgeReq(IwMessagePtr msg);
 
+		virtual void UponStatsReq(IwMessagePtr msg);
+
+		virtual void UponBenchmarkReq(IwMessagePtr msg);
+
+		virtual void UponConfAllocateReq(IwMessagePtr msg);
+
+		virtual void UponConfAttachReq(IwMessagePtr msg);
+
+		virtual void UponConfJoinReq(IwMessagePtr msg);
+
+		virtual void UponConfLeaveReq(IwMessagePtr msg);
+
+		virtual void UponConfDeallocateReq(IwMessagePtr msg);
+
 	private:
 
+		IwSimpleRTPSource*
+		CreateSource(RtpConnectionPtr conn);
+
+		MediaSink*
+		CreateSink(RtpConnectionPtr conn, const MediaFormat &media_format);
+
+		void 
+		CollectStats(RtpConnectionPtr conn, RtpQualityStats &stats);
+
 		ApiErrorCode
 		Bridge(RtpConnectionPtr src, RtpConnectionPtr dst, BOOL fullDuplex);
 
@@ -164,10 +209,18 @@ namespace ivrworx
 		RtpConnectionsMap;
 		RtpConnectionsMap _connectionsMap;
 
+		typedef std::map<int,RtpConferencePtr> 
+		RtpConferencesMap;
+		RtpConferencesMap _conferencesMap;
+
+		int _conferenceCounter;
+
 		in_addr _localInAddr;
 
 		char _stopChar;
 
+		BOOL _inbandDtmf;
+
 		friend void processIwMessagesTask(void* clientData);
 
 	};
@@ -0,0 +1,432 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "RtpConference.h"
+#include <emmintrin.h>
+
+namespace ivrworx
+{
+	static const short g_silence[PCM_FRAME_SAMPLES] = {0};
+
+	void 
+	MixAccumulate(IN OUT int *mix, IN const short *frame, IN unsigned samples)
+	{
+		for (unsigned i = 0; i < samples; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(frame + i));
+
+			// sign extend 8 x int16 into 2 x (4 x int32)
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+
+			__m128i *m = (__m128i*)(mix + i);
+			_mm_storeu_si128(m,		_mm_add_epi32(_mm_loadu_si128(m), lo));
+			_mm_storeu_si128(m + 1, _mm_add_epi32(_mm_loadu_si128(m + 1), hi));
+		}
+	}
+
+	void 
+	MixMinus(IN const int *mix, IN const short *own, OUT short *out, IN unsigned samples)
+	{
+		for (unsigned i = 0; i < samples; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(own + i));
+
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+
+			const __m128i *m = (const __m128i*)(mix + i);
+			lo = _mm_sub_epi32(_mm_loadu_si128(m), lo);
+			hi = _mm_sub_epi32(_mm_loadu_si128(m + 1), hi);
+
+			// pack with signed saturation back to 16 bit
+			_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+		}
+	}
+
+	ConferenceInputSink::ConferenceInputSink(UsageEnvironment& env, PcmCodec codec):
+	MediaSink(env),
+	_codec(codec),
+	_readPos(0),
+	_available(0)
+	{
+
+	}
+
+	ConferenceInputSink::~ConferenceInputSink()
+	{
+
+	}
+
+	Boolean 
+	ConferenceInputSink::continuePlaying() 
+	{
+		if (fSource == NULL) return False; 
+
+		fSource->getNextFrame(_buffer, CONFERENCE_RING_SAMPLES*PcmBytesPerSample(_codec),
+			afterGettingFrame, this,
+			onSourceClosure, this);
+
+		return True;
+	}
+
+	void 
+	ConferenceInputSink::afterGettingFrame(void* clientData, unsigned frameSize,
+		unsigned /*numTruncatedBytes*/,
+		struct timeval /*presentationTime*/,
+		unsigned /*durationInMicroseconds*/) 
+	{
+		ConferenceInputSink* sink = (ConferenceInputSink*)clientData;
+		sink->afterGettingFrame1(frameSize);
+	}
+
+	void 
+	ConferenceInputSink::afterGettingFrame1(unsigned frameSize) 
+	{
+		const unsigned char *payload = _buffer;
+		unsigned bytes_per_sample = PcmBytesPerSample(_codec);
+
+		short linear[PCM_FRAME_SAMPLES];
+		while (frameSize >= bytes_per_sample && bytes_per_sample > 0)
+		{
+			unsigned samples = DecodeToLinear(_codec, payload, frameSize, linear, PCM_FRAME_SAMPLES);
+
+			// make room by dropping the oldest samples, write never reaches unread audio
+			if (_available + samples > CONFERENCE_RING_SAMPLES)
+			{
+				unsigned excess = _available + samples - CONFERENCE_RING_SAMPLES;
+				_readPos = (_readPos + excess) % CONFERENCE_RING_SAMPLES;
+				_available -= excess;
+			}
+
+			unsigned write_pos = (_readPos + _available) % CONFERENCE_RING_SAMPLES;
+			for (unsigned i = 0; i < samples; i++)
+			{
+				_ring[write_pos] = linear[i];
+				write_pos = (write_pos + 1) % CONFERENCE_RING_SAMPLES;
+			}
+			_available += samples;
+
+			payload	  += samples*bytes_per_sample;
+			frameSize -= samples*bytes_per_sample;
+		}
+
+		// drop oldest audio rather than build up delay
+		const unsigned max_available = PCM_FRAME_SAMPLES*CONFERENCE_JITTER_FRAMES;
+		if (_available > max_available)
+		{
+			_readPos = (_readPos + (_available - max_available)) % CONFERENCE_RING_SAMPLES;
+			_available = max_available;
+		}
+
+		continuePlaying();
+	}
+
+	BOOL 
+	ConferenceInputSink::ReadFrame(OUT short *frame)
+	{
+		if (_available < PCM_FRAME_SAMPLES)
+		{
+			return FALSE;
+		}
+
+		for (unsigned i = 0; i < PCM_FRAME_SAMPLES; i++)
+		{
+			frame[i] = _ring[_readPos];
+			_readPos = (_readPos + 1) % CONFERENCE_RING_SAMPLES;
+		}
+		_available -= PCM_FRAME_SAMPLES;
+
+		return TRUE;
+	}
+
+	ConferenceOutputSource::ConferenceOutputSource(UsageEnvironment& env):
+	FramedSource(env)
+	{
+
+	}
+
+	ConferenceOutputSource::~ConferenceOutputSource()
+	{
+
+	}
+
+	void 
+	ConferenceOutputSource::doGetNextFrame()
+	{
+		// frames are pushed by the mixer tick
+	}
+
+	void 
+	ConferenceOutputSource::Deliver(
+		IN const unsigned char *payload, 
+		IN unsigned size, 
+		IN const struct timeval &presentation_time)
+	{
+		// sink is still busy with previous frame
+		if (!isCurrentlyAwaitingData())
+		{
+			return;
+		}
+
+		fFrameSize = size > fMaxSize ? fMaxSize : size;
+		fNumTruncatedBytes = size - fFrameSize;
+		fPresentationTime = presentation_time;
+		fDurationInMicroseconds = CONFERENCE_TICK_US;
+
+		::memcpy(fTo, payload, fFrameSize);
+
+		FramedSource::afterGetting(this);
+	}
+
+	RtpConference::RtpConference(UsageEnvironment& env, int conference_id):
+	_env(env),
+	_conferenceId(conference_id),
+	_references(1),
+	_tickTask(NULL)
+	{
+		_nextTick.tv_sec  = 0;
+		_nextTick.tv_usec = 0;
+	}
+
+	RtpConference::~RtpConference()
+	{
+		FUNCTRACKER;
+
+		while (!_participants.empty())
+		{
+			Leave(_participants.back()->participant_id);
+		}
+	}
+
+	int 
+	RtpConference::ConferenceId()
+	{
+		return _conferenceId;
+	}
+
+	size_t 
+	RtpConference::Size()
+	{
+		return _participants.size();
+	}
+
+	int 
+	RtpConference::AddReference()
+	{
+		return ++_references;
+	}
+
+	int 
+	RtpConference::ReleaseReference()
+	{
+		return --_references;
+	}
+
+	void 
+	RtpConference::ParticipantIds(OUT list<int> &ids)
+	{
+		for (ParticipantsVector::iterator iter = _participants.begin(); 
+			iter != _participants.end(); 
+			++iter)
+		{
+			ids.push_back((*iter)->participant_id);
+		}
+	}
+
+	ApiErrorCode 
+	RtpConference::Join(
+		IN int participant_id, 
+		IN FramedSource *source, 
+		IN MediaSink *sink, 
+		IN PcmCodec codec)
+	{
+		FUNCTRACKER;
+
+		if (source == NULL || sink == NULL || codec == PCM_CODEC_UNKNOWN)
+		{
+			return API_WRONG_PARAMETER;
+		}
+
+		for (ParticipantsVector::iterator iter = _participants.begin(); 
+			iter != _participants.end(); 
+			++iter)
+		{
+			if ((*iter)->participant_id == participant_id)
+			{
+				return API_WRONG_STATE;
+			}
+		}
+
+		Participant *p = new Participant();
+		p->participant_id = participant_id;
+		p->codec	= codec;
+		p->source	= source;
+		p->sink		= sink;
+		p->active	= FALSE;
+		p->input	= new ConferenceInputSink(_env, codec);
+		p->output	= new ConferenceOutputSource(_env);
+
+		if (p->input->startPlaying(*source, NULL, NULL) == FALSE ||
+			sink->startPlaying(*p->output, NULL, NULL) == FALSE)
+		{
+			LogWarn("RtpConference::Join - confh:" << _conferenceId << " cannot start participant:" << participant_id);
+
+			p->input->stopPlaying();
+			Medium::close(p->input);
+			sink->stopPlaying();
+			Medium::close(p->output);
+			delete p;
+
+			return API_FAILURE;
+		}
+
+		_participants.push_back(p);
+
+		if (_tickTask == NULL)
+		{
+			gettimeofday(&_nextTick, NULL);
+			ScheduleTick();
+		}
+
+		LogDebug("RtpConference::Join - confh:" << _conferenceId << " joined:" << participant_id << ", size:" << _participants.size());
+
+		return API_SUCCESS;
+
+	}
+
+	ApiErrorCode 
+	RtpConference::Leave(IN int participant_id)
+	{
+		FUNCTRACKER;
+
+		for (ParticipantsVector::iterator iter = _participants.begin(); 
+			iter != _participants.end(); 
+			++iter)
+		{
+			Participant *p = *iter;
+			if (p->participant_id != participant_id)
+			{
+				continue;
+			}
+
+			p->input->stopPlaying();
+			Medium::close(p->input);
+
+			p->sink->stopPlaying();
+			Medium::close(p->output);
+
+			_participants.erase(iter);
+			delete p;
+
+			if (_participants.empty() && _tickTask != NULL)
+			{
+				_env.taskScheduler().unscheduleDelayedTask(_tickTask);
+				_tickTask = NULL;
+			}
+
+			LogDebug("RtpConference::Leave - confh:" << _conferenceId << " left:" << participant_id << ", size:" << _participants.size());
+
+			return API_SUCCESS;
+		}
+
+		return API_WRONG_PARAMETER;
+
+	}
+
+	void 
+	RtpConference::TickTask(void *clientData)
+	{
+		((RtpConference*)clientData)->Tick();
+	}
+
+	void 
+	RtpConference::ScheduleTick()
+	{
+		// next tick is kept in absolute time so scheduling jitter does not accumulate
+		_nextTick.tv_usec += CONFERENCE_TICK_US;
+		if (_nextTick.tv_usec >= 1000000)
+		{
+			_nextTick.tv_sec  += _nextTick.tv_usec / 1000000;
+			_nextTick.tv_usec %= 1000000;
+		}
+
+		struct timeval now;
+		gettimeofday(&now, NULL);
+
+		__int64 delay_us = 
+			((__int64)(_nextTick.tv_sec - now.tv_sec))*1000000 + (_nextTick.tv_usec - now.tv_usec);
+
+		// we are late, start counting from now
+		if (delay_us < 0)
+		{
+			_nextTick = now;
+			delay_us = 0;
+		}
+
+		_tickTask = _env.taskScheduler().scheduleDelayedTask(delay_us, TickTask, this);
+	}
+
+	void 
+	RtpConference::Tick()
+	{
+		_tickTask = NULL;
+
+		::memset(_mix, 0, sizeof(_mix));
+
+		//
+		// sum everybody once
+		//
+		for (ParticipantsVector::iterator iter = _participants.begin(); 
+			iter != _participants.end(); 
+			++iter)
+		{
+			Participant *p = *iter;
+
+			p->active = p->input->ReadFrame(p->frame);
+			if (p->active)
+			{
+				MixAccumulate(_mix, p->frame, PCM_FRAME_SAMPLES);
+			}
+		}
+
+		struct timeval now;
+		gettimeofday(&now, NULL);
+
+		//
+		// and remove own voice for each
+		//
+		for (ParticipantsVector::iterator iter = _participants.begin(); 
+			iter != _participants.end(); 
+			++iter)
+		{
+			Participant *p = *iter;
+
+			MixMinus(_mix, p->active ? p->frame : g_silence, _out, PCM_FRAME_SAMPLES);
+
+			unsigned size = EncodeFromLinear(p->codec, _out, PCM_FRAME_SAMPLES, _payload, sizeof(_payload));
+
+			p->output->Deliver(_payload, size, now);
+		}
+
+		ScheduleTick();
+
+	}
+
+}
@@ -0,0 +1,203 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "G711Codec.h"
+
+#define CONFERENCE_TICK_US			20000
+#define CONFERENCE_JITTER_FRAMES	4
+#define CONFERENCE_RING_SAMPLES		(PCM_FRAME_SAMPLES*(CONFERENCE_JITTER_FRAMES + 2))
+#define CONFERENCE_MAX_PAYLOAD		(PCM_FRAME_SAMPLES*2)
+
+namespace ivrworx
+{
+	/**
+
+	Consumes frames of participant rtp source and keeps them decoded
+	in small ring until the next mixer tick. Ring is bounded so a 
+	participant that sends faster than the tick cannot add delay.
+
+	**/
+	class ConferenceInputSink : 
+		public MediaSink 
+	{
+	public:
+
+		ConferenceInputSink(UsageEnvironment& env, PcmCodec codec);
+
+		virtual ~ConferenceInputSink();
+
+		// reads one tick worth of samples, FALSE if participant is silent
+		BOOL ReadFrame(OUT short *frame);
+
+	private:
+		// redefined virtual function:
+		virtual Boolean continuePlaying();
+
+	private:
+		static void afterGettingFrame(void* clientData, unsigned frameSize,
+			unsigned numTruncatedBytes,
+			struct timeval presentationTime,
+			unsigned durationInMicroseconds);
+
+		void afterGettingFrame1(unsigned frameSize);
+
+	private:
+
+		PcmCodec _codec;
+
+		// never holds more samples than the ring, L16 is the widest codec
+		unsigned char _buffer[CONFERENCE_RING_SAMPLES*sizeof(short)];
+
+		short _ring[CONFERENCE_RING_SAMPLES];
+
+		unsigned _readPos;
+
+		unsigned _available;
+
+	};
+
+	/**
+
+	Frames produced by mixer for specific participant, read by
+	the participant rtp sink.
+
+	**/
+	class ConferenceOutputSource : 
+		public FramedSource 
+	{
+	public:
+
+		ConferenceOutputSource(UsageEnvironment& env);
+
+		virtual ~ConferenceOutputSource();
+
+		void Deliver(
+			IN const unsigned char *payload, 
+			IN unsigned size, 
+			IN const struct timeval &presentation_time);
+
+	private:
+		// redefined virtual function:
+		virtual void doGetNextFrame();
+
+	};
+
+	/**
+
+	N-party audio mixer. Runs on fixed 20ms tick of the live555 scheduler,
+	each participant receives sum of all other participants (mix-minus). 
+	Sum is accumulated once per tick and own contribution is subtracted per
+	participant, so tick cost is linear in number of participants.
+
+	**/
+	class RtpConference :
+		public boost::noncopyable
+	{
+	public:
+
+		RtpConference(UsageEnvironment& env, int conference_id);
+
+		virtual ~RtpConference();
+
+		ApiErrorCode Join(
+			IN int participant_id, 
+			IN FramedSource *source, 
+			IN MediaSink *sink, 
+			IN PcmCodec codec);
+
+		ApiErrorCode Leave(IN int participant_id);
+
+		void ParticipantIds(OUT list<int> &ids);
+
+		int ConferenceId();
+
+		size_t Size();
+
+		// client sessions sharing the conference, allocating session holds
+		// the first reference, proxy destroys conference after the last one
+		int AddReference();
+
+		int ReleaseReference();
+
+	private:
+
+		struct Participant
+		{
+			int participant_id;
+
+			PcmCodec codec;
+
+			FramedSource *source;
+
+			MediaSink *sink;
+
+			ConferenceInputSink *input;
+
+			ConferenceOutputSource *output;
+
+			BOOL active;
+
+			short frame[PCM_FRAME_SAMPLES];
+
+		};
+
+		typedef vector<Participant*> 
+		ParticipantsVector;
+
+		static void TickTask(void *clientData);
+
+		void Tick();
+
+		void ScheduleTick();
+
+		UsageEnvironment &_env;
+
+		int _conferenceId;
+
+		int _references;
+
+		ParticipantsVector _participants;
+
+		TaskToken _tickTask;
+
+		struct timeval _nextTick;
+
+		int _mix[PCM_FRAME_SAMPLES];
+
+		short _out[PCM_FRAME_SAMPLES];
+
+		unsigned char _payload[CONFERENCE_MAX_PAYLOAD];
+
+	};
+
+	typedef 
+	shared_ptr<RtpConference> RtpConferencePtr;
+
+	//
+	// SSE2 mixing kernels, frame length must be multiple of 8
+	//
+	void 
+	MixAccumulate(IN OUT int *mix, IN const short *frame, IN unsigned samples);
+
+	void 
+	MixMinus(IN const int *mix, IN const short *own, OUT short *out, IN unsigned samples);
+
+}
@@ -0,0 +1,154 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "RtpProxyBenchmark.h"
+#include "G711Codec.h"
+#include "InbandDtmfDetector.h"
+#include "RtpConference.h"
+#include <math.h>
+
+namespace ivrworx
+{
+	static double
+	ElapsedNs(IN const LARGE_INTEGER &start, IN int rounds)
+	{
+		LARGE_INTEGER end, frequency;
+		::QueryPerformanceCounter(&end);
+		::QueryPerformanceFrequency(&frequency);
+
+		return ((double)(end.QuadPart - start.QuadPart)*1000000000.0)/
+			((double)frequency.QuadPart*rounds);
+	}
+
+	// sum of two tones at 8kHz, second is skipped if its frequency is 0
+	static void
+	FillTones(OUT short *samples, IN unsigned count, IN double f1, IN double f2)
+	{
+		const double two_pi = 6.283185307179586;
+		for (unsigned i = 0; i < count; i++)
+		{
+			double value = 8000.0*sin(two_pi*f1*i/8000.0);
+			if (f2 > 0)
+			{
+				value += 8000.0*sin(two_pi*f2*i/8000.0);
+			}
+
+			samples[i] = (short)value;
+		}
+	}
+
+	double 
+	BenchmarkTranscoding(IN int frames)
+	{
+		short linear[PCM_FRAME_SAMPLES];
+		FillTones(linear, PCM_FRAME_SAMPLES, 1000, 0);
+
+		unsigned char ulaw[PCM_FRAME_SAMPLES];
+		unsigned char alaw[PCM_FRAME_SAMPLES];
+		unsigned char l16[PCM_FRAME_SAMPLES*2];
+
+		EncodeFromLinear(PCM_CODEC_ULAW, linear, PCM_FRAME_SAMPLES, ulaw, sizeof(ulaw));
+
+		// every conversion reads the output of the previous one
+		LARGE_INTEGER start;
+		::QueryPerformanceCounter(&start);
+		for (int i = 0; i < frames; ++i)
+		{
+			TranscodeFrame(PCM_CODEC_ULAW, ulaw, sizeof(ulaw), PCM_CODEC_ALAW, alaw, sizeof(alaw));
+			TranscodeFrame(PCM_CODEC_ALAW, alaw, sizeof(alaw), PCM_CODEC_L16,  l16,	 sizeof(l16));
+			TranscodeFrame(PCM_CODEC_L16,  l16,	 sizeof(l16),  PCM_CODEC_ULAW, ulaw, sizeof(ulaw));
+		}
+
+		return ElapsedNs(start, frames*3);
+	}
+
+	double 
+	BenchmarkInbandDtmf(IN int frames)
+	{
+		// digit 5 followed by silence, so detector goes through
+		// both the tone checks and the energy rejection
+		short tone[PCM_FRAME_SAMPLES];
+		FillTones(tone, PCM_FRAME_SAMPLES, 770, 1336);
+
+		short silence[PCM_FRAME_SAMPLES] = {0};
+
+		InbandDtmfDetector detector;
+
+		char digits[PCM_FRAME_SAMPLES];
+		unsigned detected = 0;
+
+		LARGE_INTEGER start;
+		::QueryPerformanceCounter(&start);
+		for (int i = 0; i < frames; ++i)
+		{
+			const short *frame = (i % 10) < 5 ? tone : silence;
+			detected += detector.Process(frame, PCM_FRAME_SAMPLES, digits, sizeof(digits));
+		}
+
+		double ns = ElapsedNs(start, frames);
+
+		LogDebug("BenchmarkInbandDtmf - detected " << detected << " digits in " << frames << " frames");
+
+		return ns;
+	}
+
+	double 
+	BenchmarkConferenceMix(IN int frames, IN int participants)
+	{
+		// every participant talks at its own pitch
+		vector<short> voices(participants*PCM_FRAME_SAMPLES);
+		for (int p = 0; p < participants; p++)
+		{
+			FillTones(&voices[p*PCM_FRAME_SAMPLES], PCM_FRAME_SAMPLES, 300 + 100*p, 0);
+		}
+
+		int mix[PCM_FRAME_SAMPLES];
+		short out[PCM_FRAME_SAMPLES];
+		unsigned char payload[CONFERENCE_MAX_PAYLOAD];
+
+		unsigned encoded = 0;
+
+		// same work as RtpConference::Tick without the live555 plumbing
+		LARGE_INTEGER start;
+		::QueryPerformanceCounter(&start);
+		for (int i = 0; i < frames; ++i)
+		{
+			::memset(mix, 0, sizeof(mix));
+
+			for (int p = 0; p < participants; p++)
+			{
+				MixAccumulate(mix, &voices[p*PCM_FRAME_SAMPLES], PCM_FRAME_SAMPLES);
+			}
+
+			for (int p = 0; p < participants; p++)
+			{
+				MixMinus(mix, &voices[p*PCM_FRAME_SAMPLES], out, PCM_FRAME_SAMPLES);
+				encoded += EncodeFromLinear(PCM_CODEC_ULAW, out, PCM_FRAME_SAMPLES, payload, sizeof(payload));
+			}
+		}
+
+		double ns = ElapsedNs(start, frames*participants);
+
+		LogDebug("BenchmarkConferenceMix - encoded " << encoded << " bytes for " << participants << " participants");
+
+		return ns;
+	}
+
+}
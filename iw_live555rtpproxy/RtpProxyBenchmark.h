@@ -0,0 +1,38 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	//
+	// Media kernels of the proxy timed over synthetic audio, results
+	// are ns per 20ms frame. Used by MSG_RTP_PROXY_BENCHMARK_REQ.
+	//
+	double 
+	BenchmarkTranscoding(IN int frames);
+
+	double 
+	BenchmarkInbandDtmf(IN int frames);
+
+	// ns per participant per tick
+	double 
+	BenchmarkConferenceMix(IN int frames, IN int participants);
+
+}
@@ -0,0 +1,329 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//
+// iw_logdecode - prints the records of a binary log file, see 
+// BinaryLogFormat.h, as text lines or as JSON objects one per line.
+//
+// usage: iw_logdecode [-json] <file>
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "BinaryLogFormat.h"
+
+using namespace std;
+
+// FILETIME of 1970-01-01 00:00:00 UTC
+#define IW_EPOCH_AS_FILETIME	116444736000000000ULL
+
+#define IW_LAST_LOG_LEVEL		5
+
+static const char *g_levelNames[] = {"OFF", "CRT", "WRN", "INF", "DBG", "TRC"};
+
+static bool
+ReadWholeFile(const char *file_name, vector<char> &data)
+{
+	FILE *file = fopen(file_name, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	char buffer[64*1024];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + count);
+	}
+
+	fclose(file);
+	return true;
+}
+
+static bool
+IsValidRecord(const BinaryLogRecord *record, unsigned int space)
+{
+	if (record->magic != IW_BINLOG_RECORD_MAGIC ||
+		record->size < sizeof(BinaryLogRecord) ||
+		record->size % IW_BINLOG_RECORD_ALIGN != 0 ||
+		record->size > space)
+	{
+		return false;
+	}
+
+	if (record->level == IW_BINLOG_LEVEL_PAD)
+	{
+		return true;
+	}
+
+	return record->level <= IW_LAST_LOG_LEVEL && 
+		sizeof(BinaryLogRecord) + record->length <= record->size;
+}
+
+// true if valid records follow each other from pos up to the end of 
+// its ring lap, or up to end if it comes first
+static bool
+IsRecordBoundary(
+	const char *ring, 
+	unsigned int ring_size, 
+	iw_binlog_uint64 pos, 
+	iw_binlog_uint64 end)
+{
+	iw_binlog_uint64 lap_end = (pos / ring_size + 1) * ring_size;
+	if (end > lap_end)
+	{
+		end = lap_end;
+	}
+
+	while (pos < end)
+	{
+		unsigned int offset = (unsigned int)(pos % ring_size);
+		unsigned int space	= ring_size - offset;
+
+		if (space < sizeof(BinaryLogRecord))
+		{
+			pos += space;
+			continue;
+		}
+
+		const BinaryLogRecord *record = (const BinaryLogRecord *)(ring + offset);
+		if (!IsValidRecord(record, space))
+		{
+			return false;
+		}
+
+		pos += record->size;
+	}
+
+	return pos == end;
+}
+
+static string
+FormatTime(iw_binlog_uint64 timestamp)
+{
+	char buf[64];
+	buf[0] = '\0';
+
+	if (timestamp < IW_EPOCH_AS_FILETIME)
+	{
+		return "0000/00/00 00:00:00,0000";
+	}
+
+	iw_binlog_uint64 since_epoch = timestamp - IW_EPOCH_AS_FILETIME;
+	time_t seconds = (time_t)(since_epoch / 10000000);
+	int millis = (int)((since_epoch / 10000) % 1000);
+
+	struct tm *st = gmtime(&seconds);
+	if (st == NULL)
+	{
+		return "0000/00/00 00:00:00,0000";
+	}
+
+	// same as the text log file
+	sprintf(buf, "%02d/%02d/%02d %02d:%02d:%02d,%04d",
+		st->tm_year + 1900, st->tm_mon + 1, st->tm_mday,
+		st->tm_hour, st->tm_min, st->tm_sec, millis);
+
+	return buf;
+}
+
+static string
+JsonEscape(const char *text, size_t length)
+{
+	string escaped;
+	escaped.reserve(length + 16);
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		unsigned char c = (unsigned char)text[i];
+		switch (c)
+		{
+		case '"':	escaped += "\\\""; break;
+		case '\\':	escaped += "\\\\"; break;
+		case '\n':	escaped += "\\n";  break;
+		case '\r':	escaped += "\\r";  break;
+		case '\t':	escaped += "\\t";  break;
+		default:
+			{
+				if (c < 0x20)
+				{
+					char buf[8];
+					sprintf(buf, "\\u%04x", c);
+					escaped += buf;
+				}
+				else
+				{
+					escaped += (char)c;
+				}
+			}
+		}
+	}
+
+	return escaped;
+}
+
+static void
+PrintRecord(
+	const BinaryLogHeader *header,
+	const BinaryLogFile *files,
+	const BinaryLogRecord *record,
+	bool json)
+{
+	const char *text = (const char *)record + sizeof(BinaryLogRecord);
+
+	string file_name = "?";
+	if (record->file_index < header->files_count)
+	{
+		const BinaryLogFile &file = files[record->file_index];
+		file_name.assign(file.name, strnlen(file.name, IW_BINLOG_FILE_NAME_LENGTH));
+	}
+
+	if (json)
+	{
+		printf("{\"time\":\"%s\",\"level\":\"%s\",\"thread\":%u,\"fiber\":%u,"
+			"\"file\":\"%s\",\"line\":%u,\"script\":%s,\"msg\":\"%s\"}\n",
+			FormatTime(record->timestamp).c_str(),
+			g_levelNames[record->level],
+			record->thread_id,
+			record->fiber_id,
+			JsonEscape(file_name.c_str(), file_name.length()).c_str(),
+			record->line,
+			(record->flags & IW_BINLOG_FLAG_SCRIPT) ? "true" : "false",
+			JsonEscape(text, record->length).c_str());
+	}
+	else
+	{
+		printf("%s [%s][%-5u,0x%-8x] %s:%u %.*s\n",
+			FormatTime(record->timestamp).c_str(),
+			g_levelNames[record->level],
+			record->thread_id,
+			record->fiber_id,
+			file_name.c_str(),
+			record->line,
+			(int)record->length,
+			text);
+	}
+}
+
+int 
+main(int argc, char* argv[])
+{
+	bool json = false;
+	const char *file_name = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-json") == 0)
+		{
+			json = true;
+		}
+		else
+		{
+			file_name = argv[i];
+		}
+	}
+
+	if (file_name == NULL)
+	{
+		fprintf(stderr, "usage: iw_logdecode [-json] <file>\n");
+		return 1;
+	}
+
+	vector<char> data;
+	if (!ReadWholeFile(file_name, data))
+	{
+		fprintf(stderr, "cannot read %s\n", file_name);
+		return 1;
+	}
+
+	if (data.size() < sizeof(BinaryLogHeader))
+	{
+		fprintf(stderr, "%s is not a binary log\n", file_name);
+		return 1;
+	}
+
+	const BinaryLogHeader *header = (const BinaryLogHeader *)&data[0];
+	if (header->magic != IW_BINLOG_MAGIC ||
+		header->version != IW_BINLOG_VERSION ||
+		header->ring_size == 0 ||
+		header->files_count > IW_BINLOG_MAX_FILES ||
+		header->files_offset + IW_BINLOG_MAX_FILES*sizeof(BinaryLogFile) > header->ring_offset ||
+		(size_t)header->ring_offset + header->ring_size > data.size())
+	{
+		fprintf(stderr, "%s is not a binary log or is damaged\n", file_name);
+		return 1;
+	}
+
+	const BinaryLogFile *files = (const BinaryLogFile *)(&data[0] + header->files_offset);
+	const char *ring = &data[0] + header->ring_offset;
+	unsigned int ring_size = header->ring_size;
+
+	// once the ring has wrapped the oldest data is at the write position
+	iw_binlog_uint64 write_pos = header->write_pos;
+	iw_binlog_uint64 pos = write_pos > ring_size ? write_pos - ring_size : 0;
+	bool synced = (pos == 0);
+	bool damaged = false;
+
+	while (pos < write_pos)
+	{
+		unsigned int offset = (unsigned int)(pos % ring_size);
+		unsigned int space	= ring_size - offset;
+
+		// writer leaves tails shorter than a record header unused
+		if (space < sizeof(BinaryLogRecord))
+		{
+			pos += space;
+			continue;
+		}
+
+		// a record in the middle of the oldest one or of a damaged 
+		// region may look valid, so the records after it must chain
+		if (!synced && !IsRecordBoundary(ring, ring_size, pos, write_pos))
+		{
+			pos += IW_BINLOG_RECORD_ALIGN;
+			continue;
+		}
+
+		synced = true;
+
+		const BinaryLogRecord *record = (const BinaryLogRecord *)(ring + offset);
+		if (!IsValidRecord(record, space))
+		{
+			fprintf(stderr, "damaged record at offset %u\n", offset);
+			damaged = true;
+			synced = false;
+
+			pos += IW_BINLOG_RECORD_ALIGN;
+			continue;
+		}
+
+		if (record->level != IW_BINLOG_LEVEL_PAD)
+		{
+			PrintRecord(header, files, record, json);
+		}
+
+		pos += record->size;
+	}
+
+	return damaged ? 1 : 0;
+}
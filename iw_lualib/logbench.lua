@@ -0,0 +1,17 @@
+require "ivrworx"
+
+--
+-- Measures the cost of log call sites that are filtered out. Run it with
+-- debug_level below DBG in conf.json, then both rates show the price of
+-- the level check alone and no LogDebug argument is ever evaluated.
+--
+
+ROUNDS = 1000000
+
+logger = assert(ivrworx.LOGGER)
+
+debug_ns, tracker_ns, evaluated = logger:benchmark{rounds=ROUNDS}
+
+print(string.format("%-12s %8d rounds %8.2f ns/call", "LogDebug", ROUNDS, debug_ns))
+print(string.format("%-12s %8d rounds %8.2f ns/call", "FUNCTRACKER", ROUNDS, tracker_ns))
+print(string.format("%-12s %8d of %d", "evaluated", evaluated, ROUNDS))
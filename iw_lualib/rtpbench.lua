@@ -0,0 +1,33 @@
+require "ivrworx"
+
+--
+-- Measures the media kernels of the rtp proxy. The proxy runs them on its
+-- own thread over synthetic audio, so run it on an idle proxy.
+--
+
+FRAMES = 50000
+
+PARTICIPANTS = 8
+
+-- ns of 20ms frame in one direction of one channel
+FRAME_NS = 20000000
+
+rtp = rtpproxy:new()
+
+res, result = rtp:benchmark{frames=FRAMES, participants=PARTICIPANTS}
+if res ~= ivrworx.API_SUCCESS then
+	print("benchmark failed:" .. res)
+	return
+end
+
+-- bridged call transcodes both directions
+print(string.format("%-12s %8d frames %8.1f ns/frame %10.0f calls/core",
+	"transcode", FRAMES, result.transcode_ns, FRAME_NS/(2*result.transcode_ns)))
+
+-- detector listens to the caller only
+print(string.format("%-12s %8d frames %8.1f ns/frame %10.0f calls/core",
+	"inband dtmf", FRAMES, result.dtmf_ns, FRAME_NS/result.dtmf_ns))
+
+-- mixer cost is per participant, conference of PARTICIPANTS
+print(string.format("%-12s %8d frames %8.1f ns/frame %10.0f participants/core",
+	"conference", FRAMES, result.mix_ns, FRAME_NS/result.mix_ns))
@@ -0,0 +1,71 @@
+require "ivrworx"
+require "sdphelper"
+
+--
+-- Compares parse and serialize rate of sdphelper.lua and of the native
+-- sdpdesc object. On Windows os.clock() returns wall clock time.
+--
+
+ROUNDS = 10000
+
+offer = "v=0\r\n" ..
+	"o=mhandley 2890844526 2890842807 IN IP4 126.16.64.4\r\n" ..
+	"s=SDP Seminar\r\n" ..
+	"i=A Seminar on the session description protocol\r\n" ..
+	"c=IN IP4 224.2.17.12/127\r\n" ..
+	"b=X-YZ:128\r\n" ..
+	"t=2873397496 2873404696\r\n" ..
+	"a=recvonly\r\n" ..
+	"m=audio 49170 RTP/AVP 0 8 18 101\r\n" ..
+	"a=rtpmap:0 PCMU/8000\r\n" ..
+	"a=rtpmap:8 PCMA/8000\r\n" ..
+	"a=rtpmap:18 G729/8000\r\n" ..
+	"a=fmtp:18 annexb=no\r\n" ..
+	"a=rtpmap:101 telephone-event/8000\r\n" ..
+	"a=fmtp:101 0-15\r\n" ..
+	"a=ptime:20\r\n" ..
+	"m=video 51372 RTP/AVP 99\r\n" ..
+	"a=rtpmap:99 h263-1998/90000\r\n"
+
+function report(name, started)
+	local elapsed = os.clock() - started
+	if elapsed <= 0 then elapsed = 0.001 end
+	print(string.format("%-20s %6d rounds %8.3f sec %10.1f rounds/sec", name, ROUNDS, elapsed, ROUNDS/elapsed))
+end
+
+started = os.clock()
+for i = 1, ROUNDS do
+	local parsed = parse_sdp(offer)
+end
+report("sdphelper parse", started)
+
+started = os.clock()
+for i = 1, ROUNDS do
+	local parsed = parse_sdp(offer)
+	local text = convert_sdp(parsed)
+end
+report("sdphelper roundtrip", started)
+
+started = os.clock()
+for i = 1, ROUNDS do
+	local parsed = sdpdesc:new{sdp=offer}
+end
+report("sdpdesc parse", started)
+
+started = os.clock()
+for i = 1, ROUNDS do
+	local parsed = sdpdesc:new{sdp=offer}
+	local text = parsed:tostring()
+end
+report("sdpdesc roundtrip", started)
+
+-- answer with PCMA only, on a new port
+started = os.clock()
+for i = 1, ROUNDS do
+	local answer = sdpdesc:new{sdp=offer}
+	answer:removemedia{index=2}
+	answer:setcodecs{index=1, codecs={8, 101}}
+	answer:setport{index=1, port=6000}
+	local text = answer:tostring()
+end
+report("sdpdesc answer", started)
@@ -371,10 +371,6 @@ end
 
 function convert_media_descriptors(mtree)
 
-	print("=================================================")
-   table_print(mtree)
-   print("=================================================")
-
 	local res = "";
 
 	if (mtree == nil) then return ""; end;
@@ -0,0 +1,52 @@
+require "ivrworx"
+
+--
+-- Measures SQLite insert rate of plain, group committed and pipelined
+-- group committed writes. On Windows os.clock() returns wall clock time.
+--
+
+ROWS = 2000
+
+sql = sqlsession:new();
+sql:open{url="sqlbench.db"}
+
+sql:exec{sql="DROP TABLE IF EXISTS bench"}
+sql:exec{sql="CREATE TABLE bench (id INTEGER PRIMARY KEY, caller TEXT, duration INTEGER)"}
+
+function report(name, started)
+	local elapsed = os.clock() - started
+	if elapsed <= 0 then elapsed = 0.001 end
+	print(string.format("%-12s %6d rows %8.3f sec %10.1f rows/sec", name, ROWS, elapsed, ROWS/elapsed))
+end
+
+function insert(i)
+	return "INSERT INTO bench (caller, duration) VALUES ('sip:" .. i .. "@bench', " .. i .. ")"
+end
+
+-- every insert is its own transaction
+started = os.clock()
+for i = 1, ROWS do
+	sql:exec{sql=insert(i)}
+end
+report("plain", started)
+
+-- every insert waits for the group commit it joined
+started = os.clock()
+for i = 1, ROWS do
+	sql:exec{sql=insert(i), batched=true}
+end
+report("batched", started)
+
+-- inserts are pipelined and acknowledged together
+started = os.clock()
+for i = 1, ROWS do
+	sql:submit{sql=insert(i)}
+end
+res, failed = sql:flush()
+report("pipelined", started)
+
+if failed ~= 0 then
+	print("failed inserts:" .. failed)
+end
+
+sql:close()
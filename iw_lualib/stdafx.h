@@ -5,6 +5,8 @@
 
 #pragma once
 
+#define IW_LOG_MODULE	LOG_MODULE_IVR
+
 // Modify the following defines if you have to target a platform prior to the ones specified below.
 // Refer to MSDN for the latest info on corresponding values for different platforms.
 #ifndef WINVER				// Allow use of features specific to Windows XP or later.
@@ -0,0 +1,299 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "IwAsyncRecorder.h"
+
+namespace ivrworx
+{
+
+	enum AsyncRecState
+	{
+		ASYNC_REC_CLOSED,
+		ASYNC_REC_STOPPED,
+		ASYNC_REC_RECORDING
+	};
+
+	struct AsyncRecData
+	{
+		AsyncRecData():
+		writer(NULL),
+		close_chunk(NULL),
+		state(ASYNC_REC_CLOSED),
+		recording_id(IW_UNDEFINED),
+		rate(8000),
+		nchannels(1){};
+
+		RecordingWriter *writer;
+
+		// taken upon open, so close is never dropped
+		RecordingChunk *close_chunk;
+
+		AsyncRecState state;
+
+		long recording_id;
+
+		int rate;
+
+		int nchannels;
+	};
+
+	static void 
+	async_rec_init(MSFilter *f)
+	{
+		f->data = new AsyncRecData();
+	}
+
+	static int async_rec_close(MSFilter *f, void *arg);
+
+	static void 
+	async_rec_uninit(MSFilter *f)
+	{
+		async_rec_close(f,NULL);
+
+		delete (AsyncRecData*)f->data;
+		f->data = NULL;
+	}
+
+	static void 
+	async_rec_process(MSFilter *f)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		mblk_t *m = NULL;
+
+		ms_filter_lock(f);
+
+		while ((m = ms_queue_get(f->inputs[0])) != NULL)
+		{
+			if (d->state == ASYNC_REC_RECORDING)
+			{
+				mblk_t *it = m;
+				while (it != NULL)
+				{
+					const char *src = (const char*)it->b_rptr;
+					size_t left		= it->b_wptr - it->b_rptr;
+
+					while (left > 0)
+					{
+						RecordingChunk *chunk = d->writer->AllocChunk();
+						if (chunk == NULL)
+						{
+							break;
+						}
+
+						size_t size = left < IW_REC_CHUNK_CAPACITY ? left : IW_REC_CHUNK_CAPACITY;
+
+						chunk->type			= REC_CHUNK_DATA;
+						chunk->recording_id = d->recording_id;
+						chunk->size			= size;
+						::memcpy(chunk->data, src, size);
+
+						d->writer->Push(chunk);
+
+						src  += size;
+						left -= size;
+					}
+
+					it = it->b_cont;
+				}
+			}
+
+			freemsg(m);
+		}
+
+		ms_filter_unlock(f);
+	}
+
+	static int 
+	async_rec_set_writer(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		ms_filter_lock(f);
+		d->writer = *((RecordingWriter**)arg);
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	async_rec_open(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		const char *path = (const char*)arg;
+		size_t len = ::strlen(path);
+
+		if (d->writer == NULL || len > IW_REC_CHUNK_CAPACITY)
+		{
+			return -1;
+		}
+
+		async_rec_close(f,NULL);
+
+		RecordingChunk *chunk		= d->writer->AllocChunk();
+		RecordingChunk *close_chunk = d->writer->AllocChunk();
+		if (chunk == NULL || close_chunk == NULL)
+		{
+			if (chunk != NULL)
+			{
+				d->writer->FreeChunk(chunk);
+			}
+
+			if (close_chunk != NULL)
+			{
+				d->writer->FreeChunk(close_chunk);
+			}
+
+			LogWarn("async_rec_open - cannot open recording:" << path << ", writer is behind");
+			return -1;
+		}
+
+		ms_filter_lock(f);
+
+		d->recording_id = d->writer->NewRecordingId();
+		d->state		= ASYNC_REC_STOPPED;
+		d->close_chunk	= close_chunk;
+
+		chunk->type			= REC_CHUNK_OPEN;
+		chunk->recording_id = d->recording_id;
+		chunk->size			= len;
+		::memcpy(chunk->data, path, len);
+
+		d->writer->Push(chunk);
+
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	async_rec_start(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		int res = -1;
+
+		ms_filter_lock(f);
+		if (d->state != ASYNC_REC_CLOSED)
+		{
+			d->state = ASYNC_REC_RECORDING;
+			res = 0;
+		}
+		ms_filter_unlock(f);
+
+		return res;
+	}
+
+	static int 
+	async_rec_stop(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		ms_filter_lock(f);
+		if (d->state == ASYNC_REC_RECORDING)
+		{
+			d->state = ASYNC_REC_STOPPED;
+		}
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	async_rec_close(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		ms_filter_lock(f);
+
+		if (d->state != ASYNC_REC_CLOSED)
+		{
+			RecordingChunk *chunk = d->close_chunk;
+
+			chunk->type			= REC_CHUNK_CLOSE;
+			chunk->recording_id = d->recording_id;
+			chunk->rate			= d->rate;
+			chunk->nchannels	= d->nchannels;
+			chunk->size			= 0;
+
+			d->writer->Push(chunk);
+
+			d->close_chunk	= NULL;
+			d->state		= ASYNC_REC_CLOSED;
+			d->recording_id = IW_UNDEFINED;
+		}
+
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	async_rec_set_sample_rate(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		ms_filter_lock(f);
+		d->rate = *((int*)arg);
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	async_rec_set_nchannels(MSFilter *f, void *arg)
+	{
+		AsyncRecData *d = (AsyncRecData*)f->data;
+
+		ms_filter_lock(f);
+		d->nchannels = *((int*)arg);
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static MSFilterMethod async_rec_methods[] = {
+		{ IW_ASYNC_REC_SET_WRITER,	 async_rec_set_writer		},
+		{ MS_FILE_REC_OPEN,			 async_rec_open				},
+		{ MS_FILE_REC_START,		 async_rec_start			},
+		{ MS_FILE_REC_STOP,			 async_rec_stop				},
+		{ MS_FILE_REC_CLOSE,		 async_rec_close			},
+		{ MS_FILTER_SET_SAMPLE_RATE, async_rec_set_sample_rate	},
+		{ MS_FILTER_SET_NCHANNELS,	 async_rec_set_nchannels	},
+		{ 0,						 NULL						}
+	};
+
+	MSFilterDesc iw_async_rec_desc = {
+		MS_FILE_REC_ID,							// same id, so file recorder methods pass type check
+		"IwAsyncRecorder",
+		"Records through ivrworx background writer",
+		MS_FILTER_OTHER,
+		NULL,
+		1,
+		0,
+		async_rec_init,
+		NULL,
+		async_rec_process,
+		NULL,
+		async_rec_uninit,
+		async_rec_methods
+	};
+
+}
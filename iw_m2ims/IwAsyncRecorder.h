@@ -0,0 +1,38 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#pragma once
+
+#include "RecordingWriter.h"
+
+namespace ivrworx
+{
+	//
+	// Mediastreamer2 sink filter recording decoded audio through 
+	// RecordingWriter. It answers file recorder methods (open, start, 
+	// stop, close, sample rate, channels) so it may replace the file 
+	// recorder in the session graph. Ticker thread only copies frames 
+	// to writer chunks, frames are dropped if writer falls behind.
+	//
+#define IW_ASYNC_REC_SET_WRITER MS_FILTER_METHOD(MS_FILE_REC_ID, 40, RecordingWriter*)
+
+	extern MSFilterDesc iw_async_rec_desc;
+
+}
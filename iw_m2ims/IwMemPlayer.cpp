@@ -0,0 +1,269 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "IwMemPlayer.h"
+
+namespace ivrworx
+{
+	enum MemPlayerState
+	{
+		MEM_PLAYER_CLOSED,
+		MEM_PLAYER_STOPPED,
+		MEM_PLAYER_PLAYING
+	};
+
+	struct MemPlayerData
+	{
+		MemPlayerData():
+		state(MEM_PLAYER_CLOSED),
+		current(0),
+		pos(0),
+		elapsed(0),
+		loop_after(-1){};
+
+		CachedPromptsVector playlist;
+
+		MemPlayerState state;
+
+		size_t current;
+
+		size_t pos;
+
+		int elapsed;
+
+		int loop_after;
+	};
+
+	static void 
+	mem_player_init(MSFilter *f)
+	{
+		f->data = new MemPlayerData();
+	}
+
+	static void 
+	mem_player_uninit(MSFilter *f)
+	{
+		delete (MemPlayerData*)f->data;
+		f->data = NULL;
+	}
+
+	static void 
+	mem_player_process(MSFilter *f)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+
+		if (d->state != MEM_PLAYER_PLAYING || d->playlist.empty())
+		{
+			ms_filter_unlock(f);
+			return;
+		}
+
+		// all prompts of the list share session encoding
+		const CachedPrompt &first = *d->playlist.front();
+
+		// linear frames are re-framed by the encoder, encoded ones
+		// go directly to rtp so they are sent in packet size
+		int ptime = first.encoding == PROMPT_ENCODING_LINEAR ? 
+			f->ticker->interval : IW_MEM_PLAYER_PTIME;
+
+		size_t bytes = 
+			(first.clock_rate * ptime / 1000) * PromptBytesPerSample(first.encoding);
+
+		d->elapsed += f->ticker->interval;
+
+		while (d->elapsed >= ptime && d->state == MEM_PLAYER_PLAYING)
+		{
+			d->elapsed -= ptime;
+
+			mblk_t *om = allocb(bytes, 0);
+
+			size_t filled = 0;
+			BOOL list_done = FALSE;
+
+			// frame may span several prompts
+			while (filled < bytes)
+			{
+				const CachedPrompt &prompt = *d->playlist[d->current];
+
+				size_t chunk = min(bytes - filled, prompt.data.size() - d->pos);
+				if (chunk > 0)
+				{
+					::memcpy(om->b_wptr + filled, &prompt.data[d->pos], chunk);
+				}
+
+				filled += chunk;
+				d->pos += chunk;
+
+				if (d->pos >= prompt.data.size())
+				{
+					d->pos = 0;
+					if (++d->current == d->playlist.size())
+					{
+						d->current = 0;
+						list_done = TRUE;
+						break;
+					}
+				}
+			}
+
+			// pad last frame with silence
+			::memset(om->b_wptr + filled, PromptSilenceByte(first.encoding), bytes - filled);
+
+			om->b_wptr += bytes;
+
+			ms_queue_put(f->outputs[0], om);
+
+			if (list_done)
+			{
+				ms_filter_notify_no_arg(f, MS_FILE_PLAYER_EOF);
+
+				if (d->loop_after < 0)
+				{
+					d->state = MEM_PLAYER_STOPPED;
+				}
+			}
+		}
+
+		ms_filter_unlock(f);
+	}
+
+	static int 
+	mem_player_set_playlist(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		d->playlist	= *((CachedPromptsVector*)arg);
+		d->state	= MEM_PLAYER_STOPPED;
+		d->current	= 0;
+		d->pos		= 0;
+		d->elapsed	= 0;
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_start(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		if (d->state == MEM_PLAYER_STOPPED)
+		{
+			d->state = MEM_PLAYER_PLAYING;
+		}
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_stop(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		if (d->state == MEM_PLAYER_PLAYING)
+		{
+			d->state	= MEM_PLAYER_STOPPED;
+			d->current	= 0;
+			d->pos		= 0;
+		}
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_close(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		d->playlist.clear();
+		d->state	= MEM_PLAYER_CLOSED;
+		d->current	= 0;
+		d->pos		= 0;
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_loop(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		d->loop_after = *((int*)arg);
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_get_sample_rate(MSFilter *f, void *arg)
+	{
+		MemPlayerData *d = (MemPlayerData*)f->data;
+
+		ms_filter_lock(f);
+		*((int*)arg) = d->playlist.empty() ? 8000 : d->playlist.front()->clock_rate;
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static int 
+	mem_player_get_nchannels(MSFilter *f, void *arg)
+	{
+		*((int*)arg) = 1;
+		return 0;
+	}
+
+	static MSFilterMethod mem_player_methods[] = {
+		{ IW_MEM_PLAYER_SET_PLAYLIST, mem_player_set_playlist	 },
+		{ MS_FILE_PLAYER_START,		 mem_player_start			 },
+		{ MS_FILE_PLAYER_STOP,		 mem_player_stop			 },
+		{ MS_FILE_PLAYER_CLOSE,		 mem_player_close			 },
+		{ MS_FILE_PLAYER_LOOP,		 mem_player_loop			 },
+		{ MS_FILTER_GET_SAMPLE_RATE, mem_player_get_sample_rate },
+		{ MS_FILTER_GET_NCHANNELS,	 mem_player_get_nchannels	 },
+		{ 0,						 NULL						 }
+	};
+
+	MSFilterDesc iw_mem_player_desc = {
+		MS_FILE_PLAYER_ID,						// same id, so file player methods pass type check
+		"IwMemPlayer",
+		"Plays prompts from ivrworx prompt cache",
+		MS_FILTER_OTHER,
+		NULL,
+		0,
+		1,
+		mem_player_init,
+		NULL,
+		mem_player_process,
+		NULL,
+		mem_player_uninit,
+		mem_player_methods
+	};
+
+}
@@ -0,0 +1,41 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "PromptCache.h"
+
+namespace ivrworx
+{
+	//
+	// Mediastreamer2 source filter playing prompts from PromptCache. 
+	// It answers file player methods (start, stop, close, loop, sample rate) 
+	// and raises MS_FILE_PLAYER_EOF so it may replace the file player in 
+	// the session graph. Encoded prompts are sent in 20ms frames and are 
+	// linked directly to rtp sender, linear prompts go through the encoder.
+	// Playlist is played back to back, frames span prompt boundaries and 
+	// EOF is raised once at the end of the list.
+	//
+#define IW_MEM_PLAYER_SET_PLAYLIST MS_FILTER_METHOD(MS_FILE_PLAYER_ID, 40, CachedPromptsVector)
+
+#define IW_MEM_PLAYER_PTIME 20
+
+	extern MSFilterDesc iw_mem_player_desc;
+
+}
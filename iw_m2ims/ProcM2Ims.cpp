@@ -19,6 +19,9 @@
 
 #include "StdAfx.h"
 #include "ProcM2Ims.h"
+#include "IwMemPlayer.h"
+#include "TickerProbe.h"
+#include "IwAsyncRecorder.h"
 
 
 namespace ivrworx 
@@ -30,6 +33,17 @@ namespace ivrworx
 #define	IW_DEFAULT_IMS_TIMEOUT		60000 // 1 min
 #define IW_MAX_RTP_MSG_LENGTH	1024
 
+#define IW_DEFAULT_PROMPT_CACHE_MAX_MB		64
+#define IW_DEFAULT_PROMPT_CACHE_CHECK_INTERVAL	5000 // 5 sec
+
+#define IW_DEFAULT_GRAPH_POOL_SIZE	16 // per payload
+
+#define IW_DEFAULT_RECORDING_FLUSH_INTERVAL	1000 // 1 sec
+#define IW_DEFAULT_RECORDING_SYNC_INTERVAL	5000 // 5 sec
+#define IW_DEFAULT_RECORDING_MAX_BUFFERED_MB	16
+
+#define GRAPH_POOL_KEY(rcv,idx) ((rcv)*RTP_PROFILE_MAX_PAYLOADS + (idx))
+
 	HANDLE g_iocpHandle = NULL;
 
 	static void iw_logger_func(OrtpLogLevel lev, const char *fmt, va_list args) 
@@ -121,7 +135,12 @@ namespace ivrworx
 		correlation_id(IW_UNDEFINED),
 		snd_device_type(SND_DEVICE_TYPE_FILE),
 		rcv_device_type(RCV_DEVICE_FILE_REC_ID),
-		pt(NULL)
+		pt(NULL),
+		pt_idx(IW_UNDEFINED),
+		ticker_idx(IW_UNDEFINED),
+		prompt_encoding(PROMPT_ENCODING_LINEAR),
+		prompt_passthrough(FALSE),
+		playlist_pos(0)
 	{
 
 	}
@@ -208,14 +227,64 @@ namespace ivrworx
 		_rtp_q(NULL),
 		_rtpWorkerShutdownEvt(NULL),
 		_avProfile(NULL),
-		_ticker(NULL),
 		_correlationCounter(0),
-		_rtpWorkerHandle(NULL)
+		_rtpWorkerHandle(NULL),
+		_graphPoolSize(IW_DEFAULT_GRAPH_POOL_SIZE),
+		_graphPoolHits(0),
+		_graphPoolMisses(0)
 	{
 		FUNCTRACKER;
 
 		ServiceId(_conf->GetString("m2ims/uri"));
 
+		if (_conf->HasOption("m2ims/graph_pool_size"))
+		{
+			int pool_size = _conf->GetInt("m2ims/graph_pool_size");
+			_graphPoolSize = pool_size > 0 ? pool_size : 0;
+		}
+
+		LogDebug("ProcM2Ims::ProcM2Ims - graph pool size:" << _graphPoolSize);
+
+		if (_conf->HasOption("m2ims/async_recording") && 
+			_conf->GetBool("m2ims/async_recording"))
+		{
+			RecordingFormat format = 
+				(_conf->HasOption("m2ims/recording_format") && _conf->GetString("m2ims/recording_format") == "raw") ? 
+				RECORDING_FORMAT_RAW : RECORDING_FORMAT_WAV;
+
+			int flush_interval = _conf->HasOption("m2ims/recording_flush_interval") ? 
+				_conf->GetInt("m2ims/recording_flush_interval") : IW_DEFAULT_RECORDING_FLUSH_INTERVAL;
+
+			int sync_interval = _conf->HasOption("m2ims/recording_sync_interval") ? 
+				_conf->GetInt("m2ims/recording_sync_interval") : IW_DEFAULT_RECORDING_SYNC_INTERVAL;
+
+			int max_mb = _conf->HasOption("m2ims/recording_max_buffered_mb") ? 
+				_conf->GetInt("m2ims/recording_max_buffered_mb") : IW_DEFAULT_RECORDING_MAX_BUFFERED_MB;
+
+			_recWriter = RecordingWriterPtr(new RecordingWriter(
+				format,
+				flush_interval,
+				sync_interval,
+				(((size_t)max_mb) * 1024 * 1024) / sizeof(RecordingChunk)));
+		}
+
+		if (_conf->HasOption("m2ims/prompt_cache") && 
+			_conf->GetBool("m2ims/prompt_cache"))
+		{
+			int max_mb = _conf->HasOption("m2ims/prompt_cache_max_mb") ? 
+				_conf->GetInt("m2ims/prompt_cache_max_mb") : IW_DEFAULT_PROMPT_CACHE_MAX_MB;
+
+			int check_interval = _conf->HasOption("m2ims/prompt_cache_check_interval") ? 
+				_conf->GetInt("m2ims/prompt_cache_check_interval") : IW_DEFAULT_PROMPT_CACHE_CHECK_INTERVAL;
+
+			LogDebug("ProcM2Ims::ProcM2Ims - prompt cache max_mb:" << max_mb << ", check_interval:" << check_interval);
+
+			_promptCache = PromptCachePtr(new PromptCache(
+				_conf->GetString("m2ims/sounds_dir"),
+				((size_t)max_mb) * 1024 * 1024,
+				check_interval));
+		}
+
 		_iocpPtr = IocpInterruptorPtr(new IocpInterruptor());
 		_inbound->HandleInterruptor(_iocpPtr);
 
@@ -247,14 +316,22 @@ namespace ivrworx
 			::CloseHandle(_rtpWorkerHandle);
 		}
 
-		if (_ticker != NULL) 
+		for (size_t i = 0; i < _tickers.size(); ++i)
 		{
-			ms_ticker_destroy(_ticker);
-			_ticker = NULL;
+			ms_ticker_detach(_tickers[i],_tickerProbes[i]);
+			ms_ticker_destroy(_tickers[i]);
+			ms_filter_destroy(_tickerProbes[i]);
 		}
+
+		_tickers.clear();
+		_tickerProbes.clear();
+		_tickerLoad.clear();
 		
 		ms_exit();
 
+		// recorders are gone, close what is left
+		_recWriter.reset();
+
 		if (_avProfile != NULL) 
 		{
 			rtp_profile_destroy(_avProfile);
@@ -384,10 +461,11 @@ namespace ivrworx
 		ortp_init();
 		ms_init();
 
-		_ticker = ms_ticker_new();
-		if (_ticker == NULL)
+		CreateTickers();
+
+		if (_recWriter && IW_FAILURE(_recWriter->Start()))
 		{
-			LogCrit("Cannot start ms ticker");
+			LogCrit("Cannot start recording writer");
 			throw;
 		}
 
@@ -473,6 +551,16 @@ namespace ivrworx
 				else 
 				{
 					LogInfo("Ims keep alive.");
+					if (_promptCache)
+					{
+						_promptCache->LogStats();
+					}
+					LogGraphPoolStats();
+					LogTickerStats();
+					if (_recWriter)
+					{
+						_recWriter->LogStats();
+					}
 					continue;
 				}
 			}
@@ -570,46 +658,18 @@ namespace ivrworx
 		PayloadType *pt = NULL;
 		int idx			= -1;
 		stringstream sdps;
+		SdpParser::Medium medium;
+		StreamingCtxPtr ctx;
 
 		shared_ptr<MsgStreamAllocateSessionReq> req  =
 			dynamic_pointer_cast<MsgStreamAllocateSessionReq> (msg);
 
-		//
-		// create new context
-		//
-		StreamingCtxPtr ctx(new StreamingCtx());
 		long handle = GetNewImsHandle();
-		ctx->streamer_handle = handle;
-		ctx->rcv_device_type = req->rcv_device_type;
-
-		//
-		// create ortp stream and initialize it with available port
-		//
-		// local port will be allocated dynamically
-		ctx->stream = audio_stream_new(0, false /*ms_is_ipv6(req->local_media_data.iptoa()*/);
-		if (ctx->stream==NULL)
-		{
-			LogWarn("Failed to find available port");
-			goto error;
-
-		}
-		
-
-		/********************
-		*
-		*		Session 
-		*
-		*********************/
-		// create local rtp profile and associate it with session
-		RtpSession *rtps=ctx->stream->session;
-		RtpProfile *profile=rtp_profile_clone_full(_avProfile);
-		rtp_session_set_profile(rtps,profile);
-		ctx->profile = profile;
 
 		if (req->offer.body.size() != 0 && req->offer.type == "application/sdp")
 		{
 			SdpParser parser(req->offer.body);
-			SdpParser::Medium medium = parser.first_audio_medium();
+			medium = parser.first_audio_medium();
 
 			if (!medium.connection.is_valid() || medium.list.empty())
 			{
@@ -617,29 +677,79 @@ namespace ivrworx
 				goto error;
 			}
 
-			
 			NegotiateCodec(medium.list,&pt,&idx);
 			if (pt == NULL)
 			{
 				LogDebug("ProcM2Ims::AllocatePlaybackSession - error negotiating, imsh:" <<  handle);
 				goto error;
 			}
-			else
-			{
-				ctx->pt = pt;
-			}
-				
-			ApiErrorCode res = RecommutateSession(ctx,medium.connection,pt,idx);
-			if (IW_FAILURE(res))
+
+			//
+			// try idle graph first
+			//
+			ctx = AcquirePooledGraph(req->rcv_device_type, idx);
+			if (ctx)
 			{
-				LogDebug("ProcM2Ims::AllocatePlaybackSession - error re-commutating, imsh:" <<  handle);
-				goto error;
+				ctx->streamer_handle = handle;
+				ApiErrorCode res = RebindPooledGraph(ctx,medium.connection);
+				if (IW_FAILURE(res))
+				{
+					LogDebug("ProcM2Ims::AllocatePlaybackSession - error rebinding pooled graph, imsh:" <<  handle);
+					TearDown(ctx);
+					goto error;
+				}
 			}
 		}
 		else
 		{
 			LogDebug("ProcM2Ims::AllocatePlaybackSession - no valid info, not re-commutating, imsh:" <<  handle);
 		}
+
+		if (!ctx)
+		{
+			//
+			// create new context
+			//
+			ctx = StreamingCtxPtr(new StreamingCtx());
+			ctx->streamer_handle = handle;
+			ctx->rcv_device_type = req->rcv_device_type;
+
+			//
+			// create ortp stream and initialize it with available port
+			//
+			// local port will be allocated dynamically
+			ctx->stream = audio_stream_new(0, false /*ms_is_ipv6(req->local_media_data.iptoa()*/);
+			if (ctx->stream==NULL)
+			{
+				LogWarn("Failed to find available port");
+				goto error;
+
+			}
+
+
+			/********************
+			*
+			*		Session 
+			*
+			*********************/
+			// create local rtp profile and associate it with session
+			RtpSession *rtps=ctx->stream->session;
+			RtpProfile *profile=rtp_profile_clone_full(_avProfile);
+			rtp_session_set_profile(rtps,profile);
+			ctx->profile = profile;
+
+			if (pt != NULL)
+			{
+				ctx->pt = pt;
+
+				ApiErrorCode res = RecommutateSession(ctx,medium.connection,pt,idx);
+				if (IW_FAILURE(res))
+				{
+					LogDebug("ProcM2Ims::AllocatePlaybackSession - error re-commutating, imsh:" <<  handle);
+					goto error;
+				}
+			}
+		}
 		
 
 		
@@ -710,10 +820,8 @@ error:
 			return API_SUCCESS;
 		};
 
-		if (ctx->stream->ticker == NULL)
-		{
-			ctx->stream->ticker = _ticker;
-		};
+		int ticker_idx = LeastLoadedTicker();
+		ctx->stream->ticker = _tickers[ticker_idx];
 
 		// final touch
 		int res = ms_ticker_attach(ctx->stream->ticker,ctx->stream->soundread);
@@ -728,6 +836,9 @@ error:
 			return API_FAILURE;
 		}
 
+		ctx->ticker_idx = ticker_idx;
+		_tickerLoad[ticker_idx]++;
+
 		ctx->state = IMS_TICKING;
 
 		return API_SUCCESS;
@@ -957,7 +1068,18 @@ error:
 
 		case SND_DEVICE_TYPE_FILE:
 			{
-				ctx->stream->soundread = ms_filter_new(MS_FILE_PLAYER_ID);
+				if (_promptCache)
+				{
+					ctx->prompt_encoding	= PromptEncodingFromMime(pt->mime_type);
+					ctx->prompt_passthrough = (ctx->prompt_encoding != PROMPT_ENCODING_LINEAR);
+
+					ctx->stream->soundread = ms_filter_new_from_desc(&iw_mem_player_desc);
+				}
+				else
+				{
+					ctx->stream->soundread = ms_filter_new(MS_FILE_PLAYER_ID);
+				}
+
 				if (ctx->stream->soundread  == NULL) 
 				{
 					LogWarn("error:ms_filter_new(MS_FILE_PLAYER_ID)");
@@ -1055,12 +1177,27 @@ error:
 			}
 		case RCV_DEVICE_FILE_REC_ID:
 			{
-				//we just do not open the file so it stays dummy
-				ctx->stream->soundwrite=ms_filter_new(MS_FILE_REC_ID);
-				if (ctx->stream->soundwrite == NULL) 
+				// frames are written on recording writer thread
+				if (_recWriter)
 				{
-					LogWarn("error:ms_filter_new(MS_FILE_REC_ID)");
-					goto error;
+					ctx->stream->soundwrite=ms_filter_new_from_desc(&iw_async_rec_desc);
+					if (ctx->stream->soundwrite == NULL) 
+					{
+						LogWarn("error:ms_filter_new_from_desc(iw_async_rec_desc)");
+						goto error;
+					}
+
+					RecordingWriter *writer = _recWriter.get();
+					ms_filter_call_method(ctx->stream->soundwrite,IW_ASYNC_REC_SET_WRITER,&writer);
+				}
+				else
+				{
+					ctx->stream->soundwrite=ms_filter_new(MS_FILE_REC_ID);
+					if (ctx->stream->soundwrite == NULL) 
+					{
+						LogWarn("error:ms_filter_new(MS_FILE_REC_ID)");
+						goto error;
+					}
 				}
 
 				ms_filter_call_method_noarg(ctx->stream->soundwrite,MS_FILE_REC_CLOSE);
@@ -1107,18 +1244,31 @@ error:
 		*
 		***********************************************************************/
 
-		res = ms_filter_link(ctx->stream->soundread,0,ctx->stream->encoder,0);
-		if (res < 0) 
+		if (ctx->prompt_passthrough)
 		{
-			LogWarn("error:ms_filter_link soundread->encoder");
-			goto error;
+			// prompts are encoded already
+			res = ms_filter_link(ctx->stream->soundread,0,ctx->stream->rtpsend,0);
+			if (res < 0) 
+			{
+				LogWarn("error:ms_filter_link soundread->rtpsend");
+				goto error;
+			}
 		}
-
-		res = ms_filter_link(ctx->stream->encoder,0,ctx->stream->rtpsend,0);
-		if (res < 0) 
+		else
 		{
-			LogWarn("error:ms_filter_link encoder->rtpsend");
-			goto error;
+			res = ms_filter_link(ctx->stream->soundread,0,ctx->stream->encoder,0);
+			if (res < 0) 
+			{
+				LogWarn("error:ms_filter_link soundread->encoder");
+				goto error;
+			}
+
+			res = ms_filter_link(ctx->stream->encoder,0,ctx->stream->rtpsend,0);
+			if (res < 0) 
+			{
+				LogWarn("error:ms_filter_link encoder->rtpsend");
+				goto error;
+			}
 		}
 
 // 		res = ms_filter_link(ctx->stream->dtmfgen,0,ctx->stream->soundwrite,0);
@@ -1149,6 +1299,8 @@ error:
 			goto error;
 		}
 
+		ctx->pt_idx = idx;
+
 		return API_SUCCESS;
 
 error:
@@ -1194,12 +1346,111 @@ error:
 
 		}
 
+		ReleaseTicker(ctx);
+
 		ctx->state = IMS_STOPPED;
 
 		return API_SUCCESS;
 
 	}
 
+	void
+	ProcM2Ims::CreateTickers()
+	{
+		FUNCTRACKER;
+
+		SYSTEM_INFO sys_info;
+		::GetSystemInfo(&sys_info);
+		int num_of_cpus = sys_info.dwNumberOfProcessors > 0 ? sys_info.dwNumberOfProcessors : 1;
+
+		// zero means ticker per core
+		int num_of_tickers = _conf->HasOption("m2ims/tickers") ? 
+			_conf->GetInt("m2ims/tickers") : 1;
+		if (num_of_tickers <= 0)
+		{
+			num_of_tickers = num_of_cpus;
+		}
+
+		BOOL affinity = _conf->HasOption("m2ims/ticker_affinity") && 
+			_conf->GetBool("m2ims/ticker_affinity");
+
+		LogDebug("ProcM2Ims::CreateTickers - tickers:" << num_of_tickers << ", cpus:" << num_of_cpus << ", affinity:" << affinity);
+
+		for (int i = 0; i < num_of_tickers; ++i)
+		{
+			MSTicker *ticker = ms_ticker_new();
+			if (ticker == NULL)
+			{
+				LogCrit("Cannot start ms ticker");
+				throw;
+			}
+
+			if (affinity)
+			{
+				DWORD_PTR mask = ((DWORD_PTR)1) << (i % num_of_cpus);
+				if (::SetThreadAffinityMask(ticker->thread, mask) == 0)
+				{
+					LogSysError("::SetThreadAffinityMask");
+				}
+			}
+
+			MSFilter *probe = ms_filter_new_from_desc(&iw_ticker_probe_desc);
+			if (probe == NULL || ms_ticker_attach(ticker,probe) < 0)
+			{
+				LogCrit("Cannot attach ticker probe");
+				throw;
+			}
+
+			_tickers.push_back(ticker);
+			_tickerProbes.push_back(probe);
+			_tickerLoad.push_back(0);
+		}
+
+	}
+
+	int
+	ProcM2Ims::LeastLoadedTicker()
+	{
+		int least = 0;
+		for (int i = 1; i < (int)_tickerLoad.size(); ++i)
+		{
+			if (_tickerLoad[i] < _tickerLoad[least])
+			{
+				least = i;
+			}
+		}
+
+		return least;
+	}
+
+	void
+	ProcM2Ims::ReleaseTicker(IN StreamingCtxPtr ctx)
+	{
+		if (ctx->ticker_idx == IW_UNDEFINED)
+		{
+			return;
+		}
+
+		_tickerLoad[ctx->ticker_idx]--;
+		ctx->ticker_idx = IW_UNDEFINED;
+	}
+
+	void
+	ProcM2Ims::LogTickerStats()
+	{
+		for (size_t i = 0; i < _tickers.size(); ++i)
+		{
+			TickerProbeStats stats;
+			ms_filter_call_method(_tickerProbes[i],IW_TICKER_PROBE_GET_STATS,&stats);
+
+			LogInfo("Ticker " << i 
+				<< " load:"		<< _tickerLoad[i] 
+				<< ", ticks:"		<< stats.ticks 
+				<< ", late ticks:"	<< stats.late_ticks 
+				<< ", max late:"	<< stats.max_late_ms << "ms");
+		}
+	}
+
 	void 
 	ProcM2Ims::ModifySession(IwMessagePtr msg)
 	{
@@ -1310,6 +1561,166 @@ error:
 
 
 
+	ApiErrorCode
+	ProcM2Ims::OpenFilePrompt(IN StreamingCtxPtr ctx, IN const string &file_name)
+	{
+		FUNCTRACKER;
+
+		int res = -1;
+
+		string filename = file_name;
+
+		//
+		// Check if file exists
+		//
+		WIN32_FIND_DATAA FindFileData;
+		HANDLE hFind = NULL; 
+		hFind = ::FindFirstFileA(filename.c_str(), &FindFileData);
+		if (hFind == INVALID_HANDLE_VALUE) 
+		{
+			LogDebug("file:" << filename << " not found. Trying relative path...");
+
+			// relative path?
+			filename = _conf->GetString("m2ims/sounds_dir")+ "\\" + file_name;
+			hFind = ::FindFirstFileA(filename.c_str(), &FindFileData);
+			if (hFind == INVALID_HANDLE_VALUE) 
+			{
+				LogWarn("file:" << filename << " not found.");
+				return API_FAILURE;
+			}
+			else
+			{
+				BOOL res = FALSE;
+				res = ::FindClose(hFind);
+				if (res == FALSE)
+				{
+					LogCrit("::CloseHandle");
+					throw;
+				}
+			}
+		} 
+		else
+		{
+			BOOL res = FALSE;
+			res = ::FindClose(hFind);
+			if (res == FALSE)
+			{
+				LogCrit("::CloseHandle");
+				throw;
+			}
+		}
+
+
+
+		char buffer[1024];
+		buffer[0] = '\0';
+		DWORD res_len = 0;
+		res_len=::GetFullPathNameA(filename.c_str(),1024,buffer,NULL);
+		if (res_len <= 0)
+		{
+			LogSysError("::GetFullPathNameA");
+			return API_FAILURE;
+		}
+
+		
+		filename = buffer;
+		LogDebug("StartPlayback:: Play file name:" << filename  << ", imsh:" << ctx->streamer_handle 
+			<< ", dst:" << ::inet_ntoa(ctx->stream->session->rtp.rem_addr.sin_addr)<< ":" << ::ntohs(ctx->stream->session->rtp.rem_addr.sin_port));
+
+		
+
+		res = ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_CLOSE);
+		if (res < 0)
+		{
+			LogWarn("mserror:ms_filter_call_method_noarg MS_FILE_PLAYER_CLOSE imsh:" << ctx->streamer_handle);
+			return API_FAILURE;
+		}
+
+		res = ms_filter_call_method(ctx->stream->soundread,MS_FILE_PLAYER_OPEN,(void*)filename.c_str());
+		if (res < 0)
+		{
+			LogWarn("mserror:ms_filter_call_method MS_FILE_PLAYER_OPEN imsh:" << ctx->streamer_handle);
+			return API_FAILURE;
+		}
+
+		return API_SUCCESS;
+
+	}
+
+	ApiErrorCode
+	ProcM2Ims::OpenCachedPrompts(IN StreamingCtxPtr ctx, IN const vector<string> &file_names)
+	{
+		FUNCTRACKER;
+
+		CachedPromptsVector prompts;
+		for (vector<string>::const_iterator iter = file_names.begin(); 
+			iter != file_names.end(); 
+			++iter)
+		{
+			CachedPromptPtr prompt;
+			ApiErrorCode iw_res = _promptCache->Get(*iter, ctx->prompt_encoding, prompt);
+			if (IW_FAILURE(iw_res))
+			{
+				LogWarn("OpenCachedPrompts:: file:" << *iter << " cannot be loaded, imsh:" << ctx->streamer_handle);
+				return iw_res;
+			}
+
+			LogDebug("OpenCachedPrompts:: Play file name:" << prompt->path << ", imsh:" << ctx->streamer_handle 
+				<< ", dst:" << ::inet_ntoa(ctx->stream->session->rtp.rem_addr.sin_addr)<< ":" << ::ntohs(ctx->stream->session->rtp.rem_addr.sin_port));
+
+			prompts.push_back(prompt);
+		}
+
+		int res = ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_CLOSE);
+		if (res < 0)
+		{
+			LogWarn("mserror:ms_filter_call_method_noarg MS_FILE_PLAYER_CLOSE imsh:" << ctx->streamer_handle);
+			return API_FAILURE;
+		}
+
+		res = ms_filter_call_method(ctx->stream->soundread,IW_MEM_PLAYER_SET_PLAYLIST,&prompts);
+		if (res < 0)
+		{
+			LogWarn("mserror:ms_filter_call_method IW_MEM_PLAYER_SET_PLAYLIST imsh:" << ctx->streamer_handle);
+			return API_FAILURE;
+		}
+
+		return API_SUCCESS;
+
+	}
+
+	BOOL
+	ProcM2Ims::PlayNextFile(IN StreamingCtxPtr ctx)
+	{
+		FUNCTRACKER;
+
+		// memory player plays the whole list by itself
+		if (_promptCache || ctx->playlist.size() < 2 || ctx->state != IMS_TICKING)
+		{
+			return FALSE;
+		}
+
+		ctx->playlist_pos++;
+		if (ctx->playlist_pos == ctx->playlist.size())
+		{
+			if (!ctx->loop)
+			{
+				return FALSE;
+			}
+			ctx->playlist_pos = 0;
+		}
+
+		// ticker keeps running so rtp timestamps stay continuous
+		if (IW_FAILURE(OpenFilePrompt(ctx, ctx->playlist[ctx->playlist_pos])) ||
+			ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_START) < 0)
+		{
+			LogWarn("PlayNextFile:: cannot continue playlist, imsh:" << ctx->streamer_handle);
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
 	void 
 	ProcM2Ims::StartPlayback(IwMessagePtr msg)
 	{
@@ -1350,81 +1761,23 @@ error:
 		{
 		case SND_DEVICE_TYPE_FILE:
 			{
-				string filename = req->file_name;
-
-				//
-				// Check if file exists
-				//
-				WIN32_FIND_DATAA FindFileData;
-				HANDLE hFind = NULL; 
-				hFind = ::FindFirstFileA(filename.c_str(), &FindFileData);
-				if (hFind == INVALID_HANDLE_VALUE) 
+				ctx->playlist.clear();
+				if (req->playlist.empty())
 				{
-					LogDebug("file:" << filename << " not found. Trying relative path...");
-
-					// relative path?
-					filename = _conf->GetString("m2ims/sounds_dir")+ "\\" + req->file_name;
-					hFind = ::FindFirstFileA(filename.c_str(), &FindFileData);
-					if (hFind == INVALID_HANDLE_VALUE) 
-					{
-						LogWarn("file:" << filename << " not found.");
-						SendResponse(msg, new MsgStreamPlayNack());
-						return;
-					}
-					else
-					{
-						BOOL res = FALSE;
-						res = ::FindClose(hFind);
-						if (res == FALSE)
-						{
-							LogCrit("::CloseHandle");
-							throw;
-						}
-					}
-				} 
+					ctx->playlist.push_back(req->file_name);
+				}
 				else
 				{
-					BOOL res = FALSE;
-					res = ::FindClose(hFind);
-					if (res == FALSE)
-					{
-						LogCrit("::CloseHandle");
-						throw;
-					}
+					ctx->playlist.assign(req->playlist.begin(), req->playlist.end());
 				}
+				ctx->playlist_pos = 0;
 
+				ApiErrorCode open_res = _promptCache ? 
+					OpenCachedPrompts(ctx, ctx->playlist) : 
+					OpenFilePrompt(ctx, ctx->playlist.front());
 
-
-				char buffer[1024];
-				buffer[0] = '\0';
-				DWORD res_len = 0;
-				res_len=::GetFullPathNameA(filename.c_str(),1024,buffer,NULL);
-				if (res_len <= 0)
-				{
-					LogSysError("::GetFullPathNameA");
-					SendResponse(msg, new MsgStreamPlayNack());
-					return;
-				}
-
-				
-				filename = buffer;
-				LogDebug("StartPlayback:: Play file name:" << filename << ", loop:" << req->loop << ", imsh:" << req->streamer_handle 
-					<< ", dst:" << ::inet_ntoa(ctx->stream->session->rtp.rem_addr.sin_addr)<< ":" << ::ntohs(ctx->stream->session->rtp.rem_addr.sin_port));
-
-				
-
-				res = ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_CLOSE);
-				if (res < 0)
-				{
-					LogWarn("mserror:ms_filter_call_method_noarg MS_FILE_PLAYER_CLOSE imsh:" << req->streamer_handle);
-					SendResponse(msg, new MsgStreamPlayNack());
-					return;
-				}
-
-				res = ms_filter_call_method(ctx->stream->soundread,MS_FILE_PLAYER_OPEN,(void*)filename.c_str());
-				if (res < 0)
+				if (IW_FAILURE(open_res))
 				{
-					LogWarn("mserror:ms_filter_call_method MS_FILE_PLAYER_OPEN imsh:" << req->streamer_handle);
 					SendResponse(msg, new MsgStreamPlayNack());
 					return;
 				}
@@ -1461,7 +1814,10 @@ error:
 
 
 
-				int loop_param = req->loop ? 0 : -2;
+				// file player loops single file only, lists are looped by PlayNextFile
+				BOOL player_loops = req->loop && (_promptCache || ctx->playlist.size() == 1);
+
+				int loop_param = player_loops ? 0 : -2;
 				res = ms_filter_call_method(ctx->stream->soundread,MS_FILE_PLAYER_LOOP, &loop_param);
 				if (res < 0)
 				{
@@ -1522,6 +1878,12 @@ error:
 
 		StreamingCtxPtr ctx = iter->second;
 
+		// playlist goes on
+		if (PlayNextFile(ctx))
+		{
+			return;
+		}
+
 		// ignore eof event if playback is looped
 		if (ctx->loop)
 		{
@@ -1557,7 +1919,10 @@ error:
 
 		StreamingCtxPtr ctx = iter->second;
 		
-		TearDown(ctx);
+		if (!ReleaseGraph(ctx))
+		{
+			TearDown(ctx);
+		}
 		
 		
 		// ctx dtor should release all associated resources
@@ -1565,6 +1930,160 @@ error:
 		
 	}
 
+	StreamingCtxPtr
+	ProcM2Ims::AcquirePooledGraph(IN RcvDeviceType rcvDeviceType, IN int idx)
+	{
+		FUNCTRACKER;
+
+		if (_graphPoolSize == 0)
+		{
+			return StreamingCtxPtr();
+		}
+
+		GraphPoolMap::iterator iter = 
+			_graphPool.find(GRAPH_POOL_KEY(rcvDeviceType,idx));
+
+		if (iter == _graphPool.end() || iter->second.empty())
+		{
+			_graphPoolMisses++;
+			return StreamingCtxPtr();
+		}
+
+		StreamingCtxPtr ctx = iter->second.front();
+		iter->second.pop_front();
+
+		_graphPoolHits++;
+
+		return ctx;
+	}
+
+	ApiErrorCode
+	ProcM2Ims::RebindPooledGraph(IN StreamingCtxPtr ctx, IN const CnxInfo &remoteInfo)
+	{
+		FUNCTRACKER;
+
+		RtpSession *rtps = ctx->stream->session;
+
+		// fresh sequence numbers, timestamps and source for the new call
+		rtp_session_reset(rtps);
+		rtp_session_set_ssrc(rtps,(::rand() << 16) | ::rand());
+
+		int res = rtp_session_set_remote_addr(rtps,(char *)remoteInfo.iptoa(),remoteInfo.port_ho());
+		if (res < 0) 
+		{
+			LogWarn("error:rtp_session_set_remote_addr");
+			return API_FAILURE;
+		}
+
+		ctx->stream->soundread->notify_ud = (void*)ctx->streamer_handle;
+
+		ctx->correlation_id = IW_UNDEFINED;
+		ctx->loop = FALSE;
+		ctx->playlist.clear();
+		ctx->playlist_pos = 0;
+		ctx->last_user_request.reset();
+
+		// recording file is named after the handle
+		if (ctx->rcv_device_type == RCV_DEVICE_FILE_REC_ID)
+		{
+			char buf[100];
+			::itoa(ctx->streamer_handle,buf,10);
+			string path = _conf->GetString("m2ims/record_dir") + "\\" + buf + ".wav";
+			res = ms_filter_call_method(ctx->stream->soundwrite,MS_FILE_REC_OPEN,(void*)path.c_str());
+			if (res<0) 
+			{
+				LogWarn("error:ms_filter_call_method(MS_FILE_REC_OPEN) name:" << path);
+				return API_FAILURE;
+			}
+
+			res =  ms_filter_call_method_noarg(ctx->stream->soundwrite,MS_FILE_REC_START);
+			if (res<0) 
+			{
+				LogWarn("error:ms_filter_call_method(MS_FILE_REC_START) name:" << path);
+				return API_FAILURE;
+			}
+		}
+
+		LogDebug("ProcM2Ims::RebindPooledGraph - port:" << rtps->rtp.loc_port << ", imsh:" << ctx->streamer_handle);
+
+		return API_SUCCESS;
+	}
+
+	BOOL
+	ProcM2Ims::ReleaseGraph(IN StreamingCtxPtr ctx)
+	{
+		FUNCTRACKER;
+
+		// only fully linked file playback graphs are reused
+		if (_graphPoolSize == 0 ||
+			ctx->pt == NULL ||
+			ctx->pt_idx == IW_UNDEFINED ||
+			ctx->snd_device_type != SND_DEVICE_TYPE_FILE ||
+			ctx->rcv_device_type == RCV_DEVICE_WINSND_WRITE ||
+			ctx->stream == NULL ||
+			ctx->stream->soundread == NULL)
+		{
+			return FALSE;
+		}
+
+		StreamingCtxsList &idle = 
+			_graphPool[GRAPH_POOL_KEY(ctx->rcv_device_type,ctx->pt_idx)];
+
+		if (idle.size() >= _graphPoolSize)
+		{
+			return FALSE;
+		}
+
+		if (IW_FAILURE(StopTicking(ctx)))
+		{
+			return FALSE;
+		}
+
+		ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_STOP);
+		ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_CLOSE);
+
+		if (ctx->rcv_device_type == RCV_DEVICE_FILE_REC_ID)
+		{
+			ms_filter_call_method_noarg(ctx->stream->soundwrite,MS_FILE_REC_CLOSE);
+		}
+
+		LogDebug("ProcM2Ims::ReleaseGraph - port:" << ctx->stream->session->rtp.loc_port << ", imsh:" << ctx->streamer_handle);
+
+		ctx->streamer_handle = IW_UNDEFINED;
+		ctx->stream->soundread->notify_ud = (void*)IW_UNDEFINED;
+		ctx->session_handler = LpHandlePair();
+		ctx->last_user_request.reset();
+		ctx->playlist.clear();
+
+		idle.push_back(ctx);
+
+		return TRUE;
+	}
+
+	void
+	ProcM2Ims::LogGraphPoolStats()
+	{
+		if (_graphPoolSize == 0)
+		{
+			return;
+		}
+
+		size_t idle = 0;
+		for (GraphPoolMap::iterator iter = _graphPool.begin(); 
+			iter != _graphPool.end(); 
+			++iter)
+		{
+			idle += iter->second.size();
+		}
+
+		long total = _graphPoolHits + _graphPoolMisses;
+
+		LogInfo("Graph pool hits:" << _graphPoolHits 
+			<< ", misses:" << _graphPoolMisses 
+			<< ", hit rate:" << (total == 0 ? 0 : (_graphPoolHits * 100) / total) << "%"
+			<< ", idle:" << idle);
+	}
+
 	void 
 	ProcM2Ims::TearDown(StreamingCtxPtr ctx)
 	{
@@ -1573,6 +2092,8 @@ error:
 
 		AudioStream *stream = ctx->stream;
 
+		ReleaseTicker(ctx);
+
 		if (stream->ticker)
 		{
 			if (stream->soundread)	ms_ticker_detach(stream->ticker,stream->soundread);
@@ -1586,12 +2107,15 @@ error:
 				ms_filter_unlink(stream->ec,1,stream->encoder,0);
 				ms_filter_unlink(stream->dtmfgen,0,stream->ec,0);
 				ms_filter_unlink(stream->ec,0,stream->soundwrite,0);
+			}else if (ctx->prompt_passthrough){
+				ms_filter_unlink(stream->soundread,0,stream->rtpsend,0);
+				ms_filter_unlink(stream->dtmfgen,0,stream->soundwrite,0);
 			}else{
 				ms_filter_unlink(stream->soundread,0,stream->encoder,0);
 				ms_filter_unlink(stream->dtmfgen,0,stream->soundwrite,0);
 			}
 
-			if (stream->rtpsend) ms_filter_unlink(stream->encoder,0,stream->rtpsend,0);
+			if (stream->rtpsend && !ctx->prompt_passthrough) ms_filter_unlink(stream->encoder,0,stream->rtpsend,0);
 			if (stream->decoder) ms_filter_unlink(stream->rtprecv,0,stream->decoder,0);
 			if (stream->dtmfgen) ms_filter_unlink(stream->decoder,0,stream->dtmfgen,0);
 		}
@@ -1646,6 +2170,9 @@ error:
 			return;
 		}
 
+		// late end of file event should not continue the list
+		ctx->playlist.clear();
+
 		int res = ms_filter_call_method_noarg(ctx->stream->soundread,MS_FILE_PLAYER_STOP);
 		if (res == -1)
 		{
@@ -1669,6 +2196,20 @@ error:
 		}
 
 		_streamingObjectSet.clear();
+
+		for(GraphPoolMap::iterator iter = _graphPool.begin();
+			iter != _graphPool.end();
+			iter++)
+		{
+			for (StreamingCtxsList::iterator ctx_iter = iter->second.begin();
+				ctx_iter != iter->second.end();
+				ctx_iter++)
+			{
+				TearDown(*ctx_iter);
+			}
+		}
+
+		_graphPool.clear();
 	}
 }
 
@@ -19,7 +19,8 @@
 
 #pragma once
 
-
+#include "PromptCache.h"
+#include "RecordingWriter.h"
 
 using namespace std;
 
@@ -68,6 +69,24 @@ namespace ivrworx
 
 		PayloadType *pt;
 
+		// index of negotiated payload in profile
+		int pt_idx;
+
+		// ticker the graph is attached to
+		int ticker_idx;
+
+		// encoding prompts are kept in when played from cache
+		PromptEncoding prompt_encoding;
+
+		// player is linked directly to rtp sender
+		BOOL prompt_passthrough;
+
+		// files of current play request, file player 
+		// is fed next one upon end of file
+		vector<string> playlist;
+
+		size_t playlist_pos;
+
 	};
 
 	typedef 
@@ -129,7 +148,38 @@ namespace ivrworx
 
 		void CleanUpResources();
 
-		MSTicker *_ticker;
+		ApiErrorCode OpenFilePrompt(IN StreamingCtxPtr ctx, IN const string &file_name);
+
+		ApiErrorCode OpenCachedPrompts(IN StreamingCtxPtr ctx, IN const vector<string> &file_names);
+
+		BOOL PlayNextFile(IN StreamingCtxPtr ctx);
+
+		StreamingCtxPtr AcquirePooledGraph(IN RcvDeviceType rcvDeviceType, IN int idx);
+
+		ApiErrorCode RebindPooledGraph(IN StreamingCtxPtr ctx, IN const CnxInfo &remoteInfo);
+
+		BOOL ReleaseGraph(IN StreamingCtxPtr ctx);
+
+		void LogGraphPoolStats();
+
+		void CreateTickers();
+
+		int LeastLoadedTicker();
+
+		void ReleaseTicker(IN StreamingCtxPtr ctx);
+
+		void LogTickerStats();
+
+		// graphs are spread over tickers by load
+		typedef
+		vector<MSTicker*> TickersVector;
+		TickersVector _tickers;
+
+		typedef
+		vector<MSFilter*> FiltersVector;
+		FiltersVector _tickerProbes;
+
+		vector<long> _tickerLoad;
 
 		RtpProfile *_avProfile;
 
@@ -155,6 +205,25 @@ namespace ivrworx
 
 		string _codecsListPostfix;
 
+		PromptCachePtr _promptCache;
+
+		RecordingWriterPtr _recWriter;
+
+		// idle linked graphs with their bound ports, 
+		// keyed by receive device and payload index
+		typedef 
+		list<StreamingCtxPtr> StreamingCtxsList;
+
+		typedef
+		map<int, StreamingCtxsList> GraphPoolMap;
+		GraphPoolMap _graphPool;
+
+		size_t _graphPoolSize;
+
+		long _graphPoolHits;
+
+		long _graphPoolMisses;
+
 	};
 
 	
@@ -0,0 +1,468 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "PromptCache.h"
+#include "G711.h"
+
+namespace ivrworx
+{
+
+#define IW_PROMPT_CACHE_STATS_INTERVAL 1000
+
+	static unsigned int 
+	ReadLe16(IN const unsigned char *p)
+	{
+		return p[0] | (p[1] << 8);
+	}
+
+	static unsigned int 
+	ReadLe32(IN const unsigned char *p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+	}
+
+#define IW_WAVE_FORMAT_PCM	 1
+#define IW_WAVE_FORMAT_ALAW  6
+#define IW_WAVE_FORMAT_MULAW 7
+
+	PromptEncoding 
+	PromptEncodingFromMime(IN const char *mime_type)
+	{
+		if (mime_type == NULL)
+		{
+			return PROMPT_ENCODING_LINEAR;
+		}
+
+		if (::_stricmp(mime_type,"PCMU") == 0)
+		{
+			return PROMPT_ENCODING_PCMU;
+		}
+
+		if (::_stricmp(mime_type,"PCMA") == 0)
+		{
+			return PROMPT_ENCODING_PCMA;
+		}
+
+		return PROMPT_ENCODING_LINEAR;
+	}
+
+	unsigned int
+	PromptBytesPerSample(IN PromptEncoding encoding)
+	{
+		return encoding == PROMPT_ENCODING_LINEAR ? sizeof(short) : 1;
+	}
+
+	unsigned char
+	PromptSilenceByte(IN PromptEncoding encoding)
+	{
+		switch (encoding)
+		{
+		case PROMPT_ENCODING_PCMU: return 0xFF;
+		case PROMPT_ENCODING_PCMA: return 0xD5;
+		default: return 0;
+		}
+	}
+
+	CachedPrompt::CachedPrompt():
+	encoding(PROMPT_ENCODING_LINEAR),
+	clock_rate(8000),
+	file_size(0)
+	{
+		last_write.dwLowDateTime  = 0;
+		last_write.dwHighDateTime = 0;
+	}
+
+	PromptCache::PromptCache(
+		IN const string &sounds_dir, 
+		IN size_t max_bytes, 
+		IN DWORD check_interval):
+	_soundsDir(sounds_dir),
+	_maxBytes(max_bytes),
+	_bytesUsed(0),
+	_checkInterval(check_interval),
+	_hits(0),
+	_misses(0),
+	_reloads(0)
+	{
+
+	}
+
+	PromptCache::~PromptCache()
+	{
+		LogStats();
+	}
+
+	size_t 
+	PromptCache::BytesUsed()
+	{
+		return _bytesUsed;
+	}
+
+	void 
+	PromptCache::LogStats()
+	{
+		unsigned long total = _hits + _misses;
+
+		LogInfo("PromptCache - prompts:" << _entries.size() 
+			<< ", bytes:"	<< _bytesUsed 
+			<< ", hits:"	<< _hits 
+			<< ", misses:"	<< _misses 
+			<< ", reloads:" << _reloads
+			<< ", hit rate:" << (total == 0 ? 0 : (100 * _hits) / total) << "%");
+	}
+
+	ApiErrorCode 
+	PromptCache::ResolvePath(IN const string &file_name, OUT string &full_path)
+	{
+		FUNCTRACKER;
+
+		string filename = file_name;
+
+		DWORD attrs = ::GetFileAttributesA(filename.c_str());
+		if (attrs == INVALID_FILE_ATTRIBUTES)
+		{
+			// relative path?
+			filename = _soundsDir + "\\" + file_name;
+			attrs = ::GetFileAttributesA(filename.c_str());
+		}
+
+		if (attrs == INVALID_FILE_ATTRIBUTES || (attrs & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			LogWarn("PromptCache::ResolvePath - file:" << file_name << " not found.");
+			return API_FAILURE;
+		}
+
+		char buffer[1024];
+		buffer[0] = '\0';
+
+		DWORD res_len = ::GetFullPathNameA(filename.c_str(),sizeof(buffer),buffer,NULL);
+		if (res_len == 0 || res_len >= sizeof(buffer))
+		{
+			LogSysError("::GetFullPathNameA");
+			return API_FAILURE;
+		}
+
+		full_path = buffer;
+		return API_SUCCESS;
+
+	}
+
+	BOOL 
+	PromptCache::IsStale(IN const CachedPromptPtr &prompt)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (::GetFileAttributesExA(prompt->path.c_str(), GetFileExInfoStandard, &data) == FALSE)
+		{
+			return TRUE;
+		}
+
+		return 
+			::CompareFileTime(&data.ftLastWriteTime, &prompt->last_write) != 0 || 
+			data.nFileSizeLow != prompt->file_size;
+	}
+
+	ApiErrorCode 
+	PromptCache::Get(
+		IN const string &file_name, 
+		IN PromptEncoding encoding, 
+		OUT CachedPromptPtr &prompt)
+	{
+		FUNCTRACKER;
+
+		DWORD now = ::GetTickCount();
+
+		if (((_hits + _misses) % IW_PROMPT_CACHE_STATS_INTERVAL) == 0 && 
+			(_hits + _misses) > 0)
+		{
+			LogStats();
+		}
+
+		string full_path;
+		PathsMap::iterator path_iter = _paths.find(file_name);
+		if (path_iter == _paths.end())
+		{
+			if (IW_FAILURE(ResolvePath(file_name, full_path)))
+			{
+				return API_FAILURE;
+			}
+			_paths[file_name] = full_path;
+		}
+		else
+		{
+			full_path = path_iter->second;
+		}
+
+		EntryKey key(full_path, encoding);
+		EntriesMap::iterator iter = _entries.find(key);
+
+		if (iter != _entries.end() && 
+			(now - iter->second.last_checked) >= _checkInterval)
+		{
+			iter->second.last_checked = now;
+			if (IsStale(iter->second.prompt))
+			{
+				LogDebug("PromptCache::Get - file:" << full_path << " changed, reloading.");
+
+				_bytesUsed -= iter->second.prompt->data.size();
+				_entries.erase(iter);
+				iter = _entries.end();
+				_reloads++;
+			}
+		}
+
+		if (iter != _entries.end())
+		{
+			iter->second.last_used = now;
+			prompt = iter->second.prompt;
+			_hits++;
+			return API_SUCCESS;
+		}
+
+		_misses++;
+
+		CachedPromptPtr loaded;
+		ApiErrorCode res = Load(full_path, encoding, loaded);
+		if (IW_FAILURE(res))
+		{
+			// file may have moved, resolve it again next time
+			_paths.erase(file_name);
+			return res;
+		}
+
+		size_t size = loaded->data.size();
+		if (size <= _maxBytes)
+		{
+			Evict(size);
+
+			Entry &entry = _entries[key];
+			entry.prompt		= loaded;
+			entry.last_used		= now;
+			entry.last_checked	= now;
+
+			_bytesUsed += size;
+		}
+		else
+		{
+			LogWarn("PromptCache::Get - file:" << full_path << " size:" << size << " exceeds cache size, not cached.");
+		}
+
+		prompt = loaded;
+
+		return API_SUCCESS;
+
+	}
+
+	void 
+	PromptCache::Evict(IN size_t needed)
+	{
+		// least recently used first, happens only when cache is full
+		while (!_entries.empty() && _bytesUsed + needed > _maxBytes)
+		{
+			EntriesMap::iterator lru = _entries.begin();
+			for (EntriesMap::iterator iter = _entries.begin(); iter != _entries.end(); ++iter)
+			{
+				if ((int)(iter->second.last_used - lru->second.last_used) < 0)
+				{
+					lru = iter;
+				}
+			}
+
+			LogDebug("PromptCache::Evict - file:" << lru->first.first);
+
+			_bytesUsed -= lru->second.prompt->data.size();
+			_entries.erase(lru);
+		}
+	}
+
+	ApiErrorCode 
+	PromptCache::Load(
+		IN const string &full_path, 
+		IN PromptEncoding encoding, 
+		OUT CachedPromptPtr &prompt)
+	{
+		FUNCTRACKER;
+
+		HANDLE file = ::CreateFileA(
+			full_path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			NULL,
+			OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN,
+			NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			LogWarn("PromptCache::Load - cannot open file:" << full_path);
+			return API_FAILURE;
+		}
+
+		CachedPromptPtr p(new CachedPrompt());
+		p->path		= full_path;
+		p->encoding = encoding;
+
+		BY_HANDLE_FILE_INFORMATION info;
+		if (::GetFileInformationByHandle(file, &info) == FALSE)
+		{
+			LogSysError("::GetFileInformationByHandle");
+			::CloseHandle(file);
+			return API_FAILURE;
+		}
+
+		p->last_write = info.ftLastWriteTime;
+		p->file_size  = info.nFileSizeLow;
+
+		vector<unsigned char> raw(info.nFileSizeLow);
+		DWORD read = 0;
+		BOOL read_res = raw.empty() ? TRUE : 
+			::ReadFile(file, &raw[0], (DWORD)raw.size(), &read, NULL);
+
+		::CloseHandle(file);
+
+		if (read_res == FALSE || read != raw.size() || raw.size() < 12 ||
+			::memcmp(&raw[0],"RIFF",4) != 0 || 
+			::memcmp(&raw[8],"WAVE",4) != 0)
+		{
+			LogWarn("PromptCache::Load - file:" << full_path << " is not a wav file.");
+			return API_FAILURE;
+		}
+
+		//
+		// walk the chunks
+		//
+		unsigned int format = 0;
+		unsigned int channels = 0;
+		unsigned int bits = 0;
+		const unsigned char *samples = NULL;
+		size_t samples_len = 0;
+
+		size_t pos = 12;
+		while (pos + 8 <= raw.size())
+		{
+			const unsigned char *chunk = &raw[pos];
+			size_t chunk_len = ReadLe32(chunk + 4);
+			size_t body = pos + 8;
+
+			if (::memcmp(chunk,"fmt ",4) == 0 && chunk_len >= 16 && body + 16 <= raw.size())
+			{
+				format		  = ReadLe16(&raw[body]);
+				channels	  = ReadLe16(&raw[body + 2]);
+				p->clock_rate = ReadLe32(&raw[body + 4]);
+				bits		  = ReadLe16(&raw[body + 14]);
+			}
+			else if (::memcmp(chunk,"data",4) == 0)
+			{
+				samples		= &raw[0] + body;
+				samples_len = min(chunk_len, raw.size() - body);
+			}
+
+			// length is read from the file, a chunk running past its end
+			// is the last one, truncated data chunk is played as is
+			if (chunk_len > raw.size() - body)
+			{
+				break;
+			}
+
+			pos = body + chunk_len + (chunk_len & 1);
+		}
+
+		BOOL supported = 
+			channels == 1 && 
+			((format == IW_WAVE_FORMAT_PCM && bits == 16) || 
+			 format == IW_WAVE_FORMAT_MULAW || 
+			 format == IW_WAVE_FORMAT_ALAW);
+
+		if (!supported || samples == NULL)
+		{
+			LogWarn("PromptCache::Load - file:" << full_path << " unsupported format:" << format 
+				<< ", channels:" << channels << ", bits:" << bits);
+			return API_FAILURE;
+		}
+
+		// already in requested encoding
+		if ((format == IW_WAVE_FORMAT_MULAW && encoding == PROMPT_ENCODING_PCMU) ||
+			(format == IW_WAVE_FORMAT_ALAW  && encoding == PROMPT_ENCODING_PCMA))
+		{
+			p->data.assign(samples, samples + samples_len);
+			prompt = p;
+			return API_SUCCESS;
+		}
+
+		// not a single sample, prompt stays empty
+		if (samples_len < (format == IW_WAVE_FORMAT_PCM ? sizeof(short) : 1))
+		{
+			prompt = p;
+			return API_SUCCESS;
+		}
+
+		vector<short> linear;
+		switch (format)
+		{
+		case IW_WAVE_FORMAT_MULAW:
+			{
+				linear.resize(samples_len);
+				UlawToLinear(samples, &linear[0], (unsigned)samples_len);
+				break;
+			}
+		case IW_WAVE_FORMAT_ALAW:
+			{
+				linear.resize(samples_len);
+				AlawToLinear(samples, &linear[0], (unsigned)samples_len);
+				break;
+			}
+		default:
+			{
+				linear.resize(samples_len / 2);
+				for (size_t i = 0; i < linear.size(); i++)
+					linear[i] = (short)ReadLe16(samples + 2*i);
+			}
+		}
+
+		switch (encoding)
+		{
+		case PROMPT_ENCODING_PCMU:
+			{
+				p->data.resize(linear.size());
+				LinearToUlaw(&linear[0], &p->data[0], (unsigned)linear.size());
+				break;
+			}
+		case PROMPT_ENCODING_PCMA:
+			{
+				p->data.resize(linear.size());
+				LinearToAlaw(&linear[0], &p->data[0], (unsigned)linear.size());
+				break;
+			}
+		default:
+			{
+				p->data.resize(linear.size() * sizeof(short));
+				if (!linear.empty())
+				{
+					::memcpy(&p->data[0], &linear[0], p->data.size());
+				}
+			}
+		}
+
+		LogDebug("PromptCache::Load - file:" << full_path << ", encoding:" << encoding << ", bytes:" << p->data.size());
+
+		prompt = p;
+		return API_SUCCESS;
+
+	}
+
+}
@@ -0,0 +1,161 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	enum PromptEncoding
+	{
+		PROMPT_ENCODING_LINEAR,	// host order 16 bit samples, goes through session encoder
+		PROMPT_ENCODING_PCMU,	// ready rtp payload
+		PROMPT_ENCODING_PCMA	// ready rtp payload
+	};
+
+	PromptEncoding 
+	PromptEncodingFromMime(IN const char *mime_type);
+
+	unsigned int
+	PromptBytesPerSample(IN PromptEncoding encoding);
+
+	unsigned char
+	PromptSilenceByte(IN PromptEncoding encoding);
+
+	/**
+
+	Prompt file loaded to memory and converted to encoding of the 
+	session it is played on. Shared between all players of the prompt,
+	player keeps reference so prompt invalidated by the cache stays 
+	alive till the end of playback.
+
+	**/
+	struct CachedPrompt:
+		public boost::noncopyable
+	{
+		CachedPrompt();
+
+		string path;
+
+		PromptEncoding encoding;
+
+		int clock_rate;
+
+		vector<unsigned char> data;
+
+		FILETIME last_write;
+
+		DWORD file_size;
+
+	};
+
+	typedef 
+	shared_ptr<CachedPrompt> CachedPromptPtr;
+
+	typedef
+	vector<CachedPromptPtr> CachedPromptsVector;
+
+	/**
+
+	In-memory prompt cache of ims process. Resolves prompt name to full path 
+	once, loads and encodes prompt once per encoding and serves it from 
+	memory afterwards. Prompt files are re-validated against file system not 
+	more often than configured interval, changed files are reloaded.
+
+	Not thread safe, used by ims process thread only.
+
+	**/
+	class PromptCache:
+		public boost::noncopyable
+	{
+	public:
+
+		PromptCache(
+			IN const string &sounds_dir, 
+			IN size_t max_bytes, 
+			IN DWORD check_interval);
+
+		virtual ~PromptCache();
+
+		ApiErrorCode Get(
+			IN const string &file_name, 
+			IN PromptEncoding encoding, 
+			OUT CachedPromptPtr &prompt);
+
+		void LogStats();
+
+		size_t BytesUsed();
+
+	private:
+
+		ApiErrorCode ResolvePath(
+			IN const string &file_name, 
+			OUT string &full_path);
+
+		ApiErrorCode Load(
+			IN const string &full_path, 
+			IN PromptEncoding encoding, 
+			OUT CachedPromptPtr &prompt);
+
+		BOOL IsStale(
+			IN const CachedPromptPtr &prompt);
+
+		void Evict(IN size_t needed);
+
+		struct Entry
+		{
+			Entry():last_used(0),last_checked(0){};
+
+			CachedPromptPtr prompt;
+
+			DWORD last_used;
+
+			DWORD last_checked;
+		};
+
+		typedef 
+		pair<string,PromptEncoding> EntryKey;
+
+		typedef 
+		map<EntryKey,Entry> EntriesMap;
+		EntriesMap _entries;
+
+		typedef
+		map<string,string> PathsMap;
+		PathsMap _paths;
+
+		string _soundsDir;
+
+		size_t _maxBytes;
+
+		size_t _bytesUsed;
+
+		DWORD _checkInterval;
+
+		unsigned long _hits;
+
+		unsigned long _misses;
+
+		unsigned long _reloads;
+
+	};
+
+	typedef 
+	shared_ptr<PromptCache> PromptCachePtr;
+
+}
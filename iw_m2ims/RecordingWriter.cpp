@@ -0,0 +1,469 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "RecordingWriter.h"
+
+namespace ivrworx
+{
+
+#define IW_REC_WRITE_BUFFER_SIZE	(64*1024)
+#define IW_REC_WRITER_POLL_INTERVAL	20 // ms
+#define IW_REC_WAV_HEADER_SIZE		44
+
+	RecordingWriter::RecordingFile::RecordingFile():
+	handle(INVALID_HANDLE_VALUE),
+	used(0),
+	data_bytes(0),
+	dirty(FALSE)
+	{
+
+	}
+
+	RecordingWriter::RecordingWriter(
+		IN RecordingFormat format, 
+		IN DWORD flush_interval, 
+		IN DWORD sync_interval, 
+		IN size_t max_chunks):
+	_format(format),
+	_flushInterval(flush_interval),
+	_syncInterval(sync_interval),
+	_maxChunks(max_chunks),
+	_queue(NULL),
+	_free(NULL),
+	_shutdownEvt(NULL),
+	_thread(NULL),
+	_recordingCounter(0),
+	_allocated(0),
+	_dropped(0),
+	_chunks(0),
+	_writes(0),
+	_syncs(0),
+	_bytes(0)
+	{
+		FUNCTRACKER;
+
+		_queue = (SLIST_HEADER*)::_aligned_malloc(sizeof(SLIST_HEADER),MEMORY_ALLOCATION_ALIGNMENT);
+		_free  = (SLIST_HEADER*)::_aligned_malloc(sizeof(SLIST_HEADER),MEMORY_ALLOCATION_ALIGNMENT);
+
+		if (_queue == NULL || _free == NULL)
+		{
+			LogCrit("RecordingWriter - cannot allocate lists");
+			throw;
+		}
+
+		::InitializeSListHead(_queue);
+		::InitializeSListHead(_free);
+	}
+
+	RecordingWriter::~RecordingWriter()
+	{
+		FUNCTRACKER;
+
+		Stop();
+
+		// chunks pushed after writer was stopped
+		PSLIST_ENTRY entry = ::InterlockedFlushSList(_queue);
+		while (entry != NULL)
+		{
+			PSLIST_ENTRY next = entry->Next;
+			::_aligned_free(entry);
+			entry = next;
+		}
+
+		entry = ::InterlockedFlushSList(_free);
+		while (entry != NULL)
+		{
+			PSLIST_ENTRY next = entry->Next;
+			::_aligned_free(entry);
+			entry = next;
+		}
+
+		::_aligned_free(_queue);
+		::_aligned_free(_free);
+	}
+
+	ApiErrorCode
+	RecordingWriter::Start()
+	{
+		FUNCTRACKER;
+
+		_shutdownEvt = ::CreateEvent( 
+			NULL,               // default security attributes
+			TRUE,               // manual-reset event
+			FALSE,              // initial state is nonsignaled
+			NULL				// object name
+			);
+
+		if (_shutdownEvt == NULL)
+		{
+			LogSysError("::CreateEvent");
+			return API_FAILURE;
+		}
+
+		DWORD dwThreadId = 0;
+		_thread = ::CreateThread( 
+			NULL,                   // default security attributes
+			0,                      // use default stack size  
+			WriterThread,			// thread function name
+			this,			        // argument to thread function 
+			0,                      // use default creation flags 
+			&dwThreadId);			// returns the thread identifier 
+
+		if (_thread == NULL)
+		{
+			LogSysError("::CreateThread");
+			return API_FAILURE;
+		}
+
+		LogDebug("RecordingWriter::Start - format:" << _format << ", flush:" << _flushInterval << ", sync:" << _syncInterval << ", max chunks:" << _maxChunks);
+
+		return API_SUCCESS;
+	}
+
+	void
+	RecordingWriter::Stop()
+	{
+		FUNCTRACKER;
+
+		if (_thread != NULL)
+		{
+			::SetEvent(_shutdownEvt);
+			::WaitForSingleObject(_thread, INFINITE);
+			::CloseHandle(_thread);
+			_thread = NULL;
+		}
+
+		if (_shutdownEvt != NULL)
+		{
+			::CloseHandle(_shutdownEvt);
+			_shutdownEvt = NULL;
+		}
+	}
+
+	long 
+	RecordingWriter::NewRecordingId()
+	{
+		return ::InterlockedIncrement(&_recordingCounter);
+	}
+
+	RecordingChunk *
+	RecordingWriter::AllocChunk()
+	{
+		RecordingChunk *chunk = (RecordingChunk *)::InterlockedPopEntrySList(_free);
+		if (chunk != NULL)
+		{
+			return chunk;
+		}
+
+		if ((size_t)::InterlockedIncrement(&_allocated) > _maxChunks)
+		{
+			::InterlockedDecrement(&_allocated);
+			::InterlockedIncrement(&_dropped);
+			return NULL;
+		}
+
+		chunk = (RecordingChunk *)::_aligned_malloc(sizeof(RecordingChunk),MEMORY_ALLOCATION_ALIGNMENT);
+		if (chunk == NULL)
+		{
+			::InterlockedDecrement(&_allocated);
+			::InterlockedIncrement(&_dropped);
+		}
+
+		return chunk;
+	}
+
+	void
+	RecordingWriter::FreeChunk(IN RecordingChunk *chunk)
+	{
+		::InterlockedPushEntrySList(_free, &chunk->entry);
+	}
+
+	void
+	RecordingWriter::Push(IN RecordingChunk *chunk)
+	{
+		::InterlockedPushEntrySList(_queue, &chunk->entry);
+	}
+
+	DWORD WINAPI 
+	RecordingWriter::WriterThread(LPVOID arg)
+	{
+		((RecordingWriter*)arg)->Run();
+		return 0;
+	}
+
+	void
+	RecordingWriter::Run()
+	{
+		FUNCTRACKER;
+
+		DWORD last_flush = ::GetTickCount();
+		DWORD last_sync  = last_flush;
+
+		while (::WaitForSingleObject(_shutdownEvt,IW_REC_WRITER_POLL_INTERVAL) == WAIT_TIMEOUT)
+		{
+			Drain();
+
+			DWORD now = ::GetTickCount();
+			if (now - last_sync >= _syncInterval)
+			{
+				FlushAll(TRUE);
+				last_flush = last_sync = now;
+			}
+			else if (now - last_flush >= _flushInterval)
+			{
+				FlushAll(FALSE);
+				last_flush = now;
+			}
+		}
+
+		Drain();
+
+		// recordings not closed by their sessions
+		for (RecordingFilesMap::iterator iter = _files.begin(); 
+			iter != _files.end(); 
+			++iter)
+		{
+			LogWarn("RecordingWriter::Run - closing orphan recording:" << iter->second.path);
+			CloseFile(iter->second, 8000, 1);
+		}
+
+		_files.clear();
+	}
+
+	void
+	RecordingWriter::Drain()
+	{
+		PSLIST_ENTRY entry = ::InterlockedFlushSList(_queue);
+		if (entry == NULL)
+		{
+			return;
+		}
+
+		// list is in reverse order of pushes
+		PSLIST_ENTRY ordered = NULL;
+		while (entry != NULL)
+		{
+			PSLIST_ENTRY next = entry->Next;
+			entry->Next = ordered;
+			ordered = entry;
+			entry = next;
+		}
+
+		while (ordered != NULL)
+		{
+			PSLIST_ENTRY next = ordered->Next;
+
+			HandleChunk((RecordingChunk*)ordered);
+			::InterlockedPushEntrySList(_free, ordered);
+
+			ordered = next;
+		}
+	}
+
+	void
+	RecordingWriter::HandleChunk(IN RecordingChunk *chunk)
+	{
+		_chunks++;
+
+		switch (chunk->type)
+		{
+		case REC_CHUNK_OPEN:
+			{
+				OpenFile(chunk);
+				break;
+			}
+		case REC_CHUNK_DATA:
+			{
+				RecordingFilesMap::iterator iter = _files.find(chunk->recording_id);
+				if (iter == _files.end())
+				{
+					// file could not be opened
+					break;
+				}
+
+				RecordingFile &file = iter->second;
+				if (file.used + chunk->size > file.buffer.size())
+				{
+					WriteBuffer(file);
+				}
+
+				::memcpy(&file.buffer[file.used], chunk->data, chunk->size);
+				file.used += chunk->size;
+				break;
+			}
+		case REC_CHUNK_CLOSE:
+			{
+				RecordingFilesMap::iterator iter = _files.find(chunk->recording_id);
+				if (iter == _files.end())
+				{
+					break;
+				}
+
+				CloseFile(iter->second, chunk->rate, chunk->nchannels);
+				_files.erase(iter);
+				break;
+			}
+		default:
+			{
+				LogWarn("RecordingWriter::HandleChunk - unknown chunk type:" << chunk->type);
+			}
+		}
+	}
+
+	void
+	RecordingWriter::OpenFile(IN RecordingChunk *chunk)
+	{
+		FUNCTRACKER;
+
+		RecordingFile &file = _files[chunk->recording_id];
+		file.path.assign(chunk->data, chunk->size);
+
+		file.handle = ::CreateFileA(
+			file.path.c_str(),
+			GENERIC_WRITE,
+			FILE_SHARE_READ,
+			NULL,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			NULL);
+
+		if (file.handle == INVALID_HANDLE_VALUE)
+		{
+			LogWarn("RecordingWriter::OpenFile - cannot open:" << file.path << ", err:" << ::GetLastError());
+			_files.erase(chunk->recording_id);
+			return;
+		}
+
+		file.buffer.resize(IW_REC_WRITE_BUFFER_SIZE);
+
+		// header placeholder, completed upon close
+		if (_format == RECORDING_FORMAT_WAV)
+		{
+			::memset(&file.buffer[0], 0, IW_REC_WAV_HEADER_SIZE);
+			file.used = IW_REC_WAV_HEADER_SIZE;
+		}
+
+		LogDebug("RecordingWriter::OpenFile - recording:" << chunk->recording_id << ", path:" << file.path);
+	}
+
+	void
+	RecordingWriter::WriteBuffer(IN RecordingFile &file)
+	{
+		if (file.used == 0)
+		{
+			return;
+		}
+
+		DWORD written = 0;
+		BOOL res = ::WriteFile(file.handle, &file.buffer[0], (DWORD)file.used, &written, NULL);
+		if (res == FALSE || written != file.used)
+		{
+			LogWarn("RecordingWriter::WriteBuffer - error writing:" << file.path << ", err:" << ::GetLastError());
+		}
+
+		_writes++;
+		_bytes += written;
+
+		file.data_bytes += written;
+		file.used	= 0;
+		file.dirty	= TRUE;
+	}
+
+	void 
+	RecordingWriter::CloseFile(IN RecordingFile &file, IN int rate, IN int nchannels)
+	{
+		FUNCTRACKER;
+
+		WriteBuffer(file);
+
+		if (_format == RECORDING_FORMAT_WAV)
+		{
+			DWORD data_size = file.data_bytes - IW_REC_WAV_HEADER_SIZE;
+			DWORD riff_size = file.data_bytes - 8;
+			DWORD fmt_size  = 16;
+			WORD  fmt_tag	= 1; // pcm
+			WORD  channels	= (WORD)nchannels;
+			DWORD sample_rate = rate;
+			WORD  block_align = channels * 2;
+			DWORD byte_rate = sample_rate * block_align;
+			WORD  bits		= 16;
+
+			char header[IW_REC_WAV_HEADER_SIZE];
+			char *p = header;
+			::memcpy(p,"RIFF",4);				p+=4;
+			::memcpy(p,&riff_size,4);			p+=4;
+			::memcpy(p,"WAVEfmt ",8);			p+=8;
+			::memcpy(p,&fmt_size,4);			p+=4;
+			::memcpy(p,&fmt_tag,2);				p+=2;
+			::memcpy(p,&channels,2);			p+=2;
+			::memcpy(p,&sample_rate,4);			p+=4;
+			::memcpy(p,&byte_rate,4);			p+=4;
+			::memcpy(p,&block_align,2);			p+=2;
+			::memcpy(p,&bits,2);				p+=2;
+			::memcpy(p,"data",4);				p+=4;
+			::memcpy(p,&data_size,4);
+
+			DWORD written = 0;
+			::SetFilePointer(file.handle, 0, NULL, FILE_BEGIN);
+			if (::WriteFile(file.handle, header, IW_REC_WAV_HEADER_SIZE, &written, NULL) == FALSE)
+			{
+				LogWarn("RecordingWriter::CloseFile - error writing header:" << file.path << ", err:" << ::GetLastError());
+			}
+		}
+
+		::FlushFileBuffers(file.handle);
+		::CloseHandle(file.handle);
+		file.handle = INVALID_HANDLE_VALUE;
+
+		LogDebug("RecordingWriter::CloseFile - path:" << file.path << ", bytes:" << file.data_bytes);
+	}
+
+	void 
+	RecordingWriter::FlushAll(IN BOOL sync)
+	{
+		for (RecordingFilesMap::iterator iter = _files.begin(); 
+			iter != _files.end(); 
+			++iter)
+		{
+			RecordingFile &file = iter->second;
+
+			WriteBuffer(file);
+
+			if (sync && file.dirty)
+			{
+				::FlushFileBuffers(file.handle);
+				file.dirty = FALSE;
+				_syncs++;
+			}
+		}
+	}
+
+	void
+	RecordingWriter::LogStats()
+	{
+		// writer thread counters are read without lock, values are approximate
+		LogInfo("RecordingWriter - chunks:" << _chunks 
+			<< ", allocated:"	<< _allocated 
+			<< ", dropped:"		<< _dropped 
+			<< ", writes:"		<< _writes 
+			<< ", bytes:"		<< _bytes 
+			<< ", syncs:"		<< _syncs);
+	}
+
+}
@@ -0,0 +1,178 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#pragma once
+
+namespace ivrworx
+{
+	enum RecordingFormat
+	{
+		RECORDING_FORMAT_WAV,	// 16 bit pcm wav, header is completed upon close
+		RECORDING_FORMAT_RAW	// host order 16 bit samples
+	};
+
+	enum RecordingChunkType
+	{
+		REC_CHUNK_OPEN,
+		REC_CHUNK_DATA,
+		REC_CHUNK_CLOSE
+	};
+
+#define IW_REC_CHUNK_CAPACITY 2048
+
+	/**
+
+	Unit of work passed from ticker threads to recording writer. 
+	Carries either decoded audio or open (path in data) and close 
+	(final rate and channels) commands of a recording, so all 
+	operations of one recording are handled in order.
+
+	**/
+	struct RecordingChunk
+	{
+		SLIST_ENTRY entry;
+
+		RecordingChunkType type;
+
+		long recording_id;
+
+		int rate;
+
+		int nchannels;
+
+		size_t size;
+
+		char data[IW_REC_CHUNK_CAPACITY];
+	};
+
+	/**
+
+	Writes recordings of all sessions of ims process on single background 
+	thread. Producers (recorder filters on ticker threads) push chunks into 
+	lock free list and never wait for disk, chunks come from bounded free 
+	list and are dropped and counted if writer falls behind. Writer coalesces 
+	chunks of every recording in large buffer, writes it sequentially every 
+	flush interval and syncs files to disk every sync interval.
+
+	**/
+	class RecordingWriter:
+		public boost::noncopyable
+	{
+	public:
+
+		RecordingWriter(
+			IN RecordingFormat format, 
+			IN DWORD flush_interval, 
+			IN DWORD sync_interval, 
+			IN size_t max_chunks);
+
+		virtual ~RecordingWriter();
+
+		ApiErrorCode Start();
+
+		void Stop();
+
+		long NewRecordingId();
+
+		// returns NULL if too many chunks are pending, never blocks
+		RecordingChunk *AllocChunk();
+
+		// returns chunk which was not pushed
+		void FreeChunk(IN RecordingChunk *chunk);
+
+		void Push(IN RecordingChunk *chunk);
+
+		void LogStats();
+
+	private:
+
+		static DWORD WINAPI WriterThread(LPVOID arg);
+
+		void Run();
+
+		void Drain();
+
+		void HandleChunk(IN RecordingChunk *chunk);
+
+		struct RecordingFile
+		{
+			RecordingFile();
+
+			HANDLE handle;
+
+			string path;
+
+			vector<char> buffer;
+
+			size_t used;
+
+			DWORD data_bytes;
+
+			BOOL dirty;
+		};
+
+		typedef
+		map<long,RecordingFile> RecordingFilesMap;
+		RecordingFilesMap _files;
+
+		void OpenFile(IN RecordingChunk *chunk);
+
+		void WriteBuffer(IN RecordingFile &file);
+
+		void CloseFile(IN RecordingFile &file, IN int rate, IN int nchannels);
+
+		void FlushAll(IN BOOL sync);
+
+		RecordingFormat _format;
+
+		DWORD _flushInterval;
+
+		DWORD _syncInterval;
+
+		size_t _maxChunks;
+
+		SLIST_HEADER *_queue;
+
+		SLIST_HEADER *_free;
+
+		HANDLE _shutdownEvt;
+
+		HANDLE _thread;
+
+		volatile LONG _recordingCounter;
+
+		volatile LONG _allocated;
+
+		volatile LONG _dropped;
+
+		unsigned long _chunks;
+
+		unsigned long _writes;
+
+		unsigned long _syncs;
+
+		unsigned __int64 _bytes;
+
+	};
+
+	typedef 
+	shared_ptr<RecordingWriter> RecordingWriterPtr;
+
+}
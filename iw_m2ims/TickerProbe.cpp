@@ -0,0 +1,116 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "TickerProbe.h"
+
+namespace ivrworx
+{
+	struct TickerProbeData
+	{
+		TickerProbeData()
+		{
+			last.QuadPart = 0;
+			::QueryPerformanceFrequency(&freq);
+		};
+
+		TickerProbeStats stats;
+
+		LARGE_INTEGER last;
+
+		LARGE_INTEGER freq;
+	};
+
+	static void 
+	ticker_probe_init(MSFilter *f)
+	{
+		f->data = new TickerProbeData();
+	}
+
+	static void 
+	ticker_probe_uninit(MSFilter *f)
+	{
+		delete (TickerProbeData*)f->data;
+		f->data = NULL;
+	}
+
+	static void 
+	ticker_probe_process(MSFilter *f)
+	{
+		TickerProbeData *d = (TickerProbeData*)f->data;
+
+		LARGE_INTEGER now;
+		::QueryPerformanceCounter(&now);
+
+		ms_filter_lock(f);
+
+		if (d->last.QuadPart != 0 && d->freq.QuadPart != 0)
+		{
+			long gap_ms = (long)(((now.QuadPart - d->last.QuadPart) * 1000) / d->freq.QuadPart);
+			if (gap_ms > 2 * f->ticker->interval)
+			{
+				long late_ms = gap_ms - f->ticker->interval;
+
+				d->stats.late_ticks++;
+				if (late_ms > d->stats.max_late_ms)
+				{
+					d->stats.max_late_ms = late_ms;
+				}
+			}
+		}
+
+		d->last = now;
+		d->stats.ticks++;
+
+		ms_filter_unlock(f);
+	}
+
+	static int 
+	ticker_probe_get_stats(MSFilter *f, void *arg)
+	{
+		TickerProbeData *d = (TickerProbeData*)f->data;
+
+		ms_filter_lock(f);
+		*((TickerProbeStats*)arg) = d->stats;
+		ms_filter_unlock(f);
+
+		return 0;
+	}
+
+	static MSFilterMethod ticker_probe_methods[] = {
+		{ IW_TICKER_PROBE_GET_STATS, ticker_probe_get_stats },
+		{ 0,						 NULL					}
+	};
+
+	MSFilterDesc iw_ticker_probe_desc = {
+		MS_FILTER_PLUGIN_ID,
+		"IwTickerProbe",
+		"Measures ticker lateness",
+		MS_FILTER_OTHER,
+		NULL,
+		0,
+		0,
+		ticker_probe_init,
+		NULL,
+		ticker_probe_process,
+		NULL,
+		ticker_probe_uninit,
+		ticker_probe_methods
+	};
+
+}
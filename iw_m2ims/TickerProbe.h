@@ -0,0 +1,49 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#pragma once
+
+namespace ivrworx
+{
+	//
+	// Mediastreamer2 filter without pins, attached to a ticker to 
+	// measure it. It counts ticks and ticks that came later than 
+	// twice the ticker interval, that is audio of all graphs on the 
+	// ticker was late.
+	//
+	struct TickerProbeStats
+	{
+		TickerProbeStats():
+		ticks(0),
+		late_ticks(0),
+		max_late_ms(0){};
+
+		long ticks;
+
+		long late_ticks;
+
+		long max_late_ms;
+	};
+
+#define IW_TICKER_PROBE_GET_STATS MS_FILTER_METHOD(MS_FILTER_PLUGIN_ID, 0, TickerProbeStats)
+
+	extern MSFilterDesc iw_ticker_probe_desc;
+
+}
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#define IW_LOG_MODULE	LOG_MODULE_SIP
+
 #ifndef _WIN32_WINNT		// Allow use of features specific to Windows XP or later.                   
 #define _WIN32_WINNT 0x0502	// Change this to the appropriate value to target other versions of Windows.
 #endif						
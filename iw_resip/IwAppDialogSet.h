@@ -27,6 +27,9 @@ using namespace std;
 
 #define IWDIAGSET(x) ((ivrworx::IwAppDialogSet *)((x)->getAppDialogSet().get()))
 
+// stack handle of the dialog call, undefined until its context is created
+#define IWSTACKHANDLE(x) (IWDIAGSET(x)->dialog_ctx ? IWDIAGSET(x)->dialog_ctx->stack_handle : IW_UNDEFINED)
+
 namespace ivrworx
 {
 	class IwAppDialogSet :
@@ -23,6 +23,7 @@
 #include "UASDialogUsageManager.h"
 #include "FreeContent.h"
 #include "IwAppDialogSet.h"
+#include "CallLogFilter.h"
 
 
 
@@ -339,6 +340,7 @@ namespace ivrworx
 	ProcResipStack::onSessionExpired(IN InviteSessionHandle is)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 
 		LogWarn("ProcResipStack::onSessionExpired - rsh:" << is.getId());
 		FinalizeContext(IWDIAGSET(is)->dialog_ctx);
@@ -687,6 +689,11 @@ namespace ivrworx
 				if (InboundPending())
 				{
 					shutdown_flag = ProcessApplicationMessages();
+
+					// stamp of the message applies to its handling only, 
+					// the stack goes on processing other calls
+					CallDebug(FALSE);
+
 					if (shutdown_flag)
 					{
 						break;
@@ -726,6 +733,7 @@ namespace ivrworx
 		const Contents& body)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(h));
 
 		
 		SipDialogContextPtr ctx = IWDIAGSET(h)->dialog_ctx;
@@ -753,6 +761,7 @@ namespace ivrworx
 		const Contents& body)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(h));
 
 		// On answer is actually called when answer SDP is received
 		// it may be in first OK sent to UAC, or in ACK response to 
@@ -768,6 +777,7 @@ namespace ivrworx
 		const Contents& body)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(h));
 		InviteSessionHandler::onEarlyMedia(h,msg,body);
 	}
 
@@ -779,6 +789,7 @@ namespace ivrworx
 		const Contents& body)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(h));
 		InviteSessionHandler::onRemoteAnswerChanged(h,msg,body);
 	}
 
@@ -799,6 +810,7 @@ namespace ivrworx
 		IN const SipMessage& msg)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 		_dumUac->onConnected(is,msg);
 	}
 
@@ -845,6 +857,7 @@ namespace ivrworx
 	ProcResipStack::onFailure(IN ClientInviteSessionHandle is, IN const SipMessage& msg)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 		_dumUac->onFailure(is,msg);
 
 	}
@@ -857,6 +870,7 @@ namespace ivrworx
 	{
 
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 		_dumUas->onConnectedConfirmed(is,msg);
 	}
 
@@ -912,6 +926,7 @@ namespace ivrworx
 	{
 		
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 
 		// this logic is not UAS/UAC specific
 		LogDebug("ProcResipStack::onTerminated rsh:" << is.getId());
@@ -926,6 +941,7 @@ namespace ivrworx
 		IN const SipMessage& msg)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 		_dumUac->onInfoSuccess(is,msg);
 	}
 
@@ -945,6 +961,7 @@ namespace ivrworx
 		IN const SipMessage& msg)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 		_dumUac->onInfoFailure(is,msg);
 	}
 
@@ -954,6 +971,7 @@ namespace ivrworx
 		IN const SipMessage& msg)
 	{
 		FUNCTRACKER;
+		CallLogScope call_log_scope(IWSTACKHANDLE(is));
 
 		LogDebug("ProcResipStack::onInfo rsh:" << is.getId());
 
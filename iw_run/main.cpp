@@ -18,6 +18,7 @@
 */
 
 #include "stdafx.h"
+#include <signal.h>
 
 using namespace boost::assign;
 
@@ -215,6 +216,22 @@ exit:
 }
 
 using namespace ivrworx;
+
+static ConfigurationPtr g_conf;
+
+// there is no SIGHUP on Windows, Ctrl+Break reloads the configuration instead
+static void
+ReloadOnBreak(int sig)
+{
+	::signal(SIGBREAK, ReloadOnBreak);
+
+	ConfigurationPtr conf = g_conf;
+	if (conf)
+	{
+		conf->Reload();
+	}
+}
+
 int _tmain(int argc, _TCHAR* argv[])
 {
 	wstring conf_file;
@@ -264,6 +281,9 @@ int _tmain(int argc, _TCHAR* argv[])
 		InitLog(conf);
 		LogInfo(">>>>>> IVRWORX START <<<<<<");
 
+		g_conf = conf;
+		::signal(SIGBREAK, ReloadOnBreak);
+
 		Start_CPPCSP();
 
 		START_FORKING_REGION;
@@ -276,6 +296,8 @@ int _tmain(int argc, _TCHAR* argv[])
 
 		End_CPPCSP();
 
+		::signal(SIGBREAK, SIG_DFL);
+		g_conf.reset();
 
 		LogInfo(">>>>>> IVRWORX END <<<<<<");
 		ExitLog();
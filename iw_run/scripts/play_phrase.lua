@@ -139,47 +139,73 @@ local two_digits_sounds = {
 		----------------------------------------------------------------------- 99
 }
 
-local function play_zero(handle)
+--
+-- Phrase is collected first and then played as one
+-- playlist, so there are no gaps between the words
+--
+local function new_phrase()
+
+	local phrase = { files = {} }
+	
+	function phrase:add(file)
+		table.insert(self.files, file);
+		return 0;
+	end
+	
+	return phrase;
+	
+end
+
+local function play_phrase(handle, phrase)
+
+	if (#phrase.files == 0) then return 0; end;
+	
+	return handle:play{files=phrase.files, sync=true};
+	
+end
+
+local function add_zero(phrase)
 
-	return handle:play(numbers_path.."\\0.wav",true,false);
+	return phrase:add(numbers_path.."\\0.wav");
 	
 end
 
-local function play_minus(handle)
+local function add_minus(phrase)
 
-	return handle:play(numbers_path.."\\minus.wav",true,false);
+	return phrase:add(numbers_path.."\\minus.wav");
 	
 end
 
-local function play_and(handle)
+local function add_and(phrase)
 
 	-- not implemented currently
+	return 0;
 
 end
 
 
-local function play_hundreds(handle,i)
+local function add_hundreds(phrase,i)
 
 	
 	
 	if (i == 0 or i > 10) then return 0; end;
 	
 	
-	return handle:play(numbers_path.."\\"..hundreds_sounds[i*100],true,false);
+	return phrase:add(numbers_path.."\\"..hundreds_sounds[i*100]);
 	
 end
 
 
-local function play_two_digits(handle,i)
+local function add_two_digits(phrase,i)
 
 	
 	if (i == 0) then return 0; end;
 		
-	return handle:play(numbers_path.."\\"..two_digits_sounds[i],true,false);
+	return phrase:add(numbers_path.."\\"..two_digits_sounds[i]);
 
 end
 
-local function play_three_digits(handle, i, radix)
+local function add_three_digits(phrase, i, radix)
 
 	
 	
@@ -191,26 +217,26 @@ local function play_three_digits(handle, i, radix)
 	
 	if (hundreds ~= 0)
 	then
-		res = play_hundreds(handle,hundreds);
+		res = add_hundreds(phrase,hundreds);
 		if (res ~= 0) then return res; end
 		 
-		res = play_and(handle);
+		res = add_and(phrase);
 		if (res ~= 0) then return res; end
 	end
 
-	res = play_two_digits(handle,last_two_digits);
+	res = add_two_digits(phrase,last_two_digits);
 	if (res ~= 0) then return res; end
 	
 	if (radix ~= nil and radix ~= "" ) then 
 	
-		res = handle:play(numbers_path.."\\"..radix,true,false);
+		res = phrase:add(numbers_path.."\\"..radix);
 		if (res ~= 0) then return res; end
 		
 	end
 end
 
 
-local function play_number(handle,i) 
+local function add_number(phrase,i) 
 
 	--
 	-- Disabled Not working currently
@@ -218,12 +244,12 @@ local function play_number(handle,i)
 
 	local num_to_play  = math.abs(i);
 	
-	conf = assert(ivrworx.CONF);
+	local sounds_dir = ivrworx.config["sounds_dir"];
 	
-	if (conf:getstring("sounds_dir") == nil) then 
+	if (sounds_dir == nil) then 
 		numbers_path = "basic_words\\numbers";
 	else
-		numbers_path = conf:getstring("sounds_dir").."\\basic_words\\numbers";
+		numbers_path = sounds_dir.."\\basic_words\\numbers";
 	end
 	
 	logger = assert(ivrworx.LOGGER);
@@ -232,12 +258,12 @@ local function play_number(handle,i)
 
 	if  (i == 0) 
 	then
-	  return  play_zero(handle)
+	  return  add_zero(phrase)
 	end
 
 	if (i < 0)
 	then
-	  return play_minus(handle);
+	  return add_minus(phrase);
 	end
 
 
@@ -258,14 +284,14 @@ local function play_number(handle,i)
 	--
 	-- play milliards
 	--
-	res = play_three_digits(handle,tonumber(string.sub(num_str,1,1)),"Billion.wav");
+	res = add_three_digits(phrase,tonumber(string.sub(num_str,1,1)),"Billion.wav");
 	if (res ~= 0) then return res; end;
 	
 	
 	--
 	-- play millions
 	--
-	res = play_three_digits(handle,tonumber(string.sub(num_str,2,4)),"Million.wav");
+	res = add_three_digits(phrase,tonumber(string.sub(num_str,2,4)),"Million.wav");
 	if (res ~= 0) then return res; end;
 	
 			
@@ -277,12 +303,12 @@ local function play_number(handle,i)
 	thousands_num = tonumber(string.sub(num_str,5,7));
 	if (thousands_num >=1 and thousands_num <= 10) then 
 	
-		res = handle:play(numbers_path.."\\"..thousands_sounds[thousands_num],true,false);
+		res = phrase:add(numbers_path.."\\"..thousands_sounds[thousands_num]);
 		if (res ~= 0) then return res; end;
 		
 	else
 	
-	 	res = play_three_digits(handle,thousands_num,"Thousand.wav");
+	 	res = add_three_digits(phrase,thousands_num,"Thousand.wav");
 	 	if (res ~= 0) then return res; end;
 	 	
 	end
@@ -291,13 +317,25 @@ local function play_number(handle,i)
 	-- play remainder		
 	-- 
 	
-	return play_three_digits(handle,tonumber(string.sub(num_str,8,10)));
+	return add_three_digits(phrase,tonumber(string.sub(num_str,8,10)));
 		
 
 
 end
 
 
+function play_number(handle,i)
+
+	local phrase = new_phrase();
+	
+	local res = add_number(phrase,i);
+	if (res ~= nil and res ~= 0) then return res; end;
+	
+	return play_phrase(handle,phrase);
+
+end
+
+
 --
 -- Checks only first symbol for alphanumericity
 --
@@ -323,29 +361,32 @@ function spell_number(handle, str)
 
 	if (str == nil) then return -1; end;
 	
-	conf = assert(ivrworx.CONF);
+	local sounds_dir = ivrworx.config["sounds_dir"];
 	
-	if (conf:getstring("sounds_dir") == nil) then 
+	if (sounds_dir == nil) then 
 		letters_path = "basic_words\\alphabet";
 	else
-		letters_path = conf:getstring("sounds_dir").."\\basic_words\\alphabet";
+		letters_path = sounds_dir.."\\basic_words\\alphabet";
 	end
 	
 	local num_len = string.len(str);
+	local phrase = new_phrase();
 	
 	for i = 1,num_len,1 do
 	
 	    local symbol = string.sub(str,i,i);
 	    
 	    if (tonumber(symbol) ~= nil) then
-	    	play_number(handle,tonumber(symbol))
+	    	add_number(phrase,tonumber(symbol))
 	    else
 			if (isalphanumeric(symbol)) then
-				handle:play(letters_path.."\\"..symbol..".wav",true,false);
+				phrase:add(letters_path.."\\"..symbol..".wav");
 			end
 		end
 	    
 	end
+	
+	return play_phrase(handle,phrase);
 
 end
 
@@ -19,11 +19,27 @@
 
 #include "StdAfx.h"
 #include "ProcSqlite.h"
+#include "ProcSqliteWorker.h"
 #include "SqliteSession.h"
 #include "Logger.h"
 
+#pragma push_macro("SendMessage")
+#undef SendMessage
+
 namespace  ivrworx
 {
+	static BOOL
+	IsSelectStatement(const string &sql)
+	{
+		string::size_type pos = sql.find_first_not_of(" \t\r\n(");
+		if (pos == string::npos)
+		{
+			return FALSE;
+		}
+
+		return ::_strnicmp(sql.c_str() + pos, "SELECT", 6) == 0;
+	}
+
 	ProcSqlite::ProcSqlite(ConfigurationPtr conf, LpHandlePair pair)
 		:LightweightProcess(pair,"SQLite"),
 		_conf(conf)
@@ -38,6 +54,14 @@ namespace  ivrworx
 	void
 	ProcSqlite::real_run()
 	{
+		START_FORKING_REGION;
+
+		if (IW_FAILURE(StartWorkers(forking)))
+		{
+			LogCrit("Cannot start sqlite workers.");
+			ShutdownWorkers();
+			return;
+		}
 
 		I_AM_READY;
 
@@ -53,6 +77,12 @@ namespace  ivrworx
 			case API_TIMEOUT:
 				{
 					LogInfo("Sqlite keep alive.");
+					for (size_t i = 0; i < _workers.size(); ++i)
+					{
+						LogInfo("Sqlite worker:" << i 
+							<< ", sessions:" << _workers[i]->sessions 
+							<< ", pending:" << _workers[i]->pending);
+					}
 					continue;
 				}
 			case API_SUCCESS:
@@ -71,6 +101,7 @@ namespace  ivrworx
 			{
 			case MSG_PROC_SHUTDOWN_REQ:
 				{
+					ShutdownWorkers();
 					SendResponse(msg,new MsgShutdownAck());
 					shutdown_flag = TRUE;
 					continue;
@@ -100,6 +131,11 @@ namespace  ivrworx
 					UponSqlStepReq(msg);
 					break;
 				}
+			case MSG_SQL_FETCH_REQ:
+				{
+					UponSqlFetchReq(msg);
+					break;
+				}
 			default:
 				{
 					BOOL res = HandleOOBMessage(msg);
@@ -113,20 +149,115 @@ namespace  ivrworx
 			}
 		} //while
 
-		CloseAllConnections();
+		ShutdownWorkers();
+
+		END_FORKING_REGION
+	}
+
+	ApiErrorCode
+	ProcSqlite::StartWorkers(ScopedForking &forking)
+	{
+		FUNCTRACKER;
+
+		SYSTEM_INFO sys_info;
+		::GetSystemInfo(&sys_info);
+		int num_of_cpus = sys_info.dwNumberOfProcessors > 0 ? sys_info.dwNumberOfProcessors : 1;
+
+		// zero means worker per core
+		int num_of_workers = _conf->HasOption("sqlite/workers") ? 
+			_conf->GetInt("sqlite/workers") : 4;
+		if (num_of_workers <= 0)
+		{
+			num_of_workers = num_of_cpus;
+		}
+
+		int boot_time = _conf->GetInt("default_boot_time");
+
+		for (int i = 0; i < num_of_workers; ++i)
+		{
+			SqliteWorkerCtxPtr worker(new SqliteWorkerCtx());
+
+			DECLARE_NAMED_HANDLE_PAIR(worker_pair);
+			worker->pair = worker_pair;
+
+			FORK(new ProcSqliteWorker(_conf, worker_pair, i, &worker->pending));
+			if (IW_FAILURE(WaitTillReady(MilliSeconds(boot_time), worker_pair)))
+			{
+				LogCrit("Cannot start sqlite worker:" << i);
+				return API_FAILURE;
+			}
+
+			_workers.push_back(worker);
+		}
+
+		LogInfo("Started " << num_of_workers << " sqlite workers.");
+
+		return API_SUCCESS;
 	}
 
 	void
-	ProcSqlite::CloseAllConnections()
+	ProcSqlite::ShutdownWorkers()
 	{
 		FUNCTRACKER;
 
-		for (SqlSessionsMap::iterator iter = _sqlMap.begin(); 
-			iter != _sqlMap.end(); ++iter)
+		int boot_time = _conf->GetInt("default_boot_time");
+
+		for (SqliteWorkersVector::iterator iter = _workers.begin(); 
+			iter != _workers.end(); ++iter)
 		{
-			::sqlite3_close((*iter).second);
+			Shutdown(MilliSeconds(boot_time), (*iter)->pair);
 		}
 
+		_workers.clear();
+		_routes.clear();
+	}
+
+	int
+	ProcSqlite::LeastLoadedWorker()
+	{
+		int selected = 0;
+		for (size_t i = 1; i < _workers.size(); ++i)
+		{
+			if (_workers[i]->pending < _workers[selected]->pending ||
+				(_workers[i]->pending == _workers[selected]->pending && 
+				 _workers[i]->sessions < _workers[selected]->sessions))
+			{
+				selected = (int)i;
+			}
+		}
+
+		return selected;
+	}
+
+	int
+	ProcSqlite::WriterWorker(const string &connection_url)
+	{
+		// all writes to the same file are serialized by single worker
+		unsigned long hash = 5381;
+		for (string::const_iterator iter = connection_url.begin(); 
+			iter != connection_url.end(); ++iter)
+		{
+			hash = ((hash << 5) + hash) + (unsigned char)(*iter);
+		}
+
+		return (int)(hash % _workers.size());
+	}
+
+	void
+	ProcSqlite::ForwardToWorker(int worker, IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		SqliteWorkerCtxPtr ctx = _workers[worker];
+
+		// the source of the message is kept, so the
+		// worker responds directly to the requester
+		::InterlockedIncrement(&ctx->pending);
+		if (IW_FAILURE(SendMessage(ctx->pair.inbound, msg)))
+		{
+			::InterlockedDecrement(&ctx->pending);
+			LogWarn("Cannot forward msg:" << msg->message_id << " to sqlite worker:" << worker);
+		}
 	}
 
 	void
@@ -137,16 +268,19 @@ namespace  ivrworx
 		shared_ptr<MsgSqlCloseConnectionReq> close_conn_req
 			= shared_dynamic_cast<MsgSqlCloseConnectionReq>(msg);
 
-		SqlSessionsMap::iterator iter = 
-			_sqlMap.find(close_conn_req->session_id);
+		SqlRoutesMap::iterator iter = 
+			_routes.find(close_conn_req->session_id);
 
-		if (iter == _sqlMap.end())
+		if (iter == _routes.end())
 		{
 			return;
 		}
 
-		int res = sqlite3_close((*iter).second);
-		LogDebug("sqlite3_close sqls:" << close_conn_req->session_id << " res:" << res);
+		int worker = (*iter).second.worker;
+		_workers[worker]->sessions--;
+		_routes.erase(iter);
+
+		ForwardToWorker(worker, msg);
 
 	}
 
@@ -158,14 +292,13 @@ namespace  ivrworx
 		shared_ptr<MsgSqlFinalizeReq> finalize_req
 			= shared_dynamic_cast<MsgSqlFinalizeReq>(msg);
 
-		SqlSessionsMap::iterator iter = _sqlMap.find(finalize_req->session_id);
-		if ( iter == _sqlMap.end())
+		SqlRoutesMap::iterator iter = _routes.find(finalize_req->session_id);
+		if ( iter == _routes.end())
 		{
 			return;
 		}
 
-		int rc = sqlite3_finalize(finalize_req->pStmt);
-		LogDebug("sqlite3_finalize sqls:" << finalize_req->session_id << " res:" << rc);
+		ForwardToWorker((*iter).second.worker, msg);
 
 	}
 
@@ -177,33 +310,28 @@ namespace  ivrworx
 		shared_ptr<MsgSqlExecReq> exec_req
 			= shared_dynamic_cast<MsgSqlExecReq>(msg);
 
-		SqlSessionsMap::iterator iter = _sqlMap.find(exec_req->session_id);
-		if ( iter == _sqlMap.end())
+		SqlRoutesMap::iterator iter = _routes.find(exec_req->session_id);
+		if ( iter == _routes.end())
 		{
 			MsgSqlExecNack *nack = new MsgSqlExecNack();
 			SendResponse(msg, nack);
 			return;
 		}
 
-		sqlite3 *db = (*iter).second;
+		const string &connection_url = (*iter).second.connection_url;
+		exec_req->connection_url = connection_url;
 
-		char *errmsg;
-		int rc = sqlite3_exec(
-			db,
-			exec_req->sql_statement.c_str(), 
-			NULL,
-			NULL,
-			&errmsg);
-
-		LogDebug("sqlite3_exec sqls:" << exec_req->session_id << " stmnt:" << exec_req->sql_statement <<" res:" << rc);
-
-		MsgSqlOpenConnectionAck *ack = new MsgSqlOpenConnectionAck();
-		ack->db = db;
-		ack->rc = rc;
-		ack->rc = rc;
-
-		SendResponse(msg, ack);
+		// the session worker is the writer of the file, only reads 
+		// outside of a transaction may run on other connection
+		int worker = (*iter).second.worker;
+		if (exec_req->group_commit == FALSE && 
+			IsSelectStatement(exec_req->sql_statement) && 
+			(*iter).second.state->transaction_open == FALSE)
+		{
+			worker = LeastLoadedWorker();
+		}
 
+		ForwardToWorker(worker, msg);
 
 	}
 
@@ -215,22 +343,36 @@ namespace  ivrworx
 		shared_ptr<MsgSqlStepReq> step_req
 			= shared_dynamic_cast<MsgSqlStepReq>(msg);
 
-		if (step_req->session_id < 0 ||
-			_sqlMap.find(step_req->session_id) == _sqlMap.end())
+		SqlRoutesMap::iterator iter = _routes.find(step_req->session_id);
+		if (iter == _routes.end())
 		{
 			MsgSqlStepNack *nack = new MsgSqlStepNack();
 			SendResponse(msg, nack);
 			return;
 		}
 
-		int rc = sqlite3_step(step_req->pStmt);
-		LogDebug("sqlite3_step sqls:" << step_req->session_id << " res:" << rc);
+		// prepared statements live on the connection of the session worker
+		ForwardToWorker((*iter).second.worker, msg);
+
+	}
+
+	void
+	ProcSqlite::UponSqlFetchReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
 
-		MsgSqlStepAck *ack = new MsgSqlStepAck();
-		ack->rc = rc;
-		SendResponse(msg, ack);
+		shared_ptr<MsgSqlFetchReq> fetch_req
+			= shared_dynamic_cast<MsgSqlFetchReq>(msg);
 
+		SqlRoutesMap::iterator iter = _routes.find(fetch_req->session_id);
+		if (iter == _routes.end())
+		{
+			MsgSqlFetchNack *nack = new MsgSqlFetchNack();
+			SendResponse(msg, nack);
+			return;
+		}
 
+		ForwardToWorker((*iter).second.worker, msg);
 
 	}
 
@@ -240,40 +382,34 @@ namespace  ivrworx
 	{
 		FUNCTRACKER;
 
-		sqlite3 *db = NULL;
-
 		shared_ptr<MsgSqlOpenConnectionReq> open_conn_req
 			= shared_dynamic_cast<MsgSqlOpenConnectionReq>(msg);
 
 		if (open_conn_req->session_id < 0 ||
-			_sqlMap.find(open_conn_req->session_id) != _sqlMap.end())
+			_routes.find(open_conn_req->session_id) != _routes.end())
 		{
 			MsgSqlOpenConnectionNack *nack = new MsgSqlOpenConnectionNack();
 			SendResponse(msg, nack);
 			return;
 		}
 
-		int rc = sqlite3_open(
-			open_conn_req->connection_url.c_str(), 
-			&db);
+		SqlSessionRoute route;
+		route.connection_url = open_conn_req->connection_url;
+		// all sessions of the file live on its writer worker
+		route.worker = WriterWorker(route.connection_url);
+		route.state.reset(new SqlSessionState());
 
-		LogDebug("sqlite3_open db:" << open_conn_req->connection_url.c_str() << " res:" << rc);
+		open_conn_req->state = route.state;
 
-		if (db != NULL)
-		{
-			_sqlMap[open_conn_req->session_id] = db;
-		}
+		_routes[open_conn_req->session_id] = route;
+		_workers[route.worker]->sessions++;
 
-			
-		MsgSqlOpenConnectionAck *ack = new MsgSqlOpenConnectionAck();
-		ack->db = db;
-		ack->rc = rc;
-
-		SendResponse(msg, ack);
+		LogDebug("open sqls:" << open_conn_req->session_id << " db:" << route.connection_url << " worker:" << route.worker);
 
+		ForwardToWorker(route.worker, msg);
 
 	}
 
 }
 
-
+#pragma pop_macro("SendMessage")
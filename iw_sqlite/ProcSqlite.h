@@ -20,12 +20,48 @@
 #pragma once
 #include "LightweightProcess.h"
 #include "Configuration.h"
+#include "SqliteSession.h"
 
 namespace ivrworx
 {
+	struct SqliteWorkerCtx
+	{
+		SqliteWorkerCtx():pending(0),sessions(0){};
+
+		LpHandlePair pair;
+
+		// requests forwarded and not yet served by the worker
+		volatile LONG pending;
+
+		int sessions;
+	};
+
+	typedef
+	shared_ptr<SqliteWorkerCtx> SqliteWorkerCtxPtr;
+
+	typedef
+	vector<SqliteWorkerCtxPtr> SqliteWorkersVector;
+
+	struct SqlSessionRoute
+	{
+		string connection_url;
+
+		// worker owning connection of session prepared statements
+		int worker;
+
+		SqlSessionStatePtr state;
+	};
+
+	typedef 
+	map<int,SqlSessionRoute> SqlRoutesMap;
 	
-	typedef map<int,sqlite3*> SqlSessionsMap;
-	
+	/**
+
+	Front process of sqlite service. It owns no connections, it only 
+	routes the requests to the pool of ProcSqliteWorker processes which
+	answer the requester directly.
+
+	**/
 	class ProcSqlite :
 		public LightweightProcess
 	{
@@ -37,6 +73,10 @@ namespace ivrworx
 
 	private:
 
+		ApiErrorCode StartWorkers(ScopedForking &forking);
+
+		void ShutdownWorkers();
+
 		void UponSqlOpenConnectionReq(IwMessagePtr msg);
 
 		void UponSqlCloseConnectionReq(IwMessagePtr msg);
@@ -47,11 +87,19 @@ namespace ivrworx
 
 		void UponSqlFinalizeReq(IwMessagePtr msg);
 
-		void CloseAllConnections();
+		void UponSqlFetchReq(IwMessagePtr msg);
+
+		void ForwardToWorker(int worker, IwMessagePtr msg);
+
+		int LeastLoadedWorker();
+
+		int WriterWorker(const string &connection_url);
 
 		ConfigurationPtr _conf;
 
-		SqlSessionsMap _sqlMap;
+		SqliteWorkersVector _workers;
+
+		SqlRoutesMap _routes;
 
 	};
 
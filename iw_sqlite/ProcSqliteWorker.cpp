@@ -0,0 +1,914 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "ProcSqliteWorker.h"
+#include "SqliteSession.h"
+#include "Logger.h"
+
+#define IW_SQLITE_RETRY_INTERVAL 5
+
+namespace  ivrworx
+{
+	static int
+	RequestSessionId(IwMessagePtr msg)
+	{
+		MsgSqlMixin *mixin = dynamic_cast<MsgSqlMixin*>(msg.get());
+		return mixin == NULL ? IW_UNDEFINED : mixin->session_id;
+	}
+
+	static void
+	ReadRow(sqlite3_stmt *stmt, SqlRow &row)
+	{
+		int columns = ::sqlite3_column_count(stmt);
+		row.resize(columns);
+
+		for (int i = 0; i < columns; ++i)
+		{
+			SqlValue &value = row[i];
+			value.type = ::sqlite3_column_type(stmt, i);
+
+			switch (value.type)
+			{
+			case SQLITE_INTEGER:
+				{
+					value.int_value = ::sqlite3_column_int64(stmt, i);
+					break;
+				}
+			case SQLITE_FLOAT:
+				{
+					value.float_value = ::sqlite3_column_double(stmt, i);
+					break;
+				}
+			case SQLITE_TEXT:
+				{
+					const char *text = (const char *)::sqlite3_column_text(stmt, i);
+					value.text_value.assign(text, ::sqlite3_column_bytes(stmt, i));
+					break;
+				}
+			case SQLITE_BLOB:
+				{
+					const char *blob = (const char *)::sqlite3_column_blob(stmt, i);
+					int size = ::sqlite3_column_bytes(stmt, i);
+					if (blob != NULL)
+					{
+						value.text_value.assign(blob, size);
+					}
+					break;
+				}
+			default:
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	ProcSqliteWorker::ProcSqliteWorker(
+		IN ConfigurationPtr conf, 
+		IN LpHandlePair pair, 
+		IN int index,
+		IN volatile LONG *pending)
+		:LightweightProcess(pair,"SQLite Worker"),
+		_conf(conf),
+		_index(index),
+		_pending(pending),
+		_statementCacheSize(64),
+		_busyTimeout(5000),
+		_fetchRows(100),
+		_groupCommitInterval(10),
+		_groupCommitRows(100),
+		_commits(0),
+		_committedRows(0),
+		_retrying(NULL)
+	{
+		if (_conf->HasOption("sqlite/statement_cache_size"))
+		{
+			_statementCacheSize = _conf->GetInt("sqlite/statement_cache_size");
+		}
+
+		if (_conf->HasOption("sqlite/busy_timeout"))
+		{
+			_busyTimeout = _conf->GetInt("sqlite/busy_timeout");
+		}
+
+		if (_conf->HasOption("sqlite/fetch_rows"))
+		{
+			_fetchRows = _conf->GetInt("sqlite/fetch_rows");
+		}
+
+		if (_conf->HasOption("sqlite/group_commit_interval"))
+		{
+			_groupCommitInterval = _conf->GetInt("sqlite/group_commit_interval");
+		}
+
+		if (_conf->HasOption("sqlite/group_commit_rows"))
+		{
+			_groupCommitRows = _conf->GetInt("sqlite/group_commit_rows");
+		}
+	}
+
+	ProcSqliteWorker::~ProcSqliteWorker(void)
+	{
+	}
+
+	void
+	ProcSqliteWorker::real_run()
+	{
+
+		I_AM_READY;
+
+		BOOL shutdown_flag = FALSE;
+		while(shutdown_flag == FALSE)
+		{
+
+			ApiErrorCode res = API_SUCCESS;
+			long timeout = NextCommitTimeout();
+			if (!_deferred.empty() && 
+				(timeout == 0 || timeout > IW_SQLITE_RETRY_INTERVAL))
+			{
+				timeout = IW_SQLITE_RETRY_INTERVAL;
+			}
+
+			IwMessagePtr msg = _inbound->Wait( 
+				timeout > 0 ? MilliSeconds(timeout) : Seconds(60), res);
+
+			switch (res)
+			{
+			case API_TIMEOUT:
+				{
+					if (timeout > 0)
+					{
+						CommitBatches(TRUE);
+						RetryDeferred();
+						continue;
+					}
+
+					for (SqlConnectionsMap::iterator iter = _connections.begin(); 
+						iter != _connections.end(); ++iter)
+					{
+						LogInfo("Sqlite worker:" << _index << " db:" << iter->first);
+						iter->second->statements->LogStats();
+					}
+					LogInfo("Sqlite worker:" << _index << " group commits:" << _commits << " rows:" << _committedRows);
+					continue;
+				}
+			case API_SUCCESS:
+				{
+					break;
+				}
+			default:
+				{
+					LogCrit("Error wating for messages");
+					shutdown_flag = TRUE;
+					continue;;
+				}
+			}
+
+			// anything but a group commit write sees the batched rows committed
+			if (msg->message_id != MSG_SQL_EXEC_REQ ||
+				shared_dynamic_cast<MsgSqlExecReq>(msg)->group_commit == FALSE)
+			{
+				CommitBatches(FALSE);
+			}
+
+			switch (msg->message_id)
+			{
+			case MSG_PROC_SHUTDOWN_REQ:
+				{
+					SendResponse(msg,new MsgShutdownAck());
+					shutdown_flag = TRUE;
+					continue;
+				}
+			case MSG_SQL_OPEN_CONNECTION_REQ:
+			case MSG_SQL_CLOSE_CONNECTION_REQ:
+			case MSG_SQL_FINALIZE_REQ:
+			case MSG_SQL_EXEC_REQ:
+			case MSG_SQL_STEP_REQ:
+			case MSG_SQL_FETCH_REQ:
+				{
+					int session_id = RequestSessionId(msg);
+					if (IsDeferred(session_id))
+					{
+						// keeps the order of the session requests
+						DeferredRequest deferred;
+						deferred.request = msg;
+						deferred.session_id = session_id;
+						deferred.since = ::GetTickCount();
+						_deferred.push_back(deferred);
+					}
+					else
+					{
+						ServeRequest(msg);
+					}
+
+					::InterlockedDecrement(_pending);
+					RetryDeferred();
+					break;
+				}
+			default:
+				{
+					BOOL res = HandleOOBMessage(msg);
+					if (res == FALSE)
+					{
+						LogCrit("Unknown msg:" << msg->message_id);
+						shutdown_flag = TRUE;
+						continue;;
+					}
+				}
+			}
+		} //while
+
+		CommitBatches(FALSE);
+		CloseAllConnections();
+	}
+
+	void
+	ProcSqliteWorker::ServeRequest(IwMessagePtr msg)
+	{
+		switch (msg->message_id)
+		{
+		case MSG_SQL_OPEN_CONNECTION_REQ:
+			{
+				UponSqlOpenConnectionReq(msg);
+				break;
+			}
+		case MSG_SQL_CLOSE_CONNECTION_REQ:
+			{
+				UponSqlCloseConnectionReq(msg);
+				break;
+			}
+		case MSG_SQL_FINALIZE_REQ:
+			{
+				UponSqlFinalizeReq(msg);
+				break;
+			}
+		case MSG_SQL_EXEC_REQ:
+			{
+				UponSqlExecReq(msg);
+				break;
+			}
+		case MSG_SQL_STEP_REQ:
+			{
+				UponSqlStepReq(msg);
+				break;
+			}
+		case MSG_SQL_FETCH_REQ:
+			{
+				UponSqlFetchReq(msg);
+				break;
+			}
+		default:
+			{
+				LogWarn("Unexpected sql msg:" << msg->message_id);
+			}
+		}
+	}
+
+	BOOL
+	ProcSqliteWorker::IsDeferred(IN int session_id)
+	{
+		for (DeferredRequestsList::iterator iter = _deferred.begin(); 
+			iter != _deferred.end(); ++iter)
+		{
+			if (iter->session_id == session_id)
+			{
+				return TRUE;
+			}
+		}
+
+		return FALSE;
+	}
+
+	BOOL
+	ProcSqliteWorker::DeferBusy(IN IwMessagePtr msg)
+	{
+		DWORD now = ::GetTickCount();
+		DWORD since = (_retrying != NULL) ? _retrying->since : now;
+
+		if ((long)(now - since) >= _busyTimeout)
+		{
+			// waited long enough, the requester gets SQLITE_BUSY
+			return FALSE;
+		}
+
+		DeferredRequest deferred;
+		deferred.request = msg;
+		deferred.session_id = RequestSessionId(msg);
+		deferred.since = since;
+		_deferred.push_back(deferred);
+
+		return TRUE;
+	}
+
+	void
+	ProcSqliteWorker::RetryDeferred()
+	{
+		if (_deferred.empty())
+		{
+			return;
+		}
+
+		DeferredRequestsList retries;
+		retries.swap(_deferred);
+
+		for (DeferredRequestsList::iterator iter = retries.begin(); 
+			iter != retries.end(); ++iter)
+		{
+			if (IsDeferred(iter->session_id))
+			{
+				// an earlier request of the session is still waiting
+				_deferred.push_back(*iter);
+				continue;
+			}
+
+			_retrying = &(*iter);
+			ServeRequest(iter->request);
+			_retrying = NULL;
+		}
+	}
+
+	SqliteConnectionPtr
+	ProcSqliteWorker::OpenConnection(IN const string &connection_url, OUT int &rc)
+	{
+		FUNCTRACKER;
+
+		sqlite3 *db = NULL;
+		rc = ::sqlite3_open(connection_url.c_str(), &db);
+
+		LogDebug("sqlite3_open worker:" << _index << " db:" << connection_url << " res:" << rc);
+
+		if (rc != SQLITE_OK)
+		{
+			::sqlite3_close(db);
+			return SqliteConnectionPtr();
+		}
+
+		// no busy handler, locked requests are retried by DeferBusy
+		SqliteConnectionPtr conn(new SqliteConnection());
+		conn->db = db;
+		conn->statements.reset(new SqliteStatementCache(db, _statementCacheSize));
+
+		ApplyPragmas(conn, connection_url);
+
+		return conn;
+	}
+
+	SqliteConnectionPtr
+	ProcSqliteWorker::GetConnection(IN const string &connection_url, OUT int &rc)
+	{
+		FUNCTRACKER;
+
+		rc = SQLITE_OK;
+
+		SqlConnectionsMap::iterator iter = _connections.find(connection_url);
+		if (iter != _connections.end())
+		{
+			return iter->second;
+		}
+
+		SqliteConnectionPtr conn = OpenConnection(connection_url, rc);
+		if (conn)
+		{
+			_connections[connection_url] = conn;
+		}
+
+		return conn;
+	}
+
+	void
+	ProcSqliteWorker::CloseConnection(IN SqliteConnectionPtr conn)
+	{
+		FUNCTRACKER;
+
+		conn->statements->Clear();
+
+		// statements not finalized by the script would keep the file open
+		sqlite3_stmt *stmt = NULL;
+		while ((stmt = ::sqlite3_next_stmt(conn->db, NULL)) != NULL)
+		{
+			LogDebug("sqlite3_finalize worker:" << _index << " left open stmt:" << stmt);
+			::sqlite3_finalize(stmt);
+		}
+
+		int rc = ::sqlite3_close(conn->db);
+		if (rc != SQLITE_OK)
+		{
+			LogWarn("sqlite3_close worker:" << _index << " res:" << rc);
+		}
+	}
+
+	void
+	ProcSqliteWorker::UpdateSessionState(IN SqliteConnectionPtr conn)
+	{
+		if (conn->session_state)
+		{
+			conn->session_state->transaction_open = 
+				::sqlite3_get_autocommit(conn->db) ? FALSE : TRUE;
+		}
+	}
+
+	void
+	ProcSqliteWorker::ApplyPragmas(IN SqliteConnectionPtr conn, IN const string &connection_url)
+	{
+		FUNCTRACKER;
+
+		if (_conf->HasOption("sqlite/journal_mode"))
+		{
+			string pragma = "PRAGMA journal_mode=" + _conf->GetString("sqlite/journal_mode");
+			int rc = ::sqlite3_exec(conn->db, pragma.c_str(), NULL, NULL, NULL);
+			LogDebug("worker:" << _index << " db:" << connection_url << " " << pragma << " res:" << rc);
+		}
+
+		if (_conf->HasOption("sqlite/synchronous"))
+		{
+			string pragma = "PRAGMA synchronous=" + _conf->GetString("sqlite/synchronous");
+			int rc = ::sqlite3_exec(conn->db, pragma.c_str(), NULL, NULL, NULL);
+			LogDebug("worker:" << _index << " db:" << connection_url << " " << pragma << " res:" << rc);
+		}
+
+	}
+
+	int
+	ProcSqliteWorker::ExecStatement(IN SqliteConnectionPtr conn, IN const string &sql)
+	{
+		BOOL cacheable = FALSE;
+		sqlite3_stmt *stmt = NULL;
+		int rc = conn->statements->Acquire(sql, &stmt, cacheable);
+
+		if (rc == SQLITE_OK && stmt == NULL)
+		{
+			rc = ::sqlite3_exec(
+				conn->db,
+				sql.c_str(), 
+				NULL,
+				NULL,
+				NULL);
+		} 
+		else if (rc == SQLITE_OK)
+		{
+			while ((rc = ::sqlite3_step(stmt)) == SQLITE_ROW);
+			rc = (rc == SQLITE_DONE) ? SQLITE_OK : rc;
+
+			conn->statements->Release(stmt, cacheable);
+		}
+
+		return rc;
+	}
+
+	void
+	ProcSqliteWorker::UponSqlGroupExecReq(IN shared_ptr<MsgSqlExecReq> exec_req, IN SqliteConnectionPtr conn)
+	{
+		FUNCTRACKER;
+
+		int rc = SQLITE_OK;
+		if (conn->batch.empty())
+		{
+			rc = ExecStatement(conn, "BEGIN");
+			if (rc != SQLITE_OK)
+			{
+				LogWarn("Cannot open group commit transaction worker:" << _index << " res:" << rc);
+
+				MsgSqlExecAck *ack = new MsgSqlExecAck();
+				ack->db = conn->db;
+				ack->rc = rc;
+				SendResponse(exec_req, ack);
+				return;
+			}
+			conn->batch_start = ::GetTickCount();
+		}
+
+		// every row runs in its own savepoint so a failing statement 
+		// does not roll back the rows already batched with it
+		ExecStatement(conn, "SAVEPOINT iw_row");
+
+		PendingWrite write;
+		write.request = exec_req;
+		write.rc = ExecStatement(conn, exec_req->sql_statement);
+		write.changes = ::sqlite3_changes(conn->db);
+		write.last_insert_rowid = ::sqlite3_last_insert_rowid(conn->db);
+
+		if (write.rc != SQLITE_OK)
+		{
+			ExecStatement(conn, "ROLLBACK TO iw_row");
+		}
+		ExecStatement(conn, "RELEASE iw_row");
+
+		if (write.rc == SQLITE_BUSY && DeferBusy(exec_req))
+		{
+			if (conn->batch.empty())
+			{
+				ExecStatement(conn, "COMMIT");
+			}
+			return;
+		}
+
+		LogDebug("group exec sqls:" << exec_req->session_id << " worker:" << _index << " stmnt:" << exec_req->sql_statement <<" res:" << write.rc);
+
+		conn->batch.push_back(write);
+
+		if ((int)conn->batch.size() >= _groupCommitRows)
+		{
+			CommitBatch(conn);
+		}
+
+	}
+
+	void
+	ProcSqliteWorker::CommitBatch(IN SqliteConnectionPtr conn)
+	{
+		FUNCTRACKER;
+
+		if (conn->batch.empty())
+		{
+			return;
+		}
+
+		int commit_rc = ExecStatement(conn, "COMMIT");
+		if (commit_rc == SQLITE_BUSY && 
+			(long)(::GetTickCount() - conn->batch_start) < _groupCommitInterval + _busyTimeout)
+		{
+			// a reader of other session holds the file, retried on the next pass
+			return;
+		}
+
+		if (commit_rc != SQLITE_OK)
+		{
+			LogWarn("Group commit failed worker:" << _index << " rows:" << conn->batch.size() << " res:" << commit_rc);
+			ExecStatement(conn, "ROLLBACK");
+		}
+
+		LogDebug("group commit worker:" << _index << " rows:" << conn->batch.size() << " res:" << commit_rc);
+
+		// writers are acknowledged only once their rows are durable
+		for (PendingWritesList::iterator iter = conn->batch.begin(); 
+			iter != conn->batch.end(); ++iter)
+		{
+			MsgSqlExecAck *ack = new MsgSqlExecAck();
+			ack->db = conn->db;
+			ack->rc = (commit_rc == SQLITE_OK) ? iter->rc : commit_rc;
+			ack->changes = iter->changes;
+			ack->last_insert_rowid = iter->last_insert_rowid;
+
+			SendResponse(iter->request, ack);
+		}
+
+		_commits++;
+		_committedRows += (long)conn->batch.size();
+
+		conn->batch.clear();
+
+	}
+
+	void
+	ProcSqliteWorker::CommitBatches(IN BOOL due_only)
+	{
+		DWORD now = ::GetTickCount();
+
+		for (SqlConnectionsMap::iterator iter = _connections.begin(); 
+			iter != _connections.end(); ++iter)
+		{
+			SqliteConnectionPtr conn = iter->second;
+			if (conn->batch.empty())
+			{
+				continue;
+			}
+
+			if (due_only == FALSE || 
+				(long)(now - conn->batch_start) >= _groupCommitInterval)
+			{
+				CommitBatch(conn);
+			}
+		}
+	}
+
+	long
+	ProcSqliteWorker::NextCommitTimeout()
+	{
+		DWORD now = ::GetTickCount();
+
+		long timeout = 0;
+		for (SqlConnectionsMap::iterator iter = _connections.begin(); 
+			iter != _connections.end(); ++iter)
+		{
+			SqliteConnectionPtr conn = iter->second;
+			if (conn->batch.empty())
+			{
+				continue;
+			}
+
+			long remaining = _groupCommitInterval - (long)(now - conn->batch_start);
+			remaining = remaining < 1 ? 1 : remaining;
+
+			timeout = (timeout == 0 || remaining < timeout) ? remaining : timeout;
+		}
+
+		return timeout;
+	}
+
+	void
+	ProcSqliteWorker::CloseAllConnections()
+	{
+		FUNCTRACKER;
+
+		for (SqlSessionsMap::iterator iter = _sessions.begin(); 
+			iter != _sessions.end(); ++iter)
+		{
+			CloseConnection((*iter).second);
+		}
+
+		_sessions.clear();
+
+		for (SqlConnectionsMap::iterator iter = _connections.begin(); 
+			iter != _connections.end(); ++iter)
+		{
+			CloseConnection((*iter).second);
+		}
+
+		_connections.clear();
+
+	}
+
+	void
+	ProcSqliteWorker::UponSqlCloseConnectionReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlCloseConnectionReq> close_conn_req
+			= shared_dynamic_cast<MsgSqlCloseConnectionReq>(msg);
+
+		SqlSessionsMap::iterator iter = _sessions.find(close_conn_req->session_id);
+		if (iter == _sessions.end())
+		{
+			return;
+		}
+
+		CloseConnection(iter->second);
+		_sessions.erase(iter);
+
+		LogDebug("close sqls:" << close_conn_req->session_id << " worker:" << _index);
+
+	}
+
+	void
+	ProcSqliteWorker::UponSqlFinalizeReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlFinalizeReq> finalize_req
+			= shared_dynamic_cast<MsgSqlFinalizeReq>(msg);
+
+		SqlSessionsMap::iterator iter = _sessions.find(finalize_req->session_id);
+		if ( iter == _sessions.end())
+		{
+			return;
+		}
+
+		if (iter->second->stream_stmt == finalize_req->pStmt)
+		{
+			iter->second->stream_stmt = NULL;
+		}
+
+		int rc = ::sqlite3_finalize(finalize_req->pStmt);
+		LogDebug("sqlite3_finalize sqls:" << finalize_req->session_id << " res:" << rc);
+
+	}
+
+	void
+	ProcSqliteWorker::UponSqlExecReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlExecReq> exec_req
+			= shared_dynamic_cast<MsgSqlExecReq>(msg);
+
+		// group commit writes and reads of sessions opened on other 
+		// workers run on the connection shared by the worker
+		int rc = SQLITE_OK;
+		SqliteConnectionPtr conn;
+
+		SqlSessionsMap::iterator iter = _sessions.find(exec_req->session_id);
+		if (exec_req->group_commit == FALSE && iter != _sessions.end())
+		{
+			conn = iter->second;
+		}
+		else
+		{
+			conn = GetConnection(exec_req->connection_url, rc);
+		}
+
+		if (!conn)
+		{
+			MsgSqlExecNack *nack = new MsgSqlExecNack();
+			nack->rc = rc;
+			SendResponse(msg, nack);
+			return;
+		}
+
+		if (exec_req->group_commit == TRUE)
+		{
+			UponSqlGroupExecReq(exec_req, conn);
+			return;
+		}
+
+		sqlite3 *db = conn->db;
+
+		rc = ExecStatement(conn, exec_req->sql_statement);
+		if (rc == SQLITE_BUSY && DeferBusy(msg))
+		{
+			return;
+		}
+
+		LogDebug("exec sqls:" << exec_req->session_id << " worker:" << _index << " stmnt:" << exec_req->sql_statement <<" res:" << rc);
+
+		MsgSqlExecAck *ack = new MsgSqlExecAck();
+		ack->db = db;
+		ack->rc = rc;
+		ack->changes = ::sqlite3_changes(db);
+		ack->last_insert_rowid = ::sqlite3_last_insert_rowid(db);
+
+		UpdateSessionState(conn);
+		SendResponse(msg, ack);
+
+	}
+
+	void
+	ProcSqliteWorker::UponSqlStepReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlStepReq> step_req
+			= shared_dynamic_cast<MsgSqlStepReq>(msg);
+
+		SqlSessionsMap::iterator iter = _sessions.find(step_req->session_id);
+		if (iter == _sessions.end())
+		{
+			MsgSqlStepNack *nack = new MsgSqlStepNack();
+			SendResponse(msg, nack);
+			return;
+		}
+
+		sqlite3 *db = iter->second->db;
+
+		int rc = ::sqlite3_step(step_req->pStmt);
+		if (rc == SQLITE_BUSY && DeferBusy(msg))
+		{
+			return;
+		}
+
+		LogDebug("sqlite3_step sqls:" << step_req->session_id << " res:" << rc);
+
+		MsgSqlStepAck *ack = new MsgSqlStepAck();
+		ack->rc = rc;
+		ack->changes = ::sqlite3_changes(db);
+		ack->last_insert_rowid = ::sqlite3_last_insert_rowid(db);
+
+		UpdateSessionState(iter->second);
+		SendResponse(msg, ack);
+
+	}
+
+
+	void
+	ProcSqliteWorker::UponSqlFetchReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlFetchReq> fetch_req
+			= shared_dynamic_cast<MsgSqlFetchReq>(msg);
+
+		SqlSessionsMap::iterator iter = _sessions.find(fetch_req->session_id);
+		if (iter == _sessions.end())
+		{
+			MsgSqlFetchNack *nack = new MsgSqlFetchNack();
+			SendResponse(msg, nack);
+			return;
+		}
+
+		SqliteConnectionPtr conn = iter->second;
+		if (fetch_req->stream == TRUE)
+		{
+			if (fetch_req->resume == FALSE)
+			{
+				conn->stream_stmt = fetch_req->pStmt;
+			}
+			else if (conn->stream_stmt != fetch_req->pStmt)
+			{
+				// stream is over, stepping again would restart the statement
+				return;
+			}
+		}
+
+		int max_rows = fetch_req->max_rows > 0 ? fetch_req->max_rows : _fetchRows;
+
+		// requester asks for more once it consumes a response
+		int credit = (fetch_req->stream == TRUE && fetch_req->credit > 0) ? fetch_req->credit : 1;
+
+		vector<string> columns;
+		int count = ::sqlite3_column_count(fetch_req->pStmt);
+		for (int i = 0; i < count; ++i)
+		{
+			const char *name = ::sqlite3_column_name(fetch_req->pStmt, i);
+			columns.push_back(name == NULL ? "" : name);
+		}
+
+		BOOL done = FALSE;
+		for (int sent = 0; done == FALSE && sent < credit; ++sent)
+		{
+			MsgSqlFetchAck *ack = new MsgSqlFetchAck();
+			ack->columns = columns;
+
+			int rc = SQLITE_ROW;
+			for (int count = 0; count < max_rows; ++count)
+			{
+				rc = ::sqlite3_step(fetch_req->pStmt);
+				if (rc != SQLITE_ROW)
+				{
+					break;
+				}
+
+				ack->rows.push_back(SqlRow());
+				ReadRow(fetch_req->pStmt, ack->rows.back());
+			}
+
+			if (rc == SQLITE_BUSY && sent == 0 && ack->rows.empty() && DeferBusy(msg))
+			{
+				delete ack;
+				return;
+			}
+
+			done = (rc != SQLITE_ROW);
+
+			ack->rc = rc;
+			ack->done = done;
+
+			LogDebug("fetch sqls:" << fetch_req->session_id << " rows:" << ack->rows.size() << " res:" << rc);
+
+			UpdateSessionState(conn);
+
+			if (IW_FAILURE(SendResponse(msg, ack)))
+			{
+				// requester has gone, stop streaming
+				::sqlite3_reset(fetch_req->pStmt);
+				done = TRUE;
+			}
+		}
+
+		if (done == TRUE && conn->stream_stmt == fetch_req->pStmt)
+		{
+			conn->stream_stmt = NULL;
+		}
+
+	}
+
+	void
+	ProcSqliteWorker::UponSqlOpenConnectionReq(IwMessagePtr msg)
+	{
+		FUNCTRACKER;
+
+		shared_ptr<MsgSqlOpenConnectionReq> open_conn_req
+			= shared_dynamic_cast<MsgSqlOpenConnectionReq>(msg);
+
+		if (open_conn_req->session_id < 0 ||
+			_sessions.find(open_conn_req->session_id) != _sessions.end())
+		{
+			MsgSqlOpenConnectionNack *nack = new MsgSqlOpenConnectionNack();
+			SendResponse(msg, nack);
+			return;
+		}
+
+		int rc = SQLITE_OK;
+		SqliteConnectionPtr conn = 
+			OpenConnection(open_conn_req->connection_url, rc);
+
+		MsgSqlOpenConnectionAck *ack = new MsgSqlOpenConnectionAck();
+		ack->rc = rc;
+
+		if (conn)
+		{
+			conn->session_state = open_conn_req->state;
+			_sessions[open_conn_req->session_id] = conn;
+			ack->db = conn->db;
+		}
+
+		SendResponse(msg, ack);
+
+	}
+
+}
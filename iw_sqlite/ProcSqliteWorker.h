@@ -0,0 +1,189 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+#include "LightweightProcess.h"
+#include "Configuration.h"
+#include "SqliteStatementCache.h"
+#include "SqliteSession.h"
+
+namespace ivrworx
+{
+	struct PendingWrite
+	{
+		IwMessagePtr request;
+
+		int rc;
+
+		int changes;
+
+		sqlite3_int64 last_insert_rowid;
+	};
+
+	typedef
+	list<PendingWrite> PendingWritesList;
+
+	struct SqliteConnection
+	{
+		SqliteConnection():db(NULL),batch_start(0),stream_stmt(NULL){};
+
+		sqlite3 *db;
+
+		shared_ptr<SqliteStatementCache> statements;
+
+		// writes of the open group commit transaction
+		PendingWritesList batch;
+
+		DWORD batch_start;
+
+		// set for the connection of a single session only
+		SqlSessionStatePtr session_state;
+
+		// statement streamed to the session, reset once done
+		sqlite3_stmt *stream_stmt;
+	};
+
+	typedef 
+	shared_ptr<SqliteConnection> SqliteConnectionPtr;
+
+	typedef 
+	map<string,SqliteConnectionPtr> SqlConnectionsMap;
+
+	typedef 
+	map<int,SqliteConnectionPtr> SqlSessionsMap;
+
+	struct DeferredRequest
+	{
+		IwMessagePtr request;
+
+		int session_id;
+
+		// first time the request found the database locked
+		DWORD since;
+	};
+
+	typedef
+	list<DeferredRequest> DeferredRequestsList;
+
+	/**
+
+	One of the ProcSqlite workers. Every worker runs in its own thread 
+	and owns the connections of the sessions opened on it, and one more 
+	connection per database file for the stateless reads and the group 
+	commit writes routed to it, so a slow query stalls only the requests 
+	routed to the same worker. Requests are forwarded by ProcSqlite and 
+	answered directly to the requester.
+
+	Connections do not use the sqlite busy handler, as the lock may be 
+	held by other connection of the same worker. A request that finds 
+	the database locked is put aside and retried while the worker serves
+	the others, until sqlite/busy_timeout passes. Later requests of the 
+	same session wait behind it so they are served in order.
+
+	**/
+	class ProcSqliteWorker :
+		public LightweightProcess
+	{
+	public:
+		ProcSqliteWorker(
+			IN ConfigurationPtr conf, 
+			IN LpHandlePair pair, 
+			IN int index,
+			IN volatile LONG *pending);
+
+		virtual ~ProcSqliteWorker(void);
+
+		void real_run();
+
+	private:
+
+		void UponSqlOpenConnectionReq(IwMessagePtr msg);
+
+		void UponSqlCloseConnectionReq(IwMessagePtr msg);
+
+		void UponSqlStepReq(IwMessagePtr msg);
+
+		void UponSqlExecReq(IwMessagePtr msg);
+
+		void UponSqlFinalizeReq(IwMessagePtr msg);
+
+		void UponSqlFetchReq(IwMessagePtr msg);
+
+		void ServeRequest(IwMessagePtr msg);
+
+		BOOL DeferBusy(IN IwMessagePtr msg);
+
+		BOOL IsDeferred(IN int session_id);
+
+		void RetryDeferred();
+
+		SqliteConnectionPtr OpenConnection(IN const string &connection_url, OUT int &rc);
+
+		SqliteConnectionPtr GetConnection(IN const string &connection_url, OUT int &rc);
+
+		void CloseConnection(IN SqliteConnectionPtr conn);
+
+		void UpdateSessionState(IN SqliteConnectionPtr conn);
+
+		int ExecStatement(IN SqliteConnectionPtr conn, IN const string &sql);
+
+		void ApplyPragmas(IN SqliteConnectionPtr conn, IN const string &connection_url);
+
+		void UponSqlGroupExecReq(IN shared_ptr<MsgSqlExecReq> exec_req, IN SqliteConnectionPtr conn);
+
+		void CommitBatch(IN SqliteConnectionPtr conn);
+
+		void CommitBatches(IN BOOL due_only);
+
+		long NextCommitTimeout();
+
+		void CloseAllConnections();
+
+		ConfigurationPtr _conf;
+
+		int _index;
+
+		volatile LONG *_pending;
+
+		int _statementCacheSize;
+
+		int _busyTimeout;
+
+		int _fetchRows;
+
+		int _groupCommitInterval;
+
+		int _groupCommitRows;
+
+		long _commits;
+
+		long _committedRows;
+
+		SqlConnectionsMap _connections;
+
+		SqlSessionsMap _sessions;
+
+		DeferredRequestsList _deferred;
+
+		// set while a deferred request is retried
+		DeferredRequest *_retrying;
+
+	};
+
+}
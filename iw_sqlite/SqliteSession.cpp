@@ -19,9 +19,13 @@
 #include "StdAfx.h"
 #include "SqliteSession.h"
 #include "LightweightProcess.h"
+#include "LocalProcessRegistrar.h"
 #include "Logger.h"
 
 
+// batches streamed ahead of the reader
+#define IW_SQL_STREAM_WINDOW 2
+
 namespace ivrworx
 {
 	static HandleId GenerateNewSqlSessionId() 
@@ -32,7 +36,27 @@ namespace ivrworx
 	}
 
 	SqliteSession::SqliteSession(void):
-	_sessionId(IW_UNDEFINED)
+	_sessionId(IW_UNDEFINED),
+	_serviceHandleId(SQLITE_Q),
+	_db(NULL),
+	_changes(0),
+	_lastInsertRowid(0),
+	_streamStmt(NULL),
+	_streamRows(0),
+	_submitted(0)
+	{
+
+	}
+
+	SqliteSession::SqliteSession(HandleId service_handle_id):
+	_sessionId(IW_UNDEFINED),
+	_serviceHandleId(service_handle_id),
+	_db(NULL),
+	_changes(0),
+	_lastInsertRowid(0),
+	_streamStmt(NULL),
+	_streamRows(0),
+	_submitted(0)
 	{
 
 	}
@@ -42,7 +66,10 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
-		return ::sqlite3_last_insert_rowid(_db);
+		// stateless reads and batched statements run on connections
+		// shared with other sessions, so return the value of the last
+		// own request
+		return _lastInsertRowid;
 	}
 
 	int 
@@ -50,7 +77,7 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
-		return ::sqlite3_changes(_db);
+		return _changes;
 	}
 
 	int 
@@ -58,7 +85,10 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
-		return ::sqlite3_busy_timeout(_db, ms);
+		// a busy handler would sleep the worker shared with other sessions 
+		// of the file, locked requests are retried up to sqlite/busy_timeout
+		LogDebug("sqlite3_busy_timeout sqls:" << _sessionId << " ignored ms:" << ms);
+		return SQLITE_OK;
 	}
 
 	ApiErrorCode 
@@ -102,7 +132,7 @@ namespace ivrworx
 		close_req->session_id = _sessionId;
 
 		ApiErrorCode res = GetCurrRunningContext()->SendMessage(
-			SQLITE_Q,
+			_serviceHandleId,
 			IwMessagePtr(close_req));
 
 		_sessionId = IW_UNDEFINED;
@@ -112,6 +142,17 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
+		sqlite3_stream_end();
+
+		// statements still submitted are committed by the 
+		// worker anyway, only their responses are dropped
+		if (_batchHandle)
+		{
+			LocalProcessRegistrar::Instance().UnregisterChannel(
+				_batchHandle->GetObjectUid());
+			_batchHandle.reset();
+		}
+
 		sqlite3_close();
 		
 	}
@@ -137,7 +178,7 @@ namespace ivrworx
 		
 		IwMessagePtr response;
 		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
-			SQLITE_Q,
+			_serviceHandleId,
 			IwMessagePtr(open_req),
 			response,
 			Seconds(10),
@@ -204,7 +245,7 @@ namespace ivrworx
 
 		IwMessagePtr response;
 		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
-			SQLITE_Q,
+			_serviceHandleId,
 			IwMessagePtr(exec_req),
 			response,
 			Seconds(10),
@@ -228,6 +269,8 @@ namespace ivrworx
 					= shared_dynamic_cast<MsgSqlExecAck> (response);
 				
 				rc	= ack->rc;
+				_changes = ack->changes;
+				_lastInsertRowid = ack->last_insert_rowid;
 
 				return API_SUCCESS;
 			}
@@ -279,7 +322,7 @@ namespace ivrworx
 		finalize_req->session_id = _sessionId;
 
 		ApiErrorCode res = GetCurrRunningContext()->SendMessage(
-			SQLITE_Q,
+			_serviceHandleId,
 			IwMessagePtr(finalize_req));
 
 		return res;
@@ -309,7 +352,7 @@ namespace ivrworx
 
 		IwMessagePtr response;
 		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
-			SQLITE_Q,
+			_serviceHandleId,
 			IwMessagePtr(step_req),
 			response,
 			Seconds(10),
@@ -333,6 +376,8 @@ namespace ivrworx
 					= shared_dynamic_cast<MsgSqlStepAck> (response);
 
 				rc	= ack->rc;
+				_changes = ack->changes;
+				_lastInsertRowid = ack->last_insert_rowid;
 
 				return API_SUCCESS;
 			}
@@ -342,5 +387,384 @@ namespace ivrworx
 			}
 		}
 	}
-}
 
+	ApiErrorCode
+	SqliteSession::sqlite3_fetch( 
+		sqlite3_stmt *pStmt,
+		int max_rows,
+		vector<string> &columns,
+		SqlRowsList &rows,
+		BOOL &done,
+		int &rc
+		)
+	{
+
+		FUNCTRACKER;
+
+		if (_sessionId == IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		MsgSqlFetchReq *fetch_req 
+			= new MsgSqlFetchReq();
+
+		fetch_req->pStmt = pStmt;
+		fetch_req->max_rows = max_rows;
+		fetch_req->session_id = _sessionId;
+
+
+		IwMessagePtr response;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_serviceHandleId,
+			IwMessagePtr(fetch_req),
+			response,
+			Seconds(10),
+			"Fetch SQLite Db TXN"
+			);
+
+		if (IW_FAILURE(res))
+		{
+			return res;
+		};
+
+		switch (response->message_id)
+		{
+		case MSG_SQL_FETCH_NACK:
+			{
+				return API_SERVER_FAILURE;
+			}
+		case MSG_SQL_FETCH_ACK:
+			{
+				shared_ptr<MsgSqlFetchAck> ack 
+					= shared_dynamic_cast<MsgSqlFetchAck> (response);
+
+				columns = ack->columns;
+				rows.splice(rows.end(), ack->rows);
+				done = ack->done;
+				rc	 = ack->rc;
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_UNKNOWN_RESPONSE;
+			}
+		}
+	}
+
+	ApiErrorCode
+	SqliteSession::sqlite3_stream_begin( 
+		sqlite3_stmt *pStmt,
+		int batch_rows
+		)
+	{
+
+		FUNCTRACKER;
+
+		if (_sessionId == IW_UNDEFINED || _streamHandle)
+		{
+			return API_WRONG_STATE;
+		}
+
+		_streamHandle.reset(new LpHandle());
+		_streamHandle->HandleName("SQLite Stream");
+		_streamHandle->Direction(MSG_DIRECTION_INBOUND);
+
+		LocalProcessRegistrar::Instance().RegisterChannel(
+			_streamHandle->GetObjectUid(),
+			_streamHandle,
+			"");
+
+		MsgSqlFetchReq *fetch_req 
+			= new MsgSqlFetchReq();
+
+		_streamStmt = pStmt;
+		_streamRows = batch_rows;
+
+		fetch_req->pStmt = pStmt;
+		fetch_req->max_rows = batch_rows;
+		fetch_req->stream = TRUE;
+		fetch_req->credit = IW_SQL_STREAM_WINDOW;
+		fetch_req->session_id = _sessionId;
+		fetch_req->source.handle_id = _streamHandle->GetObjectUid();
+
+		ApiErrorCode res = GetCurrRunningContext()->SendMessage(
+			_serviceHandleId,
+			IwMessagePtr(fetch_req));
+
+		if (IW_FAILURE(res))
+		{
+			sqlite3_stream_end();
+		}
+
+		return res;
+
+	}
+
+	ApiErrorCode
+	SqliteSession::sqlite3_stream_next( 
+		vector<string> &columns,
+		SqlRowsList &rows,
+		BOOL &done,
+		int &rc
+		)
+	{
+
+		FUNCTRACKER;
+
+		if (!_streamHandle)
+		{
+			return API_WRONG_STATE;
+		}
+
+		IwMessagePtr response;
+		ApiErrorCode res = GetCurrRunningContext()->WaitForTxnResponse(
+			_streamHandle,
+			response,
+			Seconds(10));
+
+		if (IW_FAILURE(res))
+		{
+			sqlite3_stream_end();
+			return res;
+		};
+
+		switch (response->message_id)
+		{
+		case MSG_SQL_FETCH_NACK:
+			{
+				sqlite3_stream_end();
+				return API_SERVER_FAILURE;
+			}
+		case MSG_SQL_FETCH_ACK:
+			{
+				shared_ptr<MsgSqlFetchAck> ack 
+					= shared_dynamic_cast<MsgSqlFetchAck> (response);
+
+				columns = ack->columns;
+				rows.splice(rows.end(), ack->rows);
+				done = ack->done;
+				rc	 = ack->rc;
+
+				if (done)
+				{
+					sqlite3_stream_end();
+					return API_SUCCESS;
+				}
+
+				// batch is consumed, let the worker send one more
+				MsgSqlFetchReq *fetch_req 
+					= new MsgSqlFetchReq();
+
+				fetch_req->pStmt = _streamStmt;
+				fetch_req->max_rows = _streamRows;
+				fetch_req->stream = TRUE;
+				fetch_req->resume = TRUE;
+				fetch_req->session_id = _sessionId;
+				fetch_req->source.handle_id = _streamHandle->GetObjectUid();
+
+				if (IW_FAILURE(GetCurrRunningContext()->SendMessage(
+					_serviceHandleId,
+					IwMessagePtr(fetch_req))))
+				{
+					sqlite3_stream_end();
+				}
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				sqlite3_stream_end();
+				return API_UNKNOWN_RESPONSE;
+			}
+		}
+	}
+
+	void
+	SqliteSession::sqlite3_stream_end()
+	{
+
+		FUNCTRACKER;
+
+		if (!_streamHandle)
+		{
+			return;
+		}
+
+		// once unregistered, the worker fails to deliver 
+		// the next batch and stops stepping the statement
+		LocalProcessRegistrar::Instance().UnregisterChannel(
+			_streamHandle->GetObjectUid());
+
+		_streamHandle.reset();
+		_streamStmt = NULL;
+
+	}
+
+	ApiErrorCode
+	SqliteSession::sqlite3_exec_batched( 
+		const char *sql,
+		int &rc
+		)
+	{
+
+		FUNCTRACKER;
+
+		if (_sessionId == IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		MsgSqlExecReq *exec_req 
+			= new MsgSqlExecReq();
+
+		exec_req->sql_statement = sql;
+		exec_req->session_id = _sessionId;
+		exec_req->group_commit = TRUE;
+
+		IwMessagePtr response;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_serviceHandleId,
+			IwMessagePtr(exec_req),
+			response,
+			Seconds(10),
+			"Exec Batched SQLite Db TXN"
+			);
+
+		if (IW_FAILURE(res))
+		{
+			return res;
+		};
+
+		switch (response->message_id)
+		{
+		case MSG_SQL_EXEC_NACK:
+			{
+				return API_SERVER_FAILURE;
+			}
+		case MSG_SQL_EXEC_ACK:
+			{
+				shared_ptr<MsgSqlExecAck> ack 
+					= shared_dynamic_cast<MsgSqlExecAck> (response);
+
+				rc	= ack->rc;
+				_changes = ack->changes;
+				_lastInsertRowid = ack->last_insert_rowid;
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_UNKNOWN_RESPONSE;
+			}
+		}
+	}
+
+	ApiErrorCode
+	SqliteSession::sqlite3_submit_batched( 
+		const char *sql
+		)
+	{
+
+		FUNCTRACKER;
+
+		if (_sessionId == IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		if (!_batchHandle)
+		{
+			_batchHandle.reset(new LpHandle());
+			_batchHandle->HandleName("SQLite Batch");
+			_batchHandle->Direction(MSG_DIRECTION_INBOUND);
+
+			LocalProcessRegistrar::Instance().RegisterChannel(
+				_batchHandle->GetObjectUid(),
+				_batchHandle,
+				"");
+		}
+
+		MsgSqlExecReq *exec_req 
+			= new MsgSqlExecReq();
+
+		exec_req->sql_statement = sql;
+		exec_req->session_id = _sessionId;
+		exec_req->group_commit = TRUE;
+		exec_req->source.handle_id = _batchHandle->GetObjectUid();
+
+		ApiErrorCode res = GetCurrRunningContext()->SendMessage(
+			_serviceHandleId,
+			IwMessagePtr(exec_req));
+
+		if (IW_SUCCESS(res))
+		{
+			_submitted++;
+		}
+
+		return res;
+
+	}
+
+	ApiErrorCode
+	SqliteSession::sqlite3_wait_batched( 
+		int &failed
+		)
+	{
+
+		FUNCTRACKER;
+
+		failed = 0;
+
+		if (!_batchHandle)
+		{
+			return API_SUCCESS;
+		}
+
+		ApiErrorCode res = API_SUCCESS;
+		while (_submitted > 0)
+		{
+			IwMessagePtr response;
+			res = GetCurrRunningContext()->WaitForTxnResponse(
+				_batchHandle,
+				response,
+				Seconds(10));
+
+			if (IW_FAILURE(res))
+			{
+				failed += _submitted;
+				break;
+			}
+
+			_submitted--;
+
+			if (response->message_id != MSG_SQL_EXEC_ACK)
+			{
+				failed++;
+				continue;
+			}
+
+			shared_ptr<MsgSqlExecAck> ack 
+				= shared_dynamic_cast<MsgSqlExecAck> (response);
+
+			if (ack->rc != SQLITE_OK)
+			{
+				failed++;
+				continue;
+			}
+
+			_changes = ack->changes;
+			_lastInsertRowid = ack->last_insert_rowid;
+		}
+
+		LocalProcessRegistrar::Instance().UnregisterChannel(
+			_batchHandle->GetObjectUid());
+
+		_batchHandle.reset();
+		_submitted = 0;
+
+		return res;
+
+	}
+}
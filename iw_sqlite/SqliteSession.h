@@ -35,6 +35,47 @@ IwWorx sqlite driver outsources the long operation to a different thread by thus
 reschedule possible while waiting for results. Any api available for lua sql is available for
 ivrworx driver also.
 
+The requests are served by a pool of sqlite/workers worker threads. Every session gets 
+its own connection, with a cache of sqlite/statement_cache_size prepared statements keyed 
+by the SQL text, so explicit transactions of different sessions never mix. All sessions 
+of the same database file live on the writer worker of the file, so the writes to it are 
+serialized by one thread. A request finding the file locked by other session waits up to 
+sqlite/busy_timeout milliseconds without stalling the worker.
+
+SELECT statements of a session with no open transaction are stateless and go to the least 
+loaded worker, which runs them on its own connection to the database file. Such reads do 
+not see TEMP tables, ATTACHed databases or PRAGMAs set on the session connection, so use 
+them within a transaction or through a prepared statement.
+
+Scripts may also use the native sqlsession object, which reads the rows already typed. 
+The rows iterator has the worker stream the result set in batches of sqlite/fetch_rows 
+(or batch) rows, a couple of batches ahead of the loop, and query reads up to maxrows 
+rows in a single round trip.
+
+@code
+ db = sqlsession:new()
+ db:open{url="voice.db"}
+ for row in db:rows{sql="SELECT * FROM menu", batch=50} do
+   ivrworx.loginf(string.format("key: %s, action: %s", row.key, row.action))
+ end
+ res, routes = db:query{sql="SELECT * FROM routes", maxrows=100}
+ db:close()
+@endcode
+
+High rate inserts may join the write worker group commit. Batched statements of all 
+sessions are executed in one transaction, each in its own savepoint, which is committed 
+once sqlite/group_commit_rows statements were batched or sqlite/group_commit_interval 
+milliseconds passed. Every statement is acknowledged only after the commit, so a 
+script either waits for it or pipelines its inserts and waits for all of them at once.
+
+@code
+ db:exec{sql="INSERT INTO calls VALUES ('1001', 30)", batched=true}
+ for i, cdr in ipairs(cdrs) do
+   db:submit{sql=cdr}
+ end
+ res, failed = db:flush()
+@endcode
+
 Working with sqlite db is as simple as
 
 @code
@@ -74,9 +115,35 @@ namespace ivrworx
 		MSG_SQL_STEP_ACK,
 		MSG_SQL_STEP_NACK,
 		MSG_SQL_FINALIZE_REQ,
-		MSG_SQL_RESET_REQ
+		MSG_SQL_RESET_REQ,
+		MSG_SQL_FETCH_REQ,
+		MSG_SQL_FETCH_ACK,
+		MSG_SQL_FETCH_NACK
 	};
 
+	/**
+	Column value as read by the worker, typed according to sqlite 
+	column type. Text and blob values are kept in text_value.
+	**/
+	struct SqlValue
+	{
+		SqlValue():type(SQLITE_NULL),int_value(0),float_value(0.0){};
+
+		int type;
+
+		sqlite3_int64 int_value;
+
+		double float_value;
+
+		string text_value;
+	};
+
+	typedef 
+	vector<SqlValue> SqlRow;
+
+	typedef 
+	list<SqlRow> SqlRowsList;
+
 
 	class IW_SQLLITE_API MsgSqlMixin
 	{
@@ -102,6 +169,22 @@ namespace ivrworx
 	};
 
 	
+	/**
+	Session state shared by ProcSqlite and the worker owning
+	the session connection.
+	**/
+	struct SqlSessionState
+	{
+		SqlSessionState():transaction_open(FALSE){};
+
+		// updated by the worker before it responds, so reads 
+		// of the session are spread only when it is not set
+		volatile LONG transaction_open;
+	};
+
+	typedef
+	shared_ptr<SqlSessionState> SqlSessionStatePtr;
+	
 	class IW_SQLLITE_API MsgSqlOpenConnectionReq: 
 		public MsgSqlMixin, public MsgRequest
 	{
@@ -111,6 +194,9 @@ namespace ivrworx
 
 		  string connection_url;
 
+		  // filled by ProcSqlite when routing the request to a worker
+		  SqlSessionStatePtr state;
+
 		 
 	};
 
@@ -159,10 +245,17 @@ namespace ivrworx
 	{
 	public:
 		MsgSqlExecReq():
-		  MsgRequest(MSG_SQL_EXEC_REQ, NAME(MSG_SQL_EXEC_REQ)){};
+		  MsgRequest(MSG_SQL_EXEC_REQ, NAME(MSG_SQL_EXEC_REQ)),group_commit(FALSE){};
 
 		string sql_statement;
 
+		// filled by ProcSqlite when routing the request to a worker
+		string connection_url;
+
+		// statement joins the worker group commit, 
+		// response is sent once the transaction is durable
+		BOOL group_commit;
+
 	};
 
 	class IW_SQLLITE_API MsgSqlExecAck: 
@@ -170,10 +263,15 @@ namespace ivrworx
 	{
 	public:
 		MsgSqlExecAck():
-		  MsgResponse(MSG_SQL_EXEC_ACK, NAME(MSG_SQL_EXEC_ACK)),errmsg(NULL){};
+		  MsgResponse(MSG_SQL_EXEC_ACK, NAME(MSG_SQL_EXEC_ACK)),errmsg(NULL),
+			  changes(0),last_insert_rowid(0){};
 
 		char *errmsg;
 
+		int changes;
+
+		sqlite3_int64 last_insert_rowid;
+
 		virtual void copy_data_on_response(IN IwMessage *request)
 		{
 			MsgSqlMixin::copy_data_on_response(request);
@@ -213,10 +311,15 @@ namespace ivrworx
 	{
 	public:
 		MsgSqlStepAck():
-		  MsgResponse(MSG_SQL_STEP_ACK, NAME(MSG_SQL_STEP_ACK)){};
+		  MsgResponse(MSG_SQL_STEP_ACK, NAME(MSG_SQL_STEP_ACK)),
+			  changes(0),last_insert_rowid(0){};
 
 		int rc;
 
+		int changes;
+
+		sqlite3_int64 last_insert_rowid;
+
 		virtual void copy_data_on_response(IN IwMessage *request)
 		{
 			MsgSqlMixin::copy_data_on_response(request);
@@ -251,6 +354,70 @@ namespace ivrworx
 
 	};
 
+	class IW_SQLLITE_API MsgSqlFetchReq: 
+		public MsgSqlMixin, public MsgRequest
+	{
+	public:
+		MsgSqlFetchReq():
+		  MsgRequest(MSG_SQL_FETCH_REQ, NAME(MSG_SQL_FETCH_REQ)),
+			  pStmt(NULL),max_rows(0),stream(FALSE),credit(1),resume(FALSE){};
+
+		sqlite3_stmt *pStmt;
+
+		// rows per response, sqlite/fetch_rows if not positive
+		int max_rows;
+
+		// keep stepping till the end of result set 
+		// sending response per every max_rows rows
+		BOOL stream;
+
+		// responses the worker may send in stream mode 
+		// before the requester asks for more
+		int credit;
+
+		// grants more credit to the stream begun on the statement, 
+		// ignored once the stream is done
+		BOOL resume;
+
+	};
+
+	class IW_SQLLITE_API MsgSqlFetchAck: 
+		public MsgSqlMixin, public MsgResponse
+	{
+	public:
+		MsgSqlFetchAck():
+		  MsgResponse(MSG_SQL_FETCH_ACK, NAME(MSG_SQL_FETCH_ACK)),
+			  done(FALSE){};
+
+		vector<string> columns;
+
+		SqlRowsList rows;
+
+		BOOL done;
+
+		virtual void copy_data_on_response(IN IwMessage *request)
+		{
+			MsgSqlMixin::copy_data_on_response(request);
+			MsgResponse::copy_data_on_response(request);
+		}
+
+	};
+
+	class IW_SQLLITE_API MsgSqlFetchNack: 
+		public MsgSqlMixin, public MsgResponse
+	{
+	public:
+		MsgSqlFetchNack():
+		  MsgResponse(MSG_SQL_FETCH_NACK, NAME(MSG_SQL_FETCH_NACK)){};
+
+		  virtual void copy_data_on_response(IN IwMessage *request)
+		  {
+			  MsgSqlMixin::copy_data_on_response(request);
+			  MsgResponse::copy_data_on_response(request);
+		  }
+
+	};
+
 	/**
 	Sqlite fiber non blocking connectivity
 	**/
@@ -259,6 +426,8 @@ namespace ivrworx
 	public:
 		SqliteSession(void);
 
+		SqliteSession(HandleId service_handle_id);
+
 		virtual ~SqliteSession(void);
 
 		ApiErrorCode sqlite3_open(const char *connection_url, int &rc);
@@ -298,6 +467,52 @@ namespace ivrworx
 			int &rc						   
 			);
 
+		// steps up to max_rows rows in a single round trip
+		ApiErrorCode sqlite3_fetch( 
+			sqlite3_stmt *pStmt,
+			int max_rows,
+			vector<string> &columns,
+			SqlRowsList &rows,
+			BOOL &done,
+			int &rc
+			);
+
+		// worker streams the whole result set in batches of batch_rows 
+		// rows, which are read by sqlite3_stream_next till done is set.
+		// Only a few batches are sent ahead of the reader, every batch
+		// read asks the worker for one more.
+		ApiErrorCode sqlite3_stream_begin( 
+			sqlite3_stmt *pStmt,
+			int batch_rows
+			);
+
+		ApiErrorCode sqlite3_stream_next( 
+			vector<string> &columns,
+			SqlRowsList &rows,
+			BOOL &done,
+			int &rc
+			);
+
+		void sqlite3_stream_end();
+
+		// executes write statement as part of worker group commit, 
+		// returns once the transaction holding it is committed
+		ApiErrorCode sqlite3_exec_batched( 
+			const char *sql,
+			int &rc
+			);
+
+		// same as above but does not wait for the commit, so many 
+		// statements of the same session may share a transaction
+		ApiErrorCode sqlite3_submit_batched( 
+			const char *sql
+			);
+
+		// waits for all submitted statements to be committed
+		ApiErrorCode sqlite3_wait_batched( 
+			int &failed
+			);
+
 		int sqlite3_busy_timeout(int ms);
 
 		sqlite3_int64 sqlite3_last_insert_rowid();
@@ -308,10 +523,31 @@ namespace ivrworx
 
 		int _sessionId;
 
+		HandleId _serviceHandleId;
+
 		sqlite3 *_db;
 
+		int _changes;
+
+		sqlite3_int64 _lastInsertRowid;
+
+		// registered while streaming is in progress
+		LpHandlePtr _streamHandle;
+
+		sqlite3_stmt *_streamStmt;
+
+		int _streamRows;
+
+		// registered while batched statements are in progress
+		LpHandlePtr _batchHandle;
+
+		int _submitted;
+
 	};
 
+	typedef 
+	shared_ptr<SqliteSession> SqliteSessionPtr;
+
 
 }
 
@@ -0,0 +1,161 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "StdAfx.h"
+#include "SqliteStatementCache.h"
+#include "Logger.h"
+
+namespace ivrworx
+{
+	SqliteStatementCache::SqliteStatementCache(sqlite3 *db, size_t max_size):
+	_db(db),
+	_maxSize(max_size),
+	_hits(0),
+	_misses(0),
+	_evictions(0)
+	{
+
+	}
+
+	SqliteStatementCache::~SqliteStatementCache(void)
+	{
+		Clear();
+	}
+
+	int
+	SqliteStatementCache::Acquire(IN const string &sql, 
+								  OUT sqlite3_stmt **stmt, 
+								  OUT BOOL &cacheable)
+	{
+		FUNCTRACKER;
+
+		*stmt = NULL;
+		cacheable = FALSE;
+
+		StatementsMap::iterator iter = _statements.find(sql);
+		if (iter != _statements.end())
+		{
+			_hits++;
+
+			// move to the head of lru list
+			_lru.erase(iter->second.lru_pos);
+			_lru.push_front(sql);
+			iter->second.lru_pos = _lru.begin();
+
+			*stmt = iter->second.stmt;
+			cacheable = TRUE;
+			return SQLITE_OK;
+		}
+
+		_misses++;
+
+		const char *tail = NULL;
+		int rc = ::sqlite3_prepare_v2(_db, sql.c_str(), (int)sql.length() + 1, stmt, &tail);
+		if (rc != SQLITE_OK)
+		{
+			return rc;
+		}
+
+		// only single statement texts may be cached, the rest 
+		// of multi statement text would be lost otherwise
+		while (tail != NULL && *tail != '\0' && (::isspace(*tail) || *tail == ';'))
+		{
+			tail++;
+		}
+
+		if (tail != NULL && *tail != '\0')
+		{
+			::sqlite3_finalize(*stmt);
+			*stmt = NULL;
+			return SQLITE_OK;
+		}
+
+		if (_maxSize == 0 || *stmt == NULL)
+		{
+			return SQLITE_OK;
+		}
+
+		if (_statements.size() >= _maxSize)
+		{
+			const string &victim = _lru.back();
+			StatementsMap::iterator victim_iter = _statements.find(victim);
+
+			::sqlite3_finalize(victim_iter->second.stmt);
+			_statements.erase(victim_iter);
+			_lru.pop_back();
+			_evictions++;
+		}
+
+		_lru.push_front(sql);
+
+		CachedStatement entry;
+		entry.stmt = *stmt;
+		entry.lru_pos = _lru.begin();
+		_statements[sql] = entry;
+
+		cacheable = TRUE;
+		return SQLITE_OK;
+	}
+
+	void
+	SqliteStatementCache::Release(IN sqlite3_stmt *stmt, IN BOOL cacheable)
+	{
+		FUNCTRACKER;
+
+		if (stmt == NULL)
+		{
+			return;
+		}
+
+		if (cacheable == FALSE)
+		{
+			::sqlite3_finalize(stmt);
+			return;
+		}
+
+		::sqlite3_reset(stmt);
+		::sqlite3_clear_bindings(stmt);
+
+	}
+
+	void
+	SqliteStatementCache::Clear()
+	{
+		FUNCTRACKER;
+
+		for (StatementsMap::iterator iter = _statements.begin();
+			iter != _statements.end(); ++iter)
+		{
+			::sqlite3_finalize(iter->second.stmt);
+		}
+
+		_statements.clear();
+		_lru.clear();
+	}
+
+	void
+	SqliteStatementCache::LogStats()
+	{
+		LogInfo("Sqlite statement cache size:" << _statements.size() 
+			<< ", hits:" << _hits 
+			<< ", misses:" << _misses 
+			<< ", evictions:" << _evictions);
+	}
+
+}
@@ -0,0 +1,80 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+namespace ivrworx
+{
+	/**
+
+	LRU cache of prepared statements of a single sqlite connection keyed
+	by the SQL text. Statements are reset and their bindings cleared before
+	they are handed out again, so a cached statement is indistinguishable 
+	from a freshly prepared one. Not thread safe, the cache belongs to 
+	the worker owning the connection. Acquire returns no statement for 
+	empty or multi statement texts, which the caller has to execute the 
+	usual way.
+
+	**/
+	class SqliteStatementCache
+	{
+	public:
+
+		SqliteStatementCache(sqlite3 *db, size_t max_size);
+
+		virtual ~SqliteStatementCache(void);
+
+		int Acquire(IN const string &sql, OUT sqlite3_stmt **stmt, OUT BOOL &cacheable);
+
+		void Release(IN sqlite3_stmt *stmt, IN BOOL cacheable);
+
+		void Clear();
+
+		void LogStats();
+
+	private:
+
+		typedef list<string> LruList;
+
+		struct CachedStatement
+		{
+			sqlite3_stmt *stmt;
+
+			LruList::iterator lru_pos;
+		};
+
+		typedef map<string,CachedStatement> StatementsMap;
+
+		sqlite3 *_db;
+
+		size_t _maxSize;
+
+		StatementsMap _statements;
+
+		LruList _lru;
+
+		long _hits;
+
+		long _misses;
+
+		long _evictions;
+
+	};
+
+}
@@ -26,6 +26,55 @@
 
 namespace ivrworx
 {
+	RtpQualityStats::RtpQualityStats():
+	packets_received(0),
+	packets_expected(0),
+	packets_lost(0),
+	octets_received(0),
+	packets_sent(0),
+	octets_sent(0),
+	jitter_ms(0),
+	rtt_ms(IW_UNDEFINED),
+	kbps_in(0),
+	kbps_out(0),
+	duration_ms(0)
+	{
+
+	}
+
+	double
+	RtpQualityStats::loss_percent() const
+	{
+		if (packets_expected == 0 || packets_lost <= 0)
+		{
+			return 0;
+		}
+
+		return (100.0 * packets_lost) / packets_expected;
+	}
+
+	IW_TELEPHONY_API ostream& operator << (ostream &ostream, const RtpQualityStats &stats)
+	{
+		return ostream 
+			<< "rcvd:"		<< stats.packets_received 
+			<< " lost:"		<< stats.packets_lost 
+			<< " loss%:"	<< stats.loss_percent()
+			<< " jitter:"	<< stats.jitter_ms << "ms"
+			<< " rtt:"		<< stats.rtt_ms << "ms"
+			<< " sent:"		<< stats.packets_sent
+			<< " in:"		<< stats.kbps_in << "kbps"
+			<< " out:"		<< stats.kbps_out << "kbps"
+			<< " duration:" << stats.duration_ms << "ms";
+	}
+
+	RtpProxyBenchmark::RtpProxyBenchmark():
+	transcode_ns(0),
+	dtmf_ns(0),
+	mix_ns(0)
+	{
+
+	}
+
 	RtpProxySession::RtpProxySession(ScopedForking &forking,HandleId handle_id):
 	_rtpProxyHandleId(handle_id),
 	_handle(IW_UNDEFINED),
@@ -38,7 +87,8 @@ namespace ivrworx
 
 	RtpProxySession::~RtpProxySession(void)
 	{
-		TearDown();
+		// do not block in destructor, statistics are lost
+		SendDeallocate(FALSE);
 	}
 
 	ApiErrorCode 
@@ -101,6 +151,14 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
+		return SendDeallocate(TRUE);
+	}
+
+	ApiErrorCode 
+	RtpProxySession::SendDeallocate(IN BOOL waitForStats)
+	{
+		FUNCTRACKER;
+
 		if (_handle == IW_UNDEFINED)
 		{
 			return API_SUCCESS;
@@ -110,13 +168,144 @@ namespace ivrworx
 			new MsgRtpProxyDeallocateReq();
 
 		req->rtp_proxy_handle = _handle;
+		req->report_stats = waitForStats;
 
-		GetCurrRunningContext()->SendMessage(_rtpProxyHandleId,IwMessagePtr(req));
+		RtpProxyHandle handle = _handle;
 
 		_handle = IW_UNDEFINED;
 		_bridgedHandle = IW_UNDEFINED;
-		
-		return API_SUCCESS;
+
+		if (!waitForStats)
+		{
+			GetCurrRunningContext()->SendMessage(_rtpProxyHandleId,IwMessagePtr(req));
+			return API_SUCCESS;
+		}
+
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(req),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			"Deallocate RTP Connection TXN");
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpProxySession::TearDown - Error deallocating rtp connection rtph:" << handle << ", res:" << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_STATS_ACK:
+			{
+				shared_ptr<MsgRtpProxyStatsAck> ack 
+					= dynamic_pointer_cast<MsgRtpProxyStatsAck> (response);
+
+				_finalStats = ack->stats;
+
+				LogDebug("RtpProxySession::TearDown rtph:" << handle << " " << _finalStats);
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
+	}
+
+	ApiErrorCode 
+	RtpProxySession::Stats(OUT RtpQualityStats &stats)
+	{
+		FUNCTRACKER;
+
+		// connection is gone, report what we got upon teardown
+		if (_handle == IW_UNDEFINED)
+		{
+			stats = _finalStats;
+			return API_SUCCESS;
+		}
+
+		MsgRtpProxyStatsReq *req = 
+			new MsgRtpProxyStatsReq();
+
+		req->rtp_proxy_handle = _handle;
+
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(req),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			"Stats RTP Connection TXN");
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpProxySession::Stats - Error querying rtp connection " << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_STATS_ACK:
+			{
+				shared_ptr<MsgRtpProxyStatsAck> ack 
+					= dynamic_pointer_cast<MsgRtpProxyStatsAck> (response);
+
+				stats = ack->stats;
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
+	}
+
+	ApiErrorCode 
+	RtpProxySession::Benchmark(
+		IN int frames, 
+		IN int participants, 
+		OUT RtpProxyBenchmark &result)
+	{
+		FUNCTRACKER;
+
+		MsgRtpProxyBenchmarkReq *req = 
+			new MsgRtpProxyBenchmarkReq();
+
+		req->frames = frames;
+		req->participants = participants;
+
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(req),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			"Benchmark RTP Proxy TXN");
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpProxySession::Benchmark - Error running benchmark " << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_BENCHMARK_ACK:
+			{
+				shared_ptr<MsgRtpProxyBenchmarkAck> ack 
+					= dynamic_pointer_cast<MsgRtpProxyBenchmarkAck> (response);
+
+				result = ack->result;
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
 	}
 
 	ApiErrorCode 
@@ -328,7 +517,199 @@ namespace ivrworx
 		return _remoteOffer;
 	}
 
+	RtpConferenceSession::RtpConferenceSession(HandleId handle_id):
+	_handle(IW_UNDEFINED),
+	_rtpProxyHandleId(handle_id)
+	{
+
+	}
+
+	RtpConferenceSession::~RtpConferenceSession(void)
+	{
+		TearDown();
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::Allocate()
+	{
+		FUNCTRACKER;
+
+		if (_handle != IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(new MsgRtpProxyConfAllocateReq()),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			"Allocate RTP Conference TXN");
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpConferenceSession::Allocate - Error allocating conference " << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_CONF_ACK:
+			{
+				shared_ptr<MsgRtpProxyConfAck> ack 
+					= dynamic_pointer_cast<MsgRtpProxyConfAck> (response);
+
+				_handle = ack->conference_handle;
+
+				LogDebug("RtpConferenceSession::Allocate allocated confh:" << _handle);
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::Attach(IN RtpConferenceHandle handle)
+	{
+		FUNCTRACKER;
+
+		if (_handle != IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		MsgRtpProxyConfAttachReq *req = new MsgRtpProxyConfAttachReq();
+		req->conference_handle = handle;
+
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(req),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			"Attach RTP Conference TXN");
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpConferenceSession::Attach - Error attaching to confh:" << handle << " " << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_CONF_ACK:
+			{
+				_handle = handle;
+
+				LogDebug("RtpConferenceSession::Attach attached to confh:" << _handle);
+
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::Join(IN RtpProxySession &participant)
+	{
+		FUNCTRACKER;
+
+		LogDebug("RtpConferenceSession::Join confh:" << _handle << ", rtph:" << participant.RtpHandle());
+
+		if (_handle == IW_UNDEFINED || participant.RtpHandle() == IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		MsgRtpProxyConfJoinReq *req = new MsgRtpProxyConfJoinReq();
+		req->conference_handle = _handle;
+		req->rtp_proxy_handle  = participant.RtpHandle();
+
+		return SendParticipantReq(req, "Join RTP Conference TXN");
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::Leave(IN RtpProxySession &participant)
+	{
+		FUNCTRACKER;
+
+		LogDebug("RtpConferenceSession::Leave confh:" << _handle << ", rtph:" << participant.RtpHandle());
+
+		if (_handle == IW_UNDEFINED || participant.RtpHandle() == IW_UNDEFINED)
+		{
+			return API_WRONG_STATE;
+		}
+
+		MsgRtpProxyConfLeaveReq *req = new MsgRtpProxyConfLeaveReq();
+		req->conference_handle = _handle;
+		req->rtp_proxy_handle  = participant.RtpHandle();
+
+		return SendParticipantReq(req, "Leave RTP Conference TXN");
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::SendParticipantReq(IN MsgRequest *req, IN const string &txn_name)
+	{
+		IwMessagePtr response = NULL_MSG;
+		ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
+			_rtpProxyHandleId,
+			IwMessagePtr(req),
+			response,
+			MilliSeconds(GetCurrRunningContext()->TransactionTimeout()),
+			txn_name);
+
+		if (res != API_SUCCESS)
+		{
+			LogWarn("RtpConferenceSession - " << txn_name << " error:" << res);
+			return res;
+		}
+
+		switch (response->message_id)
+		{
+		case MSG_RTP_PROXY_ACK:
+			{
+				return API_SUCCESS;
+			}
+		default:
+			{
+				return API_FAILURE;
+			}
+		}
+	}
+
+	ApiErrorCode 
+	RtpConferenceSession::TearDown()
+	{
+		FUNCTRACKER;
+
+		if (_handle == IW_UNDEFINED)
+		{
+			return API_SUCCESS;
+		}
+
+		MsgRtpProxyConfDeallocateReq *req = 
+			new MsgRtpProxyConfDeallocateReq();
+		req->conference_handle = _handle;
+
+		_handle = IW_UNDEFINED;
+
+		return GetCurrRunningContext()->SendMessage(_rtpProxyHandleId,IwMessagePtr(req));
+	}
+
+	RtpConferenceHandle 
+	RtpConferenceSession::ConferenceHandle()
+	{
+		return _handle;
+	}
+
 }
 
 #pragma pop_macro("SendMessage")
-
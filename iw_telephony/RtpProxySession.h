@@ -33,6 +33,16 @@ namespace ivrworx
 		MSG_RTP_PROXY_BRIDGE_REQ,
 		MSG_RTP_PROXY_MODIFY_REQ,
 		MSG_RTP_PROXY_DEALLOCATE_REQ,
+		MSG_RTP_PROXY_STATS_REQ,
+		MSG_RTP_PROXY_STATS_ACK,
+		MSG_RTP_PROXY_CONF_ALLOCATE_REQ,
+		MSG_RTP_PROXY_CONF_JOIN_REQ,
+		MSG_RTP_PROXY_CONF_LEAVE_REQ,
+		MSG_RTP_PROXY_CONF_DEALLOCATE_REQ,
+		MSG_RTP_PROXY_CONF_ACK,
+		MSG_RTP_PROXY_BENCHMARK_REQ,
+		MSG_RTP_PROXY_BENCHMARK_ACK,
+		MSG_RTP_PROXY_CONF_ATTACH_REQ,
 	};
 
 	typedef int 
@@ -46,6 +56,79 @@ namespace ivrworx
 		AbstractOffer offer;
 	};	
 
+	typedef int 
+	RtpConferenceHandle;
+
+	class IW_TELEPHONY_API RtpConferenceMixin 
+	{
+	public :
+		RtpConferenceMixin():conference_handle(IW_UNDEFINED){};
+		RtpConferenceHandle conference_handle;
+	};	
+
+	/**
+
+	Media quality of single rtp connection as seen by the proxy. Inbound 
+	values are taken from rtp reception statistics of the connection source, 
+	outbound and round trip values are taken from rtcp receiver reports 
+	received for the connection sink. 
+
+	**/
+	class IW_TELEPHONY_API RtpQualityStats
+	{
+	public:
+		RtpQualityStats();
+
+		double loss_percent() const;
+
+		unsigned long packets_received;
+
+		unsigned long packets_expected;
+
+		long packets_lost;
+
+		unsigned long octets_received;
+
+		unsigned long packets_sent;
+
+		unsigned long octets_sent;
+
+		double jitter_ms;
+
+		double rtt_ms;
+
+		double kbps_in;
+
+		double kbps_out;
+
+		unsigned long duration_ms;
+
+	};
+
+	IW_TELEPHONY_API ostream& operator << (ostream &ostream, const RtpQualityStats &stats);
+
+	/**
+
+	Cost of the proxy media kernels in ns per 20ms frame, measured by the
+	proxy on synthetic audio. Proxy does not serve rtp while measuring.
+
+	**/
+	class IW_TELEPHONY_API RtpProxyBenchmark
+	{
+	public:
+		RtpProxyBenchmark();
+
+		// one frame converted between PCMU, PCMA and L16
+		double transcode_ns;
+
+		// one frame fed to in-band DTMF detector
+		double dtmf_ns;
+
+		// one participant of conference mixed, mix-minus and encoded
+		double mix_ns;
+
+	};
+
 	class IW_TELEPHONY_API MsgRtpProxyDtmfEvt:
 		public IwMessage
 	{
@@ -82,10 +165,63 @@ namespace ivrworx
 	public:
 		MsgRtpProxyDeallocateReq():
 		  MsgRequest(MSG_RTP_PROXY_DEALLOCATE_REQ, 
-			  NAME(MSG_RTP_PROXY_DEALLOCATE_REQ)){};
+			  NAME(MSG_RTP_PROXY_DEALLOCATE_REQ)),report_stats(FALSE){};
 
 		  CnxInfo remote_cnx_info;
 
+		  // if set proxy answers with MsgRtpProxyStatsAck 
+		  // holding the final statistics of the connection
+		  BOOL report_stats;
+
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyStatsReq:
+		public MsgRequest, 
+		public RtpProxyMixin
+	{
+	public:
+		MsgRtpProxyStatsReq():
+		  MsgRequest(MSG_RTP_PROXY_STATS_REQ, 
+			  NAME(MSG_RTP_PROXY_STATS_REQ)){};
+
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyStatsAck:
+		public IwMessage, public RtpProxyMixin
+	{
+	public:
+		MsgRtpProxyStatsAck():
+		  IwMessage(MSG_RTP_PROXY_STATS_ACK, 
+			  NAME(MSG_RTP_PROXY_STATS_ACK))
+		  {};
+
+		RtpQualityStats stats;
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyBenchmarkReq:
+		public MsgRequest
+	{
+	public:
+		MsgRtpProxyBenchmarkReq():
+		  MsgRequest(MSG_RTP_PROXY_BENCHMARK_REQ, 
+			  NAME(MSG_RTP_PROXY_BENCHMARK_REQ)),frames(0),participants(0){};
+
+		int frames;
+
+		// size of the mixed conference
+		int participants;
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyBenchmarkAck:
+		public IwMessage
+	{
+	public:
+		MsgRtpProxyBenchmarkAck():
+		  IwMessage(MSG_RTP_PROXY_BENCHMARK_ACK, 
+			  NAME(MSG_RTP_PROXY_BENCHMARK_ACK))
+		  {};
+
+		RtpProxyBenchmark result;
 	};
 
 	class IW_TELEPHONY_API MsgRtpProxyBridgeReq:
@@ -134,6 +270,75 @@ namespace ivrworx
 
 	};
 
+	class IW_TELEPHONY_API MsgRtpProxyConfAllocateReq:
+		public MsgRequest
+	{
+	public:
+		MsgRtpProxyConfAllocateReq():
+		  MsgRequest(MSG_RTP_PROXY_CONF_ALLOCATE_REQ, 
+			  NAME(MSG_RTP_PROXY_CONF_ALLOCATE_REQ)){};
+
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyConfAck:
+		public IwMessage, public RtpConferenceMixin
+	{
+	public:
+		MsgRtpProxyConfAck():
+		  IwMessage(MSG_RTP_PROXY_CONF_ACK, 
+			  NAME(MSG_RTP_PROXY_CONF_ACK))
+		  {};
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyConfJoinReq:
+		public MsgRequest, 
+		public RtpProxyMixin,
+		public RtpConferenceMixin
+	{
+	public:
+		MsgRtpProxyConfJoinReq():
+		  MsgRequest(MSG_RTP_PROXY_CONF_JOIN_REQ, 
+			  NAME(MSG_RTP_PROXY_CONF_JOIN_REQ)){};
+
+	};
+
+	class IW_TELEPHONY_API MsgRtpProxyConfLeaveReq:
+		public MsgRequest, 
+		public RtpProxyMixin,
+		public RtpConferenceMixin
+	{
+	public:
+		MsgRtpProxyConfLeaveReq():
+		  MsgRequest(MSG_RTP_PROXY_CONF_LEAVE_REQ, 
+			  NAME(MSG_RTP_PROXY_CONF_LEAVE_REQ)){};
+
+	};
+
+	// answered with MsgRtpProxyConfAck if conference exists
+	class IW_TELEPHONY_API MsgRtpProxyConfAttachReq:
+		public MsgRequest, 
+		public RtpConferenceMixin
+	{
+	public:
+		MsgRtpProxyConfAttachReq():
+		  MsgRequest(MSG_RTP_PROXY_CONF_ATTACH_REQ, 
+			  NAME(MSG_RTP_PROXY_CONF_ATTACH_REQ)){};
+
+	};
+
+	// not answered, releases reference of the session, participants 
+	// are released by the proxy together with the last reference
+	class IW_TELEPHONY_API MsgRtpProxyConfDeallocateReq:
+		public MsgRequest, 
+		public RtpConferenceMixin
+	{
+	public:
+		MsgRtpProxyConfDeallocateReq():
+		  MsgRequest(MSG_RTP_PROXY_CONF_DEALLOCATE_REQ, 
+			  NAME(MSG_RTP_PROXY_CONF_DEALLOCATE_REQ)){};
+
+	};
+
 	class IW_TELEPHONY_API RtpProxySession:
 		public ActiveObject
 	{
@@ -147,6 +352,14 @@ namespace ivrworx
 
 		virtual ApiErrorCode TearDown();
 
+		virtual ApiErrorCode Stats(OUT RtpQualityStats &stats);
+
+		// does not need allocated connection
+		virtual ApiErrorCode Benchmark(
+			IN int frames, 
+			IN int participants, 
+			OUT RtpProxyBenchmark &result);
+
 		virtual ApiErrorCode Modify(const AbstractOffer &remoteOffer);
 
 		virtual ApiErrorCode Bridge(IN const RtpProxySession &dest, BOOL fullDuplex = FALSE);
@@ -171,6 +384,8 @@ namespace ivrworx
 
 	private:
 
+		ApiErrorCode SendDeallocate(IN BOOL waitForStats);
+
 		AbstractOffer _remoteOffer;
 
 		AbstractOffer _localOffer;
@@ -187,11 +402,60 @@ namespace ivrworx
 
 		stringstream _dtmfBuffer;
 
+		RtpQualityStats _finalStats;
+
 
 	};
 
 	typedef 
 	shared_ptr<RtpProxySession> RtpProxySessionPtr;
 
+	/**
+
+	Client side of the rtp proxy conference. Every allocated rtp 
+	connection may be joined, it hears everybody else in the conference. 
+	Joining breaks any bridge the connection had before.
+
+	Session of other call attaches to existing conference by its handle.
+	Proxy counts the sessions, conference ends when the last one tears 
+	it down.
+
+	**/
+	class IW_TELEPHONY_API RtpConferenceSession:
+		public boost::noncopyable
+	{
+	public:
+
+		RtpConferenceSession(HandleId handle_id);
+
+		virtual ~RtpConferenceSession(void);
+
+		virtual ApiErrorCode Allocate();
+
+		virtual ApiErrorCode Attach(IN RtpConferenceHandle handle);
+
+		virtual ApiErrorCode Join(IN RtpProxySession &participant);
+
+		virtual ApiErrorCode Leave(IN RtpProxySession &participant);
+
+		virtual ApiErrorCode TearDown();
+
+		virtual RtpConferenceHandle ConferenceHandle();
+
+	private:
+
+		ApiErrorCode SendParticipantReq(
+			IN MsgRequest *req, 
+			IN const string &txn_name);
+
+		RtpConferenceHandle _handle;
+
+		HandleId _rtpProxyHandleId;
+
+	};
+
+	typedef 
+	shared_ptr<RtpConferenceSession> RtpConferenceSessionPtr;
+
 
 }
@@ -86,9 +86,29 @@ StreamingSession::PlayFile(IN const string &file_name,
 					 IN BOOL sync,
 					 IN BOOL loop)
 {
+	FUNCTRACKER;
+
+	list<string> file_names;
+	file_names.push_back(file_name);
+
+	return PlayFiles(file_names, sync, loop);
+}
+
+ApiErrorCode
+StreamingSession::PlayFiles(IN const list<string> &file_names,
+					 IN BOOL sync,
+					 IN BOOL loop)
+{
 
 	FUNCTRACKER;
 
+	if (file_names.empty())
+	{
+		return API_WRONG_PARAMETER;
+	}
+
+	const string &file_name = file_names.front();
+
 	if (_streamingSessionHandle == IW_UNDEFINED)
 	{
 		return API_WRONG_STATE;
@@ -111,6 +131,11 @@ StreamingSession::PlayFile(IN const string &file_name,
 	msg->streamer_handle	= _streamingSessionHandle;
 	msg->file_name			= file_name;
 	msg->loop				= loop;
+
+	if (file_names.size() > 1)
+	{
+		msg->playlist		= file_names;
+	}
 	
 	
 	ApiErrorCode res = GetCurrRunningContext()->DoRequestResponseTransaction(
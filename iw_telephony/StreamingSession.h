@@ -171,6 +171,10 @@ namespace ivrworx
 
 		  string file_name;
 
+		  // if not empty, files are played back to back instead 
+		  // of file_name and single stopped event is sent at the end
+		  list<string> playlist;
+
 		  BOOL loop;
 
 		  SndDeviceType snd_device_type;
@@ -292,6 +296,11 @@ namespace ivrworx
 			IN BOOL sync = FALSE,
 			IN BOOL loop = FALSE);
 
+		virtual ApiErrorCode PlayFiles(
+			IN const list<string> &fileNames,
+			IN BOOL sync = FALSE,
+			IN BOOL loop = FALSE);
+
 		virtual void TearDown();
 
 		virtual void UponActiveObjectEvent(IwMessagePtr ptr);
@@ -174,6 +174,8 @@ namespace ivrworx
 
 	const MediaFormat MediaFormat::SPEEX("SPEEX",8000,97, MediaType_SPEECH);
 
+	const MediaFormat MediaFormat::L16("L16",8000,98, MediaType_SPEECH);
+
 	const MediaFormat MediaFormat::DTMF_RFC2833("telephone-event", 8000, 101, MediaType_DTMF);
 
 	MediaFormat::MediaType  
@@ -191,6 +193,7 @@ namespace ivrworx
 			mf_map["PCMA"]			  =  MediaFormat::PCMA;
 			mf_map["PCMU"]			  =  MediaFormat::PCMU;
 			mf_map["SPEEX"]			  =  MediaFormat::SPEEX;
+			mf_map["L16"]			  =  MediaFormat::L16;
 			mf_map["telephone-event"] =  MediaFormat::DTMF_RFC2833;
 		}
 
@@ -92,6 +92,8 @@ public:
 
 	static const MediaFormat SPEEX;
 
+	static const MediaFormat L16;
+
 	int operator == (const MediaFormat &other) const;
 
 	int operator != (const MediaFormat &other) const;
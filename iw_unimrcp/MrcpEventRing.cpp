@@ -0,0 +1,158 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "StdAfx.h"
+#include "MrcpEventRing.h"
+
+namespace ivrworx
+{
+	// positions wrap, compare them by signed distance
+	static LONG 
+	Distance(IN LONG a, IN LONG b)
+	{
+		return (LONG)((ULONG)a - (ULONG)b);
+	}
+
+	MrcpEventRing::MrcpEventRing(IN size_t capacity):
+	_cells(NULL),
+	_mask(0),
+	_enqueuePos(0),
+	_dequeuePos(0),
+	_waiting(0),
+	_fullWaits(0),
+	_event(NULL)
+	{
+		FUNCTRACKER;
+
+		size_t size = 2;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+
+		_mask  = size - 1;
+		_cells = new Cell[size];
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			_cells[i].sequence = (LONG)i;
+		}
+
+		_event = ::CreateEvent( 
+			NULL,               // default security attributes
+			FALSE,              // auto-reset event
+			FALSE,              // initial state is nonsignaled
+			NULL				// object name
+			);
+
+		if (_event == NULL)
+		{
+			LogSysError("::CreateEvent");
+			throw;
+		}
+	}
+
+	MrcpEventRing::~MrcpEventRing()
+	{
+		FUNCTRACKER;
+
+		::CloseHandle(_event);
+		delete[] _cells;
+	}
+
+	void 
+	MrcpEventRing::Push(IN const MrcpEvent &evt)
+	{
+		for(;;)
+		{
+			LONG pos = _enqueuePos;
+			Cell &cell = _cells[pos & _mask];
+
+			LONG dif = Distance(cell.sequence, pos);
+			if (dif == 0)
+			{
+				if (::InterlockedCompareExchange(&_enqueuePos, pos + 1, pos) == pos)
+				{
+					cell.evt = evt;
+					::InterlockedExchange(&cell.sequence, pos + 1);
+					break;
+				}
+			}
+			else if (dif < 0)
+			{
+				// full, consumer is behind
+				::InterlockedIncrement(&_fullWaits);
+				::SwitchToThread();
+			}
+		}
+
+		if (::InterlockedExchange(&_waiting, 0) == 1)
+		{
+			::SetEvent(_event);
+		}
+	}
+
+	size_t 
+	MrcpEventRing::PopBatch(OUT MrcpEvent *events, IN size_t max_events)
+	{
+		size_t count = 0;
+		while (count < max_events)
+		{
+			Cell &cell = _cells[_dequeuePos & _mask];
+			if (Distance(cell.sequence, _dequeuePos + 1) < 0)
+			{
+				break;
+			}
+
+			events[count++] = cell.evt;
+			::InterlockedExchange(&cell.sequence, _dequeuePos + (LONG)_mask + 1);
+			_dequeuePos++;
+		}
+
+		return count;
+	}
+
+	BOOL 
+	MrcpEventRing::PrepareWait()
+	{
+		::InterlockedExchange(&_waiting, 1);
+
+		// pushed while we were busy?
+		Cell &cell = _cells[_dequeuePos & _mask];
+		return Distance(cell.sequence, _dequeuePos + 1) >= 0;
+	}
+
+	HANDLE 
+	MrcpEventRing::WinHnd()
+	{
+		return _event;
+	}
+
+	size_t 
+	MrcpEventRing::Capacity()
+	{
+		return _mask + 1;
+	}
+
+	long 
+	MrcpEventRing::FullWaits()
+	{
+		return _fullWaits;
+	}
+
+}
@@ -0,0 +1,114 @@
+/*
+*	The Altalena Project File
+*	Copyright (C) 2009  Boris Ouretskey
+*
+*	This library is free software; you can redistribute it and/or
+*	modify it under the terms of the GNU Lesser General Public
+*	License as published by the Free Software Foundation; either
+*	version 2.1 of the License, or (at your option) any later version.
+*
+*	This library is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*	Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with this library; if not, write to the Free Software
+*	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#pragma once
+
+namespace ivrworx
+{
+	//
+	// event raised by unimrcp client task and handled by mrcp process
+	//
+	struct MrcpEvent
+	{
+		MrcpEvent():
+		event_id(IW_UNDEFINED),
+		mrcp_handle_id(IW_UNDEFINED),
+		status(MRCP_SIG_STATUS_CODE_SUCCESS),
+		channel(NULL),
+		session(NULL),
+		message(NULL){};
+
+		int event_id;
+
+		MrcpHandle mrcp_handle_id;
+
+		mrcp_sig_status_code_e status;
+
+		mrcp_channel_t *channel;
+
+		mrcp_session_t *session;
+
+		mrcp_message_t *message;
+	};
+
+	/**
+
+	Preallocated bounded ring passing events from any number of unimrcp 
+	threads to single consumer (mrcp process). Every cell carries sequence 
+	number, so producers claim cells with single interlocked operation and 
+	consumer reads them without locks. Consumer drains events in batches 
+	and sleeps on event handle which producers signal only if consumer 
+	announced it is going to wait. Producers never lose events, they yield 
+	while ring is full.
+
+	**/
+	class MrcpEventRing:
+		public boost::noncopyable
+	{
+	public:
+
+		MrcpEventRing(IN size_t capacity);
+
+		virtual ~MrcpEventRing();
+
+		// any thread
+		void Push(IN const MrcpEvent &evt);
+
+		// consumer thread only
+		size_t PopBatch(OUT MrcpEvent *events, IN size_t max_events);
+
+		// consumer thread only, returns TRUE if there is no need to wait
+		BOOL PrepareWait();
+
+		HANDLE WinHnd();
+
+		size_t Capacity();
+
+		long FullWaits();
+
+	private:
+
+		struct Cell
+		{
+			volatile LONG sequence;
+
+			MrcpEvent evt;
+		};
+
+		Cell *_cells;
+
+		size_t _mask;
+
+		volatile LONG _enqueuePos;
+
+		LONG _dequeuePos;
+
+		volatile LONG _waiting;
+
+		volatile LONG _fullWaits;
+
+		HANDLE _event;
+
+	};
+
+	typedef 
+	shared_ptr<MrcpEventRing> MrcpEventRingPtr;
+
+}
@@ -17,11 +17,28 @@
 #define IW_MRCP_TERMINATE_RSP			5001
 #define IW_MRCP_MESSAGE_RECEIVE_EVT		5002
 #define IW_MRCP_TERMINATE_EVT			5003
+#define IW_MRCP_UPDATE_RSP				5004
+
+#define IW_DEFAULT_MRCP_EVENT_RING_SIZE	4096
+#define IW_MRCP_EVENT_BATCH_SIZE		64
+
+// 1 sec, pool refill granularity
+#define IW_MRCP_POOL_MAINTENANCE_INTERVAL	1000
+
+// 10 secs, pause refill after the server refused a session
+#define IW_MRCP_POOL_RETRY_INTERVAL			10000
+
+// 30 secs
+#define IW_DEFAULT_MRCP_POOL_HEALTH_INTERVAL	30
+
+// pooled sessions point their media to the discard port until leased
+#define IW_MRCP_POOL_PLACEHOLDER_IP			"127.0.0.1"
+#define IW_MRCP_POOL_PLACEHOLDER_PORT		9
 
 namespace ivrworx
 {
 	
-	static HANDLE g_iocpHandle = NULL;
+	static MrcpEventRing *g_eventRing = NULL;
 
 	static int GetNewMrcpHandle()
 	{
@@ -36,7 +53,10 @@ namespace ivrworx
 		synthesizer_channel(NULL),
 		recognizer_channel(NULL),
 		last_message(NULL),
-		rtp_desc(NULL)
+		rtp_desc(NULL),
+		pooled(FALSE),
+		pool_resource(UKNOWN_MRCP_RESOURCE),
+		health_pending(FALSE)
 	{
 
 	}
@@ -47,23 +67,27 @@ namespace ivrworx
 
 	}
 
-	void send_overlapped_message(MrcpOverlapped *olap, int event_id)
+	MrcpSessionPool::MrcpSessionPool()
+		:resource(UKNOWN_MRCP_RESOURCE),
+		size(0),
+		connecting(0),
+		backoff(FALSE),
+		last_failure(0),
+		hits(0),
+		misses(0),
+		replaced(0)
 	{
-		FUNCTRACKER;
 
-		BOOL res = ::PostQueuedCompletionStatus(
-			g_iocpHandle,				//A handle to an I/O completion port to which the I/O completion packet is to be posted.
-			0,							//The value to be returned through the lpNumberOfBytesTransferred parameter of the GetQueuedCompletionStatus function.
-			event_id,					//The value to be returned through the lpCompletionKey parameter of the GetQueuedCompletionStatus function.
-			olap						//The value to be returned through the lpOverlapped parameter of the GetQueuedCompletionStatus function.
-			);
+	}
 
-		if (res == FALSE)
+	static const char *MrcpResourceName(MrcpResource resource)
+	{
+		switch (resource)
 		{
-			LogSysError("::PostQueuedCompletionStatus");
-			throw std::exception("System error in iw_application_on_channel_add");
+		case SYNTHESIZER: return "synthesizer";
+		case RECOGNIZER:  return "recognizer";
+		default:		  return "unknown";
 		}
-
 	}
 
 	apt_bool_t iw_on_terminate_event(
@@ -74,12 +98,13 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
-		MrcpOverlapped *olap = new MrcpOverlapped();
-		olap->mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
-		olap->session = session;
-		//olap->channel = channel;
+		MrcpEvent evt;
+		evt.mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
+		evt.session = session;
+		//evt.channel = channel;
 
-		send_overlapped_message(olap,IW_MRCP_TERMINATE_EVT);
+		evt.event_id = IW_MRCP_TERMINATE_EVT;
+		g_eventRing->Push(evt);
 
 		return TRUE;
 	}
@@ -92,12 +117,31 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 
-		MrcpOverlapped *olap = new MrcpOverlapped();
-		olap->mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
-		olap->status = status;
-		olap->session = session;
+		MrcpEvent evt;
+		evt.mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
+		evt.status = status;
+		evt.session = session;
+
+		evt.event_id = IW_MRCP_TERMINATE_RSP;
+		g_eventRing->Push(evt);
+
+		return TRUE;
+	}
+
+	apt_bool_t iw_application_on_session_update(
+		mrcp_application_t *application, 
+		mrcp_session_t *session, 
+		mrcp_sig_status_code_e status)
+	{
+		FUNCTRACKER;
+
+		MrcpEvent evt;
+		evt.mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
+		evt.status = status;
+		evt.session = session;
 
-		send_overlapped_message(olap,IW_MRCP_TERMINATE_RSP);
+		evt.event_id = IW_MRCP_UPDATE_RSP;
+		g_eventRing->Push(evt);
 
 		return TRUE;
 	}
@@ -110,13 +154,14 @@ namespace ivrworx
 	{
 		FUNCTRACKER;
 		
-		MrcpOverlapped *olap = new MrcpOverlapped();
-		olap->mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
-		olap->status = status;
-		olap->channel = channel;
-		olap->session = session;
-
-		send_overlapped_message(olap,IW_MRCP_CHANNEL_ADD_EVT);
+		MrcpEvent evt;
+		evt.mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
+		evt.status = status;
+		evt.channel = channel;
+		evt.session = session;
+
+		evt.event_id = IW_MRCP_CHANNEL_ADD_EVT;
+		g_eventRing->Push(evt);
 		
 		return TRUE;
 	}
@@ -128,20 +173,21 @@ namespace ivrworx
 		mrcp_message_t *message)
 	{
 
-		MrcpOverlapped *olap = new MrcpOverlapped();
-		olap->mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
-		olap->message = message;
-		olap->channel = channel;
-		olap->session = session;
+		MrcpEvent evt;
+		evt.mrcp_handle_id = (int)((mrcp_client_session_t*)session)->app_obj;
+		evt.message = message;
+		evt.channel = channel;
+		evt.session = session;
 
-		send_overlapped_message(olap,IW_MRCP_MESSAGE_RECEIVE_EVT);
+		evt.event_id = IW_MRCP_MESSAGE_RECEIVE_EVT;
+		g_eventRing->Push(evt);
 
 
 		return TRUE;
 	}
 
 	static const mrcp_app_message_dispatcher_t iw_application_dispatcher = {
-		NULL,									/** Response to mrcp_application_session_update()request */
+		iw_application_on_session_update,		/** Response to mrcp_application_session_update()request */
 		iw_application_on_session_terminate,	/** Response to mrcp_application_session_terminate()request */
 		iw_application_on_channel_add,			/** Response to mrcp_application_channel_add() request */
 		NULL,									/** Response to mrcp_application_channel_remove() request */
@@ -165,16 +211,27 @@ namespace ivrworx
 	_application(NULL),
 	_pool(NULL),
 	_logInititiated(FALSE),
-	_mrcpClient(NULL)
+	_mrcpClient(NULL),
+	_eventsCount(0),
+	_batchesCount(0),
+	_maxBatch(0),
+	_healthInterval(0),
+	_lastHealthCheck(0),
+	_lastKeepAlive(0)
 	{
 		FUNCTRACKER;
 
 		ServiceId(_conf->GetString("unimrcp/uri"));
 
-		_iocpPtr = IocpInterruptorPtr(new IocpInterruptor());
-		_inbound->HandleInterruptor(_iocpPtr);
+		_interruptorPtr = SemaphoreInterruptorPtr(new SemaphoreInterruptor());
+		_inbound->HandleInterruptor(_interruptorPtr);
+
+		int ring_size = _conf->HasOption("unimrcp/event_ring_size") ? 
+			_conf->GetInt("unimrcp/event_ring_size") : IW_DEFAULT_MRCP_EVENT_RING_SIZE;
+
+		_eventRing = MrcpEventRingPtr(new MrcpEventRing(ring_size > 0 ? ring_size : IW_DEFAULT_MRCP_EVENT_RING_SIZE));
 
-		g_iocpHandle = _iocpPtr->WinHandle();
+		g_eventRing = _eventRing.get();
 	}
 
 	void 
@@ -187,131 +244,188 @@ namespace ivrworx
 			return;
 		}
 
+		CreateSessionPools();
+
 		LogInfo("Mrcp process started successfully.");
 		I_AM_READY;
 
-		BOOL shutdown_flag = FALSE;
-		while (shutdown_flag == FALSE)
-		{
-
-			DWORD number_of_bytes    = 0;
-			ULONG_PTR completion_key = 0;
-			LPOVERLAPPED lpOverlapped = NULL;
+		MaintainSessionPools();
+		_lastKeepAlive = ::GetTickCount();
 
-			BOOL res = ::GetQueuedCompletionStatus(
-				_iocpPtr->WinHandle(),		// A handle to the completion port. To create a completion port, use the CreateIoCompletionPort function.
-				&number_of_bytes,			// A pointer to a variable that receives the number of bytes transferred during an I/O operation that has completed.
-				&completion_key,			// A pointer to a variable that receives the completion key value associated with the file handle whose I/O operation has completed. A completion key is a per-file key that is specified in a call to CreateIoCompletionPort.
-				&lpOverlapped,				// A pointer to a variable that receives the address of the OVERLAPPED structure that was specified when the completed I/O operation was started. 
-				IW_DEFAULT_MRCP_TIMEOUT		// The number of milliseconds that the caller is willing to wait for a completion packet to appear at the completion port. If a completion packet does not appear within the specified time, the function times out, returns FALSE, and sets *lpOverlapped to NULL.
-				);
+		// pools are refilled and health-checked from this loop
+		DWORD wait_timeout = _sessionPools.empty() ? 
+			IW_DEFAULT_MRCP_TIMEOUT : IW_MRCP_POOL_MAINTENANCE_INTERVAL;
 
-			//IX_PROFILE_CHECK_INTERVAL(10000);
+		MrcpEvent events[IW_MRCP_EVENT_BATCH_SIZE];
 
-			LogDebug("ProcUniMrcp::real_run - completion_key:" << completion_key);
+		HANDLE handles[] = {_interruptorPtr->WinHnd(), _eventRing->WinHnd()};
 
-			// error during overlapped I/O?
-			int last_err = ::GetLastError();
-			if (res == FALSE)
+		BOOL shutdown_flag = FALSE;
+		while (shutdown_flag == FALSE)
+		{
+			// drain mrcp events in batches
+			size_t count = 0;
+			while ((count = _eventRing->PopBatch(events, IW_MRCP_EVENT_BATCH_SIZE)) > 0)
 			{
-				if (last_err != WAIT_TIMEOUT)
+				_eventsCount += count;
+				_batchesCount++;
+				if (count > _maxBatch)
 				{
-					LogSysError("::GetQueuedCompletionStatus");
-					Destroy();
-					return;
+					_maxBatch = count;
 				}
-				else 
+
+				for (size_t i = 0; i < count; ++i)
 				{
-					LogInfo("Mrcp keep alive.");
-					continue;
+					DispatchMrcpEvent(&events[i]);
 				}
 			}
 
-			// oRTP event?
-			switch (completion_key)
+			if (_eventRing->PrepareWait())
 			{
-			case IW_MRCP_CHANNEL_ADD_EVT:
-				{
-					onMrcpChanndelAddEvt((MrcpOverlapped*)lpOverlapped);
-					continue;
-				}
-			case IW_MRCP_MESSAGE_RECEIVE_EVT:
-				{
-					onMrcpMessageReceived((MrcpOverlapped*)lpOverlapped);
-					continue;
-				}
-			case IW_MRCP_TERMINATE_RSP:
+				continue;
+			}
+
+			DWORD res = ::WaitForMultipleObjects(
+				2,							// number of handles
+				handles,					// inbound messages and mrcp events
+				FALSE,						// any of them
+				wait_timeout				// keep alive or pool maintenance interval
+				);
+
+			switch (res)
+			{
+			case WAIT_OBJECT_0:
 				{
-					onMrcpSessionTerminatedRsp((MrcpOverlapped*)lpOverlapped);
-					continue;
+					UponInboundMessage(shutdown_flag);
+					break;
 				}
-			case IW_MRCP_TERMINATE_EVT:
+			case WAIT_OBJECT_0 + 1:
 				{
-					onMrcpSessionTerminatedEvt((MrcpOverlapped*)lpOverlapped);
-					continue;
+					// events are drained at the top of the loop
+					break;
 				}
-			case IOCP_UNIQUE_COMPLETION_KEY:
+			case WAIT_TIMEOUT:
 				{
-					ApiErrorCode err_code = API_SUCCESS;
-					IwMessagePtr ptr = _inbound->Wait(Seconds(0), err_code);
-
-					switch (ptr->message_id)
-					{
-					case MSG_MRCP_ALLOCATE_SESSION_REQ:
-						{
-							UponMrcpAllocateSessionReq(ptr);
-							break;
-						}
-					case MSG_MRCP_SPEAK_REQ:
-						{
-							UponSpeakReq(ptr);
-							break;
-						}
-					case MSG_MRCP_STOP_SPEAK_REQ:
-						{
-							UponStopSpeakReq(ptr);
-							break;
-						}
-					case MSG_MRCP_TEARDOWN_REQ:
-						{
-							UponTearDownReq(ptr);
-							break;
-						}
-					case MSG_MRCP_RECOGNIZE_REQ:
-						{
-							UponRecognizeReq(ptr);
-							break;
-						}
-					case MSG_PROC_SHUTDOWN_REQ:
-						{
-							shutdown_flag = TRUE;
-							SendResponse(ptr, new MsgShutdownAck());
-							break;
-						}
-					default:
-						{
-							BOOL oob_res = HandleOOBMessage(ptr);
-							if (oob_res == FALSE)
-							{
-								LogWarn("Received unknown OOB msg:" << ptr->message_id);
-							}// if
-						}// default
-					}// switch
 					break;
-				}// case
+				}
 			default:
 				{
-					
+					LogSysError("::WaitForMultipleObjects");
 					shutdown_flag = TRUE;
-					LogCrit("Unknown overlapped structure received");
-				} // default
-			}// case
+				}
+			}
+
+			MaintainSessionPools();
+
+			if (::GetTickCount() - _lastKeepAlive >= IW_DEFAULT_MRCP_TIMEOUT)
+			{
+				_lastKeepAlive = ::GetTickCount();
+				LogInfo("Mrcp keep alive, events:" << _eventsCount 
+					<< ", batches:"		<< _batchesCount 
+					<< ", max batch:"	<< _maxBatch 
+					<< ", ring:"		<< _eventRing->Capacity() 
+					<< ", full waits:"	<< _eventRing->FullWaits());
+				LogSessionPoolStats();
+			}
 		}// while
 
 		Destroy();
 
 	}
 
+	void
+	ProcUniMrcp::DispatchMrcpEvent(IN const MrcpEvent *evt)
+	{
+		LogDebug("ProcUniMrcp::DispatchMrcpEvent - event:" << evt->event_id);
+
+		switch (evt->event_id)
+		{
+		case IW_MRCP_CHANNEL_ADD_EVT:
+			{
+				onMrcpChanndelAddEvt(evt);
+				break;
+			}
+		case IW_MRCP_MESSAGE_RECEIVE_EVT:
+			{
+				onMrcpMessageReceived(evt);
+				break;
+			}
+		case IW_MRCP_TERMINATE_RSP:
+			{
+				onMrcpSessionTerminatedRsp(evt);
+				break;
+			}
+		case IW_MRCP_TERMINATE_EVT:
+			{
+				onMrcpSessionTerminatedEvt(evt);
+				break;
+			}
+		case IW_MRCP_UPDATE_RSP:
+			{
+				onMrcpSessionUpdateRsp(evt);
+				break;
+			}
+		default:
+			{
+				LogCrit("Unknown mrcp event received:" << evt->event_id);
+			}
+		}
+	}
+
+	void
+	ProcUniMrcp::UponInboundMessage(IN BOOL &shutdown_flag)
+	{
+		ApiErrorCode err_code = API_SUCCESS;
+		IwMessagePtr ptr = _inbound->Wait(Seconds(0), err_code);
+		if (!ptr)
+		{
+			return;
+		}
+
+		switch (ptr->message_id)
+		{
+		case MSG_MRCP_ALLOCATE_SESSION_REQ:
+			{
+				UponMrcpAllocateSessionReq(ptr);
+				break;
+			}
+		case MSG_MRCP_SPEAK_REQ:
+			{
+				UponSpeakReq(ptr);
+				break;
+			}
+		case MSG_MRCP_STOP_SPEAK_REQ:
+			{
+				UponStopSpeakReq(ptr);
+				break;
+			}
+		case MSG_MRCP_TEARDOWN_REQ:
+			{
+				UponTearDownReq(ptr);
+				break;
+			}
+		case MSG_MRCP_RECOGNIZE_REQ:
+			{
+				UponRecognizeReq(ptr);
+				break;
+			}
+		case MSG_PROC_SHUTDOWN_REQ:
+			{
+				shutdown_flag = TRUE;
+				SendResponse(ptr, new MsgShutdownAck());
+				break;
+			}
+		default:
+			{
+				BOOL oob_res = HandleOOBMessage(ptr);
+				if (oob_res == FALSE)
+				{
+					LogWarn("Received unknown OOB msg:" << ptr->message_id);
+				}// if
+			}// default
+		}// switch
+	}
+
 	/** Create demo RTP termination descriptor */
 	mpf_rtp_termination_descriptor_t* rtp_descriptor_create(apr_pool_t *pool, const CnxInfo &local_info,const MediaFormat &media_format, mpf_stream_direction_e direction)
 	{
@@ -709,6 +823,12 @@ namespace ivrworx
 		} 
 		else
 		{
+			// warm session from the pool, only the media has to be re-pointed
+			if (LeasePooledSession(req))
+			{
+				return;
+			}
+
 			ctx = MrcpSessionCtxPtr(new MrcpSessionCtx());
 			handle = GetNewMrcpHandle();
 			ctx->mrcp_handle = handle;
@@ -849,52 +969,61 @@ allocate_error:
 	}
 
 	void
-	ProcUniMrcp::onMrcpMessageReceived(MrcpOverlapped *olap)
+	ProcUniMrcp::onMrcpMessageReceived(const MrcpEvent *evt)
 	{
 		FUNCTRACKER;
 
-		shared_ptr<MrcpOverlapped> guard(olap);
-
-		MrcpHandle handle = olap->mrcp_handle_id;
-		LogDebug("ProcUniMrcp::onMrcpMessageReceived mrcph:" <<  olap->mrcp_handle_id << ", status:" << olap->status << ", request-line:" << olap->message->start_line.method_name.buf);
+		MrcpHandle handle = evt->mrcp_handle_id;
+		LogDebug("ProcUniMrcp::onMrcpMessageReceived mrcph:" <<  evt->mrcp_handle_id << ", status:" << evt->status << ", request-line:" << evt->message->start_line.method_name.buf);
 
 
 		MrcpCtxMap::iterator iter =  _mrcpCtxMap.find(handle);
 		if (iter == _mrcpCtxMap.end())
 		{
-			//mrcp_application_session_destroy(olap->session);
+			//mrcp_application_session_destroy(evt->session);
 			LogWarn("ProcUniMrcp::onMrcpMessageReceived mrcph:" << handle << " not found.");
 			return;
 		}
 
 		MrcpSessionCtxPtr ctx = (*iter).second;
 
-		LogDebug("ProcUniMrcp::Received MRCP message mrcph:" << olap->mrcp_handle_id << 
-			" -> net reqid:" << olap->message->start_line.request_id << 
-			"(" << olap->message->start_line.method_name.buf << ")" << 
+		// health check response of an idle pooled session
+		if (ctx->pooled)
+		{
+			if (ctx->last_message != NULL && 
+				ctx->last_message->start_line.request_id == evt->message->start_line.request_id)
+			{
+				ctx->health_pending = FALSE;
+			}
+			return;
+		}
+
+		LogDebug("ProcUniMrcp::Received MRCP message mrcph:" << evt->mrcp_handle_id << 
+			" -> net reqid:" << evt->message->start_line.request_id << 
+			"(" << evt->message->start_line.method_name.buf << ")" << 
 			", curr reqid:" << ctx->last_message->start_line.request_id << 
 			"(" << ctx->last_message->start_line.method_name.buf << ")" );
 
 		
 		if (ctx->last_message->start_line.request_id != 
-			olap->message->start_line.request_id)
+			evt->message->start_line.request_id)
 		{
-			LogWarn("ProcUniMrcp::Received oudated mrcp reponse mrcph:" << olap->mrcp_handle_id );
+			LogWarn("ProcUniMrcp::Received oudated mrcp reponse mrcph:" << evt->mrcp_handle_id );
 			return;
 		}
 
-		string method_name (olap->message->start_line.method_name.buf);
+		string method_name (evt->message->start_line.method_name.buf);
 
 		if (method_name == "SPEAK-COMPLETE")
 		{
 			MsgMrcpSpeakStoppedEvt *stopped_msg = new MsgMrcpSpeakStoppedEvt();
-			stopped_msg->correlation_id = olap->message->start_line.request_id;
+			stopped_msg->correlation_id = evt->message->start_line.request_id;
 			SendMessage(ctx->session_handler.inbound, IwMessagePtr(stopped_msg));
 		} 
 		else if (method_name == "SPEAK")
 		{
 			MsgMrcpSpeakAck *speak_ack= new MsgMrcpSpeakAck();
-			speak_ack->correlation_id = olap->message->start_line.request_id;
+			speak_ack->correlation_id = evt->message->start_line.request_id;
 			SendResponse(ctx->last_user_request, speak_ack);
 		}
 		else if (method_name == "STOP")
@@ -906,16 +1035,16 @@ allocate_error:
 		else if (method_name == "RECOGNIZE")
 		{
 			IwMessage *response = NULL;
-			if (olap->message->start_line.status_code <= 401) 
+			if (evt->message->start_line.status_code <= 401) 
 			{
 				MsgMrcpRecognizeAck *ack = new MsgMrcpRecognizeAck(); 
-				ack->response_error_code = olap->message->start_line.status_code;
+				ack->response_error_code = evt->message->start_line.status_code;
 				response = ack;
 			}
 			else
 			{
 				MsgMrcpRecognizeNack *nack = new MsgMrcpRecognizeNack(); 
-				nack->response_error_code = olap->message->start_line.status_code;
+				nack->response_error_code = evt->message->start_line.status_code;
 				response = nack;
 			};
 
@@ -925,15 +1054,15 @@ allocate_error:
 		else if (method_name == "RECOGNITION-COMPLETE")
 		{
 			MsgMrcpRecognitionCompleteEvt* stopped_msg = new MsgMrcpRecognitionCompleteEvt();
-			stopped_msg->correlation_id = olap->message->start_line.request_id;
-			stopped_msg->body = (olap->message->body.buf != NULL && olap->message->body.length > 0) ? 
-				string(olap->message->body.buf, olap->message->body.length):"";
+			stopped_msg->correlation_id = evt->message->start_line.request_id;
+			stopped_msg->body = (evt->message->body.buf != NULL && evt->message->body.length > 0) ? 
+				string(evt->message->body.buf, evt->message->body.length):"";
 
 			SendMessage(ctx->session_handler.inbound, IwMessagePtr(stopped_msg));
 		}
 		else
 		{
-			LogWarn("Received unknown response:" << method_name <<", mrcph:" <<olap->mrcp_handle_id )
+			LogWarn("Received unknown response:" << method_name <<", mrcph:" <<evt->mrcp_handle_id )
 		}
 
 		
@@ -941,18 +1070,15 @@ allocate_error:
 
 	
 	void
-	ProcUniMrcp::onMrcpSessionTerminatedEvt(MrcpOverlapped *olap)
+	ProcUniMrcp::onMrcpSessionTerminatedEvt(const MrcpEvent *evt)
 	{
 		FUNCTRACKER;
 
 
-		shared_ptr<MrcpOverlapped> ptr (olap);
+		MrcpHandle handle = evt->mrcp_handle_id;
+		mrcp_sig_status_code_e status = evt->status;
 
-
-		MrcpHandle handle = olap->mrcp_handle_id;
-		mrcp_sig_status_code_e status = olap->status;
-
-		LogDebug("ProcUniMrcp::onMrcpTerminatedEvt mrcph:" <<  olap->mrcp_handle_id << ", status:" << olap->status);
+		LogDebug("ProcUniMrcp::onMrcpTerminatedEvt mrcph:" <<  evt->mrcp_handle_id << ", status:" << evt->status);
 
 
 
@@ -970,50 +1096,51 @@ allocate_error:
 
 
 	void
-	ProcUniMrcp::onMrcpSessionTerminatedRsp(MrcpOverlapped *olap)
+	ProcUniMrcp::onMrcpSessionTerminatedRsp(const MrcpEvent *evt)
 	{
 		FUNCTRACKER;
 
 
-		shared_ptr<MrcpOverlapped> ptr (olap);
-
+		MrcpHandle handle = evt->mrcp_handle_id;
+		mrcp_sig_status_code_e status = evt->status;
 
-		MrcpHandle handle = olap->mrcp_handle_id;
-		mrcp_sig_status_code_e status = olap->status;
-
-		LogDebug("ProcUniMrcp::onMrcpSessionTerminatedEvt mrcph:" <<  olap->mrcp_handle_id << ", status:" << olap->status);
+		LogDebug("ProcUniMrcp::onMrcpSessionTerminatedEvt mrcph:" <<  evt->mrcp_handle_id << ", status:" << evt->status);
 
 
 		// if we got here ctx does not exist already
-		mrcp_application_session_destroy(olap->session);
+		mrcp_application_session_destroy(evt->session);
 		
 		
 	}
 
 	void
-	ProcUniMrcp::onMrcpChanndelAddEvt(MrcpOverlapped *olap)
+	ProcUniMrcp::onMrcpChanndelAddEvt(const MrcpEvent *evt)
 	{
 		FUNCTRACKER;
 
-		shared_ptr<MrcpOverlapped> ptr (olap);
-
 	
-		MrcpHandle handle = olap->mrcp_handle_id;
-		mrcp_sig_status_code_e status = olap->status;
+		MrcpHandle handle = evt->mrcp_handle_id;
+		mrcp_sig_status_code_e status = evt->status;
 
-		LogDebug("ProcUniMrcp::onMrcpChanndelAddEvtd handle:" <<  olap->mrcp_handle_id << ", status:" << olap->status);
+		LogDebug("ProcUniMrcp::onMrcpChanndelAddEvtd handle:" <<  evt->mrcp_handle_id << ", status:" << evt->status);
 
 		
 
 		MrcpCtxMap::iterator iter =  _mrcpCtxMap.find(handle);
 		if (iter == _mrcpCtxMap.end())
 		{
-			mrcp_application_session_destroy(olap->session);
+			mrcp_application_session_destroy(evt->session);
 			LogWarn("Channel status event on non existent ctx.");
 			return;
 		}
 
 		MrcpSessionCtxPtr ctx = (*iter).second;
+
+		if (ctx->pooled)
+		{
+			UponPooledChannelAdd(ctx, evt);
+			return;
+		}
 		
 		switch (status)
 		{
@@ -1021,13 +1148,8 @@ allocate_error:
 			{
 				ctx->state = MRCP_ALLOCATED;
 
-				
-				MsgMrcpAllocateSessionAck * rsp = new MsgMrcpAllocateSessionAck();
-
-				
-
 				mrcp_channel_t *channel = NULL;
-				switch (olap->channel->resource->id)
+				switch (evt->channel->resource->id)
 				{
 				case MRCP_RECOGNIZER_RESOURCE:
 					{
@@ -1045,84 +1167,7 @@ allocate_error:
 				default:{}
 				};
 
-				mpf_rtp_media_descriptor_t *remote_desc =  
-					channel->rtp_termination_slot->descriptor->audio.remote;
-
-				CnxInfo info(
-					remote_desc->ip.buf,
-					remote_desc->port);
-
-				 DWORD time = ::GetTickCount(); 
-
-				mpf_codec_descriptor_t *dtmf_descriptor = NULL;
-				string dtmf_str = "telephone-event";
-
-				BOOL found = FALSE;
-				for(int i=0; i<remote_desc->codec_list.descriptor_arr->nelts; i++) {
-					mpf_codec_descriptor_t *descriptor1 = &APR_ARRAY_IDX(remote_desc->codec_list.descriptor_arr,i,mpf_codec_descriptor_t);
-					if(descriptor1->enabled == FALSE) {
-						/* this descriptor has been already disabled, process only enabled ones */
-						continue;
-					}
-
-					if (!dtmf_descriptor)
-					{
-						apt_str_t dtmf_name;
-						dtmf_name.buf = (char*)dtmf_str.c_str();
-						dtmf_name.length = dtmf_str.length();
-
-						// found DTMF string ?
-						if (apt_string_compare(&descriptor1->name,&dtmf_name))
-						{
-							dtmf_descriptor = descriptor1;
-						}
-					}
-
-					if (!found)
-					{
-						apt_str_t name;
-						name.buf = (char*)ctx->media_format.sdp_name_tos().c_str();
-						name.length = ctx->media_format.sdp_name_tos().length();
-
-						found = apt_string_compare(&descriptor1->name,&name);
-					}
-					
-					if (found && dtmf_descriptor)
-						break;
-				}
-
-				if (!found)
-				{
-					LogWarn("ProcUniMrcp::onMrcpChanndelAddEvt - suggested codec was not found in remote answer:" <<ctx->media_format.sdp_name_tos());
-					MsgMrcpAllocateSessionNack * rsp = new MsgMrcpAllocateSessionNack();
-					SendResponse(ctx->last_user_request,rsp);
-					break;
-				}
-
-				// we assume that server agreed for the sinlge codec suggested
-				stringstream sdps;
-				sdps << "v=0" << endl
-					<< "o=mrcp " << time << " " << time <<" IN IP4 " << info.iptoa() << endl
-					<< "s=mrcp"	<< endl
-					<< "c=IN IP4 "	<< info.iptoa() << endl 
-					<< "t=0 0"	<< endl
-					<< "m=audio "  << info.port_ho() << " RTP/AVP " << ctx->media_format.sdp_mapping();
-					if (dtmf_descriptor)
-						sdps << " " << (int)dtmf_descriptor->payload_type;
-				sdps <<  endl;
-				sdps << ctx->media_format.get_sdp_a() << endl;
-				if (dtmf_descriptor)
-				{
-					sdps << "a=rtpmap:" << (int)dtmf_descriptor->payload_type<< " "<< dtmf_str << "/" << dtmf_descriptor->sampling_rate << endl;
-					sdps << "a=fmtp:"   << (int)dtmf_descriptor->payload_type<< " 0-15" << endl;
-				}
-					
-		
-				rsp->mrcp_handle = handle;
-				rsp->offer.type = "application/sdp";
-				rsp->offer.body = sdps.str();
-				
-				SendResponse(ctx->last_user_request,rsp);
+				AckAllocateSession(ctx, channel);
 				break;
 			}
 		case MRCP_SIG_STATUS_CODE_FAILURE:
@@ -1149,11 +1194,103 @@ allocate_error:
 
 	}
 
+	void
+	ProcUniMrcp::AckAllocateSession(IN MrcpSessionCtxPtr ctx, IN mrcp_channel_t *channel)
+	{
+		FUNCTRACKER;
+
+		mpf_rtp_media_descriptor_t *remote_desc =  
+			channel->rtp_termination_slot->descriptor->audio.remote;
+
+		CnxInfo info(
+			remote_desc->ip.buf,
+			remote_desc->port);
+
+		 DWORD time = ::GetTickCount(); 
+
+		mpf_codec_descriptor_t *dtmf_descriptor = NULL;
+		string dtmf_str = "telephone-event";
+
+		BOOL found = FALSE;
+		for(int i=0; i<remote_desc->codec_list.descriptor_arr->nelts; i++) {
+			mpf_codec_descriptor_t *descriptor1 = &APR_ARRAY_IDX(remote_desc->codec_list.descriptor_arr,i,mpf_codec_descriptor_t);
+			if(descriptor1->enabled == FALSE) {
+				/* this descriptor has been already disabled, process only enabled ones */
+				continue;
+			}
+
+			if (!dtmf_descriptor)
+			{
+				apt_str_t dtmf_name;
+				dtmf_name.buf = (char*)dtmf_str.c_str();
+				dtmf_name.length = dtmf_str.length();
+
+				// found DTMF string ?
+				if (apt_string_compare(&descriptor1->name,&dtmf_name))
+				{
+					dtmf_descriptor = descriptor1;
+				}
+			}
+
+			if (!found)
+			{
+				apt_str_t name;
+				name.buf = (char*)ctx->media_format.sdp_name_tos().c_str();
+				name.length = ctx->media_format.sdp_name_tos().length();
+
+				found = apt_string_compare(&descriptor1->name,&name);
+			}
+			
+			if (found && dtmf_descriptor)
+				break;
+		}
+
+		if (!found)
+		{
+			LogWarn("ProcUniMrcp::AckAllocateSession - suggested codec was not found in remote answer:" <<ctx->media_format.sdp_name_tos());
+			MsgMrcpAllocateSessionNack * rsp = new MsgMrcpAllocateSessionNack();
+			SendResponse(ctx->last_user_request,rsp);
+			return;
+		}
+
+		// we assume that server agreed for the sinlge codec suggested
+		stringstream sdps;
+		sdps << "v=0" << endl
+			<< "o=mrcp " << time << " " << time <<" IN IP4 " << info.iptoa() << endl
+			<< "s=mrcp"	<< endl
+			<< "c=IN IP4 "	<< info.iptoa() << endl 
+			<< "t=0 0"	<< endl
+			<< "m=audio "  << info.port_ho() << " RTP/AVP " << ctx->media_format.sdp_mapping();
+			if (dtmf_descriptor)
+				sdps << " " << (int)dtmf_descriptor->payload_type;
+		sdps <<  endl;
+		sdps << ctx->media_format.get_sdp_a() << endl;
+		if (dtmf_descriptor)
+		{
+			sdps << "a=rtpmap:" << (int)dtmf_descriptor->payload_type<< " "<< dtmf_str << "/" << dtmf_descriptor->sampling_rate << endl;
+			sdps << "a=fmtp:"   << (int)dtmf_descriptor->payload_type<< " 0-15" << endl;
+		}
+			
+
+		MsgMrcpAllocateSessionAck * rsp = new MsgMrcpAllocateSessionAck();
+		rsp->mrcp_handle = ctx->mrcp_handle;
+		rsp->offer.type = "application/sdp";
+		rsp->offer.body = sdps.str();
+		
+		SendResponse(ctx->last_user_request,rsp);
+
+	}
+
 	void
 	ProcUniMrcp::FinalizeSessionContext(MrcpSessionCtxPtr ctx)
 	{
 		
 		FUNCTRACKER;
+		if (ctx->pooled)
+		{
+			ReleasePooledSession(ctx);
+		}
+
 		if (ctx->session_handler.inbound)
 		{
 			ctx->session_handler.inbound->Send(new MsgMrcpTearDownEvt());
@@ -1163,6 +1300,417 @@ allocate_error:
 		
 	}
 
+	void
+	ProcUniMrcp::onMrcpSessionUpdateRsp(const MrcpEvent *evt)
+	{
+		FUNCTRACKER;
+
+		MrcpHandle handle = evt->mrcp_handle_id;
+
+		LogDebug("ProcUniMrcp::onMrcpSessionUpdateRsp mrcph:" <<  evt->mrcp_handle_id << ", status:" << evt->status);
+
+		MrcpCtxMap::iterator iter =  _mrcpCtxMap.find(handle);
+		if (iter == _mrcpCtxMap.end())
+		{
+			LogWarn("Session update response on non existent ctx.");
+			return;
+		}
+
+		MrcpSessionCtxPtr ctx = (*iter).second;
+		if (ctx->state != MRCP_LEASING)
+		{
+			LogWarn("ProcUniMrcp::onMrcpSessionUpdateRsp - mrcph:" << handle << " is not being leased.");
+			return;
+		}
+
+		mrcp_channel_t *channel = ctx->pool_resource == SYNTHESIZER ? 
+			ctx->synthesizer_channel : ctx->recognizer_channel;
+
+		if (evt->status == MRCP_SIG_STATUS_CODE_SUCCESS)
+		{
+			ctx->state = MRCP_ALLOCATED;
+			AckAllocateSession(ctx, channel);
+			return;
+		}
+
+		// server refused to re-point the media of the warm session,
+		// drop it and serve the call as if the pool was empty
+		LogWarn("ProcUniMrcp::onMrcpSessionUpdateRsp - cannot lease mrcph:" << handle << ", status:" << evt->status);
+
+		IwMessagePtr req = ctx->last_user_request;
+		ctx->session_handler = LpHandlePair();
+		ctx->last_user_request.reset();
+
+		mrcp_application_session_terminate(ctx->session);
+		FinalizeSessionContext(ctx);
+
+		UponMrcpAllocateSessionReq(req);
+	}
+
+	void
+	ProcUniMrcp::CreateSessionPools()
+	{
+		FUNCTRACKER;
+
+		int synthesizers = _conf->HasOption("unimrcp/session_pool_synthesizers") ? 
+			_conf->GetInt("unimrcp/session_pool_synthesizers") : 0;
+
+		int recognizers = _conf->HasOption("unimrcp/session_pool_recognizers") ? 
+			_conf->GetInt("unimrcp/session_pool_recognizers") : 0;
+
+		if (synthesizers <= 0 && recognizers <= 0)
+		{
+			LogInfo("Mrcp session pool is disabled.");
+			return;
+		}
+
+		string codec = _conf->HasOption("unimrcp/session_pool_codec") ? 
+			_conf->GetString("unimrcp/session_pool_codec") : "PCMU";
+
+		MediaFormat media_format = MediaFormat::GetMediaFormat(codec);
+		if (media_format.get_media_type() != MediaFormat::MediaType_SPEECH)
+		{
+			LogWarn("Mrcp session pool is disabled, unsupported codec:" << codec);
+			return;
+		}
+
+		int health_interval = _conf->HasOption("unimrcp/session_pool_health_interval") ? 
+			_conf->GetInt("unimrcp/session_pool_health_interval") : IW_DEFAULT_MRCP_POOL_HEALTH_INTERVAL;
+
+		_healthInterval = health_interval > 0 ? health_interval*1000 : 0;
+		_lastHealthCheck = ::GetTickCount();
+
+		MrcpResource resources[] = {SYNTHESIZER, RECOGNIZER};
+		int sizes[] = {synthesizers, recognizers};
+
+		for (int i = 0; i < 2; ++i)
+		{
+			if (sizes[i] <= 0)
+			{
+				continue;
+			}
+
+			MrcpSessionPool &pool = _sessionPools[resources[i]];
+			pool.resource = resources[i];
+			pool.profile = _conf->GetString("unimrcp/unimrcp_client_profile");
+			pool.media_format = media_format;
+			pool.size = sizes[i];
+
+			LogInfo("Mrcp " << MrcpResourceName(pool.resource) << " pool - profile:" << pool.profile 
+				<< ", size:" << pool.size << ", codec:" << codec);
+		}
+	}
+
+	void
+	ProcUniMrcp::MaintainSessionPools()
+	{
+		if (_sessionPools.empty())
+		{
+			return;
+		}
+
+		DWORD now = ::GetTickCount();
+
+		BOOL health_due = _healthInterval > 0 && (now - _lastHealthCheck >= _healthInterval);
+		if (health_due)
+		{
+			_lastHealthCheck = now;
+		}
+
+		for (MrcpSessionPoolsMap::iterator iter = _sessionPools.begin(); 
+			iter != _sessionPools.end(); ++iter)
+		{
+			MrcpSessionPool &pool = iter->second;
+
+			if (health_due)
+			{
+				CheckPooledSessions(pool);
+			}
+
+			if (pool.backoff && now - pool.last_failure < IW_MRCP_POOL_RETRY_INTERVAL)
+			{
+				continue;
+			}
+			pool.backoff = FALSE;
+
+			while (pool.idle.size() + pool.connecting < pool.size)
+			{
+				if (IW_FAILURE(PreallocatePooledSession(pool)))
+				{
+					pool.backoff = TRUE;
+					pool.last_failure = now;
+					break;
+				}
+			}
+		}
+	}
+
+	ApiErrorCode
+	ProcUniMrcp::PreallocatePooledSession(IN MrcpSessionPool &pool)
+	{
+		FUNCTRACKER;
+
+		MrcpSessionCtxPtr ctx = MrcpSessionCtxPtr(new MrcpSessionCtx());
+		ctx->mrcp_handle = GetNewMrcpHandle();
+		ctx->state = MRCP_CONNECTING;
+		ctx->pooled = TRUE;
+		ctx->pool_resource = pool.resource;
+		ctx->media_format = pool.media_format;
+
+		mrcp_session_t *session = 
+			mrcp_application_session_create(_application,pool.profile.c_str(), (void *)ctx->mrcp_handle);
+		if (!session)
+		{
+			LogWarn("ProcUniMrcp::PreallocatePooledSession - error:mrcp_application_session_create");
+			return API_FAILURE;
+		}
+
+		ctx->session = session;
+
+		mpf_rtp_termination_descriptor_t *rtp_descriptor = rtp_descriptor_create(
+			session->pool,
+			CnxInfo(IW_MRCP_POOL_PLACEHOLDER_IP,IW_MRCP_POOL_PLACEHOLDER_PORT),
+			pool.media_format,
+			pool.resource == RECOGNIZER ? STREAM_DIRECTION_SEND : STREAM_DIRECTION_RECEIVE);
+
+		mrcp_channel_t *channel = mrcp_application_channel_create(
+			session,
+			pool.resource == RECOGNIZER ? MRCP_RECOGNIZER_RESOURCE : MRCP_SYNTHESIZER_RESOURCE,
+			NULL,
+			rtp_descriptor,
+			NULL);
+
+		if (!channel || !mrcp_application_channel_add(session,channel))
+		{
+			LogWarn("ProcUniMrcp::PreallocatePooledSession - error:mrcp_application_channel_add");
+			mrcp_application_session_destroy(session);
+			return API_FAILURE;
+		}
+
+		if (pool.resource == RECOGNIZER)
+			ctx->recognizer_channel = channel;
+		else
+			ctx->synthesizer_channel = channel;
+
+		pool.connecting++;
+		_mrcpCtxMap[ctx->mrcp_handle] = ctx;
+
+		return API_SUCCESS;
+	}
+
+	BOOL
+	ProcUniMrcp::LeasePooledSession(IN shared_ptr<MsgMrcpAllocateSessionReq> req)
+	{
+		FUNCTRACKER;
+
+		MrcpSessionPoolsMap::iterator piter = _sessionPools.find(req->resource);
+		if (piter == _sessionPools.end())
+		{
+			return FALSE;
+		}
+
+		MrcpSessionPool &pool = piter->second;
+
+		SdpParser p(req->offer.body);
+		SdpParser::Medium  m = p.first_audio_medium();
+		if (!m.connection.is_valid())
+		{
+			// let the regular path reject it
+			return FALSE;
+		}
+
+		MediaFormatsList::iterator mfiter = m.list.begin();
+		for (; mfiter != m.list.end(); mfiter++)
+		{
+			if ((*mfiter).get_media_type() != MediaFormat::MediaType_DTMF)
+			{
+				break;
+			}
+		}
+
+		// pooled sessions were negotiated with a single codec
+		if (mfiter == m.list.end() || *mfiter != pool.media_format)
+		{
+			pool.misses++;
+			return FALSE;
+		}
+
+		while (!pool.idle.empty())
+		{
+			MrcpHandle handle = pool.idle.front();
+			pool.idle.pop_front();
+
+			MrcpCtxMap::iterator iter = _mrcpCtxMap.find(handle);
+			if (iter == _mrcpCtxMap.end())
+			{
+				continue;
+			}
+
+			MrcpSessionCtxPtr ctx = iter->second;
+			ctx->pooled = FALSE;
+
+			mrcp_channel_t *channel = pool.resource == SYNTHESIZER ? 
+				ctx->synthesizer_channel : ctx->recognizer_channel;
+
+			// re-point server media from the placeholder to the caller
+			mpf_rtp_media_descriptor_t *local_desc = 
+				channel->rtp_termination_slot->descriptor->audio.local;
+
+			apt_string_assign(&local_desc->ip,m.connection.iptoa(),ctx->session->pool);
+			local_desc->port = m.connection.port_ho();
+
+			ctx->state = MRCP_LEASING;
+			ctx->session_handler = req->session_handler;
+			ctx->last_user_request = req;
+
+			if (!mrcp_application_session_update(ctx->session))
+			{
+				LogWarn("ProcUniMrcp::LeasePooledSession - error:mrcp_application_session_update mrcph:" << handle);
+				ctx->session_handler = LpHandlePair();
+				ctx->last_user_request.reset();
+				mrcp_application_session_terminate(ctx->session);
+				FinalizeSessionContext(ctx);
+				continue;
+			}
+
+			LogDebug("ProcUniMrcp::LeasePooledSession - leased mrcph:" << handle << " " << MrcpResourceName(pool.resource));
+
+			pool.hits++;
+			return TRUE;
+		}
+
+		pool.misses++;
+		return FALSE;
+	}
+
+	void
+	ProcUniMrcp::UponPooledChannelAdd(IN MrcpSessionCtxPtr ctx, IN const MrcpEvent *evt)
+	{
+		FUNCTRACKER;
+
+		MrcpSessionPool &pool = _sessionPools[ctx->pool_resource];
+
+		if (evt->status == MRCP_SIG_STATUS_CODE_SUCCESS)
+		{
+			pool.connecting--;
+			ctx->state = MRCP_POOLED;
+			pool.idle.push_back(ctx->mrcp_handle);
+			return;
+		}
+
+		LogWarn("Mrcp " << MrcpResourceName(pool.resource) << " pool - cannot establish session, status:" << evt->status);
+
+		pool.backoff = TRUE;
+		pool.last_failure = ::GetTickCount();
+
+		if (evt->status == MRCP_SIG_STATUS_CODE_TERMINATE)
+		{
+			FinalizeSessionContext(ctx);
+			mrcp_application_session_destroy(ctx->session);
+		}
+		else
+		{
+			TerminatePooledSession(ctx);
+		}
+	}
+
+	void
+	ProcUniMrcp::CheckPooledSessions(IN MrcpSessionPool &pool)
+	{
+		FUNCTRACKER;
+
+		list<MrcpSessionCtxPtr> stale;
+
+		for (MrcpHandlesList::iterator iter = pool.idle.begin(); 
+			iter != pool.idle.end(); ++iter)
+		{
+			MrcpCtxMap::iterator ctx_iter = _mrcpCtxMap.find(*iter);
+			if (ctx_iter == _mrcpCtxMap.end())
+			{
+				continue;
+			}
+
+			MrcpSessionCtxPtr ctx = ctx_iter->second;
+
+			// previous probe was not answered
+			if (ctx->health_pending)
+			{
+				LogWarn("Mrcp " << MrcpResourceName(pool.resource) << " pool - mrcph:" << ctx->mrcp_handle << " is not responding, replacing.");
+				stale.push_back(ctx);
+				continue;
+			}
+
+			mrcp_channel_t *channel = pool.resource == SYNTHESIZER ? 
+				ctx->synthesizer_channel : ctx->recognizer_channel;
+
+			mrcp_message_t *mrcp_message = 
+				mrcp_application_message_create(
+				ctx->session,
+				channel,
+				pool.resource == SYNTHESIZER ? SYNTHESIZER_GET_PARAMS : RECOGNIZER_GET_PARAMS);
+
+			if (!mrcp_message || 
+				!mrcp_application_message_send(ctx->session,channel,mrcp_message))
+			{
+				LogWarn("Mrcp " << MrcpResourceName(pool.resource) << " pool - cannot probe mrcph:" << ctx->mrcp_handle << ", replacing.");
+				stale.push_back(ctx);
+				continue;
+			}
+
+			ctx->last_message = mrcp_message;
+			ctx->health_pending = TRUE;
+		}
+
+		for (list<MrcpSessionCtxPtr>::iterator iter = stale.begin(); 
+			iter != stale.end(); ++iter)
+		{
+			pool.replaced++;
+			TerminatePooledSession(*iter);
+		}
+	}
+
+	void
+	ProcUniMrcp::ReleasePooledSession(IN MrcpSessionCtxPtr ctx)
+	{
+		MrcpSessionPool &pool = _sessionPools[ctx->pool_resource];
+
+		if (ctx->state == MRCP_CONNECTING)
+		{
+			pool.connecting--;
+		}
+		else
+		{
+			pool.idle.remove(ctx->mrcp_handle);
+		}
+
+		ctx->pooled = FALSE;
+	}
+
+	void
+	ProcUniMrcp::TerminatePooledSession(IN MrcpSessionCtxPtr ctx)
+	{
+		FUNCTRACKER;
+
+		mrcp_application_session_terminate(ctx->session);
+		FinalizeSessionContext(ctx);
+	}
+
+	void
+	ProcUniMrcp::LogSessionPoolStats()
+	{
+		for (MrcpSessionPoolsMap::iterator iter = _sessionPools.begin(); 
+			iter != _sessionPools.end(); ++iter)
+		{
+			MrcpSessionPool &pool = iter->second;
+			LogInfo("Mrcp " << MrcpResourceName(pool.resource) << " pool - size:" << pool.size 
+				<< ", idle:"		<< pool.idle.size() 
+				<< ", connecting:"	<< pool.connecting 
+				<< ", hits:"		<< pool.hits 
+				<< ", misses:"		<< pool.misses 
+				<< ", replaced:"	<< pool.replaced);
+		}
+	}
+
 	ApiErrorCode
 	ProcUniMrcp::Init()
 	{
@@ -1254,6 +1802,7 @@ error:
 	{
 		
 		_mrcpCtxMap.clear();
+		_sessionPools.clear();
 
 		if (_mrcpClient) 
 		{
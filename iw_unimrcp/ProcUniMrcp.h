@@ -1,12 +1,16 @@
 #pragma once
 
+#include "MrcpEventRing.h"
+
 namespace ivrworx
 {
 	enum MrcpSessionState
 	{
 		MRCP_INITIAL,
 		MRCP_CONNECTING,
-		MRCP_ALLOCATED
+		MRCP_ALLOCATED,
+		MRCP_POOLED,
+		MRCP_LEASING
 	};
 
 
@@ -41,6 +45,15 @@ namespace ivrworx
 
 		MediaFormat media_format;
 
+		// session was pre-established by the pool
+		// and was not leased to a call yet
+		//
+		BOOL pooled;
+
+		MrcpResource pool_resource;
+
+		BOOL health_pending;
+
 	};
 
 	typedef 
@@ -49,20 +62,39 @@ namespace ivrworx
 	typedef	
 	map<MrcpHandle, MrcpSessionCtxPtr> MrcpCtxMap;
 
-	struct MrcpOverlapped:
-		public OVERLAPPED
+	typedef
+	list<MrcpHandle> MrcpHandlesList;
+
+	struct MrcpSessionPool
 	{
-		MrcpHandle mrcp_handle_id;
+		MrcpSessionPool();
 
-		mrcp_sig_status_code_e status;
+		MrcpResource resource;
 
-		mrcp_channel_t *channel;
+		string profile;
 
-		mrcp_session_t *session;
+		MediaFormat media_format;
+
+		size_t size;
+
+		size_t connecting;
 
-		mrcp_message_t *message;
+		MrcpHandlesList idle;
+
+		BOOL backoff;
+
+		DWORD last_failure;
+
+		unsigned long hits;
+
+		unsigned long misses;
+
+		unsigned long replaced;
 	};
 
+	typedef
+	map<MrcpResource, MrcpSessionPool> MrcpSessionPoolsMap;
+
 	class ProcUniMrcp : 
 		public LightweightProcess
 	{
@@ -93,16 +125,19 @@ namespace ivrworx
 
 		// mrcp server events
 		virtual void onMrcpChanndelAddEvt(
-			IN MrcpOverlapped *olap);
+			IN const MrcpEvent *evt);
 
 		virtual void onMrcpMessageReceived(
-			IN MrcpOverlapped *olap);
+			IN const MrcpEvent *evt);
 
 		virtual void onMrcpSessionTerminatedRsp(
-			IN MrcpOverlapped *olap);
+			IN const MrcpEvent *evt);
 
 		virtual void onMrcpSessionTerminatedEvt(
-			IN MrcpOverlapped *olap);
+			IN const MrcpEvent *evt);
+
+		virtual void onMrcpSessionUpdateRsp(
+			IN const MrcpEvent *evt);
 
 	private:
 		
@@ -112,9 +147,42 @@ namespace ivrworx
 
 		void FinalizeSessionContext(MrcpSessionCtxPtr ctx);
 
+		void DispatchMrcpEvent(IN const MrcpEvent *evt);
+
+		void UponInboundMessage(IN BOOL &shutdown_flag);
+
+		void AckAllocateSession(IN MrcpSessionCtxPtr ctx, IN mrcp_channel_t *channel);
+
+		// session pool
+		void CreateSessionPools();
+
+		void MaintainSessionPools();
+
+		ApiErrorCode PreallocatePooledSession(IN MrcpSessionPool &pool);
+
+		BOOL LeasePooledSession(IN shared_ptr<MsgMrcpAllocateSessionReq> req);
+
+		void UponPooledChannelAdd(IN MrcpSessionCtxPtr ctx, IN const MrcpEvent *evt);
+
+		void CheckPooledSessions(IN MrcpSessionPool &pool);
+
+		void ReleasePooledSession(IN MrcpSessionCtxPtr ctx);
+
+		void TerminatePooledSession(IN MrcpSessionCtxPtr ctx);
+
+		void LogSessionPoolStats();
+
 		ConfigurationPtr _conf;
 
-		IocpInterruptorPtr _iocpPtr;
+		SemaphoreInterruptorPtr _interruptorPtr;
+
+		MrcpEventRingPtr _eventRing;
+
+		unsigned long _eventsCount;
+
+		unsigned long _batchesCount;
+
+		size_t _maxBatch;
 
 		BOOL _logInititiated;
 
@@ -125,6 +193,14 @@ namespace ivrworx
 		mrcp_client_t *_mrcpClient;
 	
 		MrcpCtxMap _mrcpCtxMap;
+
+		MrcpSessionPoolsMap _sessionPools;
+
+		DWORD _healthInterval;
+
+		DWORD _lastHealthCheck;
+
+		DWORD _lastKeepAlive;
 	};
 
 